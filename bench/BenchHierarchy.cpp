@@ -0,0 +1,92 @@
+#include "StarBench.h"
+
+#include <StarMath.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+/**
+ * TransformHierarchy throughput in nodes per second: update() and
+ * updateParallel() of a forest of skeletons, when all of them move and
+ * when one in a hundred does.
+ */
+
+namespace
+{
+  const unsigned int BONES_PER_SKELETON = 64;
+
+  float
+  randf()
+  {
+    return std::rand()/float(RAND_MAX);
+  }
+
+  /*****************************************************************************/
+  /**
+   * Skeletons whose bones hang from one of the four previous ones, about
+   * twenty levels deep.
+   */
+  void
+  buildForest(Star::transformHierarchyf& hierarchy, size_t numNodes)
+  {
+    hierarchy.clear();
+    hierarchy.reserve(numNodes);
+    for(size_t i = 0; i < numNodes; i++) {
+      const unsigned int bone = (unsigned int)(i%BONES_PER_SKELETON);
+      const unsigned int parent = bone ? (unsigned int)i-1-std::rand()%std::min(bone, 4u) :
+        Star::transformHierarchyf::NONE;
+      Star::quaternionf q(randf()-0.5f, randf()-0.5f, randf()-0.5f, randf()-0.5f);
+      q.normalize();
+      hierarchy.addNode(parent, Star::float3(randf(), randf(), randf()), q, Star::float3(1, 1, 1));
+    }
+    hierarchy.update();
+  }
+
+  /*****************************************************************************/
+  void
+  moveSkeletons(Star::transformHierarchyf& hierarchy, size_t step)
+  {
+    const size_t numNodes = hierarchy.getNumNodes();
+    for(size_t i = 0; i < numNodes; i += step*BONES_PER_SKELETON)
+      hierarchy.setDirty((unsigned int)i);
+  }
+}
+
+namespace StarBench
+{
+  /*****************************************************************************/
+  void
+  registerHierarchyBenchmarks(Runner& runner)
+  {
+    //Local transform and parent read, world matrix written
+    const size_t nodeBytes = 10*sizeof(float)+sizeof(unsigned int)+16*sizeof(float);
+    const size_t sizes[] = { 10000, 100000, 1000000 };
+    for(size_t s = 0; s < sizeof(sizes)/sizeof(sizes[0]); s++) {
+      Star::transformHierarchyf hierarchy;
+      buildForest(hierarchy, sizes[s]);
+      const size_t n = sizes[s];
+      char suffix[32];
+      std::sprintf(suffix, "/%lu", (unsigned long)n);
+      const std::string size(suffix);
+
+      runner.run("hierarchy/update_all"+size, n, n*nodeBytes, [&]() {
+          moveSkeletons(hierarchy, 1);
+          hierarchy.update();
+        });
+      runner.run("hierarchy/update_parallel_all"+size, n, n*nodeBytes, [&]() {
+          moveSkeletons(hierarchy, 1);
+          hierarchy.updateParallel();
+        });
+      runner.run("hierarchy/update_1pct"+size, n/100, n/100*nodeBytes, [&]() {
+          moveSkeletons(hierarchy, 100);
+          hierarchy.update();
+        });
+      runner.run("hierarchy/update_parallel_1pct"+size, n/100, n/100*nodeBytes, [&]() {
+          moveSkeletons(hierarchy, 100);
+          hierarchy.updateParallel();
+        });
+    }
+  }
+}
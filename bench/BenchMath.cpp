@@ -0,0 +1,171 @@
+#include "StarBench.h"
+
+#include <StarMath.h>
+
+#include <cstdlib>
+#include <vector>
+
+/**
+ * Benchmarks of the basic types: each kernel loops over arrays of N values
+ * small enough to stay in the L2 cache, so they measure computation rather
+ * than memory bandwidth.
+ */
+
+namespace
+{
+  const size_t N = 1024;
+
+  float
+  randf()
+  {
+    return std::rand()/float(RAND_MAX)*2-1;
+  }
+
+  /*****************************************************************************/
+  struct Data
+  {
+    Data() : matA(N), matB(N), matOut(N), quatA(N), quatB(N), quatOut(N),
+             vecA(N), vecB(N), vecOut(N), scalars(N), scalarOut(N)
+    {
+      for(size_t i = 0; i < N; i++) {
+        Star::quaternionf q(randf(), randf(), randf(), randf());
+        q.normalize();
+        q.toRotationMatrix(matA[i]);
+        matA[i](0, 3) = randf();
+        matA[i](1, 3) = randf();
+        matA[i](2, 3) = randf();
+        for(size_t k = 0; k < 16; k++)
+          matB[i].ptr()[k] = randf();
+        quatA[i] = q;
+        quatB[i] = Star::quaternionf(randf(), randf(), randf(), randf());
+        quatB[i].normalize();
+        vecA[i] = Star::float3(randf(), randf(), randf())*10;
+        vecB[i] = Star::float3(randf(), randf(), randf());
+        scalars[i] = randf()*3.5f;
+      }
+    }
+
+    std::vector<Star::float4x4> matA, matB, matOut;
+    std::vector<Star::quaternionf> quatA, quatB, quatOut;
+    std::vector<Star::float3> vecA, vecB, vecOut;
+    std::vector<float> scalars, scalarOut;
+  };
+}
+
+namespace StarBench
+{
+  /*****************************************************************************/
+  void
+  registerMathBenchmarks(Runner& runner)
+  {
+    static Data d;
+    const size_t mat = sizeof(Star::float4x4);
+    const size_t quat = sizeof(Star::quaternionf);
+    const size_t vec = sizeof(Star::float3);
+
+    runner.run("matrix/multiply", N, N*3*mat, [&]() {
+        for(size_t i = 0; i < N; i++)
+          d.matOut[i] = d.matA[i]*d.matB[i];
+        doNotOptimize(d.matOut[0]);
+      });
+    runner.run("matrix/inverse", N, N*2*mat, [&]() {
+        for(size_t i = 0; i < N; i++)
+          d.matOut[i] = d.matA[i].inverse();
+        doNotOptimize(d.matOut[0]);
+      });
+    runner.run("matrix/inverse_fast", N, N*2*mat, [&]() {
+        for(size_t i = 0; i < N; i++)
+          d.matOut[i] = d.matA[i].inverse<Star::PRECISION_FAST>();
+        doNotOptimize(d.matOut[0]);
+      });
+    runner.run("matrix/inverse_batch", N, N*2*mat, [&]() {
+        Star::matrixInverse(&d.matA[0], &d.matOut[0], (float*)0, (bool*)0, N);
+        doNotOptimize(d.matOut[0]);
+      });
+    runner.run("matrix/inverse_kernel", N, N*2*mat, [&]() {
+        Star::Kernels::matrixInverse(&d.matA[0], &d.matOut[0], 0, 0, N);
+        doNotOptimize(d.matOut[0]);
+      });
+    runner.run("matrix/transpose", N, N*2*mat, [&]() {
+        for(size_t i = 0; i < N; i++)
+          d.matOut[i] = d.matA[i].transpose();
+        doNotOptimize(d.matOut[0]);
+      });
+    runner.run("matrix/transform_point", N, N*(mat+2*vec), [&]() {
+        for(size_t i = 0; i < N; i++)
+          d.vecOut[i] = d.matA[i]*d.vecA[i];
+        doNotOptimize(d.vecOut[0]);
+      });
+
+    runner.run("quaternion/multiply", N, N*3*quat, [&]() {
+        for(size_t i = 0; i < N; i++)
+          d.quatOut[i] = d.quatA[i]*d.quatB[i];
+        doNotOptimize(d.quatOut[0]);
+      });
+    runner.run("quaternion/rotate", N, N*(quat+2*vec), [&]() {
+        for(size_t i = 0; i < N; i++)
+          d.vecOut[i] = d.quatA[i].rotate(d.vecA[i]);
+        doNotOptimize(d.vecOut[0]);
+      });
+    runner.run("quaternion/rotate_batch", N, N*(quat+2*vec), [&]() {
+        Star::quaternionRotate(&d.quatA[0], &d.vecA[0], &d.vecOut[0], N);
+        doNotOptimize(d.vecOut[0]);
+      });
+    runner.run("quaternion/to_rotation_matrix", N, N*(quat+mat), [&]() {
+        for(size_t i = 0; i < N; i++)
+          d.quatA[i].toRotationMatrix(d.matOut[i]);
+        doNotOptimize(d.matOut[0]);
+      });
+
+    runner.run("vec3/normalize", N, N*2*vec, [&]() {
+        for(size_t i = 0; i < N; i++) {
+          d.vecOut[i] = d.vecA[i];
+          d.vecOut[i].normalize();
+        }
+        doNotOptimize(d.vecOut[0]);
+      });
+    runner.run("vec3/normalize_fast", N, N*2*vec, [&]() {
+        for(size_t i = 0; i < N; i++) {
+          d.vecOut[i] = d.vecA[i];
+          d.vecOut[i].normalize<Star::PRECISION_FAST>();
+        }
+        doNotOptimize(d.vecOut[0]);
+      });
+    runner.run("vec3/dot", N, N*2*vec, [&]() {
+        float sum = 0;
+        for(size_t i = 0; i < N; i++)
+          sum += d.vecA[i].dot(d.vecB[i]);
+        doNotOptimize(sum);
+      });
+    runner.run("vec3/cross", N, N*3*vec, [&]() {
+        for(size_t i = 0; i < N; i++)
+          d.vecOut[i] = d.vecA[i].cross(d.vecB[i]);
+        doNotOptimize(d.vecOut[0]);
+      });
+
+    runner.run("box/extends", N, N*vec, [&]() {
+        Star::Box<float> box;
+        for(size_t i = 0; i < N; i++)
+          box.extends(d.vecA[i]);
+        doNotOptimize(box);
+      });
+    runner.run("box/contains", N, N*vec, [&]() {
+        Star::Box<float> box(Star::float3(-5, -5, -5), Star::float3(5, 5, 5));
+        size_t count = 0;
+        for(size_t i = 0; i < N; i++)
+          count += box.contains(d.vecA[i]);
+        doNotOptimize(count);
+      });
+
+    runner.run("utils/lanczos2", N, N*2*sizeof(float), [&]() {
+        for(size_t i = 0; i < N; i++)
+          d.scalarOut[i] = Star::lanczos2(d.scalars[i]);
+        doNotOptimize(d.scalarOut[0]);
+      });
+    runner.run("utils/lanczos3", N, N*2*sizeof(float), [&]() {
+        for(size_t i = 0; i < N; i++)
+          d.scalarOut[i] = Star::lanczos3(d.scalars[i]);
+        doNotOptimize(d.scalarOut[0]);
+      });
+  }
+}
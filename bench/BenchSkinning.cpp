@@ -0,0 +1,152 @@
+#include "StarBench.h"
+
+#include <StarMath.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+/**
+ * Skinning throughput in vertices per second: the naive loop transforming
+ * each vertex by each of its bone Matrix<float>, linear blend skinning with
+ * Matrix<float> and 3x4 palettes, and dual quaternion skinning, both also
+ * with the instruction set dispatched Kernels.
+ */
+
+namespace
+{
+  const size_t NUM_BONES = 64;
+  const unsigned int BONES_PER_VERTEX = 4;
+
+  float
+  randf()
+  {
+    return std::rand()/float(RAND_MAX);
+  }
+
+  /*****************************************************************************/
+  struct Mesh
+  {
+    Mesh(size_t n) : numVertices(n)
+    {
+      for(size_t c = 0; c < 3; c++) {
+        pos[c].resize(n);
+        nrm[c].resize(n);
+        outPos[c].resize(n);
+        outNrm[c].resize(n);
+      }
+      for(size_t b = 0; b < BONES_PER_VERTEX; b++) {
+        weights[b].resize(n);
+        indices[b].resize(n);
+      }
+      for(size_t i = 0; i < n; i++) {
+        float sum = 0;
+        for(size_t c = 0; c < 3; c++) {
+          pos[c][i] = randf()*10;
+          nrm[c][i] = randf()-0.5f;
+        }
+        for(size_t b = 0; b < BONES_PER_VERTEX; b++) {
+          indices[b][i] = std::rand()%NUM_BONES;
+          weights[b][i] = randf();
+          sum += weights[b][i];
+        }
+        for(size_t b = 0; b < BONES_PER_VERTEX; b++)
+          weights[b][i] /= sum;
+      }
+    }
+
+    Star::BoneInfluenceSoA<float> influences() const
+    {
+      const float* w[BONES_PER_VERTEX];
+      const unsigned int* idx[BONES_PER_VERTEX];
+      for(size_t b = 0; b < BONES_PER_VERTEX; b++) {
+        w[b] = &weights[b][0];
+        idx[b] = &indices[b][0];
+      }
+      return Star::BoneInfluenceSoA<float>(w, idx, BONES_PER_VERTEX);
+    }
+
+    Star::Vec3SoA<const float> positions() const { return Star::Vec3SoA<const float>(&pos[0][0], &pos[1][0], &pos[2][0]); }
+    Star::Vec3SoA<const float> normals() const { return Star::Vec3SoA<const float>(&nrm[0][0], &nrm[1][0], &nrm[2][0]); }
+    Star::Vec3SoA<float> outPositions() { return Star::Vec3SoA<float>(&outPos[0][0], &outPos[1][0], &outPos[2][0]); }
+    Star::Vec3SoA<float> outNormals() { return Star::Vec3SoA<float>(&outNrm[0][0], &outNrm[1][0], &outNrm[2][0]); }
+
+    size_t numVertices;
+    std::vector<float> pos[3], nrm[3], outPos[3], outNrm[3];
+    std::vector<float> weights[BONES_PER_VERTEX];
+    std::vector<unsigned int> indices[BONES_PER_VERTEX];
+  };
+
+  /*****************************************************************************/
+  void
+  skinNaive(const Star::float4x4* palette, Mesh& mesh)
+  {
+    for(size_t i = 0; i < mesh.numVertices; i++) {
+      Star::float3 p(mesh.pos[0][i], mesh.pos[1][i], mesh.pos[2][i]);
+      Star::float3 res(0, 0, 0);
+      for(size_t b = 0; b < BONES_PER_VERTEX; b++)
+        res += (palette[mesh.indices[b][i]]*p)*mesh.weights[b][i];
+      mesh.outPos[0][i] = res.x;
+      mesh.outPos[1][i] = res.y;
+      mesh.outPos[2][i] = res.z;
+    }
+  }
+}
+
+namespace StarBench
+{
+  /*****************************************************************************/
+  void
+  registerSkinningBenchmarks(Runner& runner)
+  {
+    std::vector<Star::float4x4> matrices(NUM_BONES);
+    std::vector<float> palette(NUM_BONES*12);
+    std::vector<Star::dualQuaternionf> dualQuaternions(NUM_BONES);
+    for(size_t b = 0; b < NUM_BONES; b++) {
+      Star::quaternionf q(randf()-0.5f, randf()-0.5f, randf()-0.5f, randf()-0.5f);
+      q.normalize();
+      dualQuaternions[b] = Star::dualQuaternionf(q, Star::float3(randf(), randf(), randf()));
+      dualQuaternions[b].toRigidMatrix(matrices[b]);
+      std::copy(matrices[b].constPtr(), matrices[b].constPtr()+12, &palette[b*12]);
+    }
+
+    //Bind pose, influences and skinned output
+    const size_t vertexBytes = 3*sizeof(float)+BONES_PER_VERTEX*(sizeof(float)+sizeof(unsigned int))+3*sizeof(float);
+    const size_t sizes[] = { 10000, 100000, 1000000 };
+    for(size_t s = 0; s < sizeof(sizes)/sizeof(sizes[0]); s++) {
+      Mesh mesh(sizes[s]);
+      const size_t n = mesh.numVertices;
+      char suffix[32];
+      std::sprintf(suffix, "/%lu", (unsigned long)n);
+      const std::string size(suffix);
+
+      runner.run("skinning/naive_positions"+size, n, n*vertexBytes, [&]() { skinNaive(&matrices[0], mesh); });
+      runner.run("skinning/lbs_positions"+size, n, n*vertexBytes, [&]() {
+          Star::linearBlendSkin(&palette[0], 12, mesh.influences(), mesh.positions(),
+                                Star::Vec3SoA<const float>(), mesh.outPositions(), Star::Vec3SoA<float>(), n);
+        });
+      runner.run("skinning/lbs_matrix_palette"+size, n, n*(vertexBytes+6*sizeof(float)), [&]() {
+          Star::linearBlendSkin(&matrices[0], mesh.influences(), mesh.positions(), mesh.normals(),
+                                mesh.outPositions(), mesh.outNormals(), n);
+        });
+      runner.run("skinning/lbs_positions_normals"+size, n, n*(vertexBytes+6*sizeof(float)), [&]() {
+          Star::linearBlendSkin(&palette[0], 12, mesh.influences(), mesh.positions(), mesh.normals(),
+                                mesh.outPositions(), mesh.outNormals(), n);
+        });
+      runner.run("skinning/dqs_positions_normals"+size, n, n*(vertexBytes+6*sizeof(float)), [&]() {
+          Star::dualQuaternionSkin(&dualQuaternions[0], mesh.influences(), mesh.positions(), mesh.normals(),
+                                   mesh.outPositions(), mesh.outNormals(), n);
+        });
+      runner.run("skinning/lbs_kernels_positions_normals"+size, n, n*(vertexBytes+6*sizeof(float)), [&]() {
+          Star::Kernels::linearBlendSkin(&palette[0], 12, mesh.influences(), mesh.positions(), mesh.normals(),
+                                         mesh.outPositions(), mesh.outNormals(), n);
+        });
+      runner.run("skinning/dqs_kernels_positions_normals"+size, n, n*(vertexBytes+6*sizeof(float)), [&]() {
+          Star::Kernels::dualQuaternionSkin(&dualQuaternions[0], mesh.influences(), mesh.positions(), mesh.normals(),
+                                            mesh.outPositions(), mesh.outNormals(), n);
+        });
+    }
+  }
+}
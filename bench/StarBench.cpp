@@ -0,0 +1,223 @@
+#include "StarBench.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+/**
+ * StarMath micro-benchmarks. Build with optimizations
+ * (CMAKE_BUILD_TYPE=Release) and run:
+ *
+ *   starmath_bench [--filter text] [--samples n] [--quick] [--counters] [--json file]
+ *
+ * --json writes the results so that two releases can be compared.
+ * --counters adds hardware counters, see PerfCounters.
+ */
+
+namespace StarBench
+{
+  /*****************************************************************************/
+  double
+  Result::percentile(double p) const
+  {
+    if(samples.empty())
+      return 0;
+    //Linear interpolation between the closest ranks
+    double rank = p*(samples.size()-1);
+    size_t low = size_t(rank);
+    size_t high = std::min(low+1, samples.size()-1);
+    return samples[low]+(rank-low)*(samples[high]-samples[low]);
+  }
+
+  /*****************************************************************************/
+  double
+  Result::instructionsPerCycle() const
+  {
+    if(counters[PerfCounters::INSTRUCTIONS] < 0 || counters[PerfCounters::CYCLES] <= 0)
+      return -1;
+    return counters[PerfCounters::INSTRUCTIONS]/counters[PerfCounters::CYCLES];
+  }
+
+  /*****************************************************************************/
+  double
+  Result::bytesPerCycle() const
+  {
+    if(!bytesPerCall || counters[PerfCounters::CYCLES] <= 0)
+      return -1;
+    return double(bytesPerCall)/opsPerCall/counters[PerfCounters::CYCLES];
+  }
+
+  /*****************************************************************************/
+  Runner::Runner() : m_numSamples(21), m_numWarmups(3), m_minSampleTime(2e-3)
+  {
+  }
+
+  /*****************************************************************************/
+  bool
+  Runner::enableCounters()
+  {
+    m_counters.reset(new PerfCounters);
+    if(!m_counters->isAnyAvailable()) {
+      std::fprintf(stderr, "No hardware counter available (%s), reporting timings only\n",
+                   m_counters->getError().c_str());
+      m_counters.reset();
+      return false;
+    }
+
+    for(int c = 0; c < PerfCounters::NUM_COUNTERS; c++)
+      if(!m_counters->isAvailable(PerfCounters::Counter(c)))
+        std::fprintf(stderr, "Counter %s not available\n", PerfCounters::getName(PerfCounters::Counter(c)));
+    return true;
+  }
+
+  /*****************************************************************************/
+  double
+  Runner::timeCalls(Kernel& kernel, size_t numCalls) const
+  {
+    Clock::time_point start = Clock::now();
+    for(size_t c = 0; c < numCalls; c++)
+      kernel();
+    std::chrono::duration<double> elapsed = Clock::now()-start;
+    return elapsed.count();
+  }
+
+  /*****************************************************************************/
+  void
+  Runner::run(const std::string& name, size_t opsPerCall, size_t bytesPerCall, Kernel kernel)
+  {
+    if(!m_filter.empty() && name.find(m_filter) == std::string::npos)
+      return;
+
+    for(size_t w = 0; w < m_numWarmups; w++)
+      kernel();
+
+    //Double the calls per sample until a sample is long enough for the
+    //clock resolution
+    size_t numCalls = 1;
+    while(timeCalls(kernel, numCalls) < m_minSampleTime && numCalls < (size_t(1) << 30))
+      numCalls *= 2;
+
+    Result res;
+    res.name = name;
+    res.opsPerCall = opsPerCall;
+    res.bytesPerCall = bytesPerCall;
+    res.callsPerSample = numCalls;
+    for(int c = 0; c < PerfCounters::NUM_COUNTERS; c++)
+      res.counters[c] = m_counters && m_counters->isAvailable(PerfCounters::Counter(c)) ? 0 : -1;
+
+    for(size_t s = 0; s < m_numSamples; s++) {
+      if(m_counters)
+        m_counters->start();
+      double seconds = timeCalls(kernel, numCalls);
+      if(m_counters) {
+        m_counters->stop();
+        for(int c = 0; c < PerfCounters::NUM_COUNTERS; c++)
+          if(res.counters[c] >= 0)
+            res.counters[c] += m_counters->getValue(PerfCounters::Counter(c));
+      }
+      res.samples.push_back(seconds*1e9/(double(numCalls)*opsPerCall));
+    }
+    std::sort(res.samples.begin(), res.samples.end());
+
+    const double totalOps = double(m_numSamples)*numCalls*opsPerCall;
+    for(int c = 0; c < PerfCounters::NUM_COUNTERS; c++)
+      if(res.counters[c] >= 0)
+        res.counters[c] /= totalOps;
+
+    std::printf("%-44s %10.3f ns/op  [p10 %8.3f, p90 %8.3f] %10.2f Mops/s\n", name.c_str(),
+                res.median(), res.percentile(0.1), res.percentile(0.9), res.opsPerSecond()*1e-6);
+    if(m_counters) {
+      std::printf("%-44s", "");
+      if(res.instructionsPerCycle() >= 0)
+        std::printf(" IPC %.2f", res.instructionsPerCycle());
+      if(res.bytesPerCycle() >= 0)
+        std::printf(" bytes/cycle %.2f", res.bytesPerCycle());
+      for(int c = 0; c < PerfCounters::NUM_COUNTERS; c++)
+        if(res.counters[c] >= 0)
+          std::printf(" %s/op %.3g", PerfCounters::getName(PerfCounters::Counter(c)), res.counters[c]);
+      std::printf("\n");
+    }
+    std::fflush(stdout);
+    m_results.push_back(res);
+  }
+
+  /*****************************************************************************/
+  bool
+  Runner::writeJson(const std::string& path) const
+  {
+    FILE* f = std::fopen(path.c_str(), "w");
+    if(!f)
+      return false;
+
+    std::fprintf(f, "{\n  \"context\": {\n");
+#if defined(__VERSION__)
+    std::fprintf(f, "    \"compiler\": \"%s\",\n", __VERSION__);
+#endif
+    std::fprintf(f, "    \"samples\": %lu,\n", (unsigned long)m_numSamples);
+    std::fprintf(f, "    \"min_sample_time\": %g\n  },\n", m_minSampleTime);
+    std::fprintf(f, "  \"benchmarks\": [");
+    for(size_t i = 0; i < m_results.size(); i++) {
+      const Result& r = m_results[i];
+      std::fprintf(f, "%s\n    {\n", i ? "," : "");
+      std::fprintf(f, "      \"name\": \"%s\",\n", r.name.c_str());
+      std::fprintf(f, "      \"ops_per_call\": %lu,\n", (unsigned long)r.opsPerCall);
+      std::fprintf(f, "      \"calls_per_sample\": %lu,\n", (unsigned long)r.callsPerSample);
+      std::fprintf(f, "      \"ns_per_op\": %.6g,\n", r.median());
+      std::fprintf(f, "      \"ns_per_op_min\": %.6g,\n", r.samples.front());
+      std::fprintf(f, "      \"ns_per_op_p10\": %.6g,\n", r.percentile(0.1));
+      std::fprintf(f, "      \"ns_per_op_p90\": %.6g,\n", r.percentile(0.9));
+      std::fprintf(f, "      \"ns_per_op_max\": %.6g,\n", r.samples.back());
+      if(r.bytesPerCall)
+        std::fprintf(f, "      \"bytes_per_op\": %.6g,\n", double(r.bytesPerCall)/r.opsPerCall);
+      for(int c = 0; c < PerfCounters::NUM_COUNTERS; c++)
+        if(r.counters[c] >= 0)
+          std::fprintf(f, "      \"%s_per_op\": %.6g,\n", PerfCounters::getName(PerfCounters::Counter(c)), r.counters[c]);
+      if(r.instructionsPerCycle() >= 0)
+        std::fprintf(f, "      \"ipc\": %.6g,\n", r.instructionsPerCycle());
+      if(r.bytesPerCycle() >= 0)
+        std::fprintf(f, "      \"bytes_per_cycle\": %.6g,\n", r.bytesPerCycle());
+      std::fprintf(f, "      \"ops_per_second\": %.6g\n    }", r.opsPerSecond());
+    }
+    std::fprintf(f, "\n  ]\n}\n");
+
+    return std::fclose(f) == 0;
+  }
+}
+
+/*****************************************************************************/
+int
+main(int argc, char** argv)
+{
+  StarBench::Runner runner;
+  const char* jsonPath = 0;
+  for(int i = 1; i < argc; i++) {
+    if(!std::strcmp(argv[i], "--filter") && i+1 < argc)
+      runner.setFilter(argv[++i]);
+    else if(!std::strcmp(argv[i], "--samples") && i+1 < argc)
+      runner.setNumSamples(std::max(1, std::atoi(argv[++i])));
+    else if(!std::strcmp(argv[i], "--json") && i+1 < argc)
+      jsonPath = argv[++i];
+    else if(!std::strcmp(argv[i], "--counters"))
+      runner.enableCounters();
+    else if(!std::strcmp(argv[i], "--quick")) {
+      runner.setNumSamples(5);
+      runner.setMinSampleTime(5e-4);
+    }
+    else {
+      std::fprintf(stderr, "usage: %s [--filter text] [--samples n] [--quick] [--counters] [--json file]\n", argv[0]);
+      return 1;
+    }
+  }
+
+  StarBench::registerMathBenchmarks(runner);
+  StarBench::registerSkinningBenchmarks(runner);
+  StarBench::registerHierarchyBenchmarks(runner);
+
+  if(jsonPath && !runner.writeJson(jsonPath)) {
+    std::fprintf(stderr, "Cannot write %s\n", jsonPath);
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,124 @@
+#ifndef STAR_BENCH_H
+#define STAR_BENCH_H
+
+#include "StarPerfCounters.h"
+
+#include <cstddef>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace StarBench
+{
+  /**
+   * Keep the compiler from optimizing a value away.
+   */
+  template<typename T>
+  inline void
+  doNotOptimize(const T& value)
+  {
+#if defined(__GNUC__)
+    asm volatile("" : : "g"(&value) : "memory");
+#else
+    volatile const char* p = reinterpret_cast<volatile const char*>(&value);
+    (void)*p;
+#endif
+  }
+
+  /**
+   * Timings of one benchmark. A sample times several calls of the kernel,
+   * each doing opsPerCall operations.
+   */
+  struct Result
+  {
+    std::string name;
+    size_t opsPerCall;
+    size_t bytesPerCall;
+    size_t callsPerSample;
+
+    //Nanoseconds per operation of each sample, sorted
+    std::vector<double> samples;
+
+    //Hardware counters per operation over all the samples, negative when
+    //not available
+    double counters[PerfCounters::NUM_COUNTERS];
+
+    double percentile(double p) const;
+    double median() const { return percentile(0.5); }
+    double opsPerSecond() const { return 1e9/median(); }
+    double instructionsPerCycle() const;
+    double bytesPerCycle() const;
+  };
+
+  /**
+   * Run benchmarks and report their timings.
+   *
+   * Each benchmark is called a few times to warm up caches and the branch
+   * predictors, then the number of calls per sample is chosen so that a
+   * sample lasts at least minSampleTime, and numSamples samples are taken.
+   * The median and percentiles of the samples are reported, which are far
+   * less sensitive to interruptions than the mean.
+   */
+  class Runner
+  {
+  public:
+    typedef std::function<void()> Kernel;
+
+    Runner();
+
+    /**
+     * Only run the benchmarks whose name contains filter.
+     */
+    void setFilter(const std::string& filter) { m_filter = filter; }
+
+    void setNumSamples(size_t numSamples) { m_numSamples = numSamples; }
+    void setNumWarmups(size_t numWarmups) { m_numWarmups = numWarmups; }
+    void setMinSampleTime(double seconds) { m_minSampleTime = seconds; }
+
+    /**
+     * Read hardware counters during the samples. When no counter can be
+     * opened a warning is printed and only timings are reported.
+     * @return true if at least one counter is available
+     */
+    bool enableCounters();
+
+    /**
+     * Time a kernel and print its result.
+     * @param name unique name, "group/kernel/size"
+     * @param opsPerCall number of operations done by a call
+     * @param bytesPerCall bytes read and written by a call, 0 if unknown
+     */
+    void run(const std::string& name, size_t opsPerCall, size_t bytesPerCall, Kernel kernel);
+
+    const std::vector<Result>& getResults() const { return m_results; }
+
+    /**
+     * Write the results as JSON.
+     * @return false if the file could not be written
+     */
+    bool writeJson(const std::string& path) const;
+
+  private:
+    typedef std::chrono::steady_clock Clock;
+
+    double timeCalls(Kernel& kernel, size_t numCalls) const;
+
+    std::string m_filter;
+    size_t m_numSamples;
+    size_t m_numWarmups;
+    double m_minSampleTime;
+    std::vector<Result> m_results;
+    std::unique_ptr<PerfCounters> m_counters;
+  };
+
+  /**
+   * Benchmarks of each group, defined in Bench*.cpp.
+   */
+  void registerMathBenchmarks(Runner& runner);
+  void registerSkinningBenchmarks(Runner& runner);
+  void registerHierarchyBenchmarks(Runner& runner);
+}
+
+#endif
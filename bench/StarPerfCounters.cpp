@@ -0,0 +1,146 @@
+#include "StarPerfCounters.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__) && (defined(__x86_64__) || defined(__i386__))
+#include <cpuid.h>
+#endif
+
+namespace StarBench
+{
+#if defined(__linux__)
+  namespace
+  {
+    int
+    openCounter(uint32_t type, uint64_t config)
+    {
+      perf_event_attr attr;
+      std::memset(&attr, 0, sizeof(attr));
+      attr.size = sizeof(attr);
+      attr.type = type;
+      attr.config = config;
+      attr.disabled = 1;
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+      return int(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+    }
+
+    /**
+     * Raw event counting the packed floating point instructions, 0 if
+     * unknown.
+     */
+    uint64_t
+    vectorEvent()
+    {
+      if(const char* env = std::getenv("STARMATH_PERF_VECTOR_EVENT"))
+        return std::strtoull(env, 0, 16);
+
+#if defined(__x86_64__) || defined(__i386__)
+      unsigned int eax, ebx, ecx, edx;
+      if(__get_cpuid(0, &eax, &ebx, &ecx, &edx) && ebx == 0x756e6547 && edx == 0x49656e69 && ecx == 0x6c65746e) {
+        //GenuineIntel, FP_ARITH_INST_RETIRED: event 0xc7, umasks of the
+        //128, 256 and 512-bit packed instructions
+        return 0xfcc7;
+      }
+#endif
+      return 0;
+    }
+  }
+#endif
+
+  /*****************************************************************************/
+  PerfCounters::PerfCounters()
+  {
+    for(int c = 0; c < NUM_COUNTERS; c++) {
+      m_fds[c] = -1;
+      m_values[c] = 0;
+    }
+
+#if defined(__linux__)
+    m_fds[CYCLES] = openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+    if(m_fds[CYCLES] < 0)
+      m_error = std::string("perf_event_open: ")+std::strerror(errno);
+    m_fds[INSTRUCTIONS] = openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+    m_fds[CACHE_MISSES] = openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+    m_fds[BRANCH_MISSES] = openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+    if(uint64_t event = vectorEvent())
+      m_fds[VECTOR_INSTRUCTIONS] = openCounter(PERF_TYPE_RAW, event);
+#else
+    m_error = "performance counters need Linux";
+#endif
+  }
+
+  /*****************************************************************************/
+  PerfCounters::~PerfCounters()
+  {
+#if defined(__linux__)
+    for(int c = 0; c < NUM_COUNTERS; c++)
+      if(m_fds[c] >= 0)
+        close(m_fds[c]);
+#endif
+  }
+
+  /*****************************************************************************/
+  bool
+  PerfCounters::isAnyAvailable() const
+  {
+    for(int c = 0; c < NUM_COUNTERS; c++)
+      if(m_fds[c] >= 0)
+        return true;
+    return false;
+  }
+
+  /*****************************************************************************/
+  void
+  PerfCounters::start()
+  {
+#if defined(__linux__)
+    for(int c = 0; c < NUM_COUNTERS; c++)
+      if(m_fds[c] >= 0) {
+        ioctl(m_fds[c], PERF_EVENT_IOC_RESET, 0);
+        ioctl(m_fds[c], PERF_EVENT_IOC_ENABLE, 0);
+      }
+#endif
+  }
+
+  /*****************************************************************************/
+  void
+  PerfCounters::stop()
+  {
+#if defined(__linux__)
+    for(int c = 0; c < NUM_COUNTERS; c++)
+      if(m_fds[c] >= 0)
+        ioctl(m_fds[c], PERF_EVENT_IOC_DISABLE, 0);
+
+    for(int c = 0; c < NUM_COUNTERS; c++) {
+      m_values[c] = 0;
+      //Value, time enabled and time running
+      uint64_t data[3];
+      if(m_fds[c] < 0 || read(m_fds[c], data, sizeof(data)) != ssize_t(sizeof(data)))
+        continue;
+      //Scale the counters the kernel multiplexed
+      m_values[c] = data[2] ? double(data[0])*double(data[1])/double(data[2]) : 0;
+    }
+#endif
+  }
+
+  /*****************************************************************************/
+  const char*
+  PerfCounters::getName(Counter c)
+  {
+    static const char* names[NUM_COUNTERS] = {
+      "cycles", "instructions", "cache_misses", "branch_misses", "vector_instructions"
+    };
+    return names[c];
+  }
+}
@@ -0,0 +1,83 @@
+#ifndef STAR_PERF_COUNTERS_H
+#define STAR_PERF_COUNTERS_H
+
+#include <cstddef>
+#include <stdint.h>
+#include <string>
+
+namespace StarBench
+{
+  /**
+   * Hardware performance counters read with Linux perf_event_open, for the
+   * current thread and user space only.
+   *
+   * Each counter is opened separately, so the ones the CPU or the
+   * permissions (kernel.perf_event_paranoid) don't allow are just missing.
+   * Counters multiplexed by the kernel are scaled to the whole run.
+   *
+   * There is no portable event for vector instructions. On Intel CPUs
+   * FP_ARITH_INST_RETIRED with the packed umasks is used, another raw event
+   * can be given as hexadecimal in STARMATH_PERF_VECTOR_EVENT.
+   */
+  class PerfCounters
+  {
+  public:
+    enum Counter
+    {
+      CYCLES,
+      INSTRUCTIONS,
+      CACHE_MISSES,
+      BRANCH_MISSES,
+      VECTOR_INSTRUCTIONS,
+      NUM_COUNTERS
+    };
+
+    /**
+     * Open the counters, disabled.
+     */
+    PerfCounters();
+    ~PerfCounters();
+
+    /**
+     * Check if a counter could be opened.
+     */
+    bool isAvailable(Counter c) const { return m_fds[c] >= 0; }
+
+    /**
+     * Check if at least one counter could be opened.
+     */
+    bool isAnyAvailable() const;
+
+    /**
+     * Get the reason why the cycle counter is missing, empty if it is not.
+     */
+    const std::string& getError() const { return m_error; }
+
+    /**
+     * Reset and start the counters.
+     */
+    void start();
+
+    /**
+     * Stop the counters and read them.
+     */
+    void stop();
+
+    /**
+     * Get the value of a counter between the last start and stop.
+     */
+    double getValue(Counter c) const { return m_values[c]; }
+
+    static const char* getName(Counter c);
+
+  private:
+    PerfCounters(const PerfCounters&);
+    PerfCounters& operator = (const PerfCounters&);
+
+    int m_fds[NUM_COUNTERS];
+    double m_values[NUM_COUNTERS];
+    std::string m_error;
+  };
+}
+
+#endif
@@ -0,0 +1,19 @@
+# Fail if one of the OBJECTS defines a weak function, run with
+#   cmake -DNM=<nm> -DOBJECTS=<objects> -P CheckWeakSymbols.cmake
+# The kernel sources are compiled with the AVX2 and AVX-512 flags. An
+# inline function of a header they emit out of line, e.g. at -O0, is a weak
+# symbol the linker can pick for the whole program, which then crashes on
+# the processors without these instructions.
+foreach(object ${OBJECTS})
+  execute_process(COMMAND ${NM} -C --defined-only ${object}
+                  OUTPUT_VARIABLE symbols RESULT_VARIABLE result)
+  if(NOT result EQUAL 0)
+    message(FATAL_ERROR "${NM} failed on ${object}")
+  endif(NOT result EQUAL 0)
+  string(REGEX MATCHALL "[^\n]* [Ww] [^\n]*" weak "${symbols}")
+  if(weak)
+    string(REPLACE ";" "\n" weak "${weak}")
+    message(FATAL_ERROR "${object} defines weak functions:\n${weak}")
+  endif(weak)
+  message(STATUS "${object}: no weak function")
+endforeach(object)
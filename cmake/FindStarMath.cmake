@@ -21,3 +21,19 @@ set(STARMATH_LIB_FOUND "NO")
 if(STARMATH_LIB)
 	set(STARMATH_LIB_FOUND "YES")
 endif(STARMATH_LIB)
+
+# The headers inline the PRECISION_STRICT functions in the code using them,
+# compile it with STARMATH_CXX_FLAGS so their multiply-adds are not fused
+set(STARMATH_CXX_FLAGS "")
+if(CMAKE_CXX_COMPILER_ID MATCHES "GNU|Clang")
+	set(STARMATH_CXX_FLAGS "-ffp-contract=off")
+endif(CMAKE_CXX_COMPILER_ID MATCHES "GNU|Clang")
+
+# The STARMATH_INSTRUMENT and STARMATH_PRECISION options change the code
+# inlined from the headers, set them as the library was built with
+if(STARMATH_INSTRUMENT)
+	set(STARMATH_CXX_FLAGS "${STARMATH_CXX_FLAGS} -DSTARMATH_INSTRUMENT")
+endif(STARMATH_INSTRUMENT)
+if(STARMATH_PRECISION AND NOT STARMATH_PRECISION STREQUAL "STRICT")
+	set(STARMATH_CXX_FLAGS "${STARMATH_CXX_FLAGS} -DSTARMATH_PRECISION=Star::PRECISION_${STARMATH_PRECISION}")
+endif(STARMATH_PRECISION AND NOT STARMATH_PRECISION STREQUAL "STRICT")
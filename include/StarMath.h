@@ -4,11 +4,29 @@
 #include <StarMath/StarVec2.h>
 #include <StarMath/StarVec3.h>
 #include <StarMath/StarVec4.h>
+#include <StarMath/StarSoA.h>
 #include <StarMath/StarMatrix.h>
 #include <StarMath/StarMatrix2.h>
 #include <StarMath/StarQuaternion.h>
+#include <StarMath/StarQuaternionBatch.h>
 #include <StarMath/StarPlane.h>
 #include <StarMath/StarUtils.h>
 #include <StarMath/StarBox.h>
+#include <StarMath/StarBoxSimd.h>
+#include <StarMath/StarKdTree.h>
+#include <StarMath/StarOctree.h>
+#include <StarMath/StarBroadphase.h>
+#include <StarMath/StarClipper.h>
+#include <StarMath/StarDualQuaternion.h>
+#include <StarMath/StarSkinning.h>
+#include <StarMath/StarQuaternionCodec.h>
+#include <StarMath/StarTransformHierarchy.h>
+#include <StarMath/StarCachedTransform.h>
+#include <StarMath/StarInstrument.h>
+#include <StarMath/StarKernels.h>
+#include <StarMath/StarVec.h>
+#include <StarMath/StarMat.h>
+#include <StarMath/StarPrecision.h>
+#include <StarMath/StarMatrixBatch.h>
 
 #endif
@@ -3,6 +3,7 @@
 
 #include <StarMath/StarVec3.h>
 
+#include <iosfwd>
 #include <limits>
 #include <algorithm>
 #include <vector>
@@ -76,6 +77,14 @@ namespace Star
      */
     inline bool contains(const Vec3<T>& pos) const;
 
+    /**
+     * Check for overlap with another box. Boxes are half-open like in
+     * contains(), so boxes that only touch do not intersect. See
+     * boxIntersects in StarBoxSimd.h for a SIMD version.
+     * @return true if the interiors of the two boxes overlap
+     */
+    inline bool intersects(const Box<T>& b) const;
+
     /**
      * Return indexed vertices representation of the box
      */
@@ -168,6 +177,16 @@ namespace Star
     return true;
   }
 
+  /*******************************************************************************/
+  template<typename T>
+  bool
+  Box<T>::intersects(const Box<T>& b) const
+  {
+    return m_min[0] < b.m_max[0] && b.m_min[0] < m_max[0] &&
+           m_min[1] < b.m_max[1] && b.m_min[1] < m_max[1] &&
+           m_min[2] < b.m_max[2] && b.m_min[2] < m_max[2];
+  }
+
   /*******************************************************************************/
   template<typename T>
   void
@@ -197,16 +216,21 @@ namespace Star
                            6, 3, 7 };
     indices.assign(idx, idx+sizeof(idx)/sizeof(idx[0]));
   }
+
+/*****************************************************************************/
+#ifndef STARMATH_NO_EXTERN_TEMPLATES
+  //Instantiated once in the StarMath library, see StarMath.cpp
+  extern template class Box<float>;
+  extern template class Box<double>;
+  extern template class Box<int>;
+#endif
 }
 
 /**
- * ostream operator for vectors
+ * ostream operator for boxes, defined in StarStream.h
  */
 template <typename T>
 std::ostream&
-operator << (std::ostream& os, const Star::Box<T>& b)
-{
-  return os << "(" << b.getMin() << " - " << b.getMax() << ")";
-}
+operator << (std::ostream& os, const Star::Box<T>& b);
 
 #endif
@@ -0,0 +1,35 @@
+#ifndef STAR_BOX_SIMD_H
+#define STAR_BOX_SIMD_H
+
+#include <StarMath/StarBox.h>
+#include <StarMath/StarSimd.h>
+
+namespace Star
+{
+  /*******************************************************************************/
+  /**
+   * Box<float>::intersects with the three axes compared at once in a
+   * simd::pack<float, 4>, whose last lane repeats z. Kept out of StarBox.h
+   * so that including it does not pull in StarSimd.h.
+   * @return true if the interiors of the half-open boxes overlap
+   */
+  inline bool
+  boxIntersects(const Box<float>& a, const Box<float>& b)
+  {
+    typedef simd::pack<float, 4> float4v;
+    const Vec3<float>& aMin = a.getMin();
+    const Vec3<float>& aMax = a.getMax();
+    const Vec3<float>& bMin = b.getMin();
+    const Vec3<float>& bMax = b.getMax();
+    const float mins[2][4] = { { aMin[0], aMin[1], aMin[2], aMin[2] },
+                               { bMin[0], bMin[1], bMin[2], bMin[2] } };
+    const float maxs[2][4] = { { bMax[0], bMax[1], bMax[2], bMax[2] },
+                               { aMax[0], aMax[1], aMax[2], aMax[2] } };
+    const float4v::Mask overlap =
+      (float4v::loadu(mins[0]) < float4v::loadu(maxs[0])) &
+      (float4v::loadu(mins[1]) < float4v::loadu(maxs[1]));
+    return overlap.getBits() == 0xf;
+  }
+}
+
+#endif
@@ -0,0 +1,302 @@
+#ifndef STAR_BROADPHASE_H
+#define STAR_BROADPHASE_H
+
+#include <StarMath/StarVec3.h>
+#include <StarMath/StarBox.h>
+#include <StarMath/StarSimd.h>
+
+#include <cstddef>
+#include <limits>
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+namespace Star
+{
+  /**
+   * Incremental sweep-and-prune broadphase.
+   *
+   * Boxes are kept sorted by their min along the axis where their centers
+   * spread the most. Between two updates objects move a little, so the
+   * previous order is almost sorted and an insertion sort restores it in
+   * close to linear time. The sweep then tests each box against the
+   * following ones until their min passes its max, 4 at a time with
+   * simd::pack for float boxes.
+   *
+   * Boxes follow the Box convention: min is included but not max, so boxes
+   * that only touch do not overlap.
+   */
+  template<typename T>
+  class SweepAndPrune
+  {
+  public:
+    /**
+     * An overlapping pair of box indices, first < second.
+     */
+    typedef std::pair<unsigned int, unsigned int> Pair;
+
+    /**
+     * Create an empty broadphase.
+     */
+    SweepAndPrune();
+
+    /**
+     * Update the boxes and find all the overlapping pairs.
+     * The box count may change between two updates, the sort is then
+     * restarted from scratch.
+     * @param boxes the boxes of this step
+     * @param numBoxes the number of boxes
+     * @param pairs receives at most maxPairs overlapping pairs
+     * @param maxPairs the capacity of pairs
+     * @return the number of overlapping pairs, which may be larger than
+     * maxPairs
+     */
+    size_t update(const Box<T>* boxes, size_t numBoxes, Pair* pairs, size_t maxPairs);
+
+    /**
+     * Get the current sweep axis.
+     */
+    inline unsigned int getAxis() const;
+
+    /**
+     * Get the number of swaps done by the last insertion sort.
+     */
+    inline size_t getNumSwaps() const;
+
+  private:
+    /**
+     * Sweep axis changes only if another axis spreads this much more.
+     */
+    static T axisHysteresis() { return T(1.2); }
+
+    void chooseAxis(const Box<T>* boxes, size_t numBoxes);
+    void sort(const Box<T>* boxes, size_t numBoxes, bool incremental);
+    size_t sweep(Pair* pairs, size_t maxPairs) const;
+
+    unsigned int m_axis;
+    size_t m_numSwaps;
+    std::vector<unsigned int> m_order;
+    std::vector<T> m_keys;
+
+    //Sorted bounds, m_min[0]/m_max[0] are along the sweep axis. Padded with
+    //empty boxes so the sweep can always read 4 values.
+    std::vector<T> m_min[3];
+    std::vector<T> m_max[3];
+  };
+
+  /*****************************************************************************/
+  typedef SweepAndPrune<float> sweepAndPrunef;
+  typedef SweepAndPrune<double> sweepAndPruned;
+
+  /*******************************************************************************/
+  template<typename T>
+  SweepAndPrune<T>::SweepAndPrune() : m_axis(0), m_numSwaps(0)
+  {
+  }
+
+  /*******************************************************************************/
+  template<typename T>
+  unsigned int
+  SweepAndPrune<T>::getAxis() const
+  {
+    return m_axis;
+  }
+
+  /*******************************************************************************/
+  template<typename T>
+  size_t
+  SweepAndPrune<T>::getNumSwaps() const
+  {
+    return m_numSwaps;
+  }
+
+  /*******************************************************************************/
+  template<typename T>
+  void
+  SweepAndPrune<T>::chooseAxis(const Box<T>* boxes, size_t numBoxes)
+  {
+    //Variance of the box centers (times 4 and numBoxes^2, only the ratio matters)
+    T sum[3] = { 0, 0, 0 };
+    T sum2[3] = { 0, 0, 0 };
+    for(size_t i = 0; i < numBoxes; i++) {
+      const Vec3<T>& bmin = boxes[i].getMin();
+      const Vec3<T>& bmax = boxes[i].getMax();
+      for(size_t a = 0; a < 3; a++) {
+        T c = bmin[a]+bmax[a];
+        sum[a] += c;
+        sum2[a] += c*c;
+      }
+    }
+
+    T variance[3];
+    for(size_t a = 0; a < 3; a++)
+      variance[a] = sum2[a]*T(numBoxes)-sum[a]*sum[a];
+
+    unsigned int best = 0;
+    if(variance[1] > variance[best])
+      best = 1;
+    if(variance[2] > variance[best])
+      best = 2;
+    if(variance[best] > axisHysteresis()*variance[m_axis])
+      m_axis = best;
+  }
+
+  /*******************************************************************************/
+  template<typename T>
+  void
+  SweepAndPrune<T>::sort(const Box<T>* boxes, size_t numBoxes, bool incremental)
+  {
+    const unsigned int axis = m_axis;
+    m_keys.resize(numBoxes);
+    for(size_t i = 0; i < numBoxes; i++)
+      m_keys[i] = boxes[m_order[i]].getMin()[axis];
+
+    m_numSwaps = 0;
+    if(!incremental) {
+      std::vector<std::pair<T, unsigned int> > tmp(numBoxes);
+      for(size_t i = 0; i < numBoxes; i++)
+        tmp[i] = std::make_pair(m_keys[i], m_order[i]);
+      std::sort(tmp.begin(), tmp.end());
+      for(size_t i = 0; i < numBoxes; i++) {
+        m_keys[i] = tmp[i].first;
+        m_order[i] = tmp[i].second;
+      }
+      return;
+    }
+
+    //Insertion sort, almost linear thanks to temporal coherence
+    for(size_t i = 1; i < numBoxes; i++) {
+      T key = m_keys[i];
+      unsigned int id = m_order[i];
+      size_t j = i;
+      while(j > 0 && m_keys[j-1] > key) {
+        m_keys[j] = m_keys[j-1];
+        m_order[j] = m_order[j-1];
+        j--;
+      }
+      m_keys[j] = key;
+      m_order[j] = id;
+      m_numSwaps += i-j;
+    }
+  }
+
+  /*******************************************************************************/
+  template<typename T>
+  size_t
+  SweepAndPrune<T>::update(const Box<T>* boxes, size_t numBoxes, Pair* pairs, size_t maxPairs)
+  {
+    const unsigned int prevAxis = m_axis;
+    chooseAxis(boxes, numBoxes);
+
+    bool incremental = m_order.size() == numBoxes && prevAxis == m_axis;
+    if(m_order.size() != numBoxes) {
+      m_order.resize(numBoxes);
+      for(size_t i = 0; i < numBoxes; i++)
+        m_order[i] = (unsigned int)i;
+    }
+    sort(boxes, numBoxes, incremental);
+
+    //Gather the bounds in sweep order
+    const unsigned int axes[3] = { m_axis, (m_axis+1)%3, (m_axis+2)%3 };
+    for(size_t a = 0; a < 3; a++) {
+      m_min[a].resize(numBoxes+4);
+      m_max[a].resize(numBoxes+4);
+      for(size_t i = 0; i < numBoxes; i++) {
+        const Box<T>& box = boxes[m_order[i]];
+        m_min[a][i] = box.getMin()[axes[a]];
+        m_max[a][i] = box.getMax()[axes[a]];
+      }
+      for(size_t i = numBoxes; i < numBoxes+4; i++) {
+        m_min[a][i] = std::numeric_limits<T>::max();
+        m_max[a][i] = -std::numeric_limits<T>::max();
+      }
+    }
+
+    return sweep(pairs, maxPairs);
+  }
+
+  /*******************************************************************************/
+  template<typename T>
+  size_t
+  SweepAndPrune<T>::sweep(Pair* pairs, size_t maxPairs) const
+  {
+    const size_t numBoxes = m_order.size();
+    const T* minA = &m_min[0][0];
+    const T* minB = &m_min[1][0];
+    const T* minC = &m_min[2][0];
+    const T* maxA = &m_max[0][0];
+    const T* maxB = &m_max[1][0];
+    const T* maxC = &m_max[2][0];
+
+    size_t found = 0;
+    for(size_t i = 0; i < numBoxes; i++) {
+      for(size_t j = i+1; j < numBoxes && minA[j] < maxA[i]; j++) {
+        if(minB[j] < maxB[i] && minB[i] < maxB[j] &&
+           minC[j] < maxC[i] && minC[i] < maxC[j]) {
+          if(found < maxPairs)
+            pairs[found] = std::make_pair(std::min(m_order[i], m_order[j]),
+                                          std::max(m_order[i], m_order[j]));
+          found++;
+        }
+      }
+    }
+    return found;
+  }
+
+  /*******************************************************************************/
+  template<>
+  inline size_t
+  SweepAndPrune<float>::sweep(Pair* pairs, size_t maxPairs) const
+  {
+    typedef simd::pack<float, 4> float4v;
+    const size_t numBoxes = m_order.size();
+    const float* minA = &m_min[0][0];
+    const float* minB = &m_min[1][0];
+    const float* minC = &m_min[2][0];
+    const float* maxA = &m_max[0][0];
+    const float* maxB = &m_max[1][0];
+    const float* maxC = &m_max[2][0];
+
+    size_t found = 0;
+    for(size_t i = 0; i < numBoxes; i++) {
+      const float4v iMaxA(maxA[i]);
+      const float4v iMinB(minB[i]);
+      const float4v iMaxB(maxB[i]);
+      const float4v iMinC(minC[i]);
+      const float4v iMaxC(maxC[i]);
+
+      //The padding keeps the loads in bounds, the last group is masked
+      //since an infinite max passes the padding mins
+      for(size_t j = i+1; j < numBoxes; j += 4) {
+        float4v::Mask axisMask = float4v::loadu(minA+j) < iMaxA;
+        if(numBoxes-j < 4)
+          axisMask = axisMask & float4v::Mask::firstN(numBoxes-j);
+        unsigned int axisBits = axisMask.getBits();
+        if(!axisBits)
+          break;
+
+        float4v::Mask mask = axisMask & (float4v::loadu(minB+j) < iMaxB);
+        mask = mask & (iMinB < float4v::loadu(maxB+j));
+        mask = mask & (float4v::loadu(minC+j) < iMaxC);
+        mask = mask & (iMinC < float4v::loadu(maxC+j));
+
+        unsigned int bits = mask.getBits();
+        for(size_t k = 0; bits; k++, bits >>= 1) {
+          if(bits & 1) {
+            if(found < maxPairs)
+              pairs[found] = std::make_pair(std::min(m_order[i], m_order[j+k]),
+                                            std::max(m_order[i], m_order[j+k]));
+            found++;
+          }
+        }
+
+        //Sorted mins: once a lane fails along the axis, the next ones do too
+        if(axisBits != 0xf)
+          break;
+      }
+    }
+    return found;
+  }
+}
+
+#endif
@@ -0,0 +1,240 @@
+#ifndef STAR_CACHED_TRANSFORM_H
+#define STAR_CACHED_TRANSFORM_H
+
+#include <StarMath/StarMatrix.h>
+
+#include <atomic>
+#include <thread>
+
+namespace Star
+{
+  /**
+   * A Matrix<T> with its inverse, determinant and normal matrix computed
+   * lazily, once per modification.
+   *
+   * Once the matrix is set, any number of threads may read the derived
+   * values: the first reader computes them and the others wait for it.
+   * Setting the matrix must not run concurrently with readers.
+   */
+  template <typename T>
+  class CachedTransform
+  {
+  public:
+    /**
+     * Create an identity transform.
+     */
+    CachedTransform();
+
+    /**
+     * Create a transform from a matrix.
+     */
+    explicit CachedTransform(const Matrix<T>& m);
+
+    /**
+     * Copy the matrix, and the derived values if they are computed.
+     */
+    CachedTransform(const CachedTransform& t);
+
+    /**
+     * Copy the matrix, and the derived values if they are computed.
+     */
+    CachedTransform& operator = (const CachedTransform& t);
+
+    /**
+     * Get the matrix.
+     */
+    inline const Matrix<T>& getMatrix() const;
+
+    /**
+     * Set the matrix, the derived values are recomputed on the next read.
+     */
+    void setMatrix(const Matrix<T>& m);
+
+    /**
+     * Get the inverse of the matrix, which must be invertible.
+     */
+    inline const Matrix<T>& getInverse() const;
+
+    /**
+     * Get the determinant of the matrix.
+     */
+    inline T getDeterminant() const;
+
+    /**
+     * Get the matrix transforming normals: the transpose of the inverse of
+     * the upper 3x3 part, with no translation.
+     */
+    inline const Matrix<T>& getNormalMatrix() const;
+
+    /**
+     * Check if the derived values are computed.
+     */
+    inline bool isCached() const;
+
+  private:
+    enum State
+    {
+      STALE,
+      COMPUTING,
+      READY
+    };
+
+    inline void ensureCached() const;
+    void compute() const;
+
+    Matrix<T> m_matrix;
+
+    mutable Matrix<T> m_inverse;
+    mutable Matrix<T> m_normalMatrix;
+    mutable T m_determinant;
+    mutable std::atomic<int> m_state;
+  };
+
+  /*****************************************************************************/
+  typedef CachedTransform<float> cachedTransformf;
+  typedef CachedTransform<double> cachedTransformd;
+
+  /*******************************************************************************/
+  template <typename T>
+  CachedTransform<T>::CachedTransform() : m_state(STALE)
+  {
+    m_matrix.toIdentity();
+  }
+
+  /*******************************************************************************/
+  template <typename T>
+  CachedTransform<T>::CachedTransform(const Matrix<T>& m) : m_matrix(m), m_state(STALE)
+  {
+  }
+
+  /*******************************************************************************/
+  template <typename T>
+  CachedTransform<T>::CachedTransform(const CachedTransform& t) : m_state(STALE)
+  {
+    *this = t;
+  }
+
+  /*******************************************************************************/
+  template <typename T>
+  CachedTransform<T>&
+  CachedTransform<T>::operator = (const CachedTransform& t)
+  {
+    m_matrix = t.m_matrix;
+    if(t.m_state.load(std::memory_order_acquire) == READY) {
+      m_inverse = t.m_inverse;
+      m_normalMatrix = t.m_normalMatrix;
+      m_determinant = t.m_determinant;
+      m_state.store(READY, std::memory_order_release);
+    }
+    else
+      m_state.store(STALE, std::memory_order_release);
+
+    return *this;
+  }
+
+  /*******************************************************************************/
+  template <typename T>
+  const Matrix<T>&
+  CachedTransform<T>::getMatrix() const
+  {
+    return m_matrix;
+  }
+
+  /*******************************************************************************/
+  template <typename T>
+  void
+  CachedTransform<T>::setMatrix(const Matrix<T>& m)
+  {
+    m_matrix = m;
+    m_state.store(STALE, std::memory_order_release);
+  }
+
+  /*******************************************************************************/
+  template <typename T>
+  const Matrix<T>&
+  CachedTransform<T>::getInverse() const
+  {
+    ensureCached();
+    return m_inverse;
+  }
+
+  /*******************************************************************************/
+  template <typename T>
+  T
+  CachedTransform<T>::getDeterminant() const
+  {
+    ensureCached();
+    return m_determinant;
+  }
+
+  /*******************************************************************************/
+  template <typename T>
+  const Matrix<T>&
+  CachedTransform<T>::getNormalMatrix() const
+  {
+    ensureCached();
+    return m_normalMatrix;
+  }
+
+  /*******************************************************************************/
+  template <typename T>
+  bool
+  CachedTransform<T>::isCached() const
+  {
+    return m_state.load(std::memory_order_acquire) == READY;
+  }
+
+  /*******************************************************************************/
+  template <typename T>
+  void
+  CachedTransform<T>::ensureCached() const
+  {
+    if(m_state.load(std::memory_order_acquire) == READY)
+      return;
+
+    //The reader winning the exchange computes, the others wait for it
+    int expected = STALE;
+    if(m_state.compare_exchange_strong(expected, COMPUTING, std::memory_order_acquire)) {
+      compute();
+      m_state.store(READY, std::memory_order_release);
+    }
+    else {
+      while(m_state.load(std::memory_order_acquire) != READY)
+        std::this_thread::yield();
+    }
+  }
+
+  /*******************************************************************************/
+  template <typename T>
+  void
+  CachedTransform<T>::compute() const
+  {
+    //The determinant is the first row dotted with the first column of the
+    //adjoint, which saves the 4 minors of determinant()
+    m_inverse = m_matrix.adjoint4();
+    m_determinant = m_matrix(0, 0)*m_inverse(0, 0)+m_matrix(0, 1)*m_inverse(1, 0)+
+      m_matrix(0, 2)*m_inverse(2, 0)+m_matrix(0, 3)*m_inverse(3, 0);
+    m_inverse *= T(1)/m_determinant;
+
+    //Inverse transpose of the 3x3 part, its cofactors over its determinant
+    const Matrix<T>& m = m_matrix;
+    T c[3][3];
+    c[0][0] = m(1, 1)*m(2, 2)-m(1, 2)*m(2, 1);
+    c[0][1] = m(1, 2)*m(2, 0)-m(1, 0)*m(2, 2);
+    c[0][2] = m(1, 0)*m(2, 1)-m(1, 1)*m(2, 0);
+    c[1][0] = m(0, 2)*m(2, 1)-m(0, 1)*m(2, 2);
+    c[1][1] = m(0, 0)*m(2, 2)-m(0, 2)*m(2, 0);
+    c[1][2] = m(0, 1)*m(2, 0)-m(0, 0)*m(2, 1);
+    c[2][0] = m(0, 1)*m(1, 2)-m(0, 2)*m(1, 1);
+    c[2][1] = m(0, 2)*m(1, 0)-m(0, 0)*m(1, 2);
+    c[2][2] = m(0, 0)*m(1, 1)-m(0, 1)*m(1, 0);
+    const T invDet3 = T(1)/(m(0, 0)*c[0][0]+m(0, 1)*c[0][1]+m(0, 2)*c[0][2]);
+
+    m_normalMatrix.toIdentity();
+    for(size_t i = 0; i < 3; i++)
+      for(size_t j = 0; j < 3; j++)
+        m_normalMatrix(i, j) = c[i][j]*invDet3;
+  }
+}
+
+#endif
@@ -0,0 +1,234 @@
+#ifndef STAR_CLIPPER_H
+#define STAR_CLIPPER_H
+
+#include <StarMath/StarVec3.h>
+#include <StarMath/StarPlane.h>
+
+#include <cassert>
+#include <cstddef>
+#include <algorithm>
+#include <vector>
+
+namespace Star
+{
+  /**
+   * Clip a convex polygon against a plane (one Sutherland-Hodgman step).
+   * The part in front of the plane is kept, points on the plane are kept.
+   * Edge intersections are always computed from the kept vertex, so edges
+   * shared by two polygons are cut at the same point.
+   * @param in the polygon vertices
+   * @param numVertices the number of vertices
+   * @param plane the clipping plane
+   * @param out receives at most numVertices+1 vertices, must not alias in
+   * @return the number of vertices of the clipped polygon, 0 if it is
+   * fully behind the plane
+   */
+  template<typename T>
+  size_t
+  clipPolygon(const Vec3<T>* in, size_t numVertices, const Plane<T>& plane, Vec3<T>* out)
+  {
+    size_t numOut = 0;
+    if(!numVertices)
+      return 0;
+
+    const Vec3<T>* prev = &in[numVertices-1];
+    T prevDist = plane.distance(*prev);
+    for(size_t i = 0; i < numVertices; i++) {
+      const Vec3<T>* cur = &in[i];
+      T curDist = plane.distance(*cur);
+      bool prevIn = prevDist >= 0;
+      bool curIn = curDist >= 0;
+
+      if(prevIn != curIn) {
+        if(prevIn)
+          out[numOut++] = *prev+(*cur-*prev)*(prevDist/(prevDist-curDist));
+        else
+          out[numOut++] = *cur+(*prev-*cur)*(curDist/(curDist-prevDist));
+      }
+      if(curIn)
+        out[numOut++] = *cur;
+
+      prev = cur;
+      prevDist = curDist;
+    }
+    return numOut;
+  }
+
+  /**
+   * Clip triangle soups against a set of planes, keeping the front side of
+   * all of them. Clipped polygons are fan triangulated.
+   *
+   * Input is processed in chunks of triangles. Chunks are clipped in
+   * parallel, each one writing into its own worst-case slice of the output
+   * buffer, and the slices are compacted afterward, so no locking or output
+   * allocation is needed. Successive calls can stream a large soup through
+   * the same clipper.
+   */
+  template<typename T>
+  class TriangleClipper
+  {
+  public:
+    /**
+     * Create a clipper.
+     * @param planes the clipping planes, with unit normals
+     * @param numPlanes the number of planes, at most MAX_PLANES
+     * @param chunkSize the number of triangles processed by a task
+     */
+    TriangleClipper(const Plane<T>* planes, size_t numPlanes, size_t chunkSize = 4096);
+
+    /**
+     * Get the number of triangles the output buffer must hold.
+     * @param numTriangles the number of input triangles
+     */
+    inline size_t getMaxOutputTriangles(size_t numTriangles) const;
+
+    /**
+     * Clip triangles.
+     * @param triangles the input triangles, 3 vertices each
+     * @param numTriangles the number of input triangles
+     * @param out receives the clipped triangles, must hold
+     * getMaxOutputTriangles(numTriangles)*3 vertices
+     * @return the number of output triangles
+     */
+    size_t clip(const Vec3<T>* triangles, size_t numTriangles, Vec3<T>* out) const;
+
+    /**
+     * Clip one triangle.
+     * @param triangle the 3 vertices of the triangle
+     * @param out receives at most numPlanes+1 triangles
+     * @return the number of output triangles
+     */
+    size_t clipTriangle(const Vec3<T>* triangle, Vec3<T>* out) const;
+
+    /**
+     * Get the number of planes.
+     */
+    inline size_t getNumPlanes() const;
+
+    static const size_t MAX_PLANES = 32;
+
+  private:
+    size_t clipChunk(const Vec3<T>* triangles, size_t numTriangles, Vec3<T>* out) const;
+
+    std::vector<Plane<T> > m_planes;
+    size_t m_chunkSize;
+  };
+
+  /*****************************************************************************/
+  typedef TriangleClipper<float> triangleClipperf;
+  typedef TriangleClipper<double> triangleClipperd;
+
+  template<typename T> const size_t TriangleClipper<T>::MAX_PLANES;
+
+  /*******************************************************************************/
+  template<typename T>
+  TriangleClipper<T>::TriangleClipper(const Plane<T>* planes, size_t numPlanes, size_t chunkSize)
+    : m_planes(planes, planes+numPlanes), m_chunkSize(std::max<size_t>(chunkSize, 1))
+  {
+    assert(numPlanes <= MAX_PLANES);
+  }
+
+  /*******************************************************************************/
+  template<typename T>
+  size_t
+  TriangleClipper<T>::getMaxOutputTriangles(size_t numTriangles) const
+  {
+    //Each plane adds at most one vertex to the polygon, so one triangle
+    return numTriangles*(m_planes.size()+1);
+  }
+
+  /*******************************************************************************/
+  template<typename T>
+  size_t
+  TriangleClipper<T>::getNumPlanes() const
+  {
+    return m_planes.size();
+  }
+
+  /*******************************************************************************/
+  template<typename T>
+  size_t
+  TriangleClipper<T>::clipTriangle(const Vec3<T>* triangle, Vec3<T>* out) const
+  {
+    const size_t numPlanes = m_planes.size();
+
+    //Trivial accept and reject before the general case
+    bool inside = true;
+    for(size_t p = 0; p < numPlanes; p++) {
+      T d0 = m_planes[p].distance(triangle[0]);
+      T d1 = m_planes[p].distance(triangle[1]);
+      T d2 = m_planes[p].distance(triangle[2]);
+      if(d0 < 0 && d1 < 0 && d2 < 0)
+        return 0;
+      inside = inside && d0 >= 0 && d1 >= 0 && d2 >= 0;
+    }
+    if(inside) {
+      out[0] = triangle[0];
+      out[1] = triangle[1];
+      out[2] = triangle[2];
+      return 1;
+    }
+
+    Vec3<T> buffers[2][MAX_PLANES+3];
+    Vec3<T>* poly = buffers[0];
+    Vec3<T>* tmp = buffers[1];
+    poly[0] = triangle[0];
+    poly[1] = triangle[1];
+    poly[2] = triangle[2];
+    size_t numVertices = 3;
+    for(size_t p = 0; p < numPlanes && numVertices; p++) {
+      numVertices = clipPolygon(poly, numVertices, m_planes[p], tmp);
+      std::swap(poly, tmp);
+    }
+    if(numVertices < 3)
+      return 0;
+
+    for(size_t i = 1; i+1 < numVertices; i++) {
+      *out++ = poly[0];
+      *out++ = poly[i];
+      *out++ = poly[i+1];
+    }
+    return numVertices-2;
+  }
+
+  /*******************************************************************************/
+  template<typename T>
+  size_t
+  TriangleClipper<T>::clipChunk(const Vec3<T>* triangles, size_t numTriangles, Vec3<T>* out) const
+  {
+    size_t numOut = 0;
+    for(size_t i = 0; i < numTriangles; i++)
+      numOut += clipTriangle(triangles+3*i, out+3*numOut);
+    return numOut;
+  }
+
+  /*******************************************************************************/
+  template<typename T>
+  size_t
+  TriangleClipper<T>::clip(const Vec3<T>* triangles, size_t numTriangles, Vec3<T>* out) const
+  {
+    const size_t numChunks = (numTriangles+m_chunkSize-1)/m_chunkSize;
+    if(numChunks <= 1)
+      return clipChunk(triangles, numTriangles, out);
+
+    //Chunk c writes at its worst case offset, then slices are packed
+    const size_t sliceSize = getMaxOutputTriangles(m_chunkSize);
+    std::vector<size_t> counts(numChunks);
+#pragma omp parallel for schedule(dynamic, 1)
+    for(long c = 0; c < long(numChunks); c++) {
+      size_t begin = c*m_chunkSize;
+      size_t size = std::min(m_chunkSize, numTriangles-begin);
+      counts[c] = clipChunk(triangles+3*begin, size, out+3*c*sliceSize);
+    }
+
+    size_t numOut = counts[0];
+    for(size_t c = 1; c < numChunks; c++) {
+      const Vec3<T>* slice = out+3*c*sliceSize;
+      std::copy(slice, slice+3*counts[c], out+3*numOut);
+      numOut += counts[c];
+    }
+    return numOut;
+  }
+}
+
+#endif
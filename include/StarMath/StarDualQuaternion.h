@@ -0,0 +1,299 @@
+#ifndef STAR_DUAL_QUATERNION_H
+#define STAR_DUAL_QUATERNION_H
+
+#include <StarMath/StarVec3.h>
+#include <StarMath/StarMatrix.h>
+#include <StarMath/StarQuaternion.h>
+
+#include <iosfwd>
+
+namespace Star
+{
+  /**
+   * A dual quaternion real+e*dual representing a rigid transform. For a
+   * rotation r followed by a translation t, real is r and dual is
+   * (t, 0)*r/2.
+   */
+  template <typename T>
+  class DualQuaternion
+  {
+  public:
+    /**
+     * Constructor with undefined values.
+     */
+    DualQuaternion() {};
+
+    /**
+     * Constructor from the real and dual parts.
+     */
+    DualQuaternion(const Quaternion<T>& real, const Quaternion<T>& dual);
+
+    /**
+     * Construct the transform rotating by a unit quaternion then
+     * translating.
+     */
+    DualQuaternion(const Quaternion<T>& rotation, const Vec3<T>& translation);
+
+    /**
+     * Addition, used to blend transforms.
+     */
+    DualQuaternion& operator += ( const DualQuaternion& );
+
+    /**
+     * Scalar multiplication.
+     */
+    DualQuaternion& operator *= ( T );
+
+    /**
+     * Addition.
+     */
+    DualQuaternion operator + ( const DualQuaternion& ) const;
+
+    /**
+     * Composition: the result applies dq then this transform.
+     */
+    DualQuaternion operator * ( const DualQuaternion& dq ) const;
+
+    /**
+     * Scalar multiplication.
+     */
+    DualQuaternion operator * ( T ) const;
+
+    /**
+     * Equality check. Use std's epsilon.
+     */
+    bool operator == ( const DualQuaternion& ) const;
+
+    /**
+     * Inequality check. Use std's epsilon.
+     */
+    bool operator != ( const DualQuaternion& ) const;
+
+    /**
+     * Convert to identity transform.
+     */
+    void toIdentity();
+
+    /**
+     * Quaternion conjugate of both parts. For a unit dual quaternion this
+     * is the inverse transform.
+     */
+    DualQuaternion conjugate() const;
+
+    /**
+     * Divide both parts by the length of the real part, making a blend of
+     * unit dual quaternions a rigid transform again.
+     * @return The length of the real part
+     */
+    T normalize();
+
+    /**
+     * Get the rotation of a unit dual quaternion.
+     */
+    const Quaternion<T>& getRotation() const;
+
+    /**
+     * Get the translation of a unit dual quaternion.
+     */
+    Vec3<T> getTranslation() const;
+
+    /**
+     * Transform a point by a unit dual quaternion.
+     */
+    Vec3<T> transformPoint(const Vec3<T>& p) const;
+
+    /**
+     * Rotate a vector by a unit dual quaternion, ignoring the translation.
+     */
+    Vec3<T> transformVector(const Vec3<T>& v) const;
+
+    /**
+     * Set this dual quaternion from a rigid transform matrix (rotation and
+     * translation only).
+     */
+    void fromRigidMatrix(const Matrix<T>& m);
+
+    /**
+     * Convert a unit dual quaternion into a 4x4 matrix.
+     */
+    void toRigidMatrix(Matrix<T>& m) const;
+
+  public:
+    Quaternion<T> real, dual;
+  };
+
+  /*****************************************************************************/
+  typedef DualQuaternion<float> dualQuaternionf;
+  typedef DualQuaternion<double> dualQuaterniond;
+
+  /*******************************************************************************/
+  template <typename T>
+  DualQuaternion<T>::DualQuaternion(const Quaternion<T>& real, const Quaternion<T>& dual)
+    : real(real), dual(dual)
+  {
+  }
+
+  /*******************************************************************************/
+  template <typename T>
+  DualQuaternion<T>::DualQuaternion(const Quaternion<T>& rotation, const Vec3<T>& translation)
+    : real(rotation), dual(Quaternion<T>(translation.x, translation.y, translation.z, 0)*rotation*T(0.5))
+  {
+  }
+
+  /*******************************************************************************/
+  template <typename T>
+  DualQuaternion<T>&
+  DualQuaternion<T>::operator += ( const DualQuaternion& dq )
+  {
+    real += dq.real;
+    dual += dq.dual;
+
+    return *this;
+  }
+
+  /*******************************************************************************/
+  template <typename T>
+  DualQuaternion<T>&
+  DualQuaternion<T>::operator *= ( T k )
+  {
+    real *= k;
+    dual *= k;
+
+    return *this;
+  }
+
+  /*******************************************************************************/
+  template <typename T>
+  DualQuaternion<T>
+  DualQuaternion<T>::operator + ( const DualQuaternion& dq ) const
+  {
+    return DualQuaternion<T>(real+dq.real, dual+dq.dual);
+  }
+
+  /*******************************************************************************/
+  template <typename T>
+  DualQuaternion<T>
+  DualQuaternion<T>::operator * ( const DualQuaternion& dq ) const
+  {
+    return DualQuaternion<T>(real*dq.real, real*dq.dual+dual*dq.real);
+  }
+
+  /*******************************************************************************/
+  template <typename T>
+  DualQuaternion<T>
+  DualQuaternion<T>::operator * ( T k ) const
+  {
+    return DualQuaternion<T>(real*k, dual*k);
+  }
+
+  /*******************************************************************************/
+  template <typename T>
+  bool
+  DualQuaternion<T>::operator == ( const DualQuaternion& dq ) const
+  {
+    return real == dq.real && dual == dq.dual;
+  }
+
+  /*******************************************************************************/
+  template <typename T>
+  bool
+  DualQuaternion<T>::operator != ( const DualQuaternion& dq ) const
+  {
+    return !(*this == dq);
+  }
+
+  /*******************************************************************************/
+  template <typename T>
+  void
+  DualQuaternion<T>::toIdentity()
+  {
+    real.toIdentity();
+    dual = Quaternion<T>(0, 0, 0, 0);
+  }
+
+  /*******************************************************************************/
+  template <typename T>
+  DualQuaternion<T>
+  DualQuaternion<T>::conjugate() const
+  {
+    return DualQuaternion<T>(real.conjugate(), dual.conjugate());
+  }
+
+  /*******************************************************************************/
+  template <typename T>
+  T
+  DualQuaternion<T>::normalize()
+  {
+    T len = real.length();
+    *this *= T(1)/len;
+
+    return len;
+  }
+
+  /*******************************************************************************/
+  template <typename T>
+  const Quaternion<T>&
+  DualQuaternion<T>::getRotation() const
+  {
+    return real;
+  }
+
+  /*******************************************************************************/
+  template <typename T>
+  Vec3<T>
+  DualQuaternion<T>::getTranslation() const
+  {
+    //Vector part of 2*dual*conjugate(real)
+    Vec3<T> r(real.x, real.y, real.z);
+    Vec3<T> d(dual.x, dual.y, dual.z);
+    return (d*real.w-r*dual.w+r.cross(d))*T(2);
+  }
+
+  /*******************************************************************************/
+  template <typename T>
+  Vec3<T>
+  DualQuaternion<T>::transformPoint(const Vec3<T>& p) const
+  {
+    return real.rotate(p)+getTranslation();
+  }
+
+  /*******************************************************************************/
+  template <typename T>
+  Vec3<T>
+  DualQuaternion<T>::transformVector(const Vec3<T>& v) const
+  {
+    return real.rotate(v);
+  }
+
+  /*******************************************************************************/
+  template <typename T>
+  void
+  DualQuaternion<T>::fromRigidMatrix(const Matrix<T>& m)
+  {
+    Quaternion<T> rotation;
+    rotation.fromRotationMatrix(m);
+    *this = DualQuaternion<T>(rotation, Vec3<T>(m(0, 3), m(1, 3), m(2, 3)));
+  }
+
+  /*******************************************************************************/
+  template <typename T>
+  void
+  DualQuaternion<T>::toRigidMatrix(Matrix<T>& m) const
+  {
+    real.toRotationMatrix(m);
+    Vec3<T> t = getTranslation();
+    m(0, 3) = t.x;
+    m(1, 3) = t.y;
+    m(2, 3) = t.z;
+  }
+
+  /*****************************************************************************/
+  /**
+   * ostream operator for dual quaternions, defined in StarStream.h
+   */
+  template <typename T>
+  std::ostream&
+  operator << (std::ostream& os, const DualQuaternion<T>& dq);
+}
+
+#endif
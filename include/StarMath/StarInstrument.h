@@ -0,0 +1,154 @@
+#ifndef STAR_INSTRUMENT_H
+#define STAR_INSTRUMENT_H
+
+#include <cstddef>
+#include <stdint.h>
+
+#ifdef STARMATH_INSTRUMENT
+#include <chrono>
+#endif
+
+namespace Star
+{
+  /**
+   * Call counters of the hot functions, enabled by defining
+   * STARMATH_INSTRUMENT (the STARMATH_INSTRUMENT CMake option). Without it
+   * the instrumented functions are unchanged and the counters stay 0. The
+   * library and the code using it must agree on it: the StarMath CMake
+   * target exports it and FindStarMath.cmake sets it in STARMATH_CXX_FLAGS.
+   *
+   * Counters are per thread: a subsystem takes a snapshot before and after
+   * its work and subtracts them. Timers are off by default, when enabled
+   * each instrumented call also reads the clock, which costs more than
+   * most of these functions, so only use them to find hot spots.
+   */
+  namespace Instrument
+  {
+    enum Operation
+    {
+      MATRIX_INVERSE,
+      MATRIX_MULTIPLY,
+      QUATERNION_ROTATE,
+      VEC_NORMALIZE,
+      NUM_OPERATIONS
+    };
+
+    /**
+     * Calls and time spent per operation.
+     */
+    struct Counters
+    {
+      uint64_t calls[NUM_OPERATIONS];
+      uint64_t nanoseconds[NUM_OPERATIONS];
+
+      Counters()
+      {
+        for(size_t op = 0; op < NUM_OPERATIONS; op++)
+          calls[op] = nanoseconds[op] = 0;
+      }
+
+      /**
+       * Difference between two snapshots.
+       */
+      Counters operator - (const Counters& c) const
+      {
+        Counters res;
+        for(size_t op = 0; op < NUM_OPERATIONS; op++) {
+          res.calls[op] = calls[op]-c.calls[op];
+          res.nanoseconds[op] = nanoseconds[op]-c.nanoseconds[op];
+        }
+        return res;
+      }
+    };
+
+    inline const char*
+    getName(Operation op)
+    {
+      static const char* names[NUM_OPERATIONS] = {
+        "Matrix::inverse", "Matrix::operator*", "Quaternion::rotate", "Vec::normalize"
+      };
+      return names[op];
+    }
+
+#ifdef STARMATH_INSTRUMENT
+    /**
+     * State of the current thread.
+     */
+    struct ThreadState
+    {
+      ThreadState() : timersEnabled(false) {}
+
+      Counters counters;
+      bool timersEnabled;
+    };
+
+    inline ThreadState&
+    threadState()
+    {
+      static thread_local ThreadState state;
+      return state;
+    }
+
+    /**
+     * Count a call, and time it if timers are enabled.
+     */
+    class ScopedOperation
+    {
+    public:
+      explicit ScopedOperation(Operation op) : m_op(op), m_state(threadState())
+      {
+        m_state.counters.calls[op]++;
+        if(m_state.timersEnabled)
+          m_start = std::chrono::steady_clock::now();
+      }
+
+      ~ScopedOperation()
+      {
+        if(m_state.timersEnabled) {
+          std::chrono::steady_clock::duration elapsed = std::chrono::steady_clock::now()-m_start;
+          m_state.counters.nanoseconds[m_op] +=
+            uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+        }
+      }
+
+    private:
+      ScopedOperation(const ScopedOperation&);
+      ScopedOperation& operator = (const ScopedOperation&);
+
+      Operation m_op;
+      ThreadState& m_state;
+      std::chrono::steady_clock::time_point m_start;
+    };
+
+    /**
+     * Get the counters of the current thread.
+     */
+    inline Counters snapshot() { return threadState().counters; }
+
+    /**
+     * Reset the counters of the current thread.
+     */
+    inline void reset() { threadState().counters = Counters(); }
+
+    /**
+     * Enable or disable the timers of the current thread.
+     */
+    inline void setTimersEnabled(bool enabled) { threadState().timersEnabled = enabled; }
+
+    inline bool isEnabled() { return true; }
+#else
+    inline Counters snapshot() { return Counters(); }
+    inline void reset() {}
+    inline void setTimersEnabled(bool) {}
+    inline bool isEnabled() { return false; }
+#endif
+  }
+}
+
+#ifdef STARMATH_INSTRUMENT
+#define STAR_INSTRUMENT(op) Star::Instrument::ScopedOperation starInstrumentOperation(Star::Instrument::op)
+#else
+#define STAR_INSTRUMENT(op)
+#endif
+
+#endif
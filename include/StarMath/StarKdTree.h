@@ -0,0 +1,491 @@
+#ifndef STAR_KDTREE_H
+#define STAR_KDTREE_H
+
+#include <StarMath/StarVec3.h>
+
+#include <cassert>
+#include <cstddef>
+#include <limits>
+#include <algorithm>
+#include <vector>
+
+namespace Star
+{
+  /**
+   * A static 3D k-d tree for nearest-neighbor and radius searches.
+   *
+   * The tree has no explicit nodes: points are permuted so that the node of
+   * the range [lo, hi[ is the median point at lo+(hi-lo)/2, its left subtree
+   * is [lo, mid[ and its right subtree is ]mid, hi[. Only the split axis is
+   * stored per node. Queries use a fixed size stack and caller provided
+   * output buffers so they never allocate.
+   */
+  template<typename T>
+  class KdTree
+  {
+  public:
+    /**
+     * Create an empty tree.
+     */
+    KdTree();
+
+    /**
+     * Build the tree. The points are copied.
+     * Subtrees bigger than PARALLEL_BUILD_THRESHOLD are built in parallel
+     * when OpenMP is enabled.
+     * @param points the point cloud
+     * @param numPoints the number of points
+     */
+    void build(const Vec3<T>* points, size_t numPoints);
+
+    /**
+     * Build the tree. The points are copied.
+     */
+    void build(const std::vector<Vec3<T> >& points);
+
+    /**
+     * Get the number of points in the tree.
+     */
+    inline size_t size() const;
+
+    /**
+     * Get a point in tree order.
+     */
+    inline const Vec3<T>& getPoint(size_t i) const;
+
+    /**
+     * Get the original index of a point in tree order.
+     */
+    inline unsigned int getIndex(size_t i) const;
+
+    /**
+     * Find the nearest point.
+     * @param query the query point
+     * @param sqrDistance is the squared distance to the nearest point
+     * @return the index of the nearest point in the build array, or
+     * NOT_FOUND if the tree is empty
+     */
+    unsigned int nearest(const Vec3<T>& query, T& sqrDistance) const;
+
+    /**
+     * Find the k nearest points.
+     * @param query the query point
+     * @param k the number of neighbors to look for
+     * @param indices receives at least k indices, sorted by increasing distance
+     * @param sqrDistances receives at least k squared distances
+     * @return the number of neighbors found, min(k, size())
+     */
+    size_t knn(const Vec3<T>& query, size_t k,
+               unsigned int* indices, T* sqrDistances) const;
+
+    /**
+     * Find all the points closer than radius. Results are not sorted.
+     * @param query the query point
+     * @param radius the search radius
+     * @param indices receives at most maxResults indices
+     * @param maxResults the capacity of indices
+     * @return the number of points in the sphere, which may be larger than
+     * maxResults
+     */
+    size_t radiusSearch(const Vec3<T>& query, T radius,
+                        unsigned int* indices, size_t maxResults) const;
+
+    /**
+     * Find all the points closer than radius. Results are not sorted.
+     * @return the number of points found
+     */
+    size_t radiusSearch(const Vec3<T>& query, T radius,
+                        std::vector<unsigned int>& indices) const;
+
+    /**
+     * Run knn() for several query points in parallel.
+     * @param queries the query points
+     * @param numQueries the number of query points
+     * @param k the number of neighbors per query
+     * @param indices receives k indices per query (numQueries*k values)
+     * @param sqrDistances receives k squared distances per query
+     * @param counts if not null, receives the number of neighbors found
+     * per query
+     */
+    void knnBatch(const Vec3<T>* queries, size_t numQueries, size_t k,
+                  unsigned int* indices, T* sqrDistances,
+                  size_t* counts = 0) const;
+
+    /**
+     * Run radiusSearch() for several query points in parallel.
+     * @param indices receives maxResults indices per query
+     * @param counts receives the number of points in each sphere, which
+     * may be larger than maxResults
+     */
+    void radiusSearchBatch(const Vec3<T>* queries, size_t numQueries, T radius,
+                           unsigned int* indices, size_t maxResults,
+                           size_t* counts) const;
+
+    static const unsigned int NOT_FOUND = ~0u;
+    static const size_t PARALLEL_BUILD_THRESHOLD = 16384;
+
+  private:
+    /**
+     * Max traversal depth. Enough for 2^32 points.
+     */
+    static const size_t MAX_DEPTH = 64;
+
+    struct StackEntry
+    {
+      size_t lo, hi;
+      T sqrDist;
+    };
+
+    struct AxisLess
+    {
+      AxisLess(const Vec3<T>* points, unsigned int axis) : points(points), axis(axis) {}
+      bool operator()(unsigned int a, unsigned int b) const
+      {
+        return points[a][axis] < points[b][axis];
+      }
+      const Vec3<T>* points;
+      unsigned int axis;
+    };
+
+    void buildRange(const Vec3<T>* points, size_t lo, size_t hi);
+
+    static void heapPush(unsigned int* indices, T* dists, size_t& n,
+                         unsigned int idx, T dist);
+    static void heapReplaceTop(unsigned int* indices, T* dists, size_t n,
+                               unsigned int idx, T dist);
+
+    std::vector<Vec3<T> > m_points;
+    std::vector<unsigned int> m_indices;
+    std::vector<unsigned char> m_axis;
+  };
+
+  /*****************************************************************************/
+  typedef KdTree<float> kdtreef;
+  typedef KdTree<double> kdtreed;
+
+  template<typename T> const unsigned int KdTree<T>::NOT_FOUND;
+  template<typename T> const size_t KdTree<T>::PARALLEL_BUILD_THRESHOLD;
+  template<typename T> const size_t KdTree<T>::MAX_DEPTH;
+
+  /*******************************************************************************/
+  template<typename T>
+  KdTree<T>::KdTree()
+  {
+  }
+
+  /*******************************************************************************/
+  template<typename T>
+  void
+  KdTree<T>::build(const std::vector<Vec3<T> >& points)
+  {
+    build(points.empty() ? 0 : &points[0], points.size());
+  }
+
+  /*******************************************************************************/
+  template<typename T>
+  void
+  KdTree<T>::build(const Vec3<T>* points, size_t numPoints)
+  {
+    assert(numPoints < size_t(NOT_FOUND));
+
+    m_indices.resize(numPoints);
+    m_axis.resize(numPoints);
+    for(size_t i = 0; i < numPoints; i++)
+      m_indices[i] = (unsigned int)i;
+
+#pragma omp parallel
+#pragma omp single nowait
+    buildRange(points, 0, numPoints);
+
+    m_points.resize(numPoints);
+#pragma omp parallel for schedule(static)
+    for(long i = 0; i < long(numPoints); i++)
+      m_points[i] = points[m_indices[i]];
+  }
+
+  /*******************************************************************************/
+  template<typename T>
+  void
+  KdTree<T>::buildRange(const Vec3<T>* points, size_t lo, size_t hi)
+  {
+    if(hi <= lo)
+      return;
+
+    //Split along the axis with the largest extent
+    Vec3<T> bmin = points[m_indices[lo]];
+    Vec3<T> bmax = bmin;
+    for(size_t i = lo+1; i < hi; i++) {
+      const Vec3<T>& p = points[m_indices[i]];
+      for(size_t a = 0; a < 3; a++) {
+        bmin[a] = std::min(bmin[a], p[a]);
+        bmax[a] = std::max(bmax[a], p[a]);
+      }
+    }
+    Vec3<T> extent = bmax-bmin;
+    unsigned int axis = 0;
+    if(extent.y > extent[axis])
+      axis = 1;
+    if(extent.z > extent[axis])
+      axis = 2;
+
+    size_t mid = lo+(hi-lo)/2;
+    std::nth_element(m_indices.begin()+lo, m_indices.begin()+mid,
+                     m_indices.begin()+hi, AxisLess(points, axis));
+    m_axis[mid] = (unsigned char)axis;
+
+    if(hi-lo > PARALLEL_BUILD_THRESHOLD) {
+#pragma omp task
+      buildRange(points, lo, mid);
+#pragma omp task
+      buildRange(points, mid+1, hi);
+#pragma omp taskwait
+    } else {
+      buildRange(points, lo, mid);
+      buildRange(points, mid+1, hi);
+    }
+  }
+
+  /*******************************************************************************/
+  template<typename T>
+  size_t
+  KdTree<T>::size() const
+  {
+    return m_points.size();
+  }
+
+  /*******************************************************************************/
+  template<typename T>
+  const Vec3<T>&
+  KdTree<T>::getPoint(size_t i) const
+  {
+    return m_points[i];
+  }
+
+  /*******************************************************************************/
+  template<typename T>
+  unsigned int
+  KdTree<T>::getIndex(size_t i) const
+  {
+    return m_indices[i];
+  }
+
+  /*******************************************************************************/
+  template<typename T>
+  void
+  KdTree<T>::heapPush(unsigned int* indices, T* dists, size_t& n,
+                      unsigned int idx, T dist)
+  {
+    //Max-heap on distance, sift up
+    size_t i = n++;
+    while(i > 0) {
+      size_t parent = (i-1)/2;
+      if(dists[parent] >= dist)
+        break;
+      dists[i] = dists[parent];
+      indices[i] = indices[parent];
+      i = parent;
+    }
+    dists[i] = dist;
+    indices[i] = idx;
+  }
+
+  /*******************************************************************************/
+  template<typename T>
+  void
+  KdTree<T>::heapReplaceTop(unsigned int* indices, T* dists, size_t n,
+                            unsigned int idx, T dist)
+  {
+    //Sift down from the root
+    size_t i = 0;
+    for(;;) {
+      size_t child = 2*i+1;
+      if(child >= n)
+        break;
+      if(child+1 < n && dists[child+1] > dists[child])
+        child++;
+      if(dists[child] <= dist)
+        break;
+      dists[i] = dists[child];
+      indices[i] = indices[child];
+      i = child;
+    }
+    dists[i] = dist;
+    indices[i] = idx;
+  }
+
+  /*******************************************************************************/
+  template<typename T>
+  size_t
+  KdTree<T>::knn(const Vec3<T>& query, size_t k,
+                 unsigned int* indices, T* sqrDistances) const
+  {
+    if(k == 0 || m_points.empty())
+      return 0;
+
+    size_t found = 0;
+    StackEntry stack[MAX_DEPTH];
+    size_t top = 0;
+    stack[top].lo = 0;
+    stack[top].hi = m_points.size();
+    stack[top].sqrDist = 0;
+    top++;
+
+    while(top > 0) {
+      top--;
+      size_t lo = stack[top].lo;
+      size_t hi = stack[top].hi;
+      if(found == k && stack[top].sqrDist >= sqrDistances[0])
+        continue;
+
+      while(lo < hi) {
+        size_t mid = lo+(hi-lo)/2;
+        const Vec3<T>& p = m_points[mid];
+        Vec3<T> d = p-query;
+        T dist = d.dot(d);
+        if(found < k)
+          heapPush(indices, sqrDistances, found, m_indices[mid], dist);
+        else if(dist < sqrDistances[0])
+          heapReplaceTop(indices, sqrDistances, found, m_indices[mid], dist);
+
+        unsigned int axis = m_axis[mid];
+        T delta = query[axis]-p[axis];
+        T planeDist = delta*delta;
+
+        //Visit the near side first, keep the far side for later
+        size_t nearLo = lo, nearHi = mid, farLo = mid+1, farHi = hi;
+        if(delta >= 0) {
+          nearLo = mid+1; nearHi = hi; farLo = lo; farHi = mid;
+        }
+        if(farLo < farHi && (found < k || planeDist < sqrDistances[0])) {
+          assert(top < MAX_DEPTH);
+          stack[top].lo = farLo;
+          stack[top].hi = farHi;
+          stack[top].sqrDist = planeDist;
+          top++;
+        }
+        lo = nearLo;
+        hi = nearHi;
+      }
+    }
+
+    //Heap sort into increasing distances
+    for(size_t n = found; n > 1; n--) {
+      unsigned int idx = indices[n-1];
+      T dist = sqrDistances[n-1];
+      indices[n-1] = indices[0];
+      sqrDistances[n-1] = sqrDistances[0];
+      heapReplaceTop(indices, sqrDistances, n-1, idx, dist);
+    }
+
+    return found;
+  }
+
+  /*******************************************************************************/
+  template<typename T>
+  unsigned int
+  KdTree<T>::nearest(const Vec3<T>& query, T& sqrDistance) const
+  {
+    unsigned int idx = NOT_FOUND;
+    sqrDistance = std::numeric_limits<T>::max();
+    knn(query, 1, &idx, &sqrDistance);
+    return idx;
+  }
+
+  /*******************************************************************************/
+  template<typename T>
+  size_t
+  KdTree<T>::radiusSearch(const Vec3<T>& query, T radius,
+                          unsigned int* indices, size_t maxResults) const
+  {
+    if(m_points.empty())
+      return 0;
+
+    const T sqrRadius = radius*radius;
+    size_t found = 0;
+    StackEntry stack[MAX_DEPTH];
+    size_t top = 0;
+    stack[top].lo = 0;
+    stack[top].hi = m_points.size();
+    top++;
+
+    while(top > 0) {
+      top--;
+      size_t lo = stack[top].lo;
+      size_t hi = stack[top].hi;
+
+      while(lo < hi) {
+        size_t mid = lo+(hi-lo)/2;
+        const Vec3<T>& p = m_points[mid];
+        Vec3<T> d = p-query;
+        if(d.dot(d) <= sqrRadius) {
+          if(found < maxResults)
+            indices[found] = m_indices[mid];
+          found++;
+        }
+
+        unsigned int axis = m_axis[mid];
+        T delta = query[axis]-p[axis];
+
+        size_t nearLo = lo, nearHi = mid, farLo = mid+1, farHi = hi;
+        if(delta >= 0) {
+          nearLo = mid+1; nearHi = hi; farLo = lo; farHi = mid;
+        }
+        if(farLo < farHi && delta*delta <= sqrRadius) {
+          assert(top < MAX_DEPTH);
+          stack[top].lo = farLo;
+          stack[top].hi = farHi;
+          top++;
+        }
+        lo = nearLo;
+        hi = nearHi;
+      }
+    }
+
+    return found;
+  }
+
+  /*******************************************************************************/
+  template<typename T>
+  size_t
+  KdTree<T>::radiusSearch(const Vec3<T>& query, T radius,
+                          std::vector<unsigned int>& indices) const
+  {
+    indices.resize(std::max<size_t>(indices.capacity(), 16));
+    size_t found = radiusSearch(query, radius, &indices[0], indices.size());
+    if(found > indices.size()) {
+      indices.resize(found);
+      radiusSearch(query, radius, &indices[0], indices.size());
+    }
+    indices.resize(found);
+    return found;
+  }
+
+  /*******************************************************************************/
+  template<typename T>
+  void
+  KdTree<T>::knnBatch(const Vec3<T>* queries, size_t numQueries, size_t k,
+                      unsigned int* indices, T* sqrDistances,
+                      size_t* counts) const
+  {
+#pragma omp parallel for schedule(dynamic, 64)
+    for(long i = 0; i < long(numQueries); i++) {
+      size_t found = knn(queries[i], k, indices+i*k, sqrDistances+i*k);
+      if(counts)
+        counts[i] = found;
+    }
+  }
+
+  /*******************************************************************************/
+  template<typename T>
+  void
+  KdTree<T>::radiusSearchBatch(const Vec3<T>* queries, size_t numQueries, T radius,
+                               unsigned int* indices, size_t maxResults,
+                               size_t* counts) const
+  {
+#pragma omp parallel for schedule(dynamic, 64)
+    for(long i = 0; i < long(numQueries); i++)
+      counts[i] = radiusSearch(queries[i], radius, indices+i*maxResults, maxResults);
+  }
+}
+
+#endif
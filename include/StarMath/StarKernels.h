@@ -0,0 +1,91 @@
+#ifndef STAR_KERNELS_H
+#define STAR_KERNELS_H
+
+#include <StarMath/StarSoA.h>
+#include <StarMath/StarSkinning.h>
+#include <StarMath/StarMatrix.h>
+
+#include <cstddef>
+
+namespace Star
+{
+  /**
+   * Float batch kernels compiled in the StarMath library once per
+   * instruction set, unlike the header templates which get the instruction
+   * set of the code including them. The best variant the CPU supports is
+   * chosen on the first call. The STARMATH_ISA environment variable
+   * (generic, sse2, avx2 or avx512) forces a lower one, e.g. to test the
+   * other code paths.
+   *
+   * Each kernel gives the same results as the header template of the same
+   * name, up to rounding differences from FMA contraction.
+   */
+  namespace Kernels
+  {
+    enum Isa
+    {
+      ISA_GENERIC, //!< Baseline flags of the build, SSE2 on x86-64
+      ISA_AVX2,    //!< AVX2 and FMA
+      ISA_AVX512,  //!< AVX-512 F, VL, DQ and BW
+      NUM_ISAS
+    };
+
+    /**
+     * Get the instruction set of the kernels in use.
+     */
+    Isa getIsa();
+
+    /**
+     * Check if the library and the CPU support an instruction set.
+     */
+    bool isSupported(Isa isa);
+
+    /**
+     * Use the kernels of another instruction set, mostly for testing.
+     * @return false if the instruction set is not supported
+     */
+    bool setIsa(Isa isa);
+
+    const char* getIsaName(Isa isa);
+
+    /**
+     * See Star::quaternionRotate.
+     */
+    void quaternionRotate(QuaternionSoA<const float> q, Vec3SoA<const float> in,
+                          Vec3SoA<float> out, size_t n);
+
+    /**
+     * See Star::quaternionNlerp.
+     */
+    void quaternionNlerp(QuaternionSoA<const float> a, QuaternionSoA<const float> b,
+                         const float* t, QuaternionSoA<float> out, size_t n);
+
+    /**
+     * See Star::quaternionToRotationMatrix.
+     */
+    void quaternionToRotationMatrix(QuaternionSoA<const float> q, Vec3SoA<const float> t,
+                                    float* out, size_t n);
+
+    /**
+     * See Star::linearBlendSkin.
+     */
+    void linearBlendSkin(const float* palette, size_t stride, BoneInfluenceSoA<float> influences,
+                         Vec3SoA<const float> positions, Vec3SoA<const float> normals,
+                         Vec3SoA<float> outPositions, Vec3SoA<float> outNormals, size_t n);
+
+    /**
+     * See Star::dualQuaternionSkin.
+     */
+    void dualQuaternionSkin(const DualQuaternion<float>* bones, BoneInfluenceSoA<float> influences,
+                            Vec3SoA<const float> positions, Vec3SoA<const float> normals,
+                            Vec3SoA<float> outPositions, Vec3SoA<float> outNormals, size_t n);
+
+    /**
+     * See Star::matrixInverse.
+     */
+    void matrixInverse(const Matrix<float>* in, Matrix<float>* out, float* determinants,
+                       bool* singular, size_t n);
+  }
+}
+
+#endif
@@ -0,0 +1,835 @@
+#ifndef STAR_MAT_H
+#define STAR_MAT_H
+
+#include <StarMath/StarVec.h>
+#include <StarMath/StarInstrument.h>
+#include <StarMath/StarPrecision.h>
+
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <iosfwd>
+#include <type_traits>
+
+namespace Star
+{
+  /**
+   * A row-major matrix of R rows and C columns. Matrix2 and Matrix are its
+   * 2x2 and 4x4 aliases.
+   */
+  template <size_t R, size_t C, typename T>
+  class Mat
+  {
+  public:
+    /**
+     * Construct an unitialised matrix, except 2x2 matrices which start as
+     * the identity like the former Matrix2 class.
+     */
+    Mat() { if(R == 2 && C == 2) toIdentity(); }
+
+    /**
+     * Construct a matrix with the specified values (row major).
+     */
+    Mat( const T * );
+
+    /**
+     * Construct a matrix with the specified values (row major), one per
+     * coefficient.
+     */
+    template <typename... Ts>
+    Mat( T e11, T e12, Ts... others );
+
+    /**
+     * Access operator. Acces is done in row major order (y,x).
+     */
+    T operator () ( size_t row, size_t col ) const;
+
+    /**
+     * Access operator. Acces is done in row major order (y,x).
+     */
+    T& operator () ( size_t row, size_t col );
+
+    /**
+     * Return a pointer to the matrix values.
+     */
+    T* ptr();
+
+    /**
+     * Return a const pointer to the matrix values.
+     */
+    const T* constPtr() const;
+
+    /**
+     * Matrix multiplication.
+     */
+    template <Precision P = STARMATH_PRECISION>
+    Mat& operator *= ( const Mat<C, C, T>& );
+
+    /**
+     * Matrix addition
+     */
+    Mat& operator += ( const Mat& );
+
+    /**
+     * Matrix substraction.
+     */
+    Mat& operator -= ( const Mat& );
+
+    /**
+     * Matrix scalar multiplication
+     */
+    Mat& operator *= ( T );
+
+    /**
+     * Matrix scalar division
+     */
+    Mat& operator /= ( T );
+
+    /**
+     * Nop
+     */
+    Mat operator + () const;
+
+    /**
+     * Negate the all matrix values
+     */
+    Mat operator - () const;
+
+    /**
+     * Matrix multiplication.
+     */
+    template <Precision P = STARMATH_PRECISION, size_t K>
+    Mat<R, K, T> operator * ( const Mat<C, K, T>& ) const;
+
+    /**
+     * Matrix addition
+     */
+    Mat operator + ( const Mat& ) const;
+
+    /**
+     * Matrix substraction.
+     */
+    Mat operator - ( const Mat& ) const;
+
+    /**
+     * Matrix scalar multiplication.
+     */
+    Mat operator * ( T ) const;
+
+    /**
+     * Matrix scalar division
+     */
+    Mat operator / ( T ) const;
+
+    /**
+     * Matrix multiplication with a scalar.
+     */
+    friend Mat operator * ( T k, const Mat& m )
+    {
+      return m*k;
+    }
+
+    /**
+     * Transform the specified vector.
+     */
+    template <Precision P = STARMATH_PRECISION>
+    Vec<R, T> operator * ( const Vec<C, T>& ) const;
+
+    /**
+     * Transform the specified point, its missing last coordinate is 1,
+     * e.g. a 3D point by a 4x4 matrix.
+     */
+    template <Precision P = STARMATH_PRECISION, size_t M>
+    typename std::enable_if<M+1 == C, Vec<M, T> >::type operator * ( const Vec<M, T>& ) const;
+
+    /**
+     * Check for exact equality.
+     * Doesn't take float imprecesion in account.
+     */
+    bool operator == ( const Mat& ) const;
+
+    /**
+     * Check for exact inequality.
+     * Doesn't take float imprecesion in account.
+     */
+    bool operator != ( const Mat& ) const;
+
+    /**
+     * Compute the matrix trace.
+     */
+    T trace() const;
+
+    /**
+     * Compute the matrix Frobenius norm
+     */
+    T FrobeniusNorm() const;
+
+    /**
+     * Compute the matrix determinant, for 2x2, 3x3 and 4x4 matrices.
+     */
+    template <Precision P = STARMATH_PRECISION>
+    T determinant() const;
+
+    /**
+     * Compute the matrix inverse, for 2x2, 3x3 and 4x4 matrices.
+     * You must check if the matrix is inversible.
+     */
+    template <Precision P = STARMATH_PRECISION>
+    Mat inverse() const;
+
+    /**
+     * Compute the matrix inverse, for 2x2, 3x3 and 4x4 matrices.
+     * You must check if the matrix is inversible.
+     * @param determinant is the previously computed matrix's determinant
+     */
+    template <Precision P = STARMATH_PRECISION>
+    Mat inverse(T& determinant) const;
+
+    /**
+     * Compute the matrix transpose.
+     */
+    Mat<C, R, T> transpose() const;
+
+    /**
+     * Create an identity matrix.
+     */
+    void toIdentity();
+
+    /**
+     * Return the determinant of the submatrix composed of rows r0, r1, r2
+     * and columns c0, c1, c2, for 4x4 matrices.
+     */
+    template <Precision P = STARMATH_PRECISION, size_t M = R>
+    T minor4(size_t r0, size_t r1, size_t r2, size_t c0, size_t c1, size_t c2) const;
+
+    /**
+     * Compute the matrix adjoint, for 4x4 matrices.
+     * @see http://en.wikipedia.org/wiki/Adjugate_matrix
+     */
+    template <Precision P = STARMATH_PRECISION, size_t M = R>
+    Mat adjoint4() const;
+
+    /**
+     * Create a 4x4 translation matrix.
+     */
+    template <size_t M = R>
+    void makeTranslation(T x, T y, T z);
+
+    /**
+     * Create a 4x4 translation matrix.
+     */
+    template <size_t M = R>
+    void makeTranslation(const Vec<3, T> &tr);
+
+    /**
+     * Create a 4x4 scaling matrix.
+     */
+    template <size_t M = R>
+    void makeScaling(const Vec<3, T> &scale);
+
+    /**
+     * Create a 4x4 scaling matrix.
+     */
+    template <size_t M = R>
+    void makeScaling(T sx, T sy, T sz);
+
+    /**
+     * Create a 4x4 rotation matrix, defined in StarQuaternion.h.
+     * @param axis is the rotation axis
+     * @param angle is the angle in radian
+     */
+    template <size_t M = R>
+    void makeRotationAxis(const Vec<3, T> axis, T angle);
+
+  private:
+    T m_mat[R][C];
+  };
+
+/*****************************************************************************/
+  /**
+   * Product of a RxC and a CxK row-major matrices, unrolled. The 4x4 float
+   * product is written row by row so the compiler vectorizes it: each
+   * result row is the sum of the rows of b scaled by the row of a.
+   */
+  template <size_t R, size_t C, size_t K, typename T, Precision P>
+  struct MatProduct
+  {
+    static inline void apply(const T* a, const T* b, T* res)
+    {
+      Unroll<R*K>::apply([=](size_t jk) {
+        const T* row = a+jk/K*C;
+        const T* col = b+jk%K;
+        T sum = row[0]*col[0];
+        Unroll<C-1>::apply([&](size_t i) { sum = madd<P, T>(row[i+1], col[(i+1)*K], sum); });
+        res[jk] = sum;
+      });
+    }
+  };
+
+  template <Precision P>
+  struct MatProduct<4, 4, 4, float, P>
+  {
+    static inline void apply(const float* a, const float* b, float* res)
+    {
+      float c[16];
+      for(size_t i = 0; i < 16; i++)
+        c[i] = b[i];
+      for(size_t j = 0; j < 4; j++, a += 4, res += 4) {
+        const float a0 = a[0], a1 = a[1], a2 = a[2], a3 = a[3];
+        float row[4];
+        for(size_t k = 0; k < 4; k++)
+          row[k] = madd<P, float>(a3, c[12+k], madd<P, float>(a2, c[8+k], madd<P, float>(a1, c[4+k], a0*c[k])));
+        for(size_t k = 0; k < 4; k++)
+          res[k] = row[k];
+      }
+    }
+  };
+
+/*****************************************************************************/
+  /**
+   * Determinant and adjoint of the NxN matrices, defined for 2, 3 and 4.
+   */
+  template <size_t N>
+  struct MatInverse;
+
+  template <>
+  struct MatInverse<2>
+  {
+    template <Precision P, typename T>
+    static T determinant(const Mat<2, 2, T>& m)
+    {
+      return productDifference<P, T>(m(0, 0), m(1, 1), m(1, 0), m(0, 1));
+    }
+
+    template <Precision P, typename T>
+    static Mat<2, 2, T> adjoint(const Mat<2, 2, T>& m)
+    {
+      return Mat<2, 2, T>(m(1, 1), -m(0, 1),
+                          -m(1, 0), m(0, 0));
+    }
+  };
+
+  template <>
+  struct MatInverse<3>
+  {
+    template <Precision P, typename T>
+    static T determinant(const Mat<3, 3, T>& m)
+    {
+      const T c0 = productDifference<P, T>(m(1, 1), m(2, 2), m(1, 2), m(2, 1));
+      const T c1 = productDifference<P, T>(m(1, 0), m(2, 2), m(2, 0), m(1, 2));
+      const T c2 = productDifference<P, T>(m(1, 0), m(2, 1), m(2, 0), m(1, 1));
+      return madd<P, T>(m(0, 2), c2, productDifference<P, T>(m(0, 0), c0, m(0, 1), c1));
+    }
+
+    template <Precision P, typename T>
+    static Mat<3, 3, T> adjoint(const Mat<3, 3, T>& m)
+    {
+      return Mat<3, 3, T>(productDifference<P, T>(m(1, 1), m(2, 2), m(1, 2), m(2, 1)),
+                          productDifference<P, T>(m(0, 2), m(2, 1), m(0, 1), m(2, 2)),
+                          productDifference<P, T>(m(0, 1), m(1, 2), m(0, 2), m(1, 1)),
+                          productDifference<P, T>(m(1, 2), m(2, 0), m(1, 0), m(2, 2)),
+                          productDifference<P, T>(m(0, 0), m(2, 2), m(0, 2), m(2, 0)),
+                          productDifference<P, T>(m(0, 2), m(1, 0), m(0, 0), m(1, 2)),
+                          productDifference<P, T>(m(1, 0), m(2, 1), m(1, 1), m(2, 0)),
+                          productDifference<P, T>(m(0, 1), m(2, 0), m(0, 0), m(2, 1)),
+                          productDifference<P, T>(m(0, 0), m(1, 1), m(0, 1), m(1, 0)));
+    }
+  };
+
+  template <>
+  struct MatInverse<4>
+  {
+    template <Precision P, typename T>
+    static T determinant(const Mat<4, 4, T>& m)
+    {
+      //Use Laplace formula
+      const T d01 = productDifference<P, T>(m(0, 0), m.template minor4<P>(1, 2, 3, 1, 2, 3),
+                                            m(0, 1), m.template minor4<P>(1, 2, 3, 0, 2, 3));
+      const T d2 = madd<P, T>(m(0, 2), m.template minor4<P>(1, 2, 3, 0, 1, 3), d01);
+      return madd<P, T>(-m(0, 3), m.template minor4<P>(1, 2, 3, 0, 1, 2), d2);
+    }
+
+    template <Precision P, typename T>
+    static Mat<4, 4, T> adjoint(const Mat<4, 4, T>& m)
+    {
+      return m.template adjoint4<P>();
+    }
+  };
+
+/*****************************************************************************/
+  template <size_t R, size_t C, typename T>
+  inline Mat<R, C, T>::Mat( const T *p )
+  {
+    T* m = ptr();
+    Unroll<R*C>::apply([=](size_t i) { m[i] = p[i]; });
+  }
+
+/*****************************************************************************/
+  template <size_t R, size_t C, typename T>
+  template <typename... Ts>
+  inline Mat<R, C, T>::Mat( T e11, T e12, Ts... others )
+  {
+    static_assert(sizeof...(Ts)+2 == R*C, "Mat needs one value per coefficient");
+    const T values[R*C] = { e11, e12, T(others)... };
+    *this = Mat(values);
+  }
+
+/*****************************************************************************/
+  template <size_t R, size_t C, typename T>
+  inline T&
+  Mat<R, C, T>::operator () ( size_t row, size_t col )
+  {
+    assert(row < R && col < C);
+    return m_mat[row][col];
+  }
+
+/*****************************************************************************/
+  template <size_t R, size_t C, typename T>
+  inline T
+  Mat<R, C, T>::operator () ( size_t row, size_t col ) const
+  {
+    assert(row < R && col < C);
+    return m_mat[row][col];
+  }
+
+/*****************************************************************************/
+  template <size_t R, size_t C, typename T>
+  inline T*
+  Mat<R, C, T>::ptr()
+  {
+    return &m_mat[0][0];
+  }
+
+/*****************************************************************************/
+  template <size_t R, size_t C, typename T>
+  inline const T*
+  Mat<R, C, T>::constPtr() const
+  {
+    return &m_mat[0][0];
+  }
+
+/*****************************************************************************/
+  template <size_t R, size_t C, typename T>
+  template <Precision P>
+  inline Mat<R, C, T>&
+  Mat<R, C, T>::operator *= ( const Mat<C, C, T>& m )
+  {
+    STAR_INSTRUMENT(MATRIX_MULTIPLY);
+    Mat tmp;
+    MatProduct<R, C, C, T, P>::apply(constPtr(), m.constPtr(), tmp.ptr());
+    *this = tmp;
+
+    return *this;
+  }
+
+/*****************************************************************************/
+  template <size_t R, size_t C, typename T>
+  inline Mat<R, C, T>&
+  Mat<R, C, T>::operator += ( const Mat& m )
+  {
+    T* p = ptr();
+    const T* q = m.constPtr();
+    Unroll<R*C>::apply([=](size_t i) { p[i] += q[i]; });
+
+    return *this;
+  }
+
+/*****************************************************************************/
+  template <size_t R, size_t C, typename T>
+  inline Mat<R, C, T>&
+  Mat<R, C, T>::operator -= ( const Mat& m )
+  {
+    T* p = ptr();
+    const T* q = m.constPtr();
+    Unroll<R*C>::apply([=](size_t i) { p[i] -= q[i]; });
+
+    return *this;
+  }
+
+/*****************************************************************************/
+  template <size_t R, size_t C, typename T>
+  inline Mat<R, C, T>&
+  Mat<R, C, T>::operator *= ( T k )
+  {
+    T* p = ptr();
+    Unroll<R*C>::apply([=](size_t i) { p[i] *= k; });
+
+    return *this;
+  }
+
+/*****************************************************************************/
+  template <size_t R, size_t C, typename T>
+  inline Mat<R, C, T>&
+  Mat<R, C, T>::operator /= ( T k )
+  {
+    T* p = ptr();
+    Unroll<R*C>::apply([=](size_t i) { p[i] /= k; });
+
+    return *this;
+  }
+
+/*****************************************************************************/
+  template <size_t R, size_t C, typename T>
+  inline Mat<R, C, T>
+  Mat<R, C, T>::operator + () const
+  {
+    return *this;
+  }
+
+/*****************************************************************************/
+  template <size_t R, size_t C, typename T>
+  inline Mat<R, C, T>
+  Mat<R, C, T>::operator - () const
+  {
+    Mat res;
+    T* r = res.ptr();
+    const T* p = constPtr();
+    Unroll<R*C>::apply([=](size_t i) { r[i] = -p[i]; });
+
+    return res;
+  }
+
+/*****************************************************************************/
+  template <size_t R, size_t C, typename T>
+  template <Precision P, size_t K>
+  inline Mat<R, K, T>
+  Mat<R, C, T>::operator * ( const Mat<C, K, T>& m ) const
+  {
+    STAR_INSTRUMENT(MATRIX_MULTIPLY);
+    Mat<R, K, T> res;
+    MatProduct<R, C, K, T, P>::apply(constPtr(), m.constPtr(), res.ptr());
+
+    return res;
+  }
+
+/*****************************************************************************/
+  template <size_t R, size_t C, typename T>
+  inline Mat<R, C, T>
+  Mat<R, C, T>::operator + ( const Mat& m ) const
+  {
+    Mat res;
+    T* r = res.ptr();
+    const T* p = constPtr();
+    const T* q = m.constPtr();
+    Unroll<R*C>::apply([=](size_t i) { r[i] = p[i]+q[i]; });
+
+    return res;
+  }
+
+/*****************************************************************************/
+  template <size_t R, size_t C, typename T>
+  inline Mat<R, C, T>
+  Mat<R, C, T>::operator - ( const Mat& m ) const
+  {
+    Mat res;
+    T* r = res.ptr();
+    const T* p = constPtr();
+    const T* q = m.constPtr();
+    Unroll<R*C>::apply([=](size_t i) { r[i] = p[i]-q[i]; });
+
+    return res;
+  }
+
+/*****************************************************************************/
+  template <size_t R, size_t C, typename T>
+  inline Mat<R, C, T>
+  Mat<R, C, T>::operator * ( T k ) const
+  {
+    Mat res;
+    T* r = res.ptr();
+    const T* p = constPtr();
+    Unroll<R*C>::apply([=](size_t i) { r[i] = k*p[i]; });
+
+    return res;
+  }
+
+/*****************************************************************************/
+  template <size_t R, size_t C, typename T>
+  inline Mat<R, C, T>
+  Mat<R, C, T>::operator / ( T k ) const
+  {
+    Mat res;
+    T* r = res.ptr();
+    const T* p = constPtr();
+    Unroll<R*C>::apply([=](size_t i) { r[i] = p[i]/k; });
+
+    return res;
+  }
+
+/*****************************************************************************/
+  template <size_t R, size_t C, typename T>
+  template <Precision P>
+  inline Vec<R, T>
+  Mat<R, C, T>::operator * ( const Vec<C, T>& v ) const
+  {
+    Vec<R, T> res;
+    T* r = res.ptr();
+    const T* p = constPtr();
+    const T* q = v.constPtr();
+    Unroll<R>::apply([=](size_t j) {
+      const T* row = p+j*C;
+      T sum = row[0]*q[0];
+      Unroll<C-1>::apply([&](size_t i) { sum = madd<P, T>(row[i+1], q[i+1], sum); });
+      r[j] = sum;
+    });
+
+    return res;
+  }
+
+/*****************************************************************************/
+  template <size_t R, size_t C, typename T>
+  template <Precision P, size_t M>
+  inline typename std::enable_if<M+1 == C, Vec<M, T> >::type
+  Mat<R, C, T>::operator * ( const Vec<M, T>& v ) const
+  {
+    static_assert(M <= R, "The matrix has less rows than the point coordinates");
+    Vec<M, T> res;
+    T* r = res.ptr();
+    const T* p = constPtr();
+    const T* q = v.constPtr();
+    Unroll<M>::apply([=](size_t j) {
+      const T* row = p+j*C;
+      T sum = row[0]*q[0];
+      Unroll<M-1>::apply([&](size_t i) { sum = madd<P, T>(row[i+1], q[i+1], sum); });
+      r[j] = sum+row[M];
+    });
+
+    return res;
+  }
+
+/*****************************************************************************/
+  template <size_t R, size_t C, typename T>
+  inline bool
+  Mat<R, C, T>::operator == ( const Mat& m ) const
+  {
+    bool res = true;
+    const T* p = constPtr();
+    const T* q = m.constPtr();
+    Unroll<R*C>::apply([&](size_t i) { res = res && p[i] == q[i]; });
+
+    return res;
+  }
+
+/*****************************************************************************/
+  template <size_t R, size_t C, typename T>
+  inline bool
+  Mat<R, C, T>::operator != ( const Mat& m ) const
+  {
+    return !(*this == m);
+  }
+
+/*****************************************************************************/
+  template <size_t R, size_t C, typename T>
+  inline T
+  Mat<R, C, T>::trace() const
+  {
+    T res = m_mat[0][0];
+    Unroll<(R < C ? R : C)-1>::apply([&](size_t i) { res += m_mat[i+1][i+1]; });
+
+    return res;
+  }
+
+/*****************************************************************************/
+  template <size_t R, size_t C, typename T>
+  inline T
+  Mat<R, C, T>::FrobeniusNorm() const
+  {
+    const T* p = constPtr();
+    T res = p[0]*p[0];
+    Unroll<R*C-1>::apply([&](size_t i) { res += p[i+1]*p[i+1]; });
+
+    return std::sqrt(res);
+  }
+
+/*****************************************************************************/
+  template <size_t R, size_t C, typename T>
+  template <Precision P>
+  inline T
+  Mat<R, C, T>::determinant() const
+  {
+    static_assert(R == C, "Only square matrices have a determinant");
+    return MatInverse<R>::template determinant<P>(*this);
+  }
+
+/*****************************************************************************/
+  template <size_t R, size_t C, typename T>
+  template <Precision P>
+  inline Mat<R, C, T>
+  Mat<R, C, T>::inverse() const
+  {
+    T det;
+    return inverse<P>(det);
+  }
+
+/*****************************************************************************/
+  template <size_t R, size_t C, typename T>
+  template <Precision P>
+  Mat<R, C, T>
+  Mat<R, C, T>::inverse(T& det) const
+  {
+    static_assert(R == C, "Only square matrices have an inverse");
+    STAR_INSTRUMENT(MATRIX_INVERSE);
+    det = determinant<P>();
+
+    Mat adj = MatInverse<R>::template adjoint<P>(*this);
+    adj *= reciprocal<P>(det);
+    return adj;
+  }
+
+/*****************************************************************************/
+  template <size_t R, size_t C, typename T>
+  inline Mat<C, R, T>
+  Mat<R, C, T>::transpose() const
+  {
+    Mat<C, R, T> res;
+    T* r = res.ptr();
+    const T* p = constPtr();
+    Unroll<R*C>::apply([=](size_t i) { r[i%C*R+i/C] = p[i]; });
+
+    return res;
+  }
+
+/*****************************************************************************/
+  template <size_t R, size_t C, typename T>
+  inline void
+  Mat<R, C, T>::toIdentity()
+  {
+    T* p = ptr();
+    Unroll<R*C>::apply([=](size_t i) { p[i] = i/C == i%C ? T(1) : T(0); });
+  }
+
+/*****************************************************************************/
+  template <size_t R, size_t C, typename T>
+  template <Precision P, size_t M>
+  STAR_FORCE_INLINE T
+  Mat<R, C, T>::minor4(size_t r0, size_t r1, size_t r2,
+                       size_t c0, size_t c1, size_t c2) const
+  {
+    static_assert(M == 4 && C == 4, "minor4 is only defined for 4x4 matrices");
+    const T t0 = productDifference<P, T>(m_mat[r1][c1], m_mat[r2][c2], m_mat[r1][c2], m_mat[r2][c1]);
+    const T t1 = productDifference<P, T>(m_mat[r1][c0], m_mat[r2][c2], m_mat[r2][c0], m_mat[r1][c2]);
+    const T t2 = productDifference<P, T>(m_mat[r1][c0], m_mat[r2][c1], m_mat[r2][c0], m_mat[r1][c1]);
+    return madd<P, T>(m_mat[r0][c2], t2, productDifference<P, T>(m_mat[r0][c0], t0, m_mat[r0][c1], t1));
+  }
+
+/*****************************************************************************/
+  template <size_t R, size_t C, typename T>
+  template <Precision P, size_t M>
+  inline Mat<R, C, T>
+  Mat<R, C, T>::adjoint4() const
+  {
+    static_assert(M == 4 && C == 4, "adjoint4 is only defined for 4x4 matrices");
+    Mat adj;
+
+    adj(0, 0) =  minor4<P>(1, 2, 3, 1, 2, 3);
+    adj(0, 1) = -minor4<P>(0, 2, 3, 1, 2, 3);
+    adj(0, 2) =  minor4<P>(0, 1, 3, 1, 2, 3);
+    adj(0, 3) = -minor4<P>(0, 1, 2, 1, 2, 3);
+
+    adj(1, 0) = -minor4<P>(1, 2, 3, 0, 2, 3);
+    adj(1, 1) =  minor4<P>(0, 2, 3, 0, 2, 3);
+    adj(1, 2) = -minor4<P>(0, 1, 3, 0, 2, 3);
+    adj(1, 3) =  minor4<P>(0, 1, 2, 0, 2, 3);
+
+    adj(2, 0) =  minor4<P>(1, 2, 3, 0, 1, 3);
+    adj(2, 1) = -minor4<P>(0, 2, 3, 0, 1, 3);
+    adj(2, 2) =  minor4<P>(0, 1, 3, 0, 1, 3);
+    adj(2, 3) = -minor4<P>(0, 1, 2, 0, 1, 3);
+
+    adj(3, 0) = -minor4<P>(1, 2, 3, 0, 1, 2);
+    adj(3, 1) =  minor4<P>(0, 2, 3, 0, 1, 2);
+    adj(3, 2) = -minor4<P>(0, 1, 3, 0, 1, 2);
+    adj(3, 3) =  minor4<P>(0, 1, 2, 0, 1, 2);
+
+    return adj;
+  }
+
+/*****************************************************************************/
+  template <size_t R, size_t C, typename T>
+  template <size_t M>
+  inline void
+  Mat<R, C, T>::makeTranslation(const Vec<3, T> &tr)
+  {
+    static_assert(M == 4 && C == 4, "Translations are 4x4 matrices");
+    toIdentity();
+    m_mat[0][3] = tr[0];
+    m_mat[1][3] = tr[1];
+    m_mat[2][3] = tr[2];
+  }
+
+/*****************************************************************************/
+  template <size_t R, size_t C, typename T>
+  template <size_t M>
+  inline void
+  Mat<R, C, T>::makeTranslation(T x, T y, T z)
+  {
+    makeTranslation<M>(Vec<3, T>(x, y, z));
+  }
+
+/*****************************************************************************/
+  template <size_t R, size_t C, typename T>
+  template <size_t M>
+  inline void
+  Mat<R, C, T>::makeScaling(const Vec<3, T> &scale)
+  {
+    static_assert(M == 4 && C == 4, "Scalings are 4x4 matrices");
+    toIdentity();
+    m_mat[0][0] = scale[0];
+    m_mat[1][1] = scale[1];
+    m_mat[2][2] = scale[2];
+  }
+
+/*****************************************************************************/
+  template <size_t R, size_t C, typename T>
+  template <size_t M>
+  inline void
+  Mat<R, C, T>::makeScaling(T sx, T sy, T sz)
+  {
+    makeScaling<M>(Vec<3, T>(sx, sy, sz));
+  }
+
+/*****************************************************************************/
+  /**
+   * ostream operator for matrices, defined in StarStream.h
+   */
+  template <size_t R, size_t C, typename T>
+  std::ostream&
+  operator << (std::ostream& os, const Mat<R, C, T>& m);
+
+/*****************************************************************************/
+  /**
+   * A 3x3 matrix with float values.
+   */
+  typedef Mat<3, 3, float> float3x3;
+
+  /**
+   * A 3x3 matrix with double values.
+   */
+  typedef Mat<3, 3, double> double3x3;
+
+/*****************************************************************************/
+#ifndef STARMATH_NO_EXTERN_TEMPLATES
+  //Instantiated once in the StarMath library, see StarMath.cpp
+  //Members are defined inline: GCC doesn't inline extern template members otherwise
+  extern template class Mat<2, 2, float>;
+  extern template class Mat<2, 2, double>;
+  extern template class Mat<2, 2, int>;
+  extern template class Mat<4, 4, float>;
+  extern template class Mat<4, 4, double>;
+  extern template class Mat<4, 4, int>;
+
+  //Except the inverse, too large to be inlined and the bulk of the compile
+  //time of the code using it. Only PRECISION_STRICT doesn't depend on the
+  //instruction set, the other policies are compiled with the caller's.
+  //Instrumented code compiles its own, which counts its calls even if the
+  //library was built without STARMATH_INSTRUMENT
+#ifndef STARMATH_INSTRUMENT
+  extern template Mat<2, 2, float> Mat<2, 2, float>::inverse<PRECISION_STRICT>(float&) const;
+  extern template Mat<2, 2, double> Mat<2, 2, double>::inverse<PRECISION_STRICT>(double&) const;
+  extern template Mat<4, 4, float> Mat<4, 4, float>::inverse<PRECISION_STRICT>(float&) const;
+  extern template Mat<4, 4, double> Mat<4, 4, double>::inverse<PRECISION_STRICT>(double&) const;
+#endif
+#endif
+}
+
+#endif
@@ -0,0 +1,118 @@
+#ifndef STAR_MATRIX_BATCH_H
+#define STAR_MATRIX_BATCH_H
+
+#include <StarMath/StarMatrix.h>
+
+#include <cmath>
+#include <cstddef>
+#include <limits>
+
+namespace Star
+{
+  /*******************************************************************************/
+  /**
+   * Compute the adjugate and the determinant of a row-major 4x4 matrix
+   * with Cramer's rule, the twelve 2x2 sub-determinants of the first and
+   * last two rows being shared by the determinant and the cofactors.
+   * Branch free so that loops calling it vectorize.
+   * @param a the 16 values of the matrix
+   * @param b receives the 16 values of the adjugate, must not alias a
+   * @return the determinant
+   */
+  template<typename T>
+  inline T
+  matrixAdjugate(const T* a, T* b)
+  {
+    const T s0 = a[0]*a[5]-a[4]*a[1];
+    const T s1 = a[0]*a[6]-a[4]*a[2];
+    const T s2 = a[0]*a[7]-a[4]*a[3];
+    const T s3 = a[1]*a[6]-a[5]*a[2];
+    const T s4 = a[1]*a[7]-a[5]*a[3];
+    const T s5 = a[2]*a[7]-a[6]*a[3];
+    const T c5 = a[10]*a[15]-a[14]*a[11];
+    const T c4 = a[9]*a[15]-a[13]*a[11];
+    const T c3 = a[9]*a[14]-a[13]*a[10];
+    const T c2 = a[8]*a[15]-a[12]*a[11];
+    const T c1 = a[8]*a[14]-a[12]*a[10];
+    const T c0 = a[8]*a[13]-a[12]*a[9];
+
+    b[0] = a[5]*c5-a[6]*c4+a[7]*c3;
+    b[1] = -a[1]*c5+a[2]*c4-a[3]*c3;
+    b[2] = a[13]*s5-a[14]*s4+a[15]*s3;
+    b[3] = -a[9]*s5+a[10]*s4-a[11]*s3;
+    b[4] = -a[4]*c5+a[6]*c2-a[7]*c1;
+    b[5] = a[0]*c5-a[2]*c2+a[3]*c1;
+    b[6] = -a[12]*s5+a[14]*s2-a[15]*s1;
+    b[7] = a[8]*s5-a[10]*s2+a[11]*s1;
+    b[8] = a[4]*c4-a[5]*c2+a[7]*c0;
+    b[9] = -a[0]*c4+a[1]*c2-a[3]*c0;
+    b[10] = a[12]*s4-a[13]*s2+a[15]*s0;
+    b[11] = -a[8]*s4+a[9]*s2-a[11]*s0;
+    b[12] = -a[4]*c3+a[5]*c1-a[6]*c0;
+    b[13] = a[0]*c3-a[1]*c1+a[2]*c0;
+    b[14] = -a[12]*s3+a[13]*s1-a[14]*s0;
+    b[15] = a[8]*s3-a[9]*s1+a[10]*s0;
+
+    return s0*c5-s1*c4+s2*c3+s3*c2-s4*c1+s5*c0;
+  }
+
+  /*******************************************************************************/
+  /**
+   * Check if a determinant is zero, denormal, infinite or NaN, i.e. if its
+   * reciprocal is not a finite number. A determinant passing the test can
+   * still give an inverse overflowing to infinity, e.g. 1e-30 with cofactors
+   * around 1e9 in float, see matrixInverse.
+   */
+  template<typename T>
+  inline bool
+  isSingularDeterminant(T det)
+  {
+    const T a = std::abs(det);
+    return !(a >= std::numeric_limits<T>::min() && a <= std::numeric_limits<T>::max());
+  }
+
+  /*******************************************************************************/
+  /**
+   * Batch Matrix<T>::inverse for float and double. Loops are branch free so
+   * the compiler can vectorize them. A matrix is singular when its
+   * determinant is zero, denormal, infinite or NaN, or when a coefficient
+   * of its inverse is not finite: its inverse is the zero matrix instead of
+   * infinities.
+   * @param in the n matrices to invert
+   * @param out receives n matrices, may alias in
+   * @param determinants receives the n determinants, may be null
+   * @param singular receives true for the singular matrices, may be null
+   * @param n the number of matrices
+   */
+  template<typename T>
+  void
+  matrixInverse(const Matrix<T>* in, Matrix<T>* out, T* determinants, bool* singular, size_t n)
+  {
+#pragma omp parallel for simd schedule(static) if(n > 16384)
+    for(long i = 0; i < long(n); i++) {
+      T a[16], b[16];
+      for(size_t k = 0; k < 16; k++)
+        a[k] = in[i].constPtr()[k];
+      const T det = matrixAdjugate(a, b);
+      const T invDet = isSingularDeterminant(det) ? T(0) : T(1)/det;
+      for(size_t k = 0; k < 16; k++)
+        b[k] *= invDet;
+      //x*0 is 0, or NaN if x is infinite or NaN. Summed as a tree rather
+      //than a chain of 16 dependent additions
+      T z[8];
+      for(size_t k = 0; k < 8; k++)
+        z[k] = b[k]*T(0)+b[k+8]*T(0);
+      const T nonFinite = ((z[0]+z[4])+(z[2]+z[6]))+((z[1]+z[5])+(z[3]+z[7]));
+      const bool isSingular = isSingularDeterminant(det) || nonFinite != T(0);
+      T* m = out[i].ptr();
+      for(size_t k = 0; k < 16; k++)
+        m[k] = isSingular ? T(0) : b[k];
+      if(determinants)
+        determinants[i] = det;
+      if(singular)
+        singular[i] = isSingular;
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,894 @@
+#ifndef STAR_OCTREE_H
+#define STAR_OCTREE_H
+
+#include <StarMath/StarUtils.h>
+#include <StarMath/StarVec3.h>
+#include <StarMath/StarBox.h>
+#include <StarMath/StarPlane.h>
+
+#include <cassert>
+#include <cstddef>
+#include <algorithm>
+#include <vector>
+
+namespace Star
+{
+  /**
+   * A pointerless octree subdividing a Box<T> domain.
+   *
+   * Nodes live in one contiguous array. The 8 children of a node are stored
+   * next to each other and every node carries its locational code: the
+   * Morton key of its cell prefixed by a 1 bit, so the root key is 1 and the
+   * child c of key k is (k<<3)|c.
+   *
+   * Items are points or boxes. An item is stored in the deepest node whose
+   * cell contains it, points always go down to a leaf. A leaf is split when
+   * it holds more than the leaf capacity and merged back when its parent
+   * subtree fits again after a removal. Items are expected to lie inside the
+   * domain, items outside are clamped to the border cells and can be missed
+   * by queries.
+   */
+  template<typename T>
+  class Octree
+  {
+  public:
+    /**
+     * An octree node.
+     */
+    struct Node
+    {
+      /**
+       * Locational code of the node.
+       */
+      uint64_t key;
+      /**
+       * Index of the parent node, NONE for the root.
+       */
+      unsigned int parent;
+      /**
+       * Index of the first of the 8 children, 0 for a leaf.
+       */
+      unsigned int firstChild;
+      /**
+       * First item of the node item list, NONE if empty.
+       */
+      unsigned int firstItem;
+      /**
+       * Number of items stored in this node.
+       */
+      unsigned int numItems;
+    };
+
+    /**
+     * Create an empty octree. A flat domain, e.g. for points on a plane,
+     * would give cells without volume: its flat axes get the extent of the
+     * largest one, or 1 if all are flat.
+     * @param domain the subdivided space
+     * @param leafCapacity the number of items above which a leaf is split
+     * @param maxDepth the maximum depth, at most MAX_DEPTH
+     */
+    Octree(const Box<T>& domain, unsigned int leafCapacity = 16,
+           unsigned int maxDepth = 10);
+
+    /**
+     * Remove all items.
+     */
+    void clear();
+
+    /**
+     * Replace the content of the octree with points.
+     * The item id of a point is its index in the array.
+     */
+    void build(const Vec3<T>* points, size_t numPoints);
+
+    /**
+     * Replace the content of the octree with boxes.
+     * The item id of a box is its index in the array.
+     */
+    void build(const Box<T>* boxes, size_t numBoxes);
+
+    /**
+     * Insert a point.
+     * @return the item id
+     */
+    unsigned int insert(const Vec3<T>& point);
+
+    /**
+     * Insert a box.
+     * @return the item id
+     */
+    unsigned int insert(const Box<T>& box);
+
+    /**
+     * Remove an item. Its id can be reused by the next insertion.
+     * @return false if the item doesn't exist
+     */
+    bool remove(unsigned int item);
+
+    /**
+     * Find the items overlapping a box.
+     * @return the number of items found
+     */
+    size_t queryBox(const Box<T>& box, std::vector<unsigned int>& items) const;
+
+    /**
+     * Find the items overlapping a sphere.
+     * @return the number of items found
+     */
+    size_t querySphere(const Vec3<T>& center, T radius,
+                       std::vector<unsigned int>& items) const;
+
+    /**
+     * Find the items inside a convex volume bounded by planes whose normals
+     * point inward, e.g. a view frustum. The test is conservative: an item
+     * is rejected only if it is fully behind one of the planes.
+     * @return the number of items found
+     */
+    size_t queryFrustum(const Plane<T>* planes, size_t numPlanes,
+                        std::vector<unsigned int>& items) const;
+
+    /**
+     * Find a node by its locational code.
+     * @return the node index or NONE if the node doesn't exist
+     */
+    unsigned int findNode(uint64_t key) const;
+
+    /**
+     * Get a node.
+     */
+    inline const Node& getNode(unsigned int node) const;
+
+    /**
+     * Get the next item in a node item list.
+     */
+    inline unsigned int getNextItem(unsigned int item) const;
+
+    /**
+     * Get the bounds of an item.
+     */
+    inline const Box<T>& getItemBox(unsigned int item) const;
+
+    /**
+     * Get the depth of a locational code.
+     */
+    static inline unsigned int getDepth(uint64_t key);
+
+    /**
+     * Get the cell of a locational code.
+     */
+    Box<T> getCell(uint64_t key) const;
+
+    /**
+     * Get the number of nodes in the node array, including unused ones.
+     */
+    inline size_t getNumNodes() const;
+
+    /**
+     * Get the number of items.
+     */
+    inline size_t getNumItems() const;
+
+    /**
+     * Get the domain, with the flat axes extended.
+     */
+    inline const Box<T>& getDomain() const;
+
+    static const unsigned int NONE = ~0u;
+    static const unsigned int MAX_DEPTH = 21;
+    static const size_t PARALLEL_BUILD_THRESHOLD = 16384;
+
+  private:
+    struct SortItem
+    {
+      uint64_t code;
+      unsigned int level;
+      unsigned int id;
+      bool operator < (const SortItem& b) const
+      {
+        return code < b.code || (code == b.code && level < b.level);
+      }
+    };
+
+    struct BoxShape
+    {
+      bool overlaps(const Vec3<T>& bmin, const Vec3<T>& bmax) const;
+      Vec3<T> min, max;
+    };
+
+    struct SphereShape
+    {
+      bool overlaps(const Vec3<T>& bmin, const Vec3<T>& bmax) const;
+      Vec3<T> center;
+      T sqrRadius;
+    };
+
+    struct FrustumShape
+    {
+      bool overlaps(const Vec3<T>& bmin, const Vec3<T>& bmax) const;
+      const Plane<T>* planes;
+      size_t numPlanes;
+    };
+
+    template<typename Shape>
+    size_t query(const Shape& shape, std::vector<unsigned int>& items) const;
+
+    void buildItems();
+    unsigned int newItem(const Box<T>& box, bool isPoint);
+    void computeCode(unsigned int item, bool isPoint);
+    uint32_t quantize(T val, size_t axis) const;
+    inline unsigned int digit(uint64_t code, unsigned int depth) const;
+
+    unsigned int buildNode(std::vector<Node>& nodes, const SortItem* items,
+                           size_t lo, size_t hi, unsigned int depth,
+                           uint64_t key, unsigned int parent);
+    void fillNode(std::vector<Node>& nodes, unsigned int node, const SortItem* items,
+                  size_t lo, size_t hi, unsigned int depth);
+    static void initNode(Node& node, uint64_t key, unsigned int parent);
+    unsigned int allocChildren(unsigned int node);
+    void attach(std::vector<Node>& nodes, unsigned int node, unsigned int item);
+    void insertItem(unsigned int item);
+    void split(unsigned int node, unsigned int depth);
+    void collapse(unsigned int node);
+
+    Box<T> m_domain;
+    unsigned int m_leafCapacity;
+    unsigned int m_maxDepth;
+    std::vector<Vec3<T> > m_cellSizes;
+    Vec3<T> m_scale;
+
+    std::vector<Node> m_nodes;
+    std::vector<unsigned int> m_freeBlocks;
+
+    std::vector<Box<T> > m_itemBoxes;
+    std::vector<uint64_t> m_itemCodes;
+    std::vector<unsigned char> m_itemLevels;
+    std::vector<unsigned int> m_itemNext;
+    std::vector<unsigned int> m_itemNodes;
+    std::vector<unsigned int> m_freeItems;
+    size_t m_numItems;
+  };
+
+  /*****************************************************************************/
+  typedef Octree<float> octreef;
+  typedef Octree<double> octreed;
+
+  template<typename T> const unsigned int Octree<T>::NONE;
+  template<typename T> const unsigned int Octree<T>::MAX_DEPTH;
+  template<typename T> const size_t Octree<T>::PARALLEL_BUILD_THRESHOLD;
+
+  /*******************************************************************************/
+  template<typename T>
+  Octree<T>::Octree(const Box<T>& domain, unsigned int leafCapacity,
+                    unsigned int maxDepth)
+    : m_domain(domain), m_leafCapacity(std::max(leafCapacity, 1u)),
+      m_maxDepth(std::min(maxDepth, (unsigned int)MAX_DEPTH))
+  {
+    Vec3<T> size = domain.getSize();
+    const T largest = std::max(size.x, std::max(size.y, size.z));
+    for(size_t i = 0; i < 3; i++)
+      if(!(size[i] > 0))
+        size[i] = largest > 0 ? largest : T(1);
+    m_domain.setMinMax(domain.getMin(), domain.getMin()+size);
+
+    m_cellSizes.resize(m_maxDepth+1);
+    for(unsigned int d = 0; d <= m_maxDepth; d++)
+      m_cellSizes[d] = size/T(1u << d);
+    T res = T(1u << m_maxDepth);
+    m_scale = Vec3<T>(res/size.x, res/size.y, res/size.z);
+    clear();
+  }
+
+  /*******************************************************************************/
+  template<typename T>
+  void
+  Octree<T>::clear()
+  {
+    m_nodes.resize(1);
+    initNode(m_nodes[0], 1, NONE);
+    m_freeBlocks.clear();
+    m_itemBoxes.clear();
+    m_itemCodes.clear();
+    m_itemLevels.clear();
+    m_itemNext.clear();
+    m_itemNodes.clear();
+    m_freeItems.clear();
+    m_numItems = 0;
+  }
+
+  /*******************************************************************************/
+  template<typename T>
+  void
+  Octree<T>::initNode(Node& node, uint64_t key, unsigned int parent)
+  {
+    node.key = key;
+    node.parent = parent;
+    node.firstChild = 0;
+    node.firstItem = NONE;
+    node.numItems = 0;
+  }
+
+  /*******************************************************************************/
+  template<typename T>
+  uint32_t
+  Octree<T>::quantize(T val, size_t axis) const
+  {
+    T q = (val-m_domain.getMin()[axis])*m_scale[axis];
+    T maxQ = T((1u << m_maxDepth)-1);
+    return uint32_t(Star::clamp(q, T(0), maxQ));
+  }
+
+  /*******************************************************************************/
+  template<typename T>
+  unsigned int
+  Octree<T>::digit(uint64_t code, unsigned int depth) const
+  {
+    return (unsigned int)(code >> 3*(m_maxDepth-depth)) & 7;
+  }
+
+  /*******************************************************************************/
+  template<typename T>
+  unsigned int
+  Octree<T>::getDepth(uint64_t key)
+  {
+    unsigned int depth = 0;
+    while(key >>= 3)
+      depth++;
+    return depth;
+  }
+
+  /*******************************************************************************/
+  template<typename T>
+  void
+  Octree<T>::computeCode(unsigned int item, bool isPoint)
+  {
+    const Box<T>& box = m_itemBoxes[item];
+    const Vec3<T>& bmin = box.getMin();
+    const Vec3<T>& bmax = box.getMax();
+    uint64_t cmin = mortonEncode3(quantize(bmin.x, 0), quantize(bmin.y, 1), quantize(bmin.z, 2));
+    m_itemCodes[item] = cmin;
+    if(isPoint) {
+      m_itemLevels[item] = (unsigned char)m_maxDepth;
+      return;
+    }
+
+    //The deepest common cell of both corners contains the whole box
+    uint64_t cmax = mortonEncode3(quantize(bmax.x, 0), quantize(bmax.y, 1), quantize(bmax.z, 2));
+    uint64_t diff = cmin ^ cmax;
+    unsigned int level = m_maxDepth;
+    while(diff) {
+      diff >>= 3;
+      level--;
+    }
+    m_itemLevels[item] = (unsigned char)level;
+  }
+
+  /*******************************************************************************/
+  template<typename T>
+  unsigned int
+  Octree<T>::newItem(const Box<T>& box, bool isPoint)
+  {
+    unsigned int item;
+    if(!m_freeItems.empty()) {
+      item = m_freeItems.back();
+      m_freeItems.pop_back();
+      m_itemBoxes[item] = box;
+    } else {
+      item = (unsigned int)m_itemBoxes.size();
+      m_itemBoxes.push_back(box);
+      m_itemCodes.push_back(0);
+      m_itemLevels.push_back(0);
+      m_itemNext.push_back(NONE);
+      m_itemNodes.push_back(NONE);
+    }
+    computeCode(item, isPoint);
+    m_numItems++;
+    return item;
+  }
+
+  /*******************************************************************************/
+  template<typename T>
+  void
+  Octree<T>::build(const Vec3<T>* points, size_t numPoints)
+  {
+    clear();
+    m_itemBoxes.resize(numPoints);
+    m_itemCodes.resize(numPoints);
+    m_itemLevels.resize(numPoints);
+    m_itemNext.resize(numPoints);
+    m_itemNodes.resize(numPoints);
+#pragma omp parallel for schedule(static)
+    for(long i = 0; i < long(numPoints); i++) {
+      m_itemBoxes[i].setMinMax(points[i], points[i]);
+      computeCode((unsigned int)i, true);
+    }
+    buildItems();
+  }
+
+  /*******************************************************************************/
+  template<typename T>
+  void
+  Octree<T>::build(const Box<T>* boxes, size_t numBoxes)
+  {
+    clear();
+    m_itemBoxes.assign(boxes, boxes+numBoxes);
+    m_itemCodes.resize(numBoxes);
+    m_itemLevels.resize(numBoxes);
+    m_itemNext.resize(numBoxes);
+    m_itemNodes.resize(numBoxes);
+#pragma omp parallel for schedule(static)
+    for(long i = 0; i < long(numBoxes); i++)
+      computeCode((unsigned int)i, false);
+    buildItems();
+  }
+
+  /*******************************************************************************/
+  template<typename T>
+  void
+  Octree<T>::buildItems()
+  {
+    size_t numItems = m_itemBoxes.size();
+    m_numItems = numItems;
+    if(!numItems)
+      return;
+
+    //Sort items by the code of their cell, so every subtree is a contiguous
+    //range starting with the items stuck in its root
+    std::vector<SortItem> items(numItems);
+#pragma omp parallel for schedule(static)
+    for(long i = 0; i < long(numItems); i++) {
+      unsigned int shift = 3*(m_maxDepth-m_itemLevels[i]);
+      items[i].code = (m_itemCodes[i] >> shift) << shift;
+      items[i].level = m_itemLevels[i];
+      items[i].id = (unsigned int)i;
+    }
+    std::sort(items.begin(), items.end());
+
+    if(numItems <= PARALLEL_BUILD_THRESHOLD || m_maxDepth == 0) {
+      fillNode(m_nodes, 0, &items[0], 0, numItems, 0);
+      return;
+    }
+
+    //Attach the root items and build the 8 root subtrees in parallel, each
+    //one in its own node array. They are merged afterward.
+    size_t lo = 0;
+    while(lo < numItems && items[lo].level == 0)
+      attach(m_nodes, 0, items[lo++].id);
+    allocChildren(0);
+
+    size_t bounds[9];
+    bounds[0] = lo;
+    for(unsigned int c = 0; c < 8; c++) {
+      size_t e = bounds[c];
+      while(e < numItems && digit(items[e].code, 1) == c)
+        e++;
+      bounds[c+1] = e;
+    }
+
+    std::vector<Node> subtrees[8];
+#pragma omp parallel for schedule(dynamic, 1)
+    for(int c = 0; c < 8; c++)
+      buildNode(subtrees[c], &items[0], bounds[c], bounds[c+1], 1, 8|c, NONE);
+
+    unsigned int bases[8];
+    for(unsigned int c = 0; c < 8; c++) {
+      bases[c] = (unsigned int)m_nodes.size();
+      m_nodes.resize(m_nodes.size()+subtrees[c].size()-1);
+    }
+
+#pragma omp parallel for schedule(dynamic, 1)
+    for(int c = 0; c < 8; c++) {
+      //Local index 0 is the child slot, the others go after bases[c]
+      const std::vector<Node>& sub = subtrees[c];
+      const unsigned int slot = 1+c;
+      const unsigned int offset = bases[c]-1;
+      for(size_t i = 0; i < sub.size(); i++) {
+        unsigned int dst = i ? (unsigned int)i+offset : slot;
+        Node node = sub[i];
+        node.parent = i ? (node.parent ? node.parent+offset : slot) : 0;
+        if(node.firstChild)
+          node.firstChild += offset;
+        m_nodes[dst] = node;
+        for(unsigned int it = node.firstItem; it != NONE; it = m_itemNext[it])
+          m_itemNodes[it] = dst;
+      }
+    }
+  }
+
+  /*******************************************************************************/
+  template<typename T>
+  unsigned int
+  Octree<T>::buildNode(std::vector<Node>& nodes, const SortItem* items,
+                       size_t lo, size_t hi, unsigned int depth,
+                       uint64_t key, unsigned int parent)
+  {
+    unsigned int node = (unsigned int)nodes.size();
+    nodes.resize(nodes.size()+1);
+    initNode(nodes[node], key, parent);
+    fillNode(nodes, node, items, lo, hi, depth);
+    return node;
+  }
+
+  /*******************************************************************************/
+  template<typename T>
+  void
+  Octree<T>::fillNode(std::vector<Node>& nodes, unsigned int node, const SortItem* items,
+                      size_t lo, size_t hi, unsigned int depth)
+  {
+    if(hi-lo <= m_leafCapacity || depth == m_maxDepth) {
+      for(size_t i = lo; i < hi; i++)
+        attach(nodes, node, items[i].id);
+      return;
+    }
+
+    while(lo < hi && items[lo].level == depth)
+      attach(nodes, node, items[lo++].id);
+
+    unsigned int first = (unsigned int)nodes.size();
+    nodes.resize(nodes.size()+8);
+    nodes[node].firstChild = first;
+    for(unsigned int c = 0; c < 8; c++)
+      initNode(nodes[first+c], (nodes[node].key << 3) | c, node);
+
+    for(unsigned int c = 0; c < 8; c++) {
+      size_t e = lo;
+      while(e < hi && digit(items[e].code, depth+1) == c)
+        e++;
+      fillNode(nodes, first+c, items, lo, e, depth+1);
+      lo = e;
+    }
+  }
+
+  /*******************************************************************************/
+  template<typename T>
+  void
+  Octree<T>::attach(std::vector<Node>& nodes, unsigned int node, unsigned int item)
+  {
+    m_itemNext[item] = nodes[node].firstItem;
+    m_itemNodes[item] = node;
+    nodes[node].firstItem = item;
+    nodes[node].numItems++;
+  }
+
+  /*******************************************************************************/
+  template<typename T>
+  unsigned int
+  Octree<T>::allocChildren(unsigned int node)
+  {
+    unsigned int first;
+    if(!m_freeBlocks.empty()) {
+      first = m_freeBlocks.back();
+      m_freeBlocks.pop_back();
+    } else {
+      first = (unsigned int)m_nodes.size();
+      m_nodes.resize(m_nodes.size()+8);
+    }
+    m_nodes[node].firstChild = first;
+    for(unsigned int c = 0; c < 8; c++)
+      initNode(m_nodes[first+c], (m_nodes[node].key << 3) | c, node);
+    return first;
+  }
+
+  /*******************************************************************************/
+  template<typename T>
+  unsigned int
+  Octree<T>::insert(const Vec3<T>& point)
+  {
+    unsigned int item = newItem(Box<T>(point, point), true);
+    insertItem(item);
+    return item;
+  }
+
+  /*******************************************************************************/
+  template<typename T>
+  unsigned int
+  Octree<T>::insert(const Box<T>& box)
+  {
+    unsigned int item = newItem(box, false);
+    insertItem(item);
+    return item;
+  }
+
+  /*******************************************************************************/
+  template<typename T>
+  void
+  Octree<T>::insertItem(unsigned int item)
+  {
+    unsigned int node = 0;
+    unsigned int depth = 0;
+    while(m_nodes[node].firstChild && depth < m_itemLevels[item]) {
+      depth++;
+      node = m_nodes[node].firstChild+digit(m_itemCodes[item], depth);
+    }
+
+    attach(m_nodes, node, item);
+    if(!m_nodes[node].firstChild && m_nodes[node].numItems > m_leafCapacity &&
+       depth < m_maxDepth)
+      split(node, depth);
+  }
+
+  /*******************************************************************************/
+  template<typename T>
+  void
+  Octree<T>::split(unsigned int node, unsigned int depth)
+  {
+    unsigned int first = allocChildren(node);
+
+    //Push down every item that fits in a child
+    unsigned int item = m_nodes[node].firstItem;
+    m_nodes[node].firstItem = NONE;
+    m_nodes[node].numItems = 0;
+    while(item != NONE) {
+      unsigned int next = m_itemNext[item];
+      if(m_itemLevels[item] > depth)
+        attach(m_nodes, first+digit(m_itemCodes[item], depth+1), item);
+      else
+        attach(m_nodes, node, item);
+      item = next;
+    }
+
+    if(depth+1 < m_maxDepth) {
+      for(unsigned int c = 0; c < 8; c++) {
+        if(m_nodes[first+c].numItems > m_leafCapacity)
+          split(first+c, depth+1);
+      }
+    }
+  }
+
+  /*******************************************************************************/
+  template<typename T>
+  bool
+  Octree<T>::remove(unsigned int item)
+  {
+    if(item >= m_itemNodes.size() || m_itemNodes[item] == NONE)
+      return false;
+
+    unsigned int node = m_itemNodes[item];
+    unsigned int* link = &m_nodes[node].firstItem;
+    while(*link != item)
+      link = &m_itemNext[*link];
+    *link = m_itemNext[item];
+    m_nodes[node].numItems--;
+
+    m_itemNodes[item] = NONE;
+    m_freeItems.push_back(item);
+    m_numItems--;
+
+    collapse(m_nodes[node].firstChild ? node : m_nodes[node].parent);
+    return true;
+  }
+
+  /*******************************************************************************/
+  template<typename T>
+  void
+  Octree<T>::collapse(unsigned int node)
+  {
+    while(node != NONE) {
+      Node& n = m_nodes[node];
+      unsigned int first = n.firstChild;
+      unsigned int total = n.numItems;
+      for(unsigned int c = 0; c < 8; c++) {
+        if(m_nodes[first+c].firstChild)
+          return;
+        total += m_nodes[first+c].numItems;
+      }
+      if(total > m_leafCapacity)
+        return;
+
+      for(unsigned int c = 0; c < 8; c++) {
+        unsigned int item = m_nodes[first+c].firstItem;
+        while(item != NONE) {
+          unsigned int next = m_itemNext[item];
+          attach(m_nodes, node, item);
+          item = next;
+        }
+      }
+      n.firstChild = 0;
+      m_freeBlocks.push_back(first);
+      node = n.parent;
+    }
+  }
+
+  /*******************************************************************************/
+  template<typename T>
+  unsigned int
+  Octree<T>::findNode(uint64_t key) const
+  {
+    unsigned int depth = getDepth(key);
+    unsigned int node = 0;
+    for(unsigned int d = depth; d > 0; d--) {
+      if(!m_nodes[node].firstChild)
+        return NONE;
+      node = m_nodes[node].firstChild+((key >> 3*(d-1)) & 7);
+    }
+    return node;
+  }
+
+  /*******************************************************************************/
+  template<typename T>
+  Box<T>
+  Octree<T>::getCell(uint64_t key) const
+  {
+    unsigned int depth = getDepth(key);
+    uint32_t x, y, z;
+    mortonDecode3(key & ~(uint64_t(1) << 3*depth), x, y, z);
+    const Vec3<T>& size = m_cellSizes[depth];
+    Vec3<T> min = m_domain.getMin()+Vec3<T>(x*size.x, y*size.y, z*size.z);
+    return Box<T>(min, min+size);
+  }
+
+  /*******************************************************************************/
+  template<typename T>
+  const typename Octree<T>::Node&
+  Octree<T>::getNode(unsigned int node) const
+  {
+    return m_nodes[node];
+  }
+
+  /*******************************************************************************/
+  template<typename T>
+  unsigned int
+  Octree<T>::getNextItem(unsigned int item) const
+  {
+    return m_itemNext[item];
+  }
+
+  /*******************************************************************************/
+  template<typename T>
+  const Box<T>&
+  Octree<T>::getItemBox(unsigned int item) const
+  {
+    return m_itemBoxes[item];
+  }
+
+  /*******************************************************************************/
+  template<typename T>
+  size_t
+  Octree<T>::getNumNodes() const
+  {
+    return m_nodes.size();
+  }
+
+  /*******************************************************************************/
+  template<typename T>
+  size_t
+  Octree<T>::getNumItems() const
+  {
+    return m_numItems;
+  }
+
+  /*******************************************************************************/
+  template<typename T>
+  const Box<T>&
+  Octree<T>::getDomain() const
+  {
+    return m_domain;
+  }
+
+  /*******************************************************************************/
+  template<typename T>
+  bool
+  Octree<T>::BoxShape::overlaps(const Vec3<T>& bmin, const Vec3<T>& bmax) const
+  {
+    return bmin.x <= max.x && bmax.x >= min.x &&
+           bmin.y <= max.y && bmax.y >= min.y &&
+           bmin.z <= max.z && bmax.z >= min.z;
+  }
+
+  /*******************************************************************************/
+  template<typename T>
+  bool
+  Octree<T>::SphereShape::overlaps(const Vec3<T>& bmin, const Vec3<T>& bmax) const
+  {
+    T sqrDist = 0;
+    for(size_t i = 0; i < 3; i++) {
+      T d = Star::clamp(center[i], bmin[i], bmax[i])-center[i];
+      sqrDist += d*d;
+    }
+    return sqrDist <= sqrRadius;
+  }
+
+  /*******************************************************************************/
+  template<typename T>
+  bool
+  Octree<T>::FrustumShape::overlaps(const Vec3<T>& bmin, const Vec3<T>& bmax) const
+  {
+    for(size_t i = 0; i < numPlanes; i++) {
+      //Test the corner the furthest along the normal
+      const Vec3<T>& n = planes[i].getNormal();
+      Vec3<T> p(n.x >= 0 ? bmax.x : bmin.x,
+                n.y >= 0 ? bmax.y : bmin.y,
+                n.z >= 0 ? bmax.z : bmin.z);
+      if(n.dot(p) < planes[i].getDistance())
+        return false;
+    }
+    return true;
+  }
+
+  /*******************************************************************************/
+  template<typename T>
+  template<typename Shape>
+  size_t
+  Octree<T>::query(const Shape& shape, std::vector<unsigned int>& items) const
+  {
+    struct StackEntry
+    {
+      unsigned int node;
+      unsigned int depth;
+      Vec3<T> min;
+    };
+
+    items.clear();
+    StackEntry stack[8*MAX_DEPTH+1];
+    size_t top = 0;
+    stack[top].node = 0;
+    stack[top].depth = 0;
+    stack[top].min = m_domain.getMin();
+    top++;
+
+    while(top > 0) {
+      top--;
+      const Node& node = m_nodes[stack[top].node];
+      const unsigned int depth = stack[top].depth;
+      const Vec3<T> cellMin = stack[top].min;
+      if(depth && !shape.overlaps(cellMin, cellMin+m_cellSizes[depth]))
+        continue;
+
+      for(unsigned int item = node.firstItem; item != NONE; item = m_itemNext[item]) {
+        const Box<T>& box = m_itemBoxes[item];
+        if(shape.overlaps(box.getMin(), box.getMax()))
+          items.push_back(item);
+      }
+
+      if(node.firstChild) {
+        const Vec3<T>& size = m_cellSizes[depth+1];
+        for(unsigned int c = 0; c < 8; c++) {
+          stack[top].node = node.firstChild+c;
+          stack[top].depth = depth+1;
+          stack[top].min = cellMin+Vec3<T>(c & 1 ? size.x : 0,
+                                           c & 2 ? size.y : 0,
+                                           c & 4 ? size.z : 0);
+          top++;
+        }
+      }
+    }
+
+    return items.size();
+  }
+
+  /*******************************************************************************/
+  template<typename T>
+  size_t
+  Octree<T>::queryBox(const Box<T>& box, std::vector<unsigned int>& items) const
+  {
+    BoxShape shape;
+    shape.min = box.getMin();
+    shape.max = box.getMax();
+    return query(shape, items);
+  }
+
+  /*******************************************************************************/
+  template<typename T>
+  size_t
+  Octree<T>::querySphere(const Vec3<T>& center, T radius,
+                         std::vector<unsigned int>& items) const
+  {
+    SphereShape shape;
+    shape.center = center;
+    shape.sqrRadius = radius*radius;
+    return query(shape, items);
+  }
+
+  /*******************************************************************************/
+  template<typename T>
+  size_t
+  Octree<T>::queryFrustum(const Plane<T>* planes, size_t numPlanes,
+                          std::vector<unsigned int>& items) const
+  {
+    FrustumShape shape;
+    shape.planes = planes;
+    shape.numPlanes = numPlanes;
+    return query(shape, items);
+  }
+}
+
+#endif
@@ -1,12 +1,30 @@
 #ifndef STAR_PLANE_H
 #define STAR_PLANE_H
 
+#include <StarMath/StarVec3.h>
+#include <StarMath/StarSoA.h>
+
+#include <cassert>
+#include <cstddef>
+#include <algorithm>
+#include <stdint.h>
+
 namespace Star
 {
   template<typename T>
   class Plane
   {
   public:
+    /**
+     * Side of a point relative to the plane.
+     */
+    enum Side
+    {
+      ON = 0,
+      FRONT = 1,
+      BACK = 2
+    };
+
     /**
      * Create a plane.
      * @param normal the plane's normal
@@ -41,6 +59,23 @@ namespace Star
      */
     T getDistance() const;
 
+    /**
+     * Compute the signed distance of a point to the plane. Positive in front
+     * of the plane, i.e. on the normal side. The normal must be unit length.
+     */
+    inline T distance(const Vec3<T>& p) const;
+
+    /**
+     * Project a point on the plane. The normal must be unit length.
+     */
+    inline Vec3<T> project(const Vec3<T>& p) const;
+
+    /**
+     * Find on which side of the plane a point is.
+     * @param epsilon is the half thickness of the plane
+     */
+    inline Side classify(const Vec3<T>& p, T epsilon) const;
+
   private:
     Vec3<T> m_normal;
     T m_distance;
@@ -94,6 +129,228 @@ namespace Star
   {
     return m_distance;
   }
+
+  /*******************************************************************************/
+  template<typename T>
+  T
+  Plane<T>::distance(const Vec3<T>& p) const
+  {
+    return m_normal.dot(p)-m_distance;
+  }
+
+  /*******************************************************************************/
+  template<typename T>
+  Vec3<T>
+  Plane<T>::project(const Vec3<T>& p) const
+  {
+    return p-m_normal*distance(p);
+  }
+
+  /*******************************************************************************/
+  template<typename T>
+  typename Plane<T>::Side
+  Plane<T>::classify(const Vec3<T>& p, T epsilon) const
+  {
+    T d = distance(p);
+    if(d > epsilon)
+      return FRONT;
+    if(d < -epsilon)
+      return BACK;
+    return ON;
+  }
+
+  /*******************************************************************************/
+  /**
+   * Compute the signed distances of points to a plane.
+   * @param plane the plane, with a unit normal
+   * @param points the points
+   * @param numPoints the number of points
+   * @param distances receives numPoints distances
+   */
+  template<typename T>
+  void
+  planeDistances(const Plane<T>& plane, const Vec3<T>* points, size_t numPoints,
+                 T* distances)
+  {
+    const T nx = plane.getNormal().x, ny = plane.getNormal().y, nz = plane.getNormal().z;
+    const T d = plane.getDistance();
+#pragma omp parallel for simd schedule(static) if(numPoints > 65536)
+    for(long i = 0; i < long(numPoints); i++)
+      distances[i] = nx*points[i].x+ny*points[i].y+nz*points[i].z-d;
+  }
+
+  /*******************************************************************************/
+  /**
+   * Compute the signed distances of points to a plane.
+   * @param plane the plane, with a unit normal
+   * @param points the points
+   * @param numPoints the number of points
+   * @param distances receives numPoints distances
+   */
+  template<typename T>
+  void
+  planeDistances(const Plane<T>& plane, Vec3SoA<const T> points, size_t numPoints,
+                 T* distances)
+  {
+    const T nx = plane.getNormal().x, ny = plane.getNormal().y, nz = plane.getNormal().z;
+    const T d = plane.getDistance();
+    const T* px = points.x;
+    const T* py = points.y;
+    const T* pz = points.z;
+#pragma omp parallel for simd schedule(static) if(numPoints > 65536)
+    for(long i = 0; i < long(numPoints); i++)
+      distances[i] = nx*px[i]+ny*py[i]+nz*pz[i]-d;
+  }
+
+  /*******************************************************************************/
+  /**
+   * Project points on a plane. Input and output may be the same arrays.
+   * @param plane the plane, with a unit normal
+   * @param points the points
+   * @param numPoints the number of points
+   * @param projected receives numPoints points
+   */
+  template<typename T>
+  void
+  planeProject(const Plane<T>& plane, Vec3SoA<const T> points, size_t numPoints,
+               Vec3SoA<T> projected)
+  {
+    const T nx = plane.getNormal().x, ny = plane.getNormal().y, nz = plane.getNormal().z;
+    const T d = plane.getDistance();
+    const T* px = points.x;
+    const T* py = points.y;
+    const T* pz = points.z;
+    T* ox = projected.x;
+    T* oy = projected.y;
+    T* oz = projected.z;
+#pragma omp parallel for simd schedule(static) if(numPoints > 65536)
+    for(long i = 0; i < long(numPoints); i++) {
+      T dist = nx*px[i]+ny*py[i]+nz*pz[i]-d;
+      ox[i] = px[i]-nx*dist;
+      oy[i] = py[i]-ny*dist;
+      oz[i] = pz[i]-nz*dist;
+    }
+  }
+
+  /*******************************************************************************/
+  /**
+   * Find on which side of a plane points are.
+   * @param plane the plane, with a unit normal
+   * @param points the points
+   * @param numPoints the number of points
+   * @param epsilon is the half thickness of the plane
+   * @param sides receives numPoints Plane<T>::Side values
+   */
+  template<typename T>
+  void
+  planeClassify(const Plane<T>& plane, const Vec3<T>* points, size_t numPoints,
+                T epsilon, unsigned char* sides)
+  {
+    const T nx = plane.getNormal().x, ny = plane.getNormal().y, nz = plane.getNormal().z;
+    const T d = plane.getDistance();
+#pragma omp parallel for simd schedule(static) if(numPoints > 65536)
+    for(long i = 0; i < long(numPoints); i++) {
+      T dist = nx*points[i].x+ny*points[i].y+nz*points[i].z-d;
+      sides[i] = (unsigned char)((dist > epsilon)*Plane<T>::FRONT+
+                                 (dist < -epsilon)*Plane<T>::BACK);
+    }
+  }
+
+  /*******************************************************************************/
+  /**
+   * Find on which side of a plane points are.
+   * @param plane the plane, with a unit normal
+   * @param points the points
+   * @param numPoints the number of points
+   * @param epsilon is the half thickness of the plane
+   * @param sides receives numPoints Plane<T>::Side values
+   */
+  template<typename T>
+  void
+  planeClassify(const Plane<T>& plane, Vec3SoA<const T> points, size_t numPoints,
+                T epsilon, unsigned char* sides)
+  {
+    const T nx = plane.getNormal().x, ny = plane.getNormal().y, nz = plane.getNormal().z;
+    const T d = plane.getDistance();
+    const T* px = points.x;
+    const T* py = points.y;
+    const T* pz = points.z;
+#pragma omp parallel for simd schedule(static) if(numPoints > 65536)
+    for(long i = 0; i < long(numPoints); i++) {
+      T dist = nx*px[i]+ny*py[i]+nz*pz[i]-d;
+      sides[i] = (unsigned char)((dist > epsilon)*Plane<T>::FRONT+
+                                 (dist < -epsilon)*Plane<T>::BACK);
+    }
+  }
+
+  /*******************************************************************************/
+  /**
+   * Classify points against up to 32 planes at once.
+   * Bit i of a mask is set when the point is on the corresponding side of
+   * planes[i]. A point inside a convex volume whose planes point inward
+   * has a null back mask.
+   * @param planes the planes, with unit normals
+   * @param numPlanes the number of planes, at most 32
+   * @param points the points
+   * @param numPoints the number of points
+   * @param epsilon is the half thickness of the planes
+   * @param backMasks if not null, receives numPoints masks of the planes
+   * the points are behind
+   * @param frontMasks if not null, receives numPoints masks of the planes
+   * the points are in front of
+   */
+  template<typename T>
+  void
+  planesClassify(const Plane<T>* planes, size_t numPlanes,
+                 Vec3SoA<const T> points, size_t numPoints, T epsilon,
+                 uint32_t* backMasks, uint32_t* frontMasks)
+  {
+    assert(numPlanes <= 32);
+
+    //Go through all the planes for a block of points while it is in cache
+    const long blockSize = 1024;
+    const long numBlocks = long((numPoints+blockSize-1)/blockSize);
+#pragma omp parallel for schedule(static) if(numPoints > 65536)
+    for(long block = 0; block < numBlocks; block++) {
+      const long begin = block*blockSize;
+      const long end = std::min(begin+blockSize, long(numPoints));
+      uint32_t back[blockSize];
+      uint32_t front[blockSize];
+      for(long i = 0; i < end-begin; i++)
+        back[i] = front[i] = 0;
+
+      for(size_t p = 0; p < numPlanes; p++) {
+        const T nx = planes[p].getNormal().x;
+        const T ny = planes[p].getNormal().y;
+        const T nz = planes[p].getNormal().z;
+        const T d = planes[p].getDistance();
+        const T* px = points.x+begin;
+        const T* py = points.y+begin;
+        const T* pz = points.z+begin;
+#pragma omp simd
+        for(long i = 0; i < end-begin; i++) {
+          T dist = nx*px[i]+ny*py[i]+nz*pz[i]-d;
+          back[i] |= uint32_t(dist < -epsilon) << p;
+          front[i] |= uint32_t(dist > epsilon) << p;
+        }
+      }
+
+      for(long i = 0; i < end-begin; i++) {
+        if(backMasks)
+          backMasks[begin+i] = back[i];
+        if(frontMasks)
+          frontMasks[begin+i] = front[i];
+      }
+    }
+  }
+
+/*****************************************************************************/
+#ifndef STARMATH_NO_EXTERN_TEMPLATES
+  //Instantiated once in the StarMath library, see StarMath.cpp
+  extern template class Plane<float>;
+  extern template class Plane<double>;
+  extern template class Plane<int>;
+#endif
 }
 
 #endif
@@ -0,0 +1,174 @@
+#ifndef STAR_PRECISION_H
+#define STAR_PRECISION_H
+
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define STAR_PRECISION_SSE
+#include <xmmintrin.h>
+#endif
+
+namespace Star
+{
+  /**
+   * Floating point policy of the Vec, Mat and Quaternion kernels: dot
+   * products, cross products, matrix products, determinants, inverses and
+   * normalizations.
+   *
+   * - PRECISION_STRICT: separate multiplies and adds in source order, the
+   *   results only depend on IEEE rounding. The code including these
+   *   headers must be compiled with -ffp-contract=off with GCC and Clang,
+   *   which fuse them when the target has FMA instructions otherwise: the
+   *   StarMath CMake target adds it to the targets linking it,
+   *   FindStarMath.cmake sets it in STARMATH_CXX_FLAGS and the other
+   *   builds must add it themselves.
+   * - PRECISION_FMA: multiply-adds are fused when the target has FMA
+   *   instructions, plain multiply-adds otherwise.
+   * - PRECISION_FAST: PRECISION_FMA, plus float reciprocals and reciprocal
+   *   square roots from the instruction set estimates refined by one
+   *   Newton-Raphson step (about 22 bits). double is computed as FMA.
+   *
+   * Every function honoring the policy takes it as its first template
+   * parameter, defaulting to STARMATH_PRECISION, e.g. v.normalize() or
+   * v.normalize<PRECISION_FAST>(). STARMATH_PRECISION is set by the
+   * STARMATH_PRECISION CMake option and must be the same for the whole
+   * program: the StarMath CMake target exports it and FindStarMath.cmake
+   * sets it in STARMATH_CXX_FLAGS.
+   */
+  enum Precision
+  {
+    PRECISION_STRICT,
+    PRECISION_FMA,
+    PRECISION_FAST
+  };
+}
+
+#ifndef STARMATH_PRECISION
+#define STARMATH_PRECISION Star::PRECISION_STRICT
+#endif
+
+#if defined(__FMA__) || defined(__AVX2__)
+#define STAR_HAS_FMA
+#endif
+
+namespace Star
+{
+/*****************************************************************************/
+  /**
+   * a*b+c with a single rounding when the target has FMA instructions.
+   */
+  template <typename T>
+  inline T
+  fusedMultiplyAdd(T a, T b, T c)
+  {
+    return a*b+c;
+  }
+
+  inline float
+  fusedMultiplyAdd(float a, float b, float c)
+  {
+#ifdef STAR_HAS_FMA
+    return std::fma(a, b, c);
+#else
+    return a*b+c;
+#endif
+  }
+
+  inline double
+  fusedMultiplyAdd(double a, double b, double c)
+  {
+#ifdef STAR_HAS_FMA
+    return std::fma(a, b, c);
+#else
+    return a*b+c;
+#endif
+  }
+
+/*****************************************************************************/
+  /**
+   * a*b+c, fused unless P is PRECISION_STRICT.
+   */
+  template <Precision P, typename T>
+  inline T
+  madd(T a, T b, T c)
+  {
+    return P == PRECISION_STRICT ? T(a*b+c) : fusedMultiplyAdd(a, b, c);
+  }
+
+/*****************************************************************************/
+  /**
+   * a*b-c*d, the 2x2 determinant the cross products and the minors are
+   * made of. With PRECISION_STRICT the same bits as the plain expression.
+   */
+  template <Precision P, typename T>
+  inline T
+  productDifference(T a, T b, T c, T d)
+  {
+    return madd<P, T>(a, b, T(-(c*d)));
+  }
+
+/*****************************************************************************/
+  /**
+   * Approximate float reciprocals, the same estimates and Newton-Raphson
+   * steps as simd::rcp and simd::rsqrt. Exact for the other types.
+   */
+  template <typename T>
+  inline T
+  approxReciprocal(T x)
+  {
+    return T(1)/x;
+  }
+
+  inline float
+  approxReciprocal(float x)
+  {
+#ifdef STAR_PRECISION_SSE
+    const float y = _mm_cvtss_f32(_mm_rcp_ss(_mm_set_ss(x)));
+    return y*(2.f-x*y);
+#else
+    return 1.f/x;
+#endif
+  }
+
+  template <typename T>
+  inline T
+  approxReciprocalSqrt(T x)
+  {
+    return T(1)/T(std::sqrt(x));
+  }
+
+  inline float
+  approxReciprocalSqrt(float x)
+  {
+#ifdef STAR_PRECISION_SSE
+    const float y = _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(x)));
+    return 0.5f*y*(3.f-x*y*y);
+#else
+    return 1.f/std::sqrt(x);
+#endif
+  }
+
+/*****************************************************************************/
+  /**
+   * 1/x, approximate for float with PRECISION_FAST.
+   */
+  template <Precision P, typename T>
+  inline T
+  reciprocal(T x)
+  {
+    return P == PRECISION_FAST ? approxReciprocal(x) : T(1)/x;
+  }
+
+/*****************************************************************************/
+  /**
+   * 1/sqrt(x), approximate for float with PRECISION_FAST.
+   */
+  template <Precision P, typename T>
+  inline T
+  reciprocalSqrt(T x)
+  {
+    return P == PRECISION_FAST ? approxReciprocalSqrt(x) : T(1)/T(std::sqrt(x));
+  }
+}
+
+#endif
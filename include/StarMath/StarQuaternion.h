@@ -2,8 +2,12 @@
 #define STAR_QUATERNION_H
 
 #include <StarMath/StarUtils.h>
+#include <StarMath/StarInstrument.h>
+#include <StarMath/StarPrecision.h>
 #include <StarMath/StarMatrix.h>
 
+#include <iosfwd>
+
 namespace Star
 {
   //template <typename T> class Quaternion;
@@ -61,6 +65,7 @@ namespace Star
     /**
      * Multiplication.
      */
+    template <Precision P = STARMATH_PRECISION>
     Quaternion& operator *= ( const Quaternion& );
 
     /**
@@ -96,6 +101,7 @@ namespace Star
     /**
      * Multiplication.
      */
+    template <Precision P = STARMATH_PRECISION>
     Quaternion operator * ( const Quaternion& ) const;
 
     /**
@@ -141,11 +147,20 @@ namespace Star
     /**
      * Compute the length
      */
+    template <Precision P = STARMATH_PRECISION>
     T length() const;
 
+    /**
+     * Normalize the quaternion.
+     * @return The quaternion length
+     */
+    template <Precision P = STARMATH_PRECISION>
+    T normalize();
+
     /**
      * Dot product.
      */
+    template <Precision P = STARMATH_PRECISION>
     T dot( const Quaternion<T>& q ) const;
 
     /**
@@ -173,9 +188,87 @@ namespace Star
     void toRotationMatrix(Matrix<T>& rotation) const;
 
     /**
-     * Rotate the specified vector with this quaternion.
+     * Set this quaternion from the rotation part (upper 3x3) of a matrix.
+     * The rotation must be orthonormal.
+     */
+    void fromRotationMatrix(const Matrix<T>& rotation);
+
+    /**
+     * Rotate the specified vector with this quaternion, which must have a
+     * unit length. Uses the cross product form, cheaper than q*v*q^-1.
+     */
+    template <Precision P = STARMATH_PRECISION>
+    Vec3<T> rotate(const Vec3<T>&v) const;
+
+    /**
+     * Spherical linear interpolation between two unit quaternions along
+     * the shortest path. Falls back to nlerp when they are very close.
+     * @param a the rotation at t=0
+     * @param b the rotation at t=1
+     * @param t the interpolation parameter in [0,1]
+     */
+    static Quaternion slerp(const Quaternion& a, const Quaternion& b, T t);
+
+    /**
+     * Normalized linear interpolation between two unit quaternions along
+     * the shortest path. Not constant speed.
+     */
+    static Quaternion nlerp(const Quaternion& a, const Quaternion& b, T t);
+
+    /**
+     * Approximate slerp: nlerp with a corrected parameter. Much cheaper than
+     * slerp, the resulting rotation is within 8e-4 radian of the slerp one.
+     */
+    static Quaternion slerpFast(const Quaternion& a, const Quaternion& b, T t);
+
+    /**
+     * Correct t so that nlerp between quaternions whose absolute dot product
+     * is d approximates slerp. Used by slerpFast.
+     */
+    static inline T slerpFastParameter(T d, T t);
+
+    /**
+     * Above this absolute dot product, slerp falls back to nlerp.
+     */
+    static T slerpThreshold() { return T(0.9995); }
+
+    /**
+     * Exponential of the pure quaternion (v, 0): the rotation of angle
+     * 2|v| around v. Uses a series expansion for small angles.
+     */
+    static Quaternion exp(const Vec3<T>& v);
+
+    /**
+     * Logarithm of a unit quaternion, the inverse of exp. Returns half the
+     * rotation angle times the rotation axis.
+     */
+    Vec3<T> log() const;
+
+    /**
+     * Power of a unit quaternion: the same rotation with its angle scaled
+     * by t.
      */
-    Vec3<T> rotate(const Vec3<T>&v);
+    Quaternion pow(T t) const;
+
+    /**
+     * Advance an orientation by a constant angular velocity.
+     * @param q the unit orientation
+     * @param omega the angular velocity in world space, in radian/s
+     * @param dt the time step
+     * @return exp(omega*dt/2)*q, normalized
+     */
+    static Quaternion integrate(const Quaternion& q, const Vec3<T>& omega, T dt);
+
+    /**
+     * Compute sin(a)/a and cos(a) from a^2 with their series expansions,
+     * accurate to double precision for a below expSeriesLimit().
+     */
+    static inline void expSeries(T a2, T& sinc, T& cosine);
+
+    /**
+     * Below this angle, exp uses expSeries instead of sin and cos.
+     */
+    static T expSeriesLimit() { return T(0.25); }
 
   public:
     T x, y, z, w;
@@ -187,7 +280,7 @@ namespace Star
 
   /*******************************************************************************/
   template <typename T>
-  Quaternion<T>::Quaternion( const T * ptr )
+  inline Quaternion<T>::Quaternion( const T * ptr )
   {
     x = ptr[0];
     y = ptr[1];
@@ -197,33 +290,33 @@ namespace Star
 
   /*******************************************************************************/
   template <typename T>
-  Quaternion<T>::Quaternion( T x, T y, T z, T w ) :x(x), y(y), z(z), w(w) {}
+  inline Quaternion<T>::Quaternion( T x, T y, T z, T w ) :x(x), y(y), z(z), w(w) {}
 
 
   /*******************************************************************************/
   template <typename T>
-  Quaternion<T>::Quaternion(const Vec3<T>& axis, const T angle)
+  inline Quaternion<T>::Quaternion(const Vec3<T>& axis, const T angle)
   {
     fromAxisAngle(axis, angle);
   }
 
   /*******************************************************************************/
   template <typename T>
-  Quaternion<T>::operator T* ()
+  inline Quaternion<T>::operator T* ()
   {
     return &x;
   }
 
   /*******************************************************************************/
   template <typename T>
-  Quaternion<T>::operator const T* () const
+  inline Quaternion<T>::operator const T* () const
   {
     return &x;
   }
 
   /*******************************************************************************/
   template <typename T>
-  Quaternion<T>&
+  inline Quaternion<T>&
   Quaternion<T>::operator += ( const Quaternion& q )
   {
     x += q.x;
@@ -236,7 +329,7 @@ namespace Star
 
   /*******************************************************************************/
   template <typename T>
-  Quaternion<T>&
+  inline Quaternion<T>&
   Quaternion<T>::operator -= ( const Quaternion& q )
   {
     x -= q.x;
@@ -249,24 +342,16 @@ namespace Star
 
   /*******************************************************************************/
   template <typename T>
-  Quaternion<T>&
+  template <Precision P>
+  inline Quaternion<T>&
   Quaternion<T>::operator *= ( const Quaternion& q )
   {
-
-    T tmpW = w*q.w - x*q.x - y*q.y - z*q.z;
-    T tmpX = w*q.x + x*q.w + y*q.z - z*q.y;
-    T tmpY = w*q.y - x*q.z + y*q.w + z*q.x;
-    z = w*q.z + x*q.y - y*q.x + z*q.w;
-    x = tmpX;
-    y = tmpY;
-    w = tmpW;
-
-    return *this;
+    return *this = operator *<P>(q);
   }
 
   /*******************************************************************************/
   template <typename T>
-  Quaternion<T>&
+  inline Quaternion<T>&
   Quaternion<T>::operator *= ( T k )
   {
     x *= k;
@@ -279,7 +364,7 @@ namespace Star
 
   /*******************************************************************************/
   template <typename T>
-  Quaternion<T>&
+  inline Quaternion<T>&
   Quaternion<T>::operator /= ( T k )
   {
     return *this *= T(1)/k;
@@ -287,7 +372,7 @@ namespace Star
 
   /*******************************************************************************/
   template <typename T>
-  Quaternion<T>
+  inline Quaternion<T>
   Quaternion<T>::operator + () const
   {
     return *this;
@@ -295,7 +380,7 @@ namespace Star
 
   /*******************************************************************************/
   template <typename T>
-  Quaternion<T>
+  inline Quaternion<T>
   Quaternion<T>::operator - () const
   {
     return Quaternion<T>(-x, -y, -z, -w);
@@ -303,7 +388,7 @@ namespace Star
 
   /*******************************************************************************/
   template <typename T>
-  Quaternion<T>
+  inline Quaternion<T>
   Quaternion<T>::operator + ( const Quaternion& q ) const
   {
     return Quaternion<T>(x+q.x, y+q.y, z+q.z, w+q.w);
@@ -311,7 +396,7 @@ namespace Star
 
   /*******************************************************************************/
   template <typename T>
-  Quaternion<T>
+  inline Quaternion<T>
   Quaternion<T>::operator - ( const Quaternion& q ) const
   {
     return Quaternion<T>(x-q.x, y-q.y, z-q.z, w-q.w);
@@ -319,18 +404,20 @@ namespace Star
 
   /*******************************************************************************/
   template <typename T>
-  Quaternion<T>
+  template <Precision P>
+  inline Quaternion<T>
   Quaternion<T>::operator * ( const Quaternion& q ) const
   {
-    return Quaternion<T>(w*q.x + x*q.w + y*q.z - z*q.y,
-                         w*q.y - x*q.z + y*q.w + z*q.x,
-                         w*q.z + x*q.y - y*q.x + z*q.w,
-                         w*q.w - x*q.x - y*q.y - z*q.z);
+    //Accumulated left to right, w*q.x + x*q.w + y*q.z - z*q.y, ...
+    return Quaternion<T>(madd<P, T>(-z, q.y, madd<P, T>(y, q.z, madd<P, T>(x, q.w, w*q.x))),
+                         madd<P, T>(z, q.x, madd<P, T>(y, q.w, madd<P, T>(-x, q.z, w*q.y))),
+                         madd<P, T>(z, q.w, madd<P, T>(-y, q.x, madd<P, T>(x, q.y, w*q.z))),
+                         madd<P, T>(-z, q.z, madd<P, T>(-y, q.y, madd<P, T>(-x, q.x, w*q.w))));
   }
 
   /*******************************************************************************/
   template <typename T>
-  Quaternion<T>
+  inline Quaternion<T>
   Quaternion<T>::operator * ( T k ) const
   {
     return Quaternion<T>(k*x, k*y, k*z, k*w);
@@ -338,7 +425,7 @@ namespace Star
 
   /*******************************************************************************/
   template <typename T>
-  Quaternion<T>
+  inline Quaternion<T>
   Quaternion<T>::operator / ( T k ) const
   {
     T tmp = T(1)/k;
@@ -347,7 +434,7 @@ namespace Star
 
   /*******************************************************************************/
   template <typename T>
-  bool
+  inline bool
   Quaternion<T>::operator == ( const Quaternion& q ) const
   {
     return isZero(x-q.x) && isZero(y-q.y) && isZero(z-q.z) && isZero(w-q.w);
@@ -355,7 +442,7 @@ namespace Star
 
   /*******************************************************************************/
   template <typename T>
-  bool
+  inline bool
   Quaternion<T>::operator != ( const Quaternion& q ) const
   {
     return !(q == *this);
@@ -363,7 +450,7 @@ namespace Star
 
   /*******************************************************************************/
   template <typename T>
-  T
+  inline T
   Quaternion<T>::norm() const
   {
     return x*x+y*y+z*z+w*w;
@@ -371,23 +458,38 @@ namespace Star
 
   /*******************************************************************************/
   template <typename T>
-  T
+  template <Precision P>
+  inline T
   Quaternion<T>::length() const
   {
-    return std::sqrt(x*x+y*y+z*z+w*w);
+    return std::sqrt(dot<P>(*this));
   }
 
   /*******************************************************************************/
   template <typename T>
-  T
+  template <Precision P>
+  inline T
+  Quaternion<T>::normalize()
+  {
+    const T len2 = dot<P>(*this);
+    const T invLen = reciprocalSqrt<P>(len2);
+    *this *= invLen;
+
+    return P == PRECISION_FAST ? len2*invLen : T(std::sqrt(len2));
+  }
+
+  /*******************************************************************************/
+  template <typename T>
+  template <Precision P>
+  inline T
   Quaternion<T>::dot( const Quaternion<T>& q ) const
   {
-    return x*q.x+y*q.y+z*q.z+w*q.w;
+    return madd<P, T>(w, q.w, madd<P, T>(z, q.z, madd<P, T>(y, q.y, x*q.x)));
   }
 
   /*******************************************************************************/
   template <typename T>
-  void
+  inline void
   Quaternion<T>::toIdentity()
   {
     x = y = z = 0;
@@ -396,7 +498,7 @@ namespace Star
 
   /*******************************************************************************/
   template <typename T>
-  Quaternion<T>
+  inline Quaternion<T>
   Quaternion<T>::conjugate() const
   {
     return Quaternion<T>(-x, -y, -z, w);
@@ -404,7 +506,7 @@ namespace Star
 
   /*******************************************************************************/
   template <typename T>
-  void
+  inline void
   Quaternion<T>::toAxisAngle( Vec3<T>& axis, T& angle ) const
   {
     T scale = std::sqrt(x*x+y*y+z*z);
@@ -427,7 +529,7 @@ namespace Star
 
   /*******************************************************************************/
   template <typename T>
-  void
+  inline void
   Quaternion<T>::fromAxisAngle(const Vec3<T>& axis, const T angle)
   {
     assert(!axis.isNull());
@@ -451,7 +553,7 @@ namespace Star
 
   /*******************************************************************************/
   template <typename T>
-  Quaternion<T>
+  inline Quaternion<T>
   Quaternion<T>::inverse() const
   {
     Quaternion<T> conj = conjugate();
@@ -460,7 +562,7 @@ namespace Star
 
   /*******************************************************************************/
   template <typename T>
-  Quaternion<T>
+  inline Quaternion<T>
   Quaternion<T>::inverseUnit() const
   {
     assert(isZero(norm()-T(1)));
@@ -469,12 +571,12 @@ namespace Star
 
   /*******************************************************************************/
   template <typename T>
-  void
+  inline void
   Quaternion<T>::toRotationMatrix(Matrix<T>& rotation) const
   {
-    float x2=x*x;
-    float y2=y*y;
-    float z2=z*z;
+    T x2=x*x;
+    T y2=y*y;
+    T z2=z*z;
 
     rotation(0, 0) = 1 - 2*y2 - 2*z2;
     rotation(0, 1) = 2*x*y - 2*w*z;
@@ -495,34 +597,196 @@ namespace Star
     rotation(3, 3) = 1;
   }
 
+  /*******************************************************************************/
+  template <typename T>
+  inline void
+  Quaternion<T>::fromRotationMatrix(const Matrix<T>& m)
+  {
+    //Divide by the largest component to stay accurate (Shepperd)
+    T tw = 1+m(0, 0)+m(1, 1)+m(2, 2);
+    T tx = 1+m(0, 0)-m(1, 1)-m(2, 2);
+    T ty = 1-m(0, 0)+m(1, 1)-m(2, 2);
+    T tz = 1-m(0, 0)-m(1, 1)+m(2, 2);
+
+    if(tw >= tx && tw >= ty && tw >= tz) {
+      T s = T(0.5)/std::sqrt(tw);
+      *this = Quaternion<T>(m(2, 1)-m(1, 2), m(0, 2)-m(2, 0), m(1, 0)-m(0, 1), tw)*s;
+    } else if(tx >= ty && tx >= tz) {
+      T s = T(0.5)/std::sqrt(tx);
+      *this = Quaternion<T>(tx, m(0, 1)+m(1, 0), m(0, 2)+m(2, 0), m(2, 1)-m(1, 2))*s;
+    } else if(ty >= tz) {
+      T s = T(0.5)/std::sqrt(ty);
+      *this = Quaternion<T>(m(0, 1)+m(1, 0), ty, m(1, 2)+m(2, 1), m(0, 2)-m(2, 0))*s;
+    } else {
+      T s = T(0.5)/std::sqrt(tz);
+      *this = Quaternion<T>(m(0, 2)+m(2, 0), m(1, 2)+m(2, 1), tz, m(1, 0)-m(0, 1))*s;
+    }
+  }
+
   /*****************************************************************************/
   template <typename T>
-  Vec3<T>
-  Quaternion<T>::rotate(const Vec3<T>&v)
+  template <Precision P>
+  inline Vec3<T>
+  Quaternion<T>::rotate(const Vec3<T>&v) const
   {
-    Quaternion<T> p = Quaternion<T>(v.x, v.y, v.z, T(0));
-    p = (*this)*p*inverseUnit();
-    return Vec3<T>(p.x, p.y, p.z);
+    STAR_INSTRUMENT(QUATERNION_ROTATE);
+    //v+2w(q x v)+2q x (q x v), with t = 2(q x v)
+    Vec3<T> u(x, y, z);
+    Vec3<T> t = u.template cross<P>(v)*T(2);
+    Vec3<T> c = u.template cross<P>(t);
+    return Vec3<T>(madd<P, T>(t.x, w, v.x)+c.x,
+                   madd<P, T>(t.y, w, v.y)+c.y,
+                   madd<P, T>(t.z, w, v.z)+c.z);
   }
 
   /*****************************************************************************/
   template <typename T>
-  std::ostream&
-  operator << (std::ostream& os, const Quaternion<T>& q)
+  inline Quaternion<T>
+  Quaternion<T>::nlerp(const Quaternion& a, const Quaternion& b, T t)
   {
-    return os << "(" << q.x << ", " << q.y <<  ", " << q.z << ", " << q.w << ")";
+    T sign = a.dot(b) < 0 ? T(-1) : T(1);
+    Quaternion<T> q = a*(T(1)-t)+b*(sign*t);
+    q.normalize();
+    return q;
+  }
+
+  /*****************************************************************************/
+  template <typename T>
+  inline Quaternion<T>
+  Quaternion<T>::slerp(const Quaternion& a, const Quaternion& b, T t)
+  {
+    T d = a.dot(b);
+    T sign = T(1);
+    if(d < 0) {
+      d = -d;
+      sign = T(-1);
+    }
+
+    if(d > slerpThreshold())
+      return nlerp(a, b, t);
+
+    T theta = std::acos(d);
+    T invSin = T(1)/std::sin(theta);
+    T wa = std::sin((T(1)-t)*theta)*invSin;
+    T wb = sign*std::sin(t*theta)*invSin;
+    return a*wa+b*wb;
+  }
+
+  /*****************************************************************************/
+  template <typename T>
+  inline T
+  Quaternion<T>::slerpFastParameter(T d, T t)
+  {
+    //Fitted correction of the nlerp parameter, see
+    //http://zeux.io/2015/07/23/approximating-slerp/
+    T A = T(1.0904)+d*(T(-3.2452)+d*(T(3.55645)-d*T(1.43519)));
+    T B = T(0.848013)+d*(T(-1.06021)+d*T(0.215638));
+    T h = t-T(0.5);
+    T k = A*h*h+B;
+    return t+t*h*(t-T(1))*k;
+  }
+
+  /*****************************************************************************/
+  template <typename T>
+  inline Quaternion<T>
+  Quaternion<T>::slerpFast(const Quaternion& a, const Quaternion& b, T t)
+  {
+    return nlerp(a, b, slerpFastParameter(std::abs(a.dot(b)), t));
+  }
+
+  /*****************************************************************************/
+  template <typename T>
+  inline void
+  Quaternion<T>::expSeries(T a2, T& sinc, T& cosine)
+  {
+    sinc = 1-a2/6*(1-a2/20*(1-a2/42*(1-a2/72*(1-a2/110))));
+    cosine = 1-a2/2*(1-a2/12*(1-a2/30*(1-a2/56*(1-a2/90))));
+  }
+
+  /*****************************************************************************/
+  template <typename T>
+  inline Quaternion<T>
+  Quaternion<T>::exp(const Vec3<T>& v)
+  {
+    T a2 = v.dot(v);
+    T sinc, cosine;
+    if(a2 < expSeriesLimit()*expSeriesLimit()) {
+      expSeries(a2, sinc, cosine);
+    } else {
+      T a = std::sqrt(a2);
+      sinc = std::sin(a)/a;
+      cosine = std::cos(a);
+    }
+    return Quaternion<T>(v.x*sinc, v.y*sinc, v.z*sinc, cosine);
+  }
+
+  /*****************************************************************************/
+  template <typename T>
+  inline Vec3<T>
+  Quaternion<T>::log() const
+  {
+    Vec3<T> v(x, y, z);
+    T s = v.length();
+
+    //atan(s/w)/s, with its series when s/w is tiny
+    T k;
+    if(w > 0 && s < T(1e-3)*w) {
+      T r2 = s*s/(w*w);
+      k = (1-r2*(T(1)/3-r2/5))/w;
+    } else if(s > 0) {
+      k = std::atan2(s, w)/s;
+    } else {
+      k = 0;
+    }
+    return v*k;
+  }
+
+  /*****************************************************************************/
+  template <typename T>
+  inline Quaternion<T>
+  Quaternion<T>::pow(T t) const
+  {
+    return exp(log()*t);
   }
 
   /*****************************************************************************/
-  //Here to avoid circular dependency
   template <typename T>
+  inline Quaternion<T>
+  Quaternion<T>::integrate(const Quaternion& q, const Vec3<T>& omega, T dt)
+  {
+    Quaternion<T> res = exp(omega*(dt/2))*q;
+    res.normalize();
+    return res;
+  }
+
+  /*****************************************************************************/
+  /**
+   * ostream operator for quaternions, defined in StarStream.h
+   */
+  template <typename T>
+  std::ostream&
+  operator << (std::ostream& os, const Quaternion<T>& q);
+
+  /*****************************************************************************/
+  //Here to avoid circular dependency
+  template <size_t R, size_t C, typename T>
+  template <size_t M>
   void
-  Matrix<T>::makeRotationAxis(const Vec3<T> axis, T angle)
+  Mat<R, C, T>::makeRotationAxis(const Vec<3, T> axis, T angle)
   {
+    static_assert(M == 4 && C == 4, "Rotations are 4x4 matrices");
     Quaternion<T> q;
     q.fromAxisAngle(axis, angle);
     q.toRotationMatrix(*this);
   }
+
+/*****************************************************************************/
+#ifndef STARMATH_NO_EXTERN_TEMPLATES
+  //Instantiated once in the StarMath library, see StarMath.cpp
+  //Members are defined inline: GCC doesn't inline extern template members otherwise
+  extern template class Quaternion<float>;
+  extern template class Quaternion<double>;
+#endif
 }
 
 
@@ -0,0 +1,488 @@
+#ifndef STAR_QUATERNION_BATCH_H
+#define STAR_QUATERNION_BATCH_H
+
+#include <StarMath/StarQuaternion.h>
+#include <StarMath/StarSoA.h>
+
+#include <cmath>
+#include <cstddef>
+#include <algorithm>
+
+namespace Star
+{
+  /*******************************************************************************/
+  /**
+   * Write the 3x3 rotation matrix of a unit quaternion, row major.
+   * @param m receives the 3 rows
+   * @param rowStride the distance between two rows, 4 for 3x4 matrices
+   */
+  template<typename T>
+  inline void
+  quaternionRotationRows(const Quaternion<T>& q, T* m, size_t rowStride = 3)
+  {
+    const T x2 = q.x*q.x, y2 = q.y*q.y, z2 = q.z*q.z;
+    const T xy = q.x*q.y, xz = q.x*q.z, yz = q.y*q.z;
+    const T wx = q.w*q.x, wy = q.w*q.y, wz = q.w*q.z;
+    T* r0 = m;
+    T* r1 = m+rowStride;
+    T* r2 = m+2*rowStride;
+    r0[0] = 1-2*(y2+z2); r0[1] = 2*(xy-wz);   r0[2] = 2*(xz+wy);
+    r1[0] = 2*(xy+wz);   r1[1] = 1-2*(x2+z2); r1[2] = 2*(yz-wx);
+    r2[0] = 2*(xz-wy);   r2[1] = 2*(yz+wx);   r2[2] = 1-2*(x2+y2);
+  }
+
+  /*******************************************************************************/
+  /**
+   * Compute a unit quaternion from 3 rotation rows, branch free so that
+   * loops calling it vectorize. Same result as
+   * Quaternion<T>::fromRotationMatrix.
+   * @param r0, r1, r2 the first 3 values of each row
+   */
+  template<typename T>
+  inline void
+  quaternionFromRotationRows(const T* r0, const T* r1, const T* r2,
+                             T& x, T& y, T& z, T& w)
+  {
+    T tw = 1+r0[0]+r1[1]+r2[2];
+    T tx = 1+r0[0]-r1[1]-r2[2];
+    T ty = 1-r0[0]+r1[1]-r2[2];
+    T tz = 1-r0[0]-r1[1]+r2[2];
+    T dx = r2[1]-r1[2], sx = r0[1]+r1[0];
+    T dy = r0[2]-r2[0], sy = r1[2]+r2[1];
+    T dz = r1[0]-r0[1], sz = r0[2]+r2[0];
+
+    //Same selection as fromRotationMatrix, written as selects
+    bool cw = tw >= tx && tw >= ty && tw >= tz;
+    bool cx = !cw && tx >= ty && tx >= tz;
+    bool cy = !cw && !cx && ty >= tz;
+    T t = cw ? tw : (cx ? tx : (cy ? ty : tz));
+    T s = T(0.5)/std::sqrt(t);
+    x = s*(cw ? dx : (cx ? tx : (cy ? sx : sz)));
+    y = s*(cw ? dy : (cx ? sx : (cy ? ty : sy)));
+    z = s*(cw ? dz : (cx ? sz : (cy ? sy : tz)));
+    w = s*(cw ? tw : (cx ? dx : (cy ? dy : dz)));
+  }
+
+  /*******************************************************************************/
+  /**
+   * Batch Quaternion<T>::nlerp on structure of arrays.
+   * Loops are branch free so the compiler can vectorize them.
+   * @param a the rotations at t=0
+   * @param b the rotations at t=1
+   * @param t the interpolation parameters
+   * @param out receives n quaternions, may alias a or b
+   * @param n the number of quaternions
+   */
+  template<typename T>
+  void
+  quaternionNlerp(QuaternionSoA<const T> a, QuaternionSoA<const T> b, const T* t,
+                  QuaternionSoA<T> out, size_t n)
+  {
+#pragma omp parallel for simd schedule(static) if(n > 65536)
+    for(long i = 0; i < long(n); i++) {
+      T d = a.x[i]*b.x[i]+a.y[i]*b.y[i]+a.z[i]*b.z[i]+a.w[i]*b.w[i];
+      T wa = T(1)-t[i];
+      T wb = d < 0 ? -t[i] : t[i];
+      T x = wa*a.x[i]+wb*b.x[i];
+      T y = wa*a.y[i]+wb*b.y[i];
+      T z = wa*a.z[i]+wb*b.z[i];
+      T w = wa*a.w[i]+wb*b.w[i];
+      T invLen = T(1)/std::sqrt(x*x+y*y+z*z+w*w);
+      out.x[i] = x*invLen;
+      out.y[i] = y*invLen;
+      out.z[i] = z*invLen;
+      out.w[i] = w*invLen;
+    }
+  }
+
+  /*******************************************************************************/
+  /**
+   * Batch Quaternion<T>::slerp on structure of arrays.
+   * The trigonometric calls only vectorize when the compiler has a vector
+   * math library (e.g. glibc libmvec with -ffast-math), use
+   * quaternionSlerpFast otherwise.
+   * @param a the rotations at t=0
+   * @param b the rotations at t=1
+   * @param t the interpolation parameters
+   * @param out receives n quaternions, may alias a or b
+   * @param n the number of quaternions
+   */
+  template<typename T>
+  void
+  quaternionSlerp(QuaternionSoA<const T> a, QuaternionSoA<const T> b, const T* t,
+                  QuaternionSoA<T> out, size_t n)
+  {
+    const T threshold = Quaternion<T>::slerpThreshold();
+#pragma omp parallel for simd schedule(static) if(n > 65536)
+    for(long i = 0; i < long(n); i++) {
+      T d = a.x[i]*b.x[i]+a.y[i]*b.y[i]+a.z[i]*b.z[i]+a.w[i]*b.w[i];
+      T sign = d < 0 ? T(-1) : T(1);
+      d = std::abs(d);
+
+      //Close quaternions use nlerp weights and are normalized
+      bool close = d > threshold;
+      T theta = std::acos(close ? T(0) : d);
+      T invSin = T(1)/std::sin(theta);
+      T wa = close ? T(1)-t[i] : std::sin((T(1)-t[i])*theta)*invSin;
+      T wb = sign*(close ? t[i] : std::sin(t[i]*theta)*invSin);
+
+      T x = wa*a.x[i]+wb*b.x[i];
+      T y = wa*a.y[i]+wb*b.y[i];
+      T z = wa*a.z[i]+wb*b.z[i];
+      T w = wa*a.w[i]+wb*b.w[i];
+      T scale = close ? T(1)/std::sqrt(x*x+y*y+z*z+w*w) : T(1);
+      out.x[i] = x*scale;
+      out.y[i] = y*scale;
+      out.z[i] = z*scale;
+      out.w[i] = w*scale;
+    }
+  }
+
+  /*******************************************************************************/
+  /**
+   * Batch Quaternion<T>::slerpFast on structure of arrays. Only uses
+   * arithmetic and a square root, so it vectorizes everywhere.
+   * @param a the rotations at t=0
+   * @param b the rotations at t=1
+   * @param t the interpolation parameters
+   * @param out receives n quaternions, may alias a or b
+   * @param n the number of quaternions
+   */
+  template<typename T>
+  void
+  quaternionSlerpFast(QuaternionSoA<const T> a, QuaternionSoA<const T> b, const T* t,
+                      QuaternionSoA<T> out, size_t n)
+  {
+#pragma omp parallel for simd schedule(static) if(n > 65536)
+    for(long i = 0; i < long(n); i++) {
+      T d = a.x[i]*b.x[i]+a.y[i]*b.y[i]+a.z[i]*b.z[i]+a.w[i]*b.w[i];
+      T ct = Quaternion<T>::slerpFastParameter(std::abs(d), t[i]);
+      T wa = T(1)-ct;
+      T wb = d < 0 ? -ct : ct;
+      T x = wa*a.x[i]+wb*b.x[i];
+      T y = wa*a.y[i]+wb*b.y[i];
+      T z = wa*a.z[i]+wb*b.z[i];
+      T w = wa*a.w[i]+wb*b.w[i];
+      T invLen = T(1)/std::sqrt(x*x+y*y+z*z+w*w);
+      out.x[i] = x*invLen;
+      out.y[i] = y*invLen;
+      out.z[i] = z*invLen;
+      out.w[i] = w*invLen;
+    }
+  }
+
+  /*******************************************************************************/
+  /**
+   * Batch Quaternion<T>::nlerp on arrays of quaternions. Prefer the
+   * structure of arrays version for large batches.
+   */
+  template<typename T>
+  void
+  quaternionNlerp(const Quaternion<T>* a, const Quaternion<T>* b, const T* t,
+                  Quaternion<T>* out, size_t n)
+  {
+    for(size_t i = 0; i < n; i++)
+      out[i] = Quaternion<T>::nlerp(a[i], b[i], t[i]);
+  }
+
+  /*******************************************************************************/
+  /**
+   * Batch Quaternion<T>::slerp on arrays of quaternions.
+   */
+  template<typename T>
+  void
+  quaternionSlerp(const Quaternion<T>* a, const Quaternion<T>* b, const T* t,
+                  Quaternion<T>* out, size_t n)
+  {
+    for(size_t i = 0; i < n; i++)
+      out[i] = Quaternion<T>::slerp(a[i], b[i], t[i]);
+  }
+
+  /*******************************************************************************/
+  /**
+   * Batch Quaternion<T>::slerpFast on arrays of quaternions.
+   */
+  template<typename T>
+  void
+  quaternionSlerpFast(const Quaternion<T>* a, const Quaternion<T>* b, const T* t,
+                      Quaternion<T>* out, size_t n)
+  {
+    for(size_t i = 0; i < n; i++)
+      out[i] = Quaternion<T>::slerpFast(a[i], b[i], t[i]);
+  }
+
+  /*******************************************************************************/
+  /**
+   * Rotate vectors by one unit quaternion, on structure of arrays.
+   * The quaternion is converted once to a 3x3 matrix, which is cheaper per
+   * vector than the cross product form.
+   * @param q the rotation
+   * @param in the vectors to rotate
+   * @param out receives n vectors, may alias in
+   * @param n the number of vectors
+   */
+  template<typename T>
+  void
+  quaternionRotate(const Quaternion<T>& q, Vec3SoA<const T> in, Vec3SoA<T> out, size_t n)
+  {
+    T m[9];
+    quaternionRotationRows(q, m);
+
+#pragma omp parallel for simd schedule(static) if(n > 65536)
+    for(long i = 0; i < long(n); i++) {
+      T vx = in.x[i], vy = in.y[i], vz = in.z[i];
+      out.x[i] = m[0]*vx+m[1]*vy+m[2]*vz;
+      out.y[i] = m[3]*vx+m[4]*vy+m[5]*vz;
+      out.z[i] = m[6]*vx+m[7]*vy+m[8]*vz;
+    }
+  }
+
+  /*******************************************************************************/
+  /**
+   * Rotate each vector by its own unit quaternion, on structure of arrays.
+   * Uses the cross product form of Quaternion<T>::rotate.
+   * @param q the rotations
+   * @param in the vectors to rotate
+   * @param out receives n vectors, may alias in
+   * @param n the number of vectors
+   */
+  template<typename T>
+  void
+  quaternionRotate(QuaternionSoA<const T> q, Vec3SoA<const T> in, Vec3SoA<T> out, size_t n)
+  {
+#pragma omp parallel for simd schedule(static) if(n > 65536)
+    for(long i = 0; i < long(n); i++) {
+      T qx = q.x[i], qy = q.y[i], qz = q.z[i], qw = q.w[i];
+      T vx = in.x[i], vy = in.y[i], vz = in.z[i];
+      T tx = 2*(qy*vz-qz*vy);
+      T ty = 2*(qz*vx-qx*vz);
+      T tz = 2*(qx*vy-qy*vx);
+      out.x[i] = vx+qw*tx+(qy*tz-qz*ty);
+      out.y[i] = vy+qw*ty+(qz*tx-qx*tz);
+      out.z[i] = vz+qw*tz+(qx*ty-qy*tx);
+    }
+  }
+
+  /*******************************************************************************/
+  /**
+   * Rotate an array of vectors by one unit quaternion.
+   * @param out receives n vectors, may alias in
+   */
+  template<typename T>
+  void
+  quaternionRotate(const Quaternion<T>& q, const Vec3<T>* in, Vec3<T>* out, size_t n)
+  {
+    T m[9];
+    quaternionRotationRows(q, m);
+
+#pragma omp parallel for simd schedule(static) if(n > 65536)
+    for(long i = 0; i < long(n); i++) {
+      T vx = in[i].x, vy = in[i].y, vz = in[i].z;
+      out[i].x = m[0]*vx+m[1]*vy+m[2]*vz;
+      out[i].y = m[3]*vx+m[4]*vy+m[5]*vz;
+      out[i].z = m[6]*vx+m[7]*vy+m[8]*vz;
+    }
+  }
+
+  /*******************************************************************************/
+  /**
+   * Rotate each vector of an array by its own unit quaternion.
+   * @param out receives n vectors, may alias in
+   */
+  template<typename T>
+  void
+  quaternionRotate(const Quaternion<T>* q, const Vec3<T>* in, Vec3<T>* out, size_t n)
+  {
+#pragma omp parallel for simd schedule(static) if(n > 65536)
+    for(long i = 0; i < long(n); i++) {
+      T qx = q[i].x, qy = q[i].y, qz = q[i].z, qw = q[i].w;
+      T vx = in[i].x, vy = in[i].y, vz = in[i].z;
+      T tx = 2*(qy*vz-qz*vy);
+      T ty = 2*(qz*vx-qx*vz);
+      T tz = 2*(qx*vy-qy*vx);
+      out[i].x = vx+qw*tx+(qy*tz-qz*ty);
+      out[i].y = vy+qw*ty+(qz*tx-qx*tz);
+      out[i].z = vz+qw*tz+(qx*ty-qy*tx);
+    }
+  }
+
+  /*******************************************************************************/
+  /**
+   * Convert unit quaternions and translations into 3x4 affine matrices, on
+   * structure of arrays. Each matrix is 12 values, row major: the upper
+   * 3 rows of the matching Matrix<T>.
+   * @param q the rotations
+   * @param t the translations, a null view means no translation
+   * @param out receives n*12 values
+   * @param n the number of poses
+   */
+  template<typename T>
+  void
+  quaternionToRotationMatrix(QuaternionSoA<const T> q, Vec3SoA<const T> t, T* out, size_t n)
+  {
+    const bool translate = t.x != 0;
+#pragma omp parallel for simd schedule(static) if(n > 65536)
+    for(long i = 0; i < long(n); i++) {
+      T* m = out+12*i;
+      quaternionRotationRows(Quaternion<T>(q.x[i], q.y[i], q.z[i], q.w[i]), m, 4);
+      m[3] = translate ? t.x[i] : T(0);
+      m[7] = translate ? t.y[i] : T(0);
+      m[11] = translate ? t.z[i] : T(0);
+    }
+  }
+
+  /*******************************************************************************/
+  /**
+   * Convert arrays of unit quaternions and translations into 3x4 affine
+   * matrices, see the structure of arrays version.
+   * @param t the translations, may be null
+   */
+  template<typename T>
+  void
+  quaternionToRotationMatrix(const Quaternion<T>* q, const Vec3<T>* t, T* out, size_t n)
+  {
+    const bool translate = t != 0;
+#pragma omp parallel for simd schedule(static) if(n > 65536)
+    for(long i = 0; i < long(n); i++) {
+      T* m = out+12*i;
+      quaternionRotationRows(q[i], m, 4);
+      m[3] = translate ? t[i].x : T(0);
+      m[7] = translate ? t[i].y : T(0);
+      m[11] = translate ? t[i].z : T(0);
+    }
+  }
+
+  /*******************************************************************************/
+  /**
+   * Convert an array of unit quaternions into 4x4 rotation matrices.
+   */
+  template<typename T>
+  void
+  quaternionToRotationMatrix(const Quaternion<T>* q, Matrix<T>* out, size_t n)
+  {
+#pragma omp parallel for schedule(static) if(n > 65536)
+    for(long i = 0; i < long(n); i++)
+      q[i].toRotationMatrix(out[i]);
+  }
+
+  /*******************************************************************************/
+  /**
+   * Extract the rotations of 3x4 affine matrices as unit quaternions, on
+   * structure of arrays. The rotation parts must be orthonormal.
+   * @param in n*12 values, see quaternionToRotationMatrix
+   * @param q receives n quaternions
+   * @param n the number of poses
+   * @param stride the distance between two matrices, 16 reads an array of
+   * Matrix<T>
+   */
+  template<typename T>
+  void
+  quaternionFromRotationMatrix(const T* in, QuaternionSoA<T> q, size_t n, size_t stride = 12)
+  {
+#pragma omp parallel for simd schedule(static) if(n > 65536)
+    for(long i = 0; i < long(n); i++) {
+      const T* m = in+stride*i;
+      quaternionFromRotationRows(m, m+4, m+8, q.x[i], q.y[i], q.z[i], q.w[i]);
+    }
+  }
+
+  /*******************************************************************************/
+  /**
+   * Extract the rotations of 3x4 affine matrices into an array of unit
+   * quaternions, see the structure of arrays version.
+   */
+  template<typename T>
+  void
+  quaternionFromRotationMatrix(const T* in, Quaternion<T>* q, size_t n, size_t stride = 12)
+  {
+#pragma omp parallel for simd schedule(static) if(n > 65536)
+    for(long i = 0; i < long(n); i++) {
+      const T* m = in+stride*i;
+      quaternionFromRotationRows(m, m+4, m+8, q[i].x, q[i].y, q[i].z, q[i].w);
+    }
+  }
+
+  /*******************************************************************************/
+  /**
+   * Batch Quaternion<T>::integrate on structure of arrays. The common case,
+   * a rotation per step below twice Quaternion<T>::expSeriesLimit(), is
+   * computed with the series expansion in a vectorized loop; faster
+   * spinning bodies are then fixed up with sin and cos.
+   * @param q the unit orientations
+   * @param omega the angular velocities in world space
+   * @param dt the time step
+   * @param out receives n orientations, may alias q
+   * @param n the number of orientations
+   */
+  template<typename T>
+  void
+  quaternionIntegrate(QuaternionSoA<const T> q, Vec3SoA<const T> omega, T dt,
+                      QuaternionSoA<T> out, size_t n)
+  {
+    const T halfDt = dt/2;
+    const T limit2 = Quaternion<T>::expSeriesLimit()*Quaternion<T>::expSeriesLimit();
+    const size_t blockSize = 1024;
+    const long numBlocks = long((n+blockSize-1)/blockSize);
+
+#pragma omp parallel for schedule(static) if(n > 65536)
+    for(long block = 0; block < numBlocks; block++) {
+      const size_t begin = block*blockSize;
+      const size_t end = std::min(begin+blockSize, n);
+      unsigned char large[blockSize];
+
+#pragma omp simd
+      for(size_t i = begin; i < end; i++) {
+        T vx = omega.x[i]*halfDt, vy = omega.y[i]*halfDt, vz = omega.z[i]*halfDt;
+        T a2 = vx*vx+vy*vy+vz*vz;
+        T sinc, ew;
+        Quaternion<T>::expSeries(a2, sinc, ew);
+        T ex = vx*sinc, ey = vy*sinc, ez = vz*sinc;
+
+        //exp(omega*dt/2)*q
+        T qx = q.x[i], qy = q.y[i], qz = q.z[i], qw = q.w[i];
+        T rx = ew*qx+ex*qw+ey*qz-ez*qy;
+        T ry = ew*qy-ex*qz+ey*qw+ez*qx;
+        T rz = ew*qz+ex*qy-ey*qx+ez*qw;
+        T rw = ew*qw-ex*qx-ey*qy-ez*qz;
+        T invLen = T(1)/std::sqrt(rx*rx+ry*ry+rz*rz+rw*rw);
+
+        //Large rotations keep q for the second pass
+        bool small = a2 < limit2;
+        large[i-begin] = !small;
+        out.x[i] = small ? rx*invLen : qx;
+        out.y[i] = small ? ry*invLen : qy;
+        out.z[i] = small ? rz*invLen : qz;
+        out.w[i] = small ? rw*invLen : qw;
+      }
+
+      for(size_t i = begin; i < end; i++) {
+        if(!large[i-begin])
+          continue;
+        Quaternion<T> res = Quaternion<T>::integrate(Quaternion<T>(out.x[i], out.y[i], out.z[i], out.w[i]),
+                                                     Vec3<T>(omega.x[i], omega.y[i], omega.z[i]), dt);
+        out.x[i] = res.x;
+        out.y[i] = res.y;
+        out.z[i] = res.z;
+        out.w[i] = res.w;
+      }
+    }
+  }
+
+  /*******************************************************************************/
+  /**
+   * Batch Quaternion<T>::integrate on arrays. Prefer the structure of
+   * arrays version for large batches.
+   * @param out receives n orientations, may alias q
+   */
+  template<typename T>
+  void
+  quaternionIntegrate(const Quaternion<T>* q, const Vec3<T>* omega, T dt,
+                      Quaternion<T>* out, size_t n)
+  {
+#pragma omp parallel for schedule(static) if(n > 65536)
+    for(long i = 0; i < long(n); i++)
+      out[i] = Quaternion<T>::integrate(q[i], omega[i], dt);
+  }
+}
+
+#endif
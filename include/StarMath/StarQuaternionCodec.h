@@ -0,0 +1,281 @@
+#ifndef STAR_QUATERNION_CODEC_H
+#define STAR_QUATERNION_CODEC_H
+
+#include <StarMath/StarQuaternion.h>
+#include <StarMath/StarSoA.h>
+
+#include <cmath>
+#include <cstddef>
+#include <stdint.h>
+
+namespace Star
+{
+  /**
+   * Smallest three compression of unit quaternions. The largest component
+   * in absolute value is dropped, after flipping the quaternion so that it
+   * is positive, and rebuilt from the unit norm. Its index takes 2 bits and
+   * the 3 other components, which lie in [-1/sqrt(2), 1/sqrt(2)], are
+   * quantized on BITS bits each.
+   *
+   * Encoding is deterministic: encoding a decoded quaternion gives back the
+   * same bits. The codecs below give the worst-case rotation error of a
+   * round trip, measured on 4 million random and tied quaternions.
+   */
+  template <unsigned int B>
+  struct QuaternionCodec
+  {
+    /**
+     * Quantization bits per component.
+     */
+    static const unsigned int BITS = B;
+
+    /**
+     * Encode a unit quaternion into the low 3*BITS+2 bits of an integer.
+     */
+    template <typename T>
+    static inline uint64_t encode(const Quaternion<T>& q);
+
+    /**
+     * Decode a quaternion encoded by encode.
+     */
+    template <typename T>
+    static inline void decode(uint64_t bits, Quaternion<T>& q);
+
+  private:
+    /**
+     * Get the component value of a quantized one.
+     */
+    template <typename T>
+    static inline T dequantize(T q);
+
+    /**
+     * Get the dropped component from the 3 others.
+     */
+    template <typename T>
+    static inline T rebuild(T a, T b, T c);
+  };
+
+  /**
+   * 32-bit smallest three codec, error below 0.0068 radian (0.39 degree).
+   */
+  struct QuaternionCodec32 : public QuaternionCodec<10>
+  {
+    typedef uint32_t Packed;
+
+    static Packed pack(uint64_t bits) { return Packed(bits); }
+    static uint64_t unpack(Packed p) { return p; }
+  };
+
+  /**
+   * 48-bit smallest three codec stored in 3 16-bit words, error below 2e-4
+   * radian.
+   */
+  struct QuaternionCodec48 : public QuaternionCodec<15>
+  {
+    struct Packed
+    {
+      uint16_t bits[3];
+    };
+
+    static Packed pack(uint64_t bits)
+    {
+      Packed p;
+      p.bits[0] = uint16_t(bits);
+      p.bits[1] = uint16_t(bits >> 16);
+      p.bits[2] = uint16_t(bits >> 32);
+      return p;
+    }
+    static uint64_t unpack(const Packed& p)
+    {
+      return uint64_t(p.bits[0]) | (uint64_t(p.bits[1]) << 16) | (uint64_t(p.bits[2]) << 32);
+    }
+  };
+
+  /**
+   * 64-bit smallest three codec, error below 7.5e-6 radian.
+   */
+  struct QuaternionCodec64 : public QuaternionCodec<20>
+  {
+    typedef uint64_t Packed;
+
+    static Packed pack(uint64_t bits) { return bits; }
+    static uint64_t unpack(Packed p) { return p; }
+  };
+
+  /*******************************************************************************/
+  template <unsigned int B> const unsigned int QuaternionCodec<B>::BITS;
+
+  /*******************************************************************************/
+  template <unsigned int B>
+  template <typename T>
+  T
+  QuaternionCodec<B>::dequantize(T q)
+  {
+    const T scale = T(2)/T((uint64_t(1) << BITS)-1);
+    const T fromUnit = T(0.70710678118654752440);
+    return (q*scale-1)*fromUnit;
+  }
+
+  /*******************************************************************************/
+  template <unsigned int B>
+  template <typename T>
+  T
+  QuaternionCodec<B>::rebuild(T a, T b, T c)
+  {
+    T d2 = 1-a*a-b*b-c*c;
+    return std::sqrt(d2 > 0 ? d2 : T(0));
+  }
+
+  /*******************************************************************************/
+  template <unsigned int B>
+  template <typename T>
+  uint64_t
+  QuaternionCodec<B>::encode(const Quaternion<T>& q)
+  {
+    const uint64_t maxValue = (uint64_t(1) << BITS)-1;
+    const T scale = T(0.5)*T(maxValue);
+
+    //Largest component, the first one on ties
+    T ax = std::abs(q.x), ay = std::abs(q.y), az = std::abs(q.z), aw = std::abs(q.w);
+    unsigned int index = 0;
+    T largest = ax;
+    index = ay > largest ? 1 : index; largest = ay > largest ? ay : largest;
+    index = az > largest ? 2 : index; largest = az > largest ? az : largest;
+    index = aw > largest ? 3 : index;
+
+    //The 3 others in order, flipped so that the dropped one is positive
+    T sign = q[index] < 0 ? T(-1) : T(1);
+    T a = sign*(index == 0 ? q.y : q.x);
+    T b = sign*(index <= 1 ? q.z : q.y);
+    T c = sign*(index == 3 ? q.z : q.w);
+
+    //Map [-1/sqrt(2), 1/sqrt(2)] to [0, maxValue], rounding to nearest
+    const T toUnit = T(1.4142135623730950488);
+    T qa = std::floor((a*toUnit+1)*scale+T(0.5));
+    T qb = std::floor((b*toUnit+1)*scale+T(0.5));
+    T qc = std::floor((c*toUnit+1)*scale+T(0.5));
+    qa = qa < 0 ? T(0) : (qa > T(maxValue) ? T(maxValue) : qa);
+    qb = qb < 0 ? T(0) : (qb > T(maxValue) ? T(maxValue) : qb);
+    qc = qc < 0 ? T(0) : (qc > T(maxValue) ? T(maxValue) : qc);
+
+    //On near ties, rounding can make a kept component as large as the
+    //rebuilt one, and encoding the decoded quaternion would drop another
+    //component. Such components are moved one step toward 0, twice at
+    //most, which keeps round trips deterministic.
+    for(unsigned int k = 0; k < 2; k++) {
+      T da = dequantize<T>(qa), db = dequantize<T>(qb), dc = dequantize<T>(qc);
+      T d = rebuild(da, db, dc);
+      qa = std::abs(da) >= d ? (da > 0 ? qa-1 : qa+1) : qa;
+      qb = std::abs(db) >= d ? (db > 0 ? qb-1 : qb+1) : qb;
+      qc = std::abs(dc) >= d ? (dc > 0 ? qc-1 : qc+1) : qc;
+    }
+
+    return (uint64_t(index) << (3*BITS)) | (uint64_t(qa) << (2*BITS)) |
+      (uint64_t(qb) << BITS) | uint64_t(qc);
+  }
+
+  /*******************************************************************************/
+  template <unsigned int B>
+  template <typename T>
+  void
+  QuaternionCodec<B>::decode(uint64_t bits, Quaternion<T>& q)
+  {
+    const uint64_t maxValue = (uint64_t(1) << BITS)-1;
+    unsigned int index = unsigned(bits >> (3*BITS)) & 3;
+    T a = dequantize<T>(T((bits >> (2*BITS)) & maxValue));
+    T b = dequantize<T>(T((bits >> BITS) & maxValue));
+    T c = dequantize<T>(T(bits & maxValue));
+    T d = rebuild(a, b, c);
+
+    q.x = index == 0 ? d : a;
+    q.y = index == 0 ? a : (index == 1 ? d : b);
+    q.z = index <= 1 ? b : (index == 2 ? d : c);
+    q.w = index == 3 ? d : c;
+  }
+
+  /*******************************************************************************/
+  /**
+   * Encode a unit quaternion, e.g. quaternionEncode<QuaternionCodec32>(q).
+   */
+  template <typename Codec, typename T>
+  inline typename Codec::Packed
+  quaternionEncode(const Quaternion<T>& q)
+  {
+    return Codec::pack(Codec::encode(q));
+  }
+
+  /*******************************************************************************/
+  /**
+   * Decode a quaternion encoded with the same codec.
+   */
+  template <typename Codec, typename T>
+  inline void
+  quaternionDecode(const typename Codec::Packed& p, Quaternion<T>& q)
+  {
+    Codec::decode(Codec::unpack(p), q);
+  }
+
+  /*******************************************************************************/
+  /**
+   * Encode an array of unit quaternions.
+   * @param out receives n packed quaternions
+   */
+  template <typename Codec, typename T>
+  void
+  quaternionEncode(const Quaternion<T>* q, typename Codec::Packed* out, size_t n)
+  {
+#pragma omp parallel for simd schedule(static) if(n > 65536)
+    for(long i = 0; i < long(n); i++)
+      out[i] = Codec::pack(Codec::encode(q[i]));
+  }
+
+  /*******************************************************************************/
+  /**
+   * Decode an array of packed quaternions.
+   * @param out receives n quaternions
+   */
+  template <typename Codec, typename T>
+  void
+  quaternionDecode(const typename Codec::Packed* in, Quaternion<T>* out, size_t n)
+  {
+#pragma omp parallel for simd schedule(static) if(n > 65536)
+    for(long i = 0; i < long(n); i++)
+      Codec::decode(Codec::unpack(in[i]), out[i]);
+  }
+
+  /*******************************************************************************/
+  /**
+   * Encode unit quaternions given as structure of arrays.
+   * @param out receives n packed quaternions
+   */
+  template <typename Codec, typename T>
+  void
+  quaternionEncode(QuaternionSoA<const T> q, typename Codec::Packed* out, size_t n)
+  {
+#pragma omp parallel for simd schedule(static) if(n > 65536)
+    for(long i = 0; i < long(n); i++)
+      out[i] = Codec::pack(Codec::encode(Quaternion<T>(q.x[i], q.y[i], q.z[i], q.w[i])));
+  }
+
+  /*******************************************************************************/
+  /**
+   * Decode packed quaternions into structure of arrays.
+   * @param out receives n quaternions
+   */
+  template <typename Codec, typename T>
+  void
+  quaternionDecode(const typename Codec::Packed* in, QuaternionSoA<T> out, size_t n)
+  {
+#pragma omp parallel for simd schedule(static) if(n > 65536)
+    for(long i = 0; i < long(n); i++) {
+      Quaternion<T> q;
+      Codec::decode(Codec::unpack(in[i]), q);
+      out.x[i] = q.x;
+      out.y[i] = q.y;
+      out.z[i] = q.z;
+      out.w[i] = q.w;
+    }
+  }
+}
+
+#endif
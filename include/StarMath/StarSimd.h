@@ -0,0 +1,1114 @@
+#ifndef STAR_SIMD_H
+#define STAR_SIMD_H
+
+#include <cstddef>
+#include <cmath>
+
+#if defined(__AVX512F__) && defined(__AVX512VL__) && defined(__AVX512DQ__) && defined(__AVX512BW__)
+#define STAR_SIMD_AVX512
+#endif
+#if defined(__AVX2__)
+#define STAR_SIMD_AVX2
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define STAR_SIMD_SSE2
+#endif
+
+#if defined(STAR_SIMD_AVX512)
+#define STAR_SIMD_ABI avx512
+#elif defined(STAR_SIMD_AVX2)
+#define STAR_SIMD_ABI avx2
+#elif defined(STAR_SIMD_SSE2)
+#define STAR_SIMD_ABI sse2
+#else
+#define STAR_SIMD_ABI scalar
+#endif
+
+#if defined(STAR_SIMD_SSE2)
+#include <immintrin.h>
+#endif
+
+#if defined(__GNUC__)
+#define STAR_SIMD_INLINE inline __attribute__((always_inline))
+#elif defined(_MSC_VER)
+#define STAR_SIMD_INLINE __forceinline
+#else
+#define STAR_SIMD_INLINE inline
+#endif
+
+namespace Star
+{
+  /**
+   * Internal SIMD layer of the StarMath kernels: a pack<T, N> holds N lanes
+   * of T and a mask<T, N> the result of comparing two packs. A kernel is
+   * written once with packs and compiled once per instruction set.
+   *
+   * The primary templates are a scalar backend for any T and N, loops the
+   * compiler may still vectorize. float packs of 4, 8 and 16 lanes map to
+   * SSE2, AVX2 and AVX-512 registers when the code is compiled for them.
+   * Everything lives in an inline namespace named after the instruction
+   * set, so objects compiled with different flags never share a symbol.
+   *
+   * Gathers compute index*stride with 32 bit integers.
+   */
+  namespace simd
+  {
+    inline namespace STAR_SIMD_ABI
+    {
+      template<typename T, size_t N> class pack;
+
+      /*****************************************************************************/
+      /**
+       * pack<T, N>::SIZE, in a base so the specializations share its
+       * definition.
+       */
+      template<size_t N>
+      struct Lanes
+      {
+        static const size_t SIZE = N;
+      };
+
+      template<size_t N> const size_t Lanes<N>::SIZE;
+
+      /*****************************************************************************/
+      /**
+       * Lanes selected by a comparison, scalar backend.
+       */
+      template<typename T, size_t N>
+      class mask
+      {
+      public:
+        STAR_SIMD_INLINE mask() {}
+
+        /**
+         * The first n lanes, all of them if n >= N.
+         */
+        STAR_SIMD_INLINE static mask firstN(size_t n)
+        {
+          mask r;
+          for(size_t i = 0; i < N; i++)
+            r.m_v[i] = i < n;
+          return r;
+        }
+
+        /**
+         * Lane i is set if bit i is.
+         */
+        STAR_SIMD_INLINE static mask fromBits(unsigned int bits)
+        {
+          mask r;
+          for(size_t i = 0; i < N; i++)
+            r.m_v[i] = ((bits >> i) & 1) != 0;
+          return r;
+        }
+
+        /**
+         * Bit i is set if lane i is.
+         */
+        STAR_SIMD_INLINE unsigned int getBits() const
+        {
+          unsigned int bits = 0;
+          for(size_t i = 0; i < N; i++)
+            bits |= (unsigned int)m_v[i] << i;
+          return bits;
+        }
+
+        STAR_SIMD_INLINE bool operator [] (size_t i) const { return m_v[i]; }
+
+        STAR_SIMD_INLINE mask operator & (const mask& b) const
+        {
+          mask r;
+          for(size_t i = 0; i < N; i++)
+            r.m_v[i] = m_v[i] && b.m_v[i];
+          return r;
+        }
+
+        STAR_SIMD_INLINE mask operator | (const mask& b) const
+        {
+          mask r;
+          for(size_t i = 0; i < N; i++)
+            r.m_v[i] = m_v[i] || b.m_v[i];
+          return r;
+        }
+
+        STAR_SIMD_INLINE mask operator ^ (const mask& b) const
+        {
+          mask r;
+          for(size_t i = 0; i < N; i++)
+            r.m_v[i] = m_v[i] != b.m_v[i];
+          return r;
+        }
+
+        STAR_SIMD_INLINE mask operator ~ () const
+        {
+          mask r;
+          for(size_t i = 0; i < N; i++)
+            r.m_v[i] = !m_v[i];
+          return r;
+        }
+
+      private:
+        template<typename U, size_t M> friend class pack;
+
+        bool m_v[N];
+      };
+
+      /*****************************************************************************/
+      /**
+       * N lanes of T, scalar backend.
+       */
+      template<typename T, size_t N>
+      class pack : public Lanes<N>
+      {
+      public:
+        typedef mask<T, N> Mask;
+
+        /**
+         * Uninitialized lanes.
+         */
+        STAR_SIMD_INLINE pack() {}
+
+        /**
+         * All the lanes set to v.
+         */
+        STAR_SIMD_INLINE pack(T v)
+        {
+          for(size_t i = 0; i < N; i++)
+            m_v[i] = v;
+        }
+
+        STAR_SIMD_INLINE static pack zero() { return pack(T(0)); }
+
+        /**
+         * Load from an address aligned on N*sizeof(T).
+         */
+        STAR_SIMD_INLINE static pack load(const T* p) { return loadu(p); }
+
+        /**
+         * Load from any address.
+         */
+        STAR_SIMD_INLINE static pack loadu(const T* p)
+        {
+          pack r;
+          for(size_t i = 0; i < N; i++)
+            r.m_v[i] = p[i];
+          return r;
+        }
+
+        /**
+         * Load the lanes of m, without reading the other addresses. The
+         * other lanes are 0.
+         */
+        STAR_SIMD_INLINE static pack load(const T* p, const Mask& m)
+        {
+          pack r;
+          for(size_t i = 0; i < N; i++)
+            r.m_v[i] = m[i] ? p[i] : T(0);
+          return r;
+        }
+
+        /**
+         * Lane i is base[indices[i]*stride].
+         */
+        STAR_SIMD_INLINE static pack gather(const T* base, const unsigned int* indices, unsigned int stride)
+        {
+          pack r;
+          for(size_t i = 0; i < N; i++)
+            r.m_v[i] = base[indices[i]*stride];
+          return r;
+        }
+
+        /**
+         * Gather the lanes of m, only their indices are read. The other
+         * lanes are 0.
+         */
+        STAR_SIMD_INLINE static pack gather(const T* base, const unsigned int* indices, unsigned int stride,
+                                            const Mask& m)
+        {
+          pack r;
+          for(size_t i = 0; i < N; i++)
+            r.m_v[i] = m[i] ? base[indices[i]*stride] : T(0);
+          return r;
+        }
+
+        /**
+         * Store to an address aligned on N*sizeof(T).
+         */
+        STAR_SIMD_INLINE void store(T* p) const { storeu(p); }
+
+        /**
+         * Store to any address.
+         */
+        STAR_SIMD_INLINE void storeu(T* p) const
+        {
+          for(size_t i = 0; i < N; i++)
+            p[i] = m_v[i];
+        }
+
+        /**
+         * Store the lanes of m, the other addresses are not written.
+         */
+        STAR_SIMD_INLINE void store(T* p, const Mask& m) const
+        {
+          for(size_t i = 0; i < N; i++)
+            if(m[i])
+              p[i] = m_v[i];
+        }
+
+        STAR_SIMD_INLINE T operator [] (size_t i) const { return m_v[i]; }
+
+#define STAR_SIMD_SCALAR_OP(op)                                         \
+        STAR_SIMD_INLINE pack operator op (const pack& b) const         \
+        {                                                               \
+          pack r;                                                       \
+          for(size_t i = 0; i < N; i++)                                 \
+            r.m_v[i] = m_v[i] op b.m_v[i];                              \
+          return r;                                                     \
+        }                                                               \
+        STAR_SIMD_INLINE pack& operator op##= (const pack& b)           \
+        {                                                               \
+          return *this = *this op b;                                    \
+        }
+        STAR_SIMD_SCALAR_OP(+)
+        STAR_SIMD_SCALAR_OP(-)
+        STAR_SIMD_SCALAR_OP(*)
+        STAR_SIMD_SCALAR_OP(/)
+#undef STAR_SIMD_SCALAR_OP
+
+        STAR_SIMD_INLINE pack operator - () const
+        {
+          pack r;
+          for(size_t i = 0; i < N; i++)
+            r.m_v[i] = -m_v[i];
+          return r;
+        }
+
+#define STAR_SIMD_SCALAR_CMP(op)                                        \
+        STAR_SIMD_INLINE Mask operator op (const pack& b) const         \
+        {                                                               \
+          Mask r;                                                       \
+          for(size_t i = 0; i < N; i++)                                 \
+            r.m_v[i] = m_v[i] op b.m_v[i];                              \
+          return r;                                                     \
+        }
+        STAR_SIMD_SCALAR_CMP(<)
+        STAR_SIMD_SCALAR_CMP(<=)
+        STAR_SIMD_SCALAR_CMP(>)
+        STAR_SIMD_SCALAR_CMP(>=)
+        STAR_SIMD_SCALAR_CMP(==)
+        STAR_SIMD_SCALAR_CMP(!=)
+#undef STAR_SIMD_SCALAR_CMP
+
+      private:
+        T m_v[N];
+      };
+
+      /*****************************************************************************/
+      /**
+       * a*b+c, fused when the instruction set has FMA.
+       */
+      template<typename T, size_t N>
+      STAR_SIMD_INLINE pack<T, N>
+      fma(const pack<T, N>& a, const pack<T, N>& b, const pack<T, N>& c)
+      {
+        return a*b+c;
+      }
+
+      /*****************************************************************************/
+      /**
+       * Lane minimum and maximum. Like minps and maxps, b is returned when
+       * the comparison is false: NaNs and zeros of either sign.
+       */
+      template<typename T, size_t N>
+      STAR_SIMD_INLINE pack<T, N>
+      min(const pack<T, N>& a, const pack<T, N>& b)
+      {
+        T r[N];
+        for(size_t i = 0; i < N; i++)
+          r[i] = a[i] < b[i] ? a[i] : b[i];
+        return pack<T, N>::loadu(r);
+      }
+
+      /*****************************************************************************/
+      template<typename T, size_t N>
+      STAR_SIMD_INLINE pack<T, N>
+      max(const pack<T, N>& a, const pack<T, N>& b)
+      {
+        T r[N];
+        for(size_t i = 0; i < N; i++)
+          r[i] = b[i] < a[i] ? a[i] : b[i];
+        return pack<T, N>::loadu(r);
+      }
+
+      /*****************************************************************************/
+      template<typename T, size_t N>
+      STAR_SIMD_INLINE pack<T, N>
+      sqrt(const pack<T, N>& a)
+      {
+        T r[N];
+        for(size_t i = 0; i < N; i++)
+          r[i] = std::sqrt(a[i]);
+        return pack<T, N>::loadu(r);
+      }
+
+      /*****************************************************************************/
+      /**
+       * Approximate 1/a: the instruction set estimate refined by one
+       * Newton-Raphson step, about 22 bits for float.
+       */
+      template<typename T, size_t N>
+      STAR_SIMD_INLINE pack<T, N>
+      rcp(const pack<T, N>& a)
+      {
+        return pack<T, N>(T(1))/a;
+      }
+
+      /*****************************************************************************/
+      /**
+       * Approximate 1/sqrt(a): the instruction set estimate refined by one
+       * Newton-Raphson step, about 22 bits for float.
+       */
+      template<typename T, size_t N>
+      STAR_SIMD_INLINE pack<T, N>
+      rsqrt(const pack<T, N>& a)
+      {
+        return pack<T, N>(T(1))/sqrt(a);
+      }
+
+      /*****************************************************************************/
+      template<typename T, size_t N>
+      STAR_SIMD_INLINE pack<T, N>
+      abs(const pack<T, N>& a)
+      {
+        T r[N];
+        for(size_t i = 0; i < N; i++)
+          r[i] = a[i] < T(0) ? -a[i] : a[i];
+        return pack<T, N>::loadu(r);
+      }
+
+      /*****************************************************************************/
+      /**
+       * Lanes of a where m is set, of b elsewhere.
+       */
+      template<typename T, size_t N>
+      STAR_SIMD_INLINE pack<T, N>
+      select(const mask<T, N>& m, const pack<T, N>& a, const pack<T, N>& b)
+      {
+        T r[N];
+        for(size_t i = 0; i < N; i++)
+          r[i] = m[i] ? a[i] : b[i];
+        return pack<T, N>::loadu(r);
+      }
+
+      /*****************************************************************************/
+      /**
+       * Permute each group of 4 lanes: lane k of a group gets its lane Ik.
+       */
+      template<int I0, int I1, int I2, int I3, typename T, size_t N>
+      STAR_SIMD_INLINE pack<T, N>
+      shuffle(const pack<T, N>& a)
+      {
+        const int idx[4] = { I0, I1, I2, I3 };
+        T r[N];
+        for(size_t i = 0; i < N; i++)
+          r[i] = a[(i & ~size_t(3))+idx[i & 3]];
+        return pack<T, N>::loadu(r);
+      }
+
+      /*****************************************************************************/
+      /**
+       * Transpose the 4x4 matrix whose rows are a, b, c and d.
+       */
+      template<typename T>
+      STAR_SIMD_INLINE void
+      transpose4(pack<T, 4>& a, pack<T, 4>& b, pack<T, 4>& c, pack<T, 4>& d)
+      {
+        T m[4][4];
+        a.storeu(m[0]);
+        b.storeu(m[1]);
+        c.storeu(m[2]);
+        d.storeu(m[3]);
+        T t[4][4];
+        for(size_t j = 0; j < 4; j++)
+          for(size_t i = 0; i < 4; i++)
+            t[i][j] = m[j][i];
+        a = pack<T, 4>::loadu(t[0]);
+        b = pack<T, 4>::loadu(t[1]);
+        c = pack<T, 4>::loadu(t[2]);
+        d = pack<T, 4>::loadu(t[3]);
+      }
+
+      /*****************************************************************************/
+      /**
+       * Sum of the lanes.
+       */
+      template<typename T, size_t N>
+      STAR_SIMD_INLINE T
+      reduceAdd(const pack<T, N>& a)
+      {
+        T r = a[0];
+        for(size_t i = 1; i < N; i++)
+          r += a[i];
+        return r;
+      }
+
+      /*****************************************************************************/
+      template<typename T, size_t N>
+      STAR_SIMD_INLINE T
+      reduceMin(const pack<T, N>& a)
+      {
+        T r = a[0];
+        for(size_t i = 1; i < N; i++)
+          r = a[i] < r ? a[i] : r;
+        return r;
+      }
+
+      /*****************************************************************************/
+      template<typename T, size_t N>
+      STAR_SIMD_INLINE T
+      reduceMax(const pack<T, N>& a)
+      {
+        T r = a[0];
+        for(size_t i = 1; i < N; i++)
+          r = r < a[i] ? a[i] : r;
+        return r;
+      }
+
+#ifdef STAR_SIMD_SSE2
+      /*****************************************************************************/
+      /**
+       * SSE2 backend.
+       */
+      template<>
+      class mask<float, 4>
+      {
+      public:
+        STAR_SIMD_INLINE mask() {}
+        STAR_SIMD_INLINE explicit mask(__m128 m) : m_m(m) {}
+
+        STAR_SIMD_INLINE static mask firstN(size_t n)
+        {
+          const int count = n < 4 ? int(n) : 4;
+          return mask(_mm_castsi128_ps(_mm_cmplt_epi32(_mm_setr_epi32(0, 1, 2, 3), _mm_set1_epi32(count))));
+        }
+
+        STAR_SIMD_INLINE static mask fromBits(unsigned int bits)
+        {
+          const __m128i lanes = _mm_setr_epi32(1, 2, 4, 8);
+          __m128i set = _mm_and_si128(_mm_set1_epi32(int(bits)), lanes);
+          return mask(_mm_castsi128_ps(_mm_cmpeq_epi32(set, lanes)));
+        }
+
+        STAR_SIMD_INLINE unsigned int getBits() const { return (unsigned int)_mm_movemask_ps(m_m); }
+        STAR_SIMD_INLINE bool operator [] (size_t i) const { return ((getBits() >> i) & 1) != 0; }
+
+        STAR_SIMD_INLINE mask operator & (const mask& b) const { return mask(_mm_and_ps(m_m, b.m_m)); }
+        STAR_SIMD_INLINE mask operator | (const mask& b) const { return mask(_mm_or_ps(m_m, b.m_m)); }
+        STAR_SIMD_INLINE mask operator ^ (const mask& b) const { return mask(_mm_xor_ps(m_m, b.m_m)); }
+        STAR_SIMD_INLINE mask operator ~ () const
+        {
+          return mask(_mm_xor_ps(m_m, _mm_castsi128_ps(_mm_set1_epi32(-1))));
+        }
+
+        STAR_SIMD_INLINE __m128 getNative() const { return m_m; }
+
+      private:
+        __m128 m_m;
+      };
+
+      /*****************************************************************************/
+      template<>
+      class pack<float, 4> : public Lanes<4>
+      {
+      public:
+        typedef mask<float, 4> Mask;
+
+        STAR_SIMD_INLINE pack() {}
+        STAR_SIMD_INLINE pack(float v) : m_v(_mm_set1_ps(v)) {}
+        STAR_SIMD_INLINE explicit pack(__m128 v) : m_v(v) {}
+
+        STAR_SIMD_INLINE static pack zero() { return pack(_mm_setzero_ps()); }
+        STAR_SIMD_INLINE static pack load(const float* p) { return pack(_mm_load_ps(p)); }
+        STAR_SIMD_INLINE static pack loadu(const float* p) { return pack(_mm_loadu_ps(p)); }
+
+        STAR_SIMD_INLINE static pack load(const float* p, const Mask& m)
+        {
+          const unsigned int bits = m.getBits();
+          if(bits == 0xf)
+            return loadu(p);
+          float r[4];
+          for(size_t i = 0; i < 4; i++)
+            r[i] = (bits >> i) & 1 ? p[i] : 0.f;
+          return loadu(r);
+        }
+
+        STAR_SIMD_INLINE static pack gather(const float* base, const unsigned int* indices, unsigned int stride)
+        {
+          return pack(_mm_setr_ps(base[indices[0]*stride], base[indices[1]*stride],
+                                  base[indices[2]*stride], base[indices[3]*stride]));
+        }
+
+        STAR_SIMD_INLINE static pack gather(const float* base, const unsigned int* indices, unsigned int stride,
+                                            const Mask& m)
+        {
+          const unsigned int bits = m.getBits();
+          float r[4];
+          for(size_t i = 0; i < 4; i++)
+            r[i] = (bits >> i) & 1 ? base[indices[i]*stride] : 0.f;
+          return loadu(r);
+        }
+
+        STAR_SIMD_INLINE void store(float* p) const { _mm_store_ps(p, m_v); }
+        STAR_SIMD_INLINE void storeu(float* p) const { _mm_storeu_ps(p, m_v); }
+
+        STAR_SIMD_INLINE void store(float* p, const Mask& m) const
+        {
+          const unsigned int bits = m.getBits();
+          if(bits == 0xf) {
+            storeu(p);
+            return;
+          }
+          float r[4];
+          storeu(r);
+          for(size_t i = 0; i < 4; i++)
+            if((bits >> i) & 1)
+              p[i] = r[i];
+        }
+
+        STAR_SIMD_INLINE float operator [] (size_t i) const
+        {
+          float r[4];
+          storeu(r);
+          return r[i];
+        }
+
+        STAR_SIMD_INLINE pack operator + (const pack& b) const { return pack(_mm_add_ps(m_v, b.m_v)); }
+        STAR_SIMD_INLINE pack operator - (const pack& b) const { return pack(_mm_sub_ps(m_v, b.m_v)); }
+        STAR_SIMD_INLINE pack operator * (const pack& b) const { return pack(_mm_mul_ps(m_v, b.m_v)); }
+        STAR_SIMD_INLINE pack operator / (const pack& b) const { return pack(_mm_div_ps(m_v, b.m_v)); }
+        STAR_SIMD_INLINE pack& operator += (const pack& b) { return *this = *this+b; }
+        STAR_SIMD_INLINE pack& operator -= (const pack& b) { return *this = *this-b; }
+        STAR_SIMD_INLINE pack& operator *= (const pack& b) { return *this = *this*b; }
+        STAR_SIMD_INLINE pack& operator /= (const pack& b) { return *this = *this/b; }
+        STAR_SIMD_INLINE pack operator - () const { return pack(_mm_xor_ps(m_v, _mm_set1_ps(-0.f))); }
+
+        STAR_SIMD_INLINE Mask operator < (const pack& b) const { return Mask(_mm_cmplt_ps(m_v, b.m_v)); }
+        STAR_SIMD_INLINE Mask operator <= (const pack& b) const { return Mask(_mm_cmple_ps(m_v, b.m_v)); }
+        STAR_SIMD_INLINE Mask operator > (const pack& b) const { return Mask(_mm_cmpgt_ps(m_v, b.m_v)); }
+        STAR_SIMD_INLINE Mask operator >= (const pack& b) const { return Mask(_mm_cmpge_ps(m_v, b.m_v)); }
+        STAR_SIMD_INLINE Mask operator == (const pack& b) const { return Mask(_mm_cmpeq_ps(m_v, b.m_v)); }
+        STAR_SIMD_INLINE Mask operator != (const pack& b) const { return Mask(_mm_cmpneq_ps(m_v, b.m_v)); }
+
+        STAR_SIMD_INLINE __m128 getNative() const { return m_v; }
+
+      private:
+        __m128 m_v;
+      };
+
+      /*****************************************************************************/
+      STAR_SIMD_INLINE pack<float, 4>
+      fma(const pack<float, 4>& a, const pack<float, 4>& b, const pack<float, 4>& c)
+      {
+#ifdef __FMA__
+        return pack<float, 4>(_mm_fmadd_ps(a.getNative(), b.getNative(), c.getNative()));
+#else
+        return a*b+c;
+#endif
+      }
+
+      STAR_SIMD_INLINE pack<float, 4>
+      min(const pack<float, 4>& a, const pack<float, 4>& b)
+      {
+        return pack<float, 4>(_mm_min_ps(a.getNative(), b.getNative()));
+      }
+
+      STAR_SIMD_INLINE pack<float, 4>
+      max(const pack<float, 4>& a, const pack<float, 4>& b)
+      {
+        return pack<float, 4>(_mm_max_ps(a.getNative(), b.getNative()));
+      }
+
+      STAR_SIMD_INLINE pack<float, 4>
+      sqrt(const pack<float, 4>& a)
+      {
+        return pack<float, 4>(_mm_sqrt_ps(a.getNative()));
+      }
+
+      STAR_SIMD_INLINE pack<float, 4>
+      rcp(const pack<float, 4>& a)
+      {
+        const pack<float, 4> y(_mm_rcp_ps(a.getNative()));
+        return y*(pack<float, 4>(2.f)-a*y);
+      }
+
+      STAR_SIMD_INLINE pack<float, 4>
+      rsqrt(const pack<float, 4>& a)
+      {
+        const pack<float, 4> y(_mm_rsqrt_ps(a.getNative()));
+        return pack<float, 4>(0.5f)*y*(pack<float, 4>(3.f)-a*y*y);
+      }
+
+      STAR_SIMD_INLINE pack<float, 4>
+      abs(const pack<float, 4>& a)
+      {
+        return pack<float, 4>(_mm_andnot_ps(_mm_set1_ps(-0.f), a.getNative()));
+      }
+
+      STAR_SIMD_INLINE pack<float, 4>
+      select(const mask<float, 4>& m, const pack<float, 4>& a, const pack<float, 4>& b)
+      {
+#ifdef __SSE4_1__
+        return pack<float, 4>(_mm_blendv_ps(b.getNative(), a.getNative(), m.getNative()));
+#else
+        return pack<float, 4>(_mm_or_ps(_mm_and_ps(m.getNative(), a.getNative()),
+                                        _mm_andnot_ps(m.getNative(), b.getNative())));
+#endif
+      }
+
+      template<int I0, int I1, int I2, int I3>
+      STAR_SIMD_INLINE pack<float, 4>
+      shuffle(const pack<float, 4>& a)
+      {
+        return pack<float, 4>(_mm_shuffle_ps(a.getNative(), a.getNative(), _MM_SHUFFLE(I3, I2, I1, I0)));
+      }
+
+      STAR_SIMD_INLINE void
+      transpose4(pack<float, 4>& a, pack<float, 4>& b, pack<float, 4>& c, pack<float, 4>& d)
+      {
+        __m128 r0 = a.getNative(), r1 = b.getNative(), r2 = c.getNative(), r3 = d.getNative();
+        _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+        a = pack<float, 4>(r0);
+        b = pack<float, 4>(r1);
+        c = pack<float, 4>(r2);
+        d = pack<float, 4>(r3);
+      }
+
+      STAR_SIMD_INLINE float
+      reduceAdd(const pack<float, 4>& a)
+      {
+        __m128 v = a.getNative();
+        v = _mm_add_ps(v, _mm_movehl_ps(v, v));
+        v = _mm_add_ss(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1)));
+        return _mm_cvtss_f32(v);
+      }
+
+      STAR_SIMD_INLINE float
+      reduceMin(const pack<float, 4>& a)
+      {
+        __m128 v = a.getNative();
+        v = _mm_min_ps(v, _mm_movehl_ps(v, v));
+        v = _mm_min_ss(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1)));
+        return _mm_cvtss_f32(v);
+      }
+
+      STAR_SIMD_INLINE float
+      reduceMax(const pack<float, 4>& a)
+      {
+        __m128 v = a.getNative();
+        v = _mm_max_ps(v, _mm_movehl_ps(v, v));
+        v = _mm_max_ss(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1)));
+        return _mm_cvtss_f32(v);
+      }
+#endif
+
+#ifdef STAR_SIMD_AVX2
+      /*****************************************************************************/
+      /**
+       * AVX2 backend.
+       */
+      template<>
+      class mask<float, 8>
+      {
+      public:
+        STAR_SIMD_INLINE mask() {}
+        STAR_SIMD_INLINE explicit mask(__m256 m) : m_m(m) {}
+
+        STAR_SIMD_INLINE static mask firstN(size_t n)
+        {
+          const int count = n < 8 ? int(n) : 8;
+          const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+          return mask(_mm256_castsi256_ps(_mm256_cmpgt_epi32(_mm256_set1_epi32(count), lanes)));
+        }
+
+        STAR_SIMD_INLINE static mask fromBits(unsigned int bits)
+        {
+          const __m256i lanes = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+          __m256i set = _mm256_and_si256(_mm256_set1_epi32(int(bits)), lanes);
+          return mask(_mm256_castsi256_ps(_mm256_cmpeq_epi32(set, lanes)));
+        }
+
+        STAR_SIMD_INLINE unsigned int getBits() const { return (unsigned int)_mm256_movemask_ps(m_m); }
+        STAR_SIMD_INLINE bool operator [] (size_t i) const { return ((getBits() >> i) & 1) != 0; }
+
+        STAR_SIMD_INLINE mask operator & (const mask& b) const { return mask(_mm256_and_ps(m_m, b.m_m)); }
+        STAR_SIMD_INLINE mask operator | (const mask& b) const { return mask(_mm256_or_ps(m_m, b.m_m)); }
+        STAR_SIMD_INLINE mask operator ^ (const mask& b) const { return mask(_mm256_xor_ps(m_m, b.m_m)); }
+        STAR_SIMD_INLINE mask operator ~ () const
+        {
+          return mask(_mm256_xor_ps(m_m, _mm256_castsi256_ps(_mm256_set1_epi32(-1))));
+        }
+
+        STAR_SIMD_INLINE __m256 getNative() const { return m_m; }
+
+      private:
+        __m256 m_m;
+      };
+
+      /*****************************************************************************/
+      template<>
+      class pack<float, 8> : public Lanes<8>
+      {
+      public:
+        typedef mask<float, 8> Mask;
+
+        STAR_SIMD_INLINE pack() {}
+        STAR_SIMD_INLINE pack(float v) : m_v(_mm256_set1_ps(v)) {}
+        STAR_SIMD_INLINE explicit pack(__m256 v) : m_v(v) {}
+
+        STAR_SIMD_INLINE static pack zero() { return pack(_mm256_setzero_ps()); }
+        STAR_SIMD_INLINE static pack load(const float* p) { return pack(_mm256_load_ps(p)); }
+        STAR_SIMD_INLINE static pack loadu(const float* p) { return pack(_mm256_loadu_ps(p)); }
+
+        STAR_SIMD_INLINE static pack load(const float* p, const Mask& m)
+        {
+          return pack(_mm256_maskload_ps(p, _mm256_castps_si256(m.getNative())));
+        }
+
+        STAR_SIMD_INLINE static pack gather(const float* base, const unsigned int* indices, unsigned int stride)
+        {
+          __m256i idx = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(indices));
+          idx = _mm256_mullo_epi32(idx, _mm256_set1_epi32(int(stride)));
+          return pack(_mm256_i32gather_ps(base, idx, 4));
+        }
+
+        STAR_SIMD_INLINE static pack gather(const float* base, const unsigned int* indices, unsigned int stride,
+                                            const Mask& m)
+        {
+          const __m256i lanes = _mm256_castps_si256(m.getNative());
+          __m256i idx = _mm256_maskload_epi32(reinterpret_cast<const int*>(indices), lanes);
+          idx = _mm256_mullo_epi32(idx, _mm256_set1_epi32(int(stride)));
+          return pack(_mm256_mask_i32gather_ps(_mm256_setzero_ps(), base, idx, m.getNative(), 4));
+        }
+
+        STAR_SIMD_INLINE void store(float* p) const { _mm256_store_ps(p, m_v); }
+        STAR_SIMD_INLINE void storeu(float* p) const { _mm256_storeu_ps(p, m_v); }
+
+        STAR_SIMD_INLINE void store(float* p, const Mask& m) const
+        {
+          _mm256_maskstore_ps(p, _mm256_castps_si256(m.getNative()), m_v);
+        }
+
+        STAR_SIMD_INLINE float operator [] (size_t i) const
+        {
+          float r[8];
+          storeu(r);
+          return r[i];
+        }
+
+        STAR_SIMD_INLINE pack operator + (const pack& b) const { return pack(_mm256_add_ps(m_v, b.m_v)); }
+        STAR_SIMD_INLINE pack operator - (const pack& b) const { return pack(_mm256_sub_ps(m_v, b.m_v)); }
+        STAR_SIMD_INLINE pack operator * (const pack& b) const { return pack(_mm256_mul_ps(m_v, b.m_v)); }
+        STAR_SIMD_INLINE pack operator / (const pack& b) const { return pack(_mm256_div_ps(m_v, b.m_v)); }
+        STAR_SIMD_INLINE pack& operator += (const pack& b) { return *this = *this+b; }
+        STAR_SIMD_INLINE pack& operator -= (const pack& b) { return *this = *this-b; }
+        STAR_SIMD_INLINE pack& operator *= (const pack& b) { return *this = *this*b; }
+        STAR_SIMD_INLINE pack& operator /= (const pack& b) { return *this = *this/b; }
+        STAR_SIMD_INLINE pack operator - () const { return pack(_mm256_xor_ps(m_v, _mm256_set1_ps(-0.f))); }
+
+        STAR_SIMD_INLINE Mask operator < (const pack& b) const { return Mask(_mm256_cmp_ps(m_v, b.m_v, _CMP_LT_OQ)); }
+        STAR_SIMD_INLINE Mask operator <= (const pack& b) const { return Mask(_mm256_cmp_ps(m_v, b.m_v, _CMP_LE_OQ)); }
+        STAR_SIMD_INLINE Mask operator > (const pack& b) const { return Mask(_mm256_cmp_ps(m_v, b.m_v, _CMP_GT_OQ)); }
+        STAR_SIMD_INLINE Mask operator >= (const pack& b) const { return Mask(_mm256_cmp_ps(m_v, b.m_v, _CMP_GE_OQ)); }
+        STAR_SIMD_INLINE Mask operator == (const pack& b) const { return Mask(_mm256_cmp_ps(m_v, b.m_v, _CMP_EQ_OQ)); }
+        STAR_SIMD_INLINE Mask operator != (const pack& b) const { return Mask(_mm256_cmp_ps(m_v, b.m_v, _CMP_NEQ_UQ)); }
+
+        STAR_SIMD_INLINE __m256 getNative() const { return m_v; }
+
+      private:
+        __m256 m_v;
+      };
+
+      /*****************************************************************************/
+      STAR_SIMD_INLINE pack<float, 8>
+      fma(const pack<float, 8>& a, const pack<float, 8>& b, const pack<float, 8>& c)
+      {
+#ifdef __FMA__
+        return pack<float, 8>(_mm256_fmadd_ps(a.getNative(), b.getNative(), c.getNative()));
+#else
+        return a*b+c;
+#endif
+      }
+
+      STAR_SIMD_INLINE pack<float, 8>
+      min(const pack<float, 8>& a, const pack<float, 8>& b)
+      {
+        return pack<float, 8>(_mm256_min_ps(a.getNative(), b.getNative()));
+      }
+
+      STAR_SIMD_INLINE pack<float, 8>
+      max(const pack<float, 8>& a, const pack<float, 8>& b)
+      {
+        return pack<float, 8>(_mm256_max_ps(a.getNative(), b.getNative()));
+      }
+
+      STAR_SIMD_INLINE pack<float, 8>
+      sqrt(const pack<float, 8>& a)
+      {
+        return pack<float, 8>(_mm256_sqrt_ps(a.getNative()));
+      }
+
+      STAR_SIMD_INLINE pack<float, 8>
+      rcp(const pack<float, 8>& a)
+      {
+        const pack<float, 8> y(_mm256_rcp_ps(a.getNative()));
+        return y*(pack<float, 8>(2.f)-a*y);
+      }
+
+      STAR_SIMD_INLINE pack<float, 8>
+      rsqrt(const pack<float, 8>& a)
+      {
+        const pack<float, 8> y(_mm256_rsqrt_ps(a.getNative()));
+        return pack<float, 8>(0.5f)*y*(pack<float, 8>(3.f)-a*y*y);
+      }
+
+      STAR_SIMD_INLINE pack<float, 8>
+      abs(const pack<float, 8>& a)
+      {
+        return pack<float, 8>(_mm256_andnot_ps(_mm256_set1_ps(-0.f), a.getNative()));
+      }
+
+      STAR_SIMD_INLINE pack<float, 8>
+      select(const mask<float, 8>& m, const pack<float, 8>& a, const pack<float, 8>& b)
+      {
+        return pack<float, 8>(_mm256_blendv_ps(b.getNative(), a.getNative(), m.getNative()));
+      }
+
+      template<int I0, int I1, int I2, int I3>
+      STAR_SIMD_INLINE pack<float, 8>
+      shuffle(const pack<float, 8>& a)
+      {
+        return pack<float, 8>(_mm256_permute_ps(a.getNative(), _MM_SHUFFLE(I3, I2, I1, I0)));
+      }
+
+      STAR_SIMD_INLINE float
+      reduceAdd(const pack<float, 8>& a)
+      {
+        return reduceAdd(pack<float, 4>(_mm_add_ps(_mm256_castps256_ps128(a.getNative()),
+                                                   _mm256_extractf128_ps(a.getNative(), 1))));
+      }
+
+      STAR_SIMD_INLINE float
+      reduceMin(const pack<float, 8>& a)
+      {
+        return reduceMin(pack<float, 4>(_mm_min_ps(_mm256_castps256_ps128(a.getNative()),
+                                                   _mm256_extractf128_ps(a.getNative(), 1))));
+      }
+
+      STAR_SIMD_INLINE float
+      reduceMax(const pack<float, 8>& a)
+      {
+        return reduceMax(pack<float, 4>(_mm_max_ps(_mm256_castps256_ps128(a.getNative()),
+                                                   _mm256_extractf128_ps(a.getNative(), 1))));
+      }
+#endif
+
+#ifdef STAR_SIMD_AVX512
+      /*****************************************************************************/
+      /**
+       * AVX-512 backend, masks are k registers.
+       */
+      template<>
+      class mask<float, 16>
+      {
+      public:
+        STAR_SIMD_INLINE mask() {}
+        STAR_SIMD_INLINE explicit mask(__mmask16 m) : m_m(m) {}
+
+        STAR_SIMD_INLINE static mask firstN(size_t n)
+        {
+          return mask(__mmask16(n >= 16 ? 0xffff : (1u << n)-1));
+        }
+
+        STAR_SIMD_INLINE static mask fromBits(unsigned int bits) { return mask(__mmask16(bits)); }
+        STAR_SIMD_INLINE unsigned int getBits() const { return m_m; }
+        STAR_SIMD_INLINE bool operator [] (size_t i) const { return ((m_m >> i) & 1) != 0; }
+
+        STAR_SIMD_INLINE mask operator & (const mask& b) const { return mask(__mmask16(m_m & b.m_m)); }
+        STAR_SIMD_INLINE mask operator | (const mask& b) const { return mask(__mmask16(m_m | b.m_m)); }
+        STAR_SIMD_INLINE mask operator ^ (const mask& b) const { return mask(__mmask16(m_m ^ b.m_m)); }
+        STAR_SIMD_INLINE mask operator ~ () const { return mask(__mmask16(~m_m)); }
+
+        STAR_SIMD_INLINE __mmask16 getNative() const { return m_m; }
+
+      private:
+        __mmask16 m_m;
+      };
+
+      /*****************************************************************************/
+      template<>
+      class pack<float, 16> : public Lanes<16>
+      {
+      public:
+        typedef mask<float, 16> Mask;
+
+        STAR_SIMD_INLINE pack() {}
+        STAR_SIMD_INLINE pack(float v) : m_v(_mm512_set1_ps(v)) {}
+        STAR_SIMD_INLINE explicit pack(__m512 v) : m_v(v) {}
+
+        STAR_SIMD_INLINE static pack zero() { return pack(_mm512_setzero_ps()); }
+        STAR_SIMD_INLINE static pack load(const float* p) { return pack(_mm512_load_ps(p)); }
+        STAR_SIMD_INLINE static pack loadu(const float* p) { return pack(_mm512_loadu_ps(p)); }
+
+        STAR_SIMD_INLINE static pack load(const float* p, const Mask& m)
+        {
+          return pack(_mm512_maskz_loadu_ps(m.getNative(), p));
+        }
+
+        STAR_SIMD_INLINE static pack gather(const float* base, const unsigned int* indices, unsigned int stride)
+        {
+          __m512i idx = _mm512_loadu_si512(indices);
+          idx = _mm512_mullo_epi32(idx, _mm512_set1_epi32(int(stride)));
+          return pack(_mm512_i32gather_ps(idx, base, 4));
+        }
+
+        STAR_SIMD_INLINE static pack gather(const float* base, const unsigned int* indices, unsigned int stride,
+                                            const Mask& m)
+        {
+          __m512i idx = _mm512_maskz_loadu_epi32(m.getNative(), indices);
+          idx = _mm512_mullo_epi32(idx, _mm512_set1_epi32(int(stride)));
+          return pack(_mm512_mask_i32gather_ps(_mm512_setzero_ps(), m.getNative(), idx, base, 4));
+        }
+
+        STAR_SIMD_INLINE void store(float* p) const { _mm512_store_ps(p, m_v); }
+        STAR_SIMD_INLINE void storeu(float* p) const { _mm512_storeu_ps(p, m_v); }
+        STAR_SIMD_INLINE void store(float* p, const Mask& m) const { _mm512_mask_storeu_ps(p, m.getNative(), m_v); }
+
+        STAR_SIMD_INLINE float operator [] (size_t i) const
+        {
+          float r[16];
+          storeu(r);
+          return r[i];
+        }
+
+        STAR_SIMD_INLINE pack operator + (const pack& b) const { return pack(_mm512_add_ps(m_v, b.m_v)); }
+        STAR_SIMD_INLINE pack operator - (const pack& b) const { return pack(_mm512_sub_ps(m_v, b.m_v)); }
+        STAR_SIMD_INLINE pack operator * (const pack& b) const { return pack(_mm512_mul_ps(m_v, b.m_v)); }
+        STAR_SIMD_INLINE pack operator / (const pack& b) const { return pack(_mm512_div_ps(m_v, b.m_v)); }
+        STAR_SIMD_INLINE pack& operator += (const pack& b) { return *this = *this+b; }
+        STAR_SIMD_INLINE pack& operator -= (const pack& b) { return *this = *this-b; }
+        STAR_SIMD_INLINE pack& operator *= (const pack& b) { return *this = *this*b; }
+        STAR_SIMD_INLINE pack& operator /= (const pack& b) { return *this = *this/b; }
+        STAR_SIMD_INLINE pack operator - () const
+        {
+          return pack(_mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(m_v),
+                                                           _mm512_set1_epi32(int(0x80000000u)))));
+        }
+
+        STAR_SIMD_INLINE Mask operator < (const pack& b) const { return Mask(_mm512_cmp_ps_mask(m_v, b.m_v, _CMP_LT_OQ)); }
+        STAR_SIMD_INLINE Mask operator <= (const pack& b) const { return Mask(_mm512_cmp_ps_mask(m_v, b.m_v, _CMP_LE_OQ)); }
+        STAR_SIMD_INLINE Mask operator > (const pack& b) const { return Mask(_mm512_cmp_ps_mask(m_v, b.m_v, _CMP_GT_OQ)); }
+        STAR_SIMD_INLINE Mask operator >= (const pack& b) const { return Mask(_mm512_cmp_ps_mask(m_v, b.m_v, _CMP_GE_OQ)); }
+        STAR_SIMD_INLINE Mask operator == (const pack& b) const { return Mask(_mm512_cmp_ps_mask(m_v, b.m_v, _CMP_EQ_OQ)); }
+        STAR_SIMD_INLINE Mask operator != (const pack& b) const { return Mask(_mm512_cmp_ps_mask(m_v, b.m_v, _CMP_NEQ_UQ)); }
+
+        STAR_SIMD_INLINE __m512 getNative() const { return m_v; }
+
+      private:
+        __m512 m_v;
+      };
+
+      /*****************************************************************************/
+      STAR_SIMD_INLINE pack<float, 16>
+      fma(const pack<float, 16>& a, const pack<float, 16>& b, const pack<float, 16>& c)
+      {
+        return pack<float, 16>(_mm512_fmadd_ps(a.getNative(), b.getNative(), c.getNative()));
+      }
+
+      STAR_SIMD_INLINE pack<float, 16>
+      min(const pack<float, 16>& a, const pack<float, 16>& b)
+      {
+        return pack<float, 16>(_mm512_min_ps(a.getNative(), b.getNative()));
+      }
+
+      STAR_SIMD_INLINE pack<float, 16>
+      max(const pack<float, 16>& a, const pack<float, 16>& b)
+      {
+        return pack<float, 16>(_mm512_max_ps(a.getNative(), b.getNative()));
+      }
+
+      STAR_SIMD_INLINE pack<float, 16>
+      sqrt(const pack<float, 16>& a)
+      {
+        return pack<float, 16>(_mm512_sqrt_ps(a.getNative()));
+      }
+
+      STAR_SIMD_INLINE pack<float, 16>
+      rcp(const pack<float, 16>& a)
+      {
+        const pack<float, 16> y(_mm512_rcp14_ps(a.getNative()));
+        return y*(pack<float, 16>(2.f)-a*y);
+      }
+
+      STAR_SIMD_INLINE pack<float, 16>
+      rsqrt(const pack<float, 16>& a)
+      {
+        const pack<float, 16> y(_mm512_rsqrt14_ps(a.getNative()));
+        return pack<float, 16>(0.5f)*y*(pack<float, 16>(3.f)-a*y*y);
+      }
+
+      STAR_SIMD_INLINE pack<float, 16>
+      abs(const pack<float, 16>& a)
+      {
+        return pack<float, 16>(_mm512_abs_ps(a.getNative()));
+      }
+
+      STAR_SIMD_INLINE pack<float, 16>
+      select(const mask<float, 16>& m, const pack<float, 16>& a, const pack<float, 16>& b)
+      {
+        return pack<float, 16>(_mm512_mask_blend_ps(m.getNative(), b.getNative(), a.getNative()));
+      }
+
+      template<int I0, int I1, int I2, int I3>
+      STAR_SIMD_INLINE pack<float, 16>
+      shuffle(const pack<float, 16>& a)
+      {
+        return pack<float, 16>(_mm512_permute_ps(a.getNative(), _MM_SHUFFLE(I3, I2, I1, I0)));
+      }
+
+      STAR_SIMD_INLINE float
+      reduceAdd(const pack<float, 16>& a)
+      {
+        return _mm512_reduce_add_ps(a.getNative());
+      }
+
+      STAR_SIMD_INLINE float
+      reduceMin(const pack<float, 16>& a)
+      {
+        return _mm512_reduce_min_ps(a.getNative());
+      }
+
+      STAR_SIMD_INLINE float
+      reduceMax(const pack<float, 16>& a)
+      {
+        return _mm512_reduce_max_ps(a.getNative());
+      }
+#endif
+
+      /*****************************************************************************/
+      /**
+       * Widest float pack of the instruction set.
+       */
+#if defined(STAR_SIMD_AVX512)
+      static const size_t FLOAT_WIDTH = 16;
+#elif defined(STAR_SIMD_AVX2)
+      static const size_t FLOAT_WIDTH = 8;
+#else
+      static const size_t FLOAT_WIDTH = 4;
+#endif
+      typedef pack<float, FLOAT_WIDTH> floatv;
+      typedef mask<float, FLOAT_WIDTH> floatm;
+    }
+  }
+}
+
+#endif
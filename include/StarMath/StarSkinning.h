@@ -0,0 +1,222 @@
+#ifndef STAR_SKINNING_H
+#define STAR_SKINNING_H
+
+#include <StarMath/StarVec3.h>
+#include <StarMath/StarMatrix.h>
+#include <StarMath/StarDualQuaternion.h>
+#include <StarMath/StarSoA.h>
+
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+
+namespace Star
+{
+  /**
+   * Structure of arrays view on the bone influences of vertices: for each
+   * influence slot, one array of weights and one of bone indices. All the
+   * vertices have numBones slots, unused ones have a zero weight. The
+   * weights of a vertex must sum to 1. The view doesn't own the arrays.
+   */
+  template <typename T>
+  struct BoneInfluenceSoA
+  {
+    /**
+     * Create a null view.
+     */
+    BoneInfluenceSoA() : numBones(0)
+    {
+      for(unsigned int b = 0; b < MAX_BONES; b++) {
+        weights[b] = 0;
+        indices[b] = 0;
+      }
+    }
+
+    /**
+     * Create a view on numBones weight and index arrays.
+     */
+    BoneInfluenceSoA(const T* const* w, const unsigned int* const* idx, unsigned int numBones)
+      : numBones(numBones)
+    {
+      assert(numBones >= 1 && numBones <= MAX_BONES);
+      for(unsigned int b = 0; b < MAX_BONES; b++) {
+        weights[b] = b < numBones ? w[b] : 0;
+        indices[b] = b < numBones ? idx[b] : 0;
+      }
+    }
+
+    /**
+     * Get a view starting at vertex i.
+     */
+    BoneInfluenceSoA offset(size_t i) const
+    {
+      BoneInfluenceSoA res(*this);
+      for(unsigned int b = 0; b < numBones; b++) {
+        res.weights[b] += i;
+        res.indices[b] += i;
+      }
+      return res;
+    }
+
+    static const unsigned int MAX_BONES = 4;
+
+    const T* weights[MAX_BONES];
+    const unsigned int* indices[MAX_BONES];
+    unsigned int numBones;
+  };
+
+  template<typename T> const unsigned int BoneInfluenceSoA<T>::MAX_BONES;
+
+  /*******************************************************************************/
+  /**
+   * Dual quaternion skinning. Each vertex blends the dual quaternions of
+   * its bones, flipping the ones in the other hemisphere than the first
+   * bone, normalizes the blend and applies it. Unlike linear blend
+   * skinning, the blend stays rigid so joints keep their volume.
+   *
+   * Vertices are split across threads for large meshes. The blend of the
+   * 8 coefficients is written as short loops the compiler vectorizes;
+   * Kernels::dualQuaternionSkin vectorizes across vertices instead.
+   * @param bones the unit dual quaternion palette
+   * @param influences the bones of each vertex
+   * @param positions the bind pose positions
+   * @param normals the bind pose normals, a null view skips normals
+   * @param outPositions receives n positions
+   * @param outNormals receives n normals if normals are given
+   * @param n the number of vertices
+   */
+  template<typename T>
+  void
+  dualQuaternionSkin(const DualQuaternion<T>* bones, BoneInfluenceSoA<T> influences,
+                     Vec3SoA<const T> positions, Vec3SoA<const T> normals,
+                     Vec3SoA<T> outPositions, Vec3SoA<T> outNormals, size_t n)
+  {
+    static_assert(sizeof(DualQuaternion<T>) == 8*sizeof(T),
+                  "The bones are read as 8 contiguous coefficients");
+    const T* palette = &bones[0].real.x;
+    const unsigned int numBones = influences.numBones;
+    const bool skinNormals = normals.x != 0;
+
+#pragma omp parallel for schedule(static) if(n > 16384)
+    for(long i = 0; i < long(n); i++) {
+      //Real part x, y, z, w then dual part x, y, z, w
+      T dq[8];
+      const T* first = palette+8*influences.indices[0][i];
+      T w = influences.weights[0][i];
+      for(unsigned int k = 0; k < 8; k++)
+        dq[k] = w*first[k];
+      for(unsigned int b = 1; b < numBones; b++) {
+        const T* bone = palette+8*influences.indices[b][i];
+        T d = bone[0]*first[0]+bone[1]*first[1]+bone[2]*first[2]+bone[3]*first[3];
+        w = d < 0 ? -influences.weights[b][i] : influences.weights[b][i];
+        for(unsigned int k = 0; k < 8; k++)
+          dq[k] += w*bone[k];
+      }
+
+      T invLen = T(1)/std::sqrt(dq[0]*dq[0]+dq[1]*dq[1]+dq[2]*dq[2]+dq[3]*dq[3]);
+      for(unsigned int k = 0; k < 8; k++)
+        dq[k] *= invLen;
+      T rx = dq[0], ry = dq[1], rz = dq[2], rw = dq[3];
+      T dx = dq[4], dy = dq[5], dz = dq[6], dw = dq[7];
+
+      //Translation is the vector part of 2*dual*conjugate(real)
+      T tx = 2*(dx*rw-rx*dw+ry*dz-rz*dy);
+      T ty = 2*(dy*rw-ry*dw+rz*dx-rx*dz);
+      T tz = 2*(dz*rw-rz*dw+rx*dy-ry*dx);
+
+      //Rotation with the cross product form of Quaternion<T>::rotate
+      T px = positions.x[i], py = positions.y[i], pz = positions.z[i];
+      T cx = 2*(ry*pz-rz*py), cy = 2*(rz*px-rx*pz), cz = 2*(rx*py-ry*px);
+      outPositions.x[i] = px+rw*cx+(ry*cz-rz*cy)+tx;
+      outPositions.y[i] = py+rw*cy+(rz*cx-rx*cz)+ty;
+      outPositions.z[i] = pz+rw*cz+(rx*cy-ry*cx)+tz;
+
+      if(skinNormals) {
+        T nx = normals.x[i], ny = normals.y[i], nz = normals.z[i];
+        cx = 2*(ry*nz-rz*ny); cy = 2*(rz*nx-rx*nz); cz = 2*(rx*ny-ry*nx);
+        outNormals.x[i] = nx+rw*cx+(ry*cz-rz*cy);
+        outNormals.y[i] = ny+rw*cy+(rz*cx-rx*cz);
+        outNormals.z[i] = nz+rw*cz+(rx*cy-ry*cx);
+      }
+    }
+  }
+
+  /*******************************************************************************/
+  /**
+   * Linear blend skinning. Each vertex first blends the affine matrices of
+   * its bones with its weights, then applies the blended matrix once, so a
+   * vertex costs one 3x4 transform instead of one per bone. Normals are
+   * transformed by the blended 3x3 part and renormalized, which is exact
+   * for bones without non-uniform scaling.
+   *
+   * The palette holds row major 3x4 matrices, as written by
+   * quaternionToRotationMatrix; an array of Matrix<T> works with a stride
+   * of 16. Vertices are split across threads for large meshes. The blend
+   * of the 12 coefficients is written as short loops the compiler
+   * vectorizes.
+   * @param palette the bone matrices
+   * @param stride the distance between two bone matrices
+   * @param influences the bones of each vertex
+   * @param positions the bind pose positions
+   * @param normals the bind pose normals, a null view skips normals
+   * @param outPositions receives n positions
+   * @param outNormals receives n normals if normals are given
+   * @param n the number of vertices
+   */
+  template<typename T>
+  void
+  linearBlendSkin(const T* palette, size_t stride, BoneInfluenceSoA<T> influences,
+                  Vec3SoA<const T> positions, Vec3SoA<const T> normals,
+                  Vec3SoA<T> outPositions, Vec3SoA<T> outNormals, size_t n)
+  {
+    const unsigned int numBones = influences.numBones;
+    const bool skinNormals = normals.x != 0;
+
+#pragma omp parallel for schedule(static) if(n > 16384)
+    for(long i = 0; i < long(n); i++) {
+      T m[12];
+      const T* bone = palette+stride*influences.indices[0][i];
+      T w = influences.weights[0][i];
+      for(unsigned int k = 0; k < 12; k++)
+        m[k] = w*bone[k];
+      for(unsigned int b = 1; b < numBones; b++) {
+        bone = palette+stride*influences.indices[b][i];
+        w = influences.weights[b][i];
+        for(unsigned int k = 0; k < 12; k++)
+          m[k] += w*bone[k];
+      }
+
+      T px = positions.x[i], py = positions.y[i], pz = positions.z[i];
+      outPositions.x[i] = m[0]*px+m[1]*py+m[2]*pz+m[3];
+      outPositions.y[i] = m[4]*px+m[5]*py+m[6]*pz+m[7];
+      outPositions.z[i] = m[8]*px+m[9]*py+m[10]*pz+m[11];
+
+      if(skinNormals) {
+        T nx = normals.x[i], ny = normals.y[i], nz = normals.z[i];
+        T rx = m[0]*nx+m[1]*ny+m[2]*nz;
+        T ry = m[4]*nx+m[5]*ny+m[6]*nz;
+        T rz = m[8]*nx+m[9]*ny+m[10]*nz;
+        T invLen = T(1)/std::sqrt(rx*rx+ry*ry+rz*rz);
+        outNormals.x[i] = rx*invLen;
+        outNormals.y[i] = ry*invLen;
+        outNormals.z[i] = rz*invLen;
+      }
+    }
+  }
+
+  /*******************************************************************************/
+  /**
+   * Linear blend skinning with a Matrix<T> palette, see the 3x4 version.
+   */
+  template<typename T>
+  void
+  linearBlendSkin(const Matrix<T>* palette, BoneInfluenceSoA<T> influences,
+                  Vec3SoA<const T> positions, Vec3SoA<const T> normals,
+                  Vec3SoA<T> outPositions, Vec3SoA<T> outNormals, size_t n)
+  {
+    linearBlendSkin(palette[0].constPtr(), 16, influences, positions, normals,
+                    outPositions, outNormals, n);
+  }
+}
+
+#endif
@@ -0,0 +1,78 @@
+#ifndef STAR_SOA_H
+#define STAR_SOA_H
+
+#include <cstddef>
+
+namespace Star
+{
+  /**
+   * Structure of arrays view on 3D vectors: one array per coordinate.
+   * Batch kernels take their inputs as Vec3SoA<const T> and their outputs
+   * as Vec3SoA<T>. The view doesn't own the arrays.
+   */
+  template <typename T>
+  struct Vec3SoA
+  {
+    /**
+     * Create a null view.
+     */
+    Vec3SoA() : x(0), y(0), z(0) {}
+
+    /**
+     * Create a view on 3 arrays.
+     */
+    Vec3SoA(T* x, T* y, T* z) : x(x), y(y), z(z) {}
+
+    /**
+     * Convert a view on mutable arrays into a view on constant arrays.
+     */
+    template <typename T2>
+    Vec3SoA(const Vec3SoA<T2>& v) : x(v.x), y(v.y), z(v.z) {}
+
+    /**
+     * Get a view starting at element i.
+     */
+    Vec3SoA offset(size_t i) const { return Vec3SoA(x+i, y+i, z+i); }
+
+    T* x;
+    T* y;
+    T* z;
+  };
+
+  /**
+   * Structure of arrays view on quaternions: one array per component.
+   * Batch kernels take their inputs as QuaternionSoA<const T> and their
+   * outputs as QuaternionSoA<T>. The view doesn't own the arrays.
+   */
+  template <typename T>
+  struct QuaternionSoA
+  {
+    /**
+     * Create a null view.
+     */
+    QuaternionSoA() : x(0), y(0), z(0), w(0) {}
+
+    /**
+     * Create a view on 4 arrays.
+     */
+    QuaternionSoA(T* x, T* y, T* z, T* w) : x(x), y(y), z(z), w(w) {}
+
+    /**
+     * Convert a view on mutable arrays into a view on constant arrays.
+     */
+    template <typename T2>
+    QuaternionSoA(const QuaternionSoA<T2>& q) : x(q.x), y(q.y), z(q.z), w(q.w) {}
+
+    /**
+     * Get a view starting at element i.
+     */
+    QuaternionSoA offset(size_t i) const { return QuaternionSoA(x+i, y+i, z+i, w+i); }
+
+    T* x;
+    T* y;
+    T* z;
+    T* w;
+  };
+}
+
+#endif
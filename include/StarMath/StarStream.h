@@ -0,0 +1,74 @@
+#ifndef STAR_STREAM_H
+#define STAR_STREAM_H
+
+#include <StarMath/StarVec2.h>
+#include <StarMath/StarVec3.h>
+#include <StarMath/StarVec4.h>
+#include <StarMath/StarBox.h>
+#include <StarMath/StarMatrix.h>
+#include <StarMath/StarMatrix2.h>
+#include <StarMath/StarQuaternion.h>
+#include <StarMath/StarDualQuaternion.h>
+
+#include <ostream>
+
+/**
+ * Stream operators of the StarMath types. The other headers only declare
+ * them with <iosfwd>; the StarMath library instantiates them for the
+ * float, double and int typedefs, include this header for other types.
+ */
+
+/*****************************************************************************/
+template <typename T>
+std::ostream&
+operator << (std::ostream& os, const Star::Box<T>& b)
+{
+  return os << "(" << b.getMin() << " - " << b.getMax() << ")";
+}
+
+namespace Star
+{
+/*****************************************************************************/
+  template <size_t N, typename T>
+  std::ostream&
+  operator << (std::ostream& os, const Vec<N, T>& v)
+  {
+    os << "(" << v[0];
+    for ( size_t i = 1; i < N; i++ )
+      os << ", " << v[i];
+    return os << ")";
+  }
+
+/*****************************************************************************/
+  template <size_t R, size_t C, typename T>
+  std::ostream&
+  operator << (std::ostream& os, const Mat<R, C, T>& m)
+  {
+    for ( size_t j = 0; j < R; j++ )
+    {
+      os << "[ ";
+      for ( size_t i = 0; i < C; i++ )
+        os << m(j, i) << " ";
+      os << "]" << std::endl;
+    }
+    return os;
+  }
+
+  /*****************************************************************************/
+  template <typename T>
+  std::ostream&
+  operator << (std::ostream& os, const Quaternion<T>& q)
+  {
+    return os << "(" << q.x << ", " << q.y <<  ", " << q.z << ", " << q.w << ")";
+  }
+
+  /*****************************************************************************/
+  template <typename T>
+  std::ostream&
+  operator << (std::ostream& os, const DualQuaternion<T>& dq)
+  {
+    return os << "(" << dq.real << ", " << dq.dual << ")";
+  }
+}
+
+#endif
@@ -0,0 +1,574 @@
+#ifndef STAR_TRANSFORM_HIERARCHY_H
+#define STAR_TRANSFORM_HIERARCHY_H
+
+#include <StarMath/StarVec3.h>
+#include <StarMath/StarMatrix.h>
+#include <StarMath/StarQuaternion.h>
+#include <StarMath/StarQuaternionBatch.h>
+#include <StarMath/StarSimd.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <cassert>
+#include <cstddef>
+#include <algorithm>
+#include <vector>
+
+namespace Star
+{
+  /**
+   * A hierarchy of transforms stored in flat arrays.
+   *
+   * Each node has a local translation, rotation and scale relative to its
+   * parent, its world matrix is parentWorld*T*R*S. Nodes are stored in
+   * topological order: a parent always has a smaller index than its
+   * children, so a single pass in index order computes all the world
+   * matrices.
+   *
+   * Changing a local transform marks the node dirty. update() then only
+   * recomputes the dirty nodes and their descendants, starting from the
+   * first dirty index. World matrices are stored contiguously and stay
+   * unchanged until the next update().
+   *
+   * When most of a large hierarchy moves, updateParallel() processes the
+   * nodes depth by depth instead: the nodes of a depth only depend on the
+   * previous one, so each depth is split in chunks shared by the threads.
+   * Walking the nodes by depth costs about three times the index order on
+   * one thread, so it falls back to update() without threads or for
+   * small or thin hierarchies.
+   */
+  template<typename T>
+  class TransformHierarchy
+  {
+  public:
+    /**
+     * Parent index of root nodes.
+     */
+    static const unsigned int NONE = ~0u;
+
+    /**
+     * Create an empty hierarchy.
+     */
+    TransformHierarchy();
+
+    /**
+     * Remove all the nodes.
+     */
+    void clear();
+
+    /**
+     * Reserve memory for numNodes nodes.
+     */
+    void reserve(size_t numNodes);
+
+    /**
+     * Add a dirty node.
+     * @param parent an existing node or NONE for a root
+     * @return the index of the node
+     */
+    unsigned int addNode(unsigned int parent, const Vec3<T>& translation,
+                         const Quaternion<T>& rotation, const Vec3<T>& scale);
+
+    /**
+     * Get the number of nodes.
+     */
+    inline size_t getNumNodes() const;
+
+    /**
+     * Get the parent of a node, NONE for a root.
+     */
+    inline unsigned int getParent(unsigned int node) const;
+
+    inline const Vec3<T>& getTranslation(unsigned int node) const;
+    inline const Quaternion<T>& getRotation(unsigned int node) const;
+    inline const Vec3<T>& getScale(unsigned int node) const;
+
+    /**
+     * Set the local transform of a node and mark it dirty.
+     */
+    inline void setTranslation(unsigned int node, const Vec3<T>& translation);
+    inline void setRotation(unsigned int node, const Quaternion<T>& rotation);
+    inline void setScale(unsigned int node, const Vec3<T>& scale);
+    inline void setLocal(unsigned int node, const Vec3<T>& translation,
+                         const Quaternion<T>& rotation, const Vec3<T>& scale);
+
+    /**
+     * Mark a node dirty, its world matrix and the ones of its descendants
+     * will be recomputed by the next update().
+     */
+    inline void setDirty(unsigned int node);
+
+    /**
+     * Check if a node or one of its ancestors changed since the last update.
+     */
+    bool isDirty(unsigned int node) const;
+
+    /**
+     * Recompute the world matrices of the dirty nodes and their
+     * descendants.
+     * @return the number of recomputed nodes
+     */
+    size_t update();
+
+    /**
+     * Same as update(), processing the nodes depth by depth with the
+     * nodes of each depth split across threads. The order by depth is
+     * rebuilt after nodes were added. Runs update() instead with a single
+     * thread, fewer than PARALLEL_MIN_NODES nodes after the first dirty
+     * one, or depths of fewer than PARALLEL_MIN_LEVEL_SIZE nodes on
+     * average. Smaller depths are processed by one thread.
+     * @return the number of recomputed nodes
+     */
+    size_t updateParallel();
+
+    /**
+     * Get the depth of a node, 0 for a root.
+     */
+    inline unsigned int getDepth(unsigned int node) const;
+
+    /**
+     * Get the world matrix of a node as of the last update().
+     */
+    inline const Matrix<T>& getWorld(unsigned int node) const;
+
+    /**
+     * Get the getNumNodes() world matrices, in node order.
+     */
+    inline const Matrix<T>* getWorldMatrices() const;
+
+    /**
+     * Compute the row major 3x4 matrix T*R*S.
+     */
+    static inline void composeLocal(const Vec3<T>& translation, const Quaternion<T>& rotation,
+                                    const Vec3<T>& scale, T* m);
+
+    /**
+     * Multiply two affine matrices given by their first 3 rows, the last
+     * row being (0, 0, 0, 1). out may not alias a or b.
+     * @param a, b, out row major 3x4 matrices with rows strideA, strideB
+     * and strideOut apart
+     */
+    static inline void multiplyAffine(const T* a, size_t strideA, const T* b, size_t strideB,
+                                      T* out, size_t strideOut);
+
+    /**
+     * Sizes below which updateParallel() gives up threads, see there.
+     */
+    static const size_t PARALLEL_MIN_NODES = 16384;
+    static const size_t PARALLEL_MIN_LEVEL_SIZE = 2048;
+
+  private:
+    void markDirty(unsigned int node);
+    void buildLevels();
+    inline void updateNode(size_t node);
+    inline bool updateIfDirty(size_t node, size_t first);
+
+    std::vector<unsigned int> m_parents;
+    std::vector<Vec3<T> > m_translations;
+    std::vector<Quaternion<T> > m_rotations;
+    std::vector<Vec3<T> > m_scales;
+    std::vector<Matrix<T> > m_worlds;
+    std::vector<unsigned int> m_depths;
+
+    //Nodes sorted by depth then index, the nodes of depth d are
+    //m_levelNodes[m_levelStarts[d]] to m_levelNodes[m_levelStarts[d+1]-1]
+    std::vector<unsigned int> m_levelNodes;
+    std::vector<size_t> m_levelStarts;
+
+    //Nodes changed since the last update, all the nodes before
+    //m_firstDirty are clean
+    std::vector<unsigned char> m_dirty;
+    size_t m_firstDirty;
+  };
+
+  /*****************************************************************************/
+  typedef TransformHierarchy<float> transformHierarchyf;
+  typedef TransformHierarchy<double> transformHierarchyd;
+
+  /*******************************************************************************/
+  template<typename T> const unsigned int TransformHierarchy<T>::NONE;
+  template<typename T> const size_t TransformHierarchy<T>::PARALLEL_MIN_NODES;
+  template<typename T> const size_t TransformHierarchy<T>::PARALLEL_MIN_LEVEL_SIZE;
+
+  /*******************************************************************************/
+  template<typename T>
+  TransformHierarchy<T>::TransformHierarchy() : m_firstDirty(0)
+  {
+  }
+
+  /*******************************************************************************/
+  template<typename T>
+  void
+  TransformHierarchy<T>::clear()
+  {
+    m_parents.clear();
+    m_translations.clear();
+    m_rotations.clear();
+    m_scales.clear();
+    m_worlds.clear();
+    m_depths.clear();
+    m_levelNodes.clear();
+    m_levelStarts.clear();
+    m_dirty.clear();
+    m_firstDirty = 0;
+  }
+
+  /*******************************************************************************/
+  template<typename T>
+  void
+  TransformHierarchy<T>::reserve(size_t numNodes)
+  {
+    m_parents.reserve(numNodes);
+    m_translations.reserve(numNodes);
+    m_rotations.reserve(numNodes);
+    m_scales.reserve(numNodes);
+    m_worlds.reserve(numNodes);
+    m_depths.reserve(numNodes);
+    m_dirty.reserve(numNodes);
+  }
+
+  /*******************************************************************************/
+  template<typename T>
+  unsigned int
+  TransformHierarchy<T>::addNode(unsigned int parent, const Vec3<T>& translation,
+                                 const Quaternion<T>& rotation, const Vec3<T>& scale)
+  {
+    assert(parent == NONE || parent < m_parents.size());
+    const unsigned int node = (unsigned int)m_parents.size();
+
+    Matrix<T> world;
+    world.toIdentity();
+    m_parents.push_back(parent);
+    m_translations.push_back(translation);
+    m_rotations.push_back(rotation);
+    m_scales.push_back(scale);
+    m_worlds.push_back(world);
+    m_depths.push_back(parent == NONE ? 0 : m_depths[parent]+1);
+    m_dirty.push_back(0);
+    markDirty(node);
+
+    return node;
+  }
+
+  /*******************************************************************************/
+  template<typename T>
+  size_t
+  TransformHierarchy<T>::getNumNodes() const
+  {
+    return m_parents.size();
+  }
+
+  /*******************************************************************************/
+  template<typename T>
+  unsigned int
+  TransformHierarchy<T>::getParent(unsigned int node) const
+  {
+    return m_parents[node];
+  }
+
+  /*******************************************************************************/
+  template<typename T>
+  unsigned int
+  TransformHierarchy<T>::getDepth(unsigned int node) const
+  {
+    return m_depths[node];
+  }
+
+  /*******************************************************************************/
+  template<typename T>
+  const Vec3<T>&
+  TransformHierarchy<T>::getTranslation(unsigned int node) const
+  {
+    return m_translations[node];
+  }
+
+  /*******************************************************************************/
+  template<typename T>
+  const Quaternion<T>&
+  TransformHierarchy<T>::getRotation(unsigned int node) const
+  {
+    return m_rotations[node];
+  }
+
+  /*******************************************************************************/
+  template<typename T>
+  const Vec3<T>&
+  TransformHierarchy<T>::getScale(unsigned int node) const
+  {
+    return m_scales[node];
+  }
+
+  /*******************************************************************************/
+  template<typename T>
+  void
+  TransformHierarchy<T>::setTranslation(unsigned int node, const Vec3<T>& translation)
+  {
+    m_translations[node] = translation;
+    markDirty(node);
+  }
+
+  /*******************************************************************************/
+  template<typename T>
+  void
+  TransformHierarchy<T>::setRotation(unsigned int node, const Quaternion<T>& rotation)
+  {
+    m_rotations[node] = rotation;
+    markDirty(node);
+  }
+
+  /*******************************************************************************/
+  template<typename T>
+  void
+  TransformHierarchy<T>::setScale(unsigned int node, const Vec3<T>& scale)
+  {
+    m_scales[node] = scale;
+    markDirty(node);
+  }
+
+  /*******************************************************************************/
+  template<typename T>
+  void
+  TransformHierarchy<T>::setLocal(unsigned int node, const Vec3<T>& translation,
+                                  const Quaternion<T>& rotation, const Vec3<T>& scale)
+  {
+    m_translations[node] = translation;
+    m_rotations[node] = rotation;
+    m_scales[node] = scale;
+    markDirty(node);
+  }
+
+  /*******************************************************************************/
+  template<typename T>
+  void
+  TransformHierarchy<T>::setDirty(unsigned int node)
+  {
+    markDirty(node);
+  }
+
+  /*******************************************************************************/
+  template<typename T>
+  void
+  TransformHierarchy<T>::markDirty(unsigned int node)
+  {
+    assert(node < m_dirty.size());
+    m_dirty[node] = 1;
+    m_firstDirty = std::min(m_firstDirty, size_t(node));
+  }
+
+  /*******************************************************************************/
+  template<typename T>
+  bool
+  TransformHierarchy<T>::isDirty(unsigned int node) const
+  {
+    for(; node != NONE && node >= m_firstDirty; node = m_parents[node])
+      if(m_dirty[node])
+        return true;
+    return false;
+  }
+
+  /*******************************************************************************/
+  template<typename T>
+  const Matrix<T>&
+  TransformHierarchy<T>::getWorld(unsigned int node) const
+  {
+    return m_worlds[node];
+  }
+
+  /*******************************************************************************/
+  template<typename T>
+  const Matrix<T>*
+  TransformHierarchy<T>::getWorldMatrices() const
+  {
+    return m_worlds.empty() ? 0 : &m_worlds[0];
+  }
+
+  /*******************************************************************************/
+  template<typename T>
+  void
+  TransformHierarchy<T>::composeLocal(const Vec3<T>& translation, const Quaternion<T>& rotation,
+                                      const Vec3<T>& scale, T* m)
+  {
+    quaternionRotationRows(rotation, m, 4);
+    for(size_t r = 0; r < 3; r++) {
+      m[4*r] *= scale.x;
+      m[4*r+1] *= scale.y;
+      m[4*r+2] *= scale.z;
+    }
+    m[3] = translation.x;
+    m[7] = translation.y;
+    m[11] = translation.z;
+  }
+
+  /*******************************************************************************/
+  template<typename T>
+  void
+  TransformHierarchy<T>::multiplyAffine(const T* a, size_t strideA, const T* b, size_t strideB,
+                                        T* out, size_t strideOut)
+  {
+    const T* b0 = b;
+    const T* b1 = b+strideB;
+    const T* b2 = b+2*strideB;
+    for(size_t r = 0; r < 3; r++) {
+      const T* ar = a+r*strideA;
+      T* o = out+r*strideOut;
+      for(size_t c = 0; c < 4; c++)
+        o[c] = ar[0]*b0[c]+ar[1]*b1[c]+ar[2]*b2[c];
+      o[3] += ar[3];
+    }
+  }
+
+  /*******************************************************************************/
+  template<>
+  inline void
+  TransformHierarchy<float>::multiplyAffine(const float* a, size_t strideA, const float* b, size_t strideB,
+                                            float* out, size_t strideOut)
+  {
+    typedef simd::pack<float, 4> float4v;
+
+    //Each output row is a combination of the rows of b, plus the
+    //translation of a in the last lane
+    const float4v b0 = float4v::loadu(b);
+    const float4v b1 = float4v::loadu(b+strideB);
+    const float4v b2 = float4v::loadu(b+2*strideB);
+    const float4v::Mask lastLane = float4v::Mask::fromBits(0x8);
+    for(size_t r = 0; r < 3; r++) {
+      const float* ar = a+r*strideA;
+      float4v row = float4v(ar[0])*b0;
+      row += float4v(ar[1])*b1;
+      row += float4v(ar[2])*b2;
+      row += simd::select(lastLane, float4v(ar[3]), float4v::zero());
+      row.storeu(out+r*strideOut);
+    }
+  }
+
+  /*******************************************************************************/
+  template<typename T>
+  void
+  TransformHierarchy<T>::updateNode(size_t node)
+  {
+    const unsigned int parent = m_parents[node];
+    T* world = m_worlds[node].ptr();
+    if(parent == NONE)
+      composeLocal(m_translations[node], m_rotations[node], m_scales[node], world);
+    else {
+      T local[12];
+      composeLocal(m_translations[node], m_rotations[node], m_scales[node], local);
+      multiplyAffine(m_worlds[parent].constPtr(), 4, local, 4, world, 4);
+    }
+  }
+
+  /*******************************************************************************/
+  template<typename T>
+  bool
+  TransformHierarchy<T>::updateIfDirty(size_t node, size_t first)
+  {
+    const unsigned int parent = m_parents[node];
+    if(parent != NONE && parent >= first)
+      m_dirty[node] |= m_dirty[parent];
+    if(!m_dirty[node])
+      return false;
+    updateNode(node);
+    return true;
+  }
+
+  /*******************************************************************************/
+  template<typename T>
+  size_t
+  TransformHierarchy<T>::update()
+  {
+    const size_t numNodes = m_parents.size();
+    const size_t first = m_firstDirty;
+    size_t numUpdated = 0;
+
+    //Parents come first, so a node is recomputed once its parent is known
+    //to be up to date. The flags of recomputed nodes stay set during the
+    //pass to propagate to their children.
+    for(size_t i = first; i < numNodes; i++)
+      numUpdated += updateIfDirty(i, first);
+
+    if(first < numNodes)
+      std::fill(m_dirty.begin()+first, m_dirty.end(), 0);
+    m_firstDirty = numNodes;
+
+    return numUpdated;
+  }
+
+  /*******************************************************************************/
+  template<typename T>
+  void
+  TransformHierarchy<T>::buildLevels()
+  {
+    //Counting sort by depth, stable so each depth stays in index order
+    const size_t numNodes = m_parents.size();
+    unsigned int maxDepth = 0;
+    for(size_t i = 0; i < numNodes; i++)
+      maxDepth = std::max(maxDepth, m_depths[i]);
+
+    m_levelStarts.assign(maxDepth+2, 0);
+    for(size_t i = 0; i < numNodes; i++)
+      m_levelStarts[m_depths[i]+1]++;
+    for(size_t d = 1; d < m_levelStarts.size(); d++)
+      m_levelStarts[d] += m_levelStarts[d-1];
+
+    std::vector<size_t> next(m_levelStarts.begin(), m_levelStarts.end()-1);
+    m_levelNodes.resize(numNodes);
+    for(size_t i = 0; i < numNodes; i++)
+      m_levelNodes[next[m_depths[i]]++] = (unsigned int)i;
+  }
+
+  /*******************************************************************************/
+  template<typename T>
+  size_t
+  TransformHierarchy<T>::updateParallel()
+  {
+    const size_t numNodes = m_parents.size();
+    const size_t first = std::min(m_firstDirty, numNodes);
+#ifdef _OPENMP
+    const bool hasThreads = omp_get_max_threads() > 1 && !omp_in_parallel();
+#else
+    const bool hasThreads = false;
+#endif
+    if(!hasThreads || numNodes-first < PARALLEL_MIN_NODES)
+      return update();
+
+    if(m_levelNodes.size() != numNodes)
+      buildLevels();
+    const size_t numLevels = m_levelStarts.size()-1;
+    if(numNodes-first < numLevels*PARALLEL_MIN_LEVEL_SIZE)
+      return update();
+    long numUpdated = 0;
+
+    //Nodes cost about the same, but dirty subtrees are uneven, so threads
+    //take chunks dynamically. The barrier at the end of each depth makes
+    //the parents ready for the next one.
+#pragma omp parallel
+    for(size_t d = 0; d < numLevels; d++) {
+      //Nodes before the first dirty one are clean
+      const unsigned int* levelBegin = &m_levelNodes[0]+m_levelStarts[d];
+      const unsigned int* levelEnd = &m_levelNodes[0]+m_levelStarts[d+1];
+      const unsigned int* begin = std::lower_bound(levelBegin, levelEnd, (unsigned int)first);
+      const long levelSize = long(levelEnd-begin);
+
+      if(levelSize < long(PARALLEL_MIN_LEVEL_SIZE)) {
+#pragma omp single
+        for(long k = 0; k < levelSize; k++)
+          numUpdated += updateIfDirty(begin[k], first);
+      }
+      else {
+#pragma omp for schedule(dynamic, 256) reduction(+:numUpdated)
+        for(long k = 0; k < levelSize; k++)
+          numUpdated += updateIfDirty(begin[k], first);
+      }
+    }
+
+    if(first < numNodes)
+      std::fill(m_dirty.begin()+first, m_dirty.end(), 0);
+    m_firstDirty = numNodes;
+
+    return size_t(numUpdated);
+  }
+}
+
+#endif
@@ -1,8 +1,22 @@
 #ifndef STAR_UTILS_H
 #define STAR_UTILS_H
 
+#include <algorithm>
 #include <cmath>
 #include <limits>
+#include <stdint.h>
+
+/**
+ * Inline even where the compiler's heuristics wouldn't, for the small
+ * helpers of large functions such as the 4x4 minors of Mat::inverse.
+ */
+#if defined(__GNUC__)
+#define STAR_FORCE_INLINE inline __attribute__((always_inline))
+#elif defined(_MSC_VER)
+#define STAR_FORCE_INLINE __forceinline
+#else
+#define STAR_FORCE_INLINE inline
+#endif
 
 namespace Star
 {
@@ -62,6 +76,52 @@ namespace Star
     {
         return (val+alignment-1) & ~(alignment-1);
     }
+
+    /**
+     * Spread the 21 low bits of val so that there are 2 zero bits between each.
+     */
+    inline uint64_t mortonSpread3(uint32_t val)
+    {
+        uint64_t x = val & 0x1fffff;
+        x = (x | x << 32) & 0x1f00000000ffffULL;
+        x = (x | x << 16) & 0x1f0000ff0000ffULL;
+        x = (x | x << 8) & 0x100f00f00f00f00fULL;
+        x = (x | x << 4) & 0x10c30c30c30c30c3ULL;
+        x = (x | x << 2) & 0x1249249249249249ULL;
+        return x;
+    }
+
+    /**
+     * Inverse of mortonSpread3.
+     */
+    inline uint32_t mortonCompact3(uint64_t x)
+    {
+        x &= 0x1249249249249249ULL;
+        x = (x ^ (x >> 2)) & 0x10c30c30c30c30c3ULL;
+        x = (x ^ (x >> 4)) & 0x100f00f00f00f00fULL;
+        x = (x ^ (x >> 8)) & 0x1f0000ff0000ffULL;
+        x = (x ^ (x >> 16)) & 0x1f00000000ffffULL;
+        x = (x ^ (x >> 32)) & 0x1fffff;
+        return uint32_t(x);
+    }
+
+    /**
+     * Interleave the bits of 3 21 bits coordinates (x in the lowest bit).
+     */
+    inline uint64_t mortonEncode3(uint32_t x, uint32_t y, uint32_t z)
+    {
+        return mortonSpread3(x) | (mortonSpread3(y) << 1) | (mortonSpread3(z) << 2);
+    }
+
+    /**
+     * Extract the 3 coordinates of a Morton code.
+     */
+    inline void mortonDecode3(uint64_t code, uint32_t& x, uint32_t& y, uint32_t& z)
+    {
+        x = mortonCompact3(code);
+        y = mortonCompact3(code >> 1);
+        z = mortonCompact3(code >> 2);
+    }
 }
 
 #endif
@@ -0,0 +1,692 @@
+#ifndef STAR_VEC_H
+#define STAR_VEC_H
+
+#include <StarMath/StarUtils.h>
+#include <StarMath/StarInstrument.h>
+#include <StarMath/StarPrecision.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <iosfwd>
+#include <limits>
+
+namespace Star
+{
+  /**
+   * Call f(0), ..., f(N-1), unrolled at compile time. The operations of Vec
+   * and Mat are written with it so they don't depend on the compiler
+   * unrolling their loops.
+   */
+  template <size_t N>
+  struct Unroll
+  {
+    template <typename F>
+    static inline void apply(const F& f)
+    {
+      Unroll<N-1>::apply(f);
+      f(N-1);
+    }
+  };
+
+  template <>
+  struct Unroll<0>
+  {
+    template <typename F>
+    static inline void apply(const F&) {}
+  };
+
+  /**
+   * Storage of the vector components. The components of the 2D, 3D and 4D
+   * vectors are the members x, y, z and w, the other sizes are only
+   * accessed through ptr().
+   */
+  template <size_t N, typename T>
+  struct VecBase
+  {
+    T* ptr() { return m_v; }
+    const T* constPtr() const { return m_v; }
+
+    T m_v[N];
+  };
+
+  template <typename T>
+  struct VecBase<2, T>
+  {
+    T* ptr() { return &x; }
+    const T* constPtr() const { return &x; }
+
+    T x, y;
+  };
+
+  template <typename T>
+  struct VecBase<3, T>
+  {
+    T* ptr() { return &x; }
+    const T* constPtr() const { return &x; }
+
+    T x, y, z;
+  };
+
+  template <typename T>
+  struct VecBase<4, T>
+  {
+    T* ptr() { return &x; }
+    const T* constPtr() const { return &x; }
+
+    T x, y, z, w;
+  };
+
+  /**
+   * A vector of N components. Vec2, Vec3 and Vec4 are its 2D, 3D and 4D
+   * aliases.
+   */
+  template <size_t N, typename T>
+  class Vec : public VecBase<N, T>
+  {
+  public:
+    /**
+     * Construct an uninitialised vector.
+     */
+    Vec() {}
+
+    /**
+     * Explicit cast
+     */
+    template <typename T2>
+    explicit Vec( const Vec<N, T2>& );
+
+    /**
+     * Construct a vector with the N values pointed by p.
+     */
+    Vec( const T *p );
+
+    /**
+     * Construct a vector with the specified values, one per component.
+     */
+    template <typename... Ts>
+    Vec( T x, T y, Ts... others );
+
+    /**
+     * Construct a vector with the components of v followed by last, e.g. a
+     * 4D vector from a 3D one and w.
+     */
+    Vec( const Vec<N-1, T>& v, T last );
+
+    /**
+     * Get a pointer on the vector values.
+     */
+    operator T* ();
+
+    /**
+     * Get a constant pointer on the vector values.
+     */
+    operator const T* () const;
+
+    /**
+     * Addition.
+     */
+    Vec& operator += ( const Vec& );
+
+    /**
+     * Substraction.
+     */
+    Vec& operator -= ( const Vec& );
+
+    /**
+     * Scalar multiplication.
+     */
+    Vec& operator *= ( T );
+
+    /**
+     * Scalar division.
+     */
+    Vec& operator /= ( T );
+
+    /**
+     * Nop
+     */
+    Vec operator + () const;
+
+    /**
+     * Negate the vector.
+     */
+    Vec operator - () const;
+
+    /**
+     * Addition.
+     */
+    Vec operator + ( const Vec& ) const;
+
+    /**
+     * Substraction.
+     */
+    Vec operator - ( const Vec& ) const;
+
+    /**
+     * Scalar multiplication.
+     */
+    Vec operator * ( T ) const;
+
+    /**
+     * Scalar division.
+     */
+    Vec operator / ( T ) const;
+
+    /**
+     * Component wise multiplication.
+     */
+    Vec operator * ( const Vec& ) const;
+
+    /**
+     * Component wise division.
+     */
+    Vec operator / ( const Vec& ) const;
+
+    /**
+     * Scalar multiplication.
+     */
+    friend Vec operator * ( T k, const Vec& v )
+    {
+      return v*k;
+    }
+
+    /**
+     * Equality check. Use std's epsilon for floating point values, exact
+     * for integer values.
+     */
+    bool operator == ( const Vec& ) const;
+
+    /**
+     * Inequality check. Use std's epsilon for floating point values, exact
+     * for integer values.
+     */
+    bool operator != ( const Vec& ) const;
+
+    /**
+     * Compute the length of the vector.
+     */
+    template <Precision P = STARMATH_PRECISION>
+    T length() const;
+
+    /**
+     * Normalize the vector.
+     * @return The vector length
+     */
+    template <Precision P = STARMATH_PRECISION>
+    T normalize();
+
+    /**
+     * Dot product.
+     */
+    template <Precision P = STARMATH_PRECISION>
+    T dot( const Vec& a ) const;
+
+    /**
+     * Check for null vector.
+     */
+    bool isNull() const;
+
+    /**
+     * Clamp each component between the ones of a and b.
+     */
+    Vec clamp( const Vec& a, const Vec& b ) const;
+
+    /**
+     * Return the product of the components, e.g. x*y*z.
+     */
+    T getSize() const;
+
+    /**
+     * Cross product, only for 3D vectors.
+     */
+    template <Precision P = STARMATH_PRECISION, size_t M = N>
+    Vec cross( const Vec& a ) const;
+
+    /**
+     * Convert HSV color into RGB color, only for 4D vectors.
+     * @return RGBA color in [0,1] from h in [0,360] and s,v in [0,1], alpha
+     * is not changed
+     */
+    template <size_t M = N>
+    Vec HsvToRgb() const;
+
+    /**
+     * Convert RGB color to HSV, only for 4D vectors.
+     * @return HSV color with h in [0,360] and s,v in [0,1] from RGBA in
+     * [0,1], alpha is not changed
+     */
+    template <size_t M = N>
+    Vec RgbToHsv() const;
+
+  private:
+    /**
+     * Equality of two components.
+     */
+    static bool isEqual( T a, T b );
+  };
+
+/*****************************************************************************/
+  template <size_t N, typename T>
+  template <typename T2>
+  inline Vec<N, T>::Vec( const Vec<N, T2>& a )
+  {
+    T* p = this->ptr();
+    const T2* q = a.constPtr();
+    Unroll<N>::apply([=](size_t i) { p[i] = T(q[i]); });
+  }
+
+/*****************************************************************************/
+  template <size_t N, typename T>
+  inline Vec<N, T>::Vec( const T *q )
+  {
+    T* p = this->ptr();
+    Unroll<N>::apply([=](size_t i) { p[i] = q[i]; });
+  }
+
+/*****************************************************************************/
+  template <size_t N, typename T>
+  template <typename... Ts>
+  inline Vec<N, T>::Vec( T x, T y, Ts... others )
+  {
+    static_assert(sizeof...(Ts)+2 == N, "Vec needs one value per component");
+    const T values[N] = { x, y, T(others)... };
+    *this = Vec(values);
+  }
+
+/*****************************************************************************/
+  template <size_t N, typename T>
+  inline Vec<N, T>::Vec( const Vec<N-1, T>& v, T last )
+  {
+    T* p = this->ptr();
+    const T* q = v.constPtr();
+    Unroll<N-1>::apply([=](size_t i) { p[i] = q[i]; });
+    p[N-1] = last;
+  }
+
+/*****************************************************************************/
+  template <size_t N, typename T>
+  inline Vec<N, T>::operator T* ()
+  {
+    return this->ptr();
+  }
+
+/*****************************************************************************/
+  template <size_t N, typename T>
+  inline Vec<N, T>::operator const T* () const
+  {
+    return this->constPtr();
+  }
+
+/*****************************************************************************/
+  template <size_t N, typename T>
+  inline Vec<N, T>&
+  Vec<N, T>::operator += ( const Vec& v )
+  {
+    T* p = this->ptr();
+    const T* q = v.constPtr();
+    Unroll<N>::apply([=](size_t i) { p[i] += q[i]; });
+
+    return *this;
+  }
+
+/*****************************************************************************/
+  template <size_t N, typename T>
+  inline Vec<N, T>&
+  Vec<N, T>::operator -= ( const Vec& v )
+  {
+    T* p = this->ptr();
+    const T* q = v.constPtr();
+    Unroll<N>::apply([=](size_t i) { p[i] -= q[i]; });
+
+    return *this;
+  }
+
+/*****************************************************************************/
+  template <size_t N, typename T>
+  inline Vec<N, T>&
+  Vec<N, T>::operator *= ( T k )
+  {
+    T* p = this->ptr();
+    Unroll<N>::apply([=](size_t i) { p[i] *= k; });
+
+    return *this;
+  }
+
+/*****************************************************************************/
+  template <size_t N, typename T>
+  inline Vec<N, T>&
+  Vec<N, T>::operator /= ( T k )
+  {
+    T* p = this->ptr();
+    Unroll<N>::apply([=](size_t i) { p[i] /= k; });
+
+    return *this;
+  }
+
+/*****************************************************************************/
+  template <size_t N, typename T>
+  inline Vec<N, T>
+  Vec<N, T>::operator + () const
+  {
+    return *this;
+  }
+
+/*****************************************************************************/
+  template <size_t N, typename T>
+  inline Vec<N, T>
+  Vec<N, T>::operator - () const
+  {
+    Vec res;
+    T* r = res.ptr();
+    const T* p = this->constPtr();
+    Unroll<N>::apply([=](size_t i) { r[i] = -p[i]; });
+
+    return res;
+  }
+
+/*****************************************************************************/
+  template <size_t N, typename T>
+  inline Vec<N, T>
+  Vec<N, T>::operator + ( const Vec& v ) const
+  {
+    Vec res;
+    T* r = res.ptr();
+    const T* p = this->constPtr();
+    const T* q = v.constPtr();
+    Unroll<N>::apply([=](size_t i) { r[i] = p[i]+q[i]; });
+
+    return res;
+  }
+
+/*****************************************************************************/
+  template <size_t N, typename T>
+  inline Vec<N, T>
+  Vec<N, T>::operator - ( const Vec& v ) const
+  {
+    Vec res;
+    T* r = res.ptr();
+    const T* p = this->constPtr();
+    const T* q = v.constPtr();
+    Unroll<N>::apply([=](size_t i) { r[i] = p[i]-q[i]; });
+
+    return res;
+  }
+
+/*****************************************************************************/
+  template <size_t N, typename T>
+  inline Vec<N, T>
+  Vec<N, T>::operator * ( T k ) const
+  {
+    Vec res;
+    T* r = res.ptr();
+    const T* p = this->constPtr();
+    Unroll<N>::apply([=](size_t i) { r[i] = p[i]*k; });
+
+    return res;
+  }
+
+/*****************************************************************************/
+  template <size_t N, typename T>
+  inline Vec<N, T>
+  Vec<N, T>::operator / ( T k ) const
+  {
+    Vec res;
+    T* r = res.ptr();
+    const T* p = this->constPtr();
+    Unroll<N>::apply([=](size_t i) { r[i] = p[i]/k; });
+
+    return res;
+  }
+
+/*****************************************************************************/
+  template <size_t N, typename T>
+  inline Vec<N, T>
+  Vec<N, T>::operator * ( const Vec& v ) const
+  {
+    Vec res;
+    T* r = res.ptr();
+    const T* p = this->constPtr();
+    const T* q = v.constPtr();
+    Unroll<N>::apply([=](size_t i) { r[i] = p[i]*q[i]; });
+
+    return res;
+  }
+
+/*****************************************************************************/
+  template <size_t N, typename T>
+  inline Vec<N, T>
+  Vec<N, T>::operator / ( const Vec& v ) const
+  {
+    Vec res;
+    T* r = res.ptr();
+    const T* p = this->constPtr();
+    const T* q = v.constPtr();
+    Unroll<N>::apply([=](size_t i) { r[i] = p[i]/q[i]; });
+
+    return res;
+  }
+
+/*****************************************************************************/
+  template <size_t N, typename T>
+  inline bool
+  Vec<N, T>::isEqual( T a, T b )
+  {
+    //Without std::abs, ambiguous for the unsigned types
+    return (a > b ? a-b : b-a) <= std::numeric_limits<T>::epsilon();
+  }
+
+/*****************************************************************************/
+  template <size_t N, typename T>
+  inline bool
+  Vec<N, T>::operator == ( const Vec& v ) const
+  {
+    bool res = true;
+    const T* p = this->constPtr();
+    const T* q = v.constPtr();
+    Unroll<N>::apply([&](size_t i) { res = res && isEqual(p[i], q[i]); });
+
+    return res;
+  }
+
+/*****************************************************************************/
+  template <size_t N, typename T>
+  inline bool
+  Vec<N, T>::operator != ( const Vec& v ) const
+  {
+    return !(*this == v);
+  }
+
+/*****************************************************************************/
+  template <size_t N, typename T>
+  template <Precision P>
+  inline T
+  Vec<N, T>::length() const
+  {
+    return std::sqrt(dot<P>(*this));
+  }
+
+/*****************************************************************************/
+  template <size_t N, typename T>
+  template <Precision P>
+  inline T
+  Vec<N, T>::normalize()
+  {
+    STAR_INSTRUMENT(VEC_NORMALIZE);
+    const T len2 = dot<P>(*this);
+    const T invLen = reciprocalSqrt<P>(len2);
+    *this *= invLen;
+
+    return P == PRECISION_FAST ? len2*invLen : T(std::sqrt(len2));
+  }
+
+/*****************************************************************************/
+  template <size_t N, typename T>
+  template <Precision P>
+  inline T
+  Vec<N, T>::dot( const Vec& a ) const
+  {
+    const T* p = this->constPtr();
+    const T* q = a.constPtr();
+    T res = p[0]*q[0];
+    Unroll<N-1>::apply([&](size_t i) { res = madd<P, T>(p[i+1], q[i+1], res); });
+
+    return res;
+  }
+
+/*****************************************************************************/
+  template <size_t N, typename T>
+  inline bool
+  Vec<N, T>::isNull() const
+  {
+    bool res = true;
+    const T* p = this->constPtr();
+    Unroll<N>::apply([&](size_t i) { res = res && isEqual(p[i], T(0)); });
+
+    return res;
+  }
+
+/*****************************************************************************/
+  template <size_t N, typename T>
+  inline Vec<N, T>
+  Vec<N, T>::clamp( const Vec& a, const Vec& b ) const
+  {
+    Vec res;
+    T* r = res.ptr();
+    const T* p = this->constPtr();
+    const T* lo = a.constPtr();
+    const T* hi = b.constPtr();
+    Unroll<N>::apply([=](size_t i) { r[i] = Star::clamp(p[i], lo[i], hi[i]); });
+
+    return res;
+  }
+
+/*****************************************************************************/
+  template <size_t N, typename T>
+  inline T
+  Vec<N, T>::getSize() const
+  {
+    const T* p = this->constPtr();
+    T res = p[0];
+    Unroll<N-1>::apply([&](size_t i) { res *= p[i+1]; });
+
+    return res;
+  }
+
+/*****************************************************************************/
+  template <size_t N, typename T>
+  template <Precision P, size_t M>
+  inline Vec<N, T>
+  Vec<N, T>::cross( const Vec& a ) const
+  {
+    static_assert(M == 3, "The cross product is only defined for 3D vectors");
+    Vec res;
+    res.x = productDifference<P, T>(this->y, a.z, this->z, a.y);
+    res.y = productDifference<P, T>(this->z, a.x, this->x, a.z);
+    res.z = productDifference<P, T>(this->x, a.y, this->y, a.x);
+
+    return res;
+  }
+
+/*****************************************************************************/
+  template <size_t N, typename T>
+  template <size_t M>
+  inline Vec<N, T>
+  Vec<N, T>::HsvToRgb() const
+  {
+    static_assert(M == 4, "HSV colors are 4D vectors");
+    int hi = (int)(this->x / 60.0f);
+    float f = this->x / 60.0f - hi;
+    float p = this->z * (1.0f - this->y);
+    float q = this->z * (1.0f - f * this->y);
+    float t = this->z * (1.0f - (1.0f - f) * this->y);
+
+    Vec res;
+    res.w = this->w;
+    switch (hi % 6)
+    {
+    case 0:
+      res.x = this->z; res.y = t; res.z = p;
+      break;
+    case 1:
+      res.x = q; res.y = this->z; res.z = p;
+      break;
+    case 2:
+      res.x = p; res.y = this->z; res.z = t;
+      break;
+    case 3:
+      res.x = p; res.y = q; res.z = this->z;
+      break;
+    case 4:
+      res.x = t; res.y = p; res.z = this->z;
+      break;
+    case 5:
+      res.x = this->z; res.y = p; res.z = q;
+      break;
+    default:
+      assert(0);
+      res.x = res.y = res.z = res.w = 0;
+    }
+
+    return res;
+  }
+
+/*****************************************************************************/
+  template <size_t N, typename T>
+  template <size_t M>
+  inline Vec<N, T>
+  Vec<N, T>::RgbToHsv() const
+  {
+    static_assert(M == 4, "HSV colors are 4D vectors");
+    float max = std::max(std::max(this->x, this->y), this->z);
+    float min = std::min(std::min(this->x, this->y), this->z);
+    float dist = max - min;
+
+    Vec hsv;
+    hsv.x = 0;
+    hsv.y = 0;
+    hsv.z = max;
+    hsv.w = this->w;
+    if (dist == 0)
+      return hsv;
+
+    hsv.y = (max < std::numeric_limits<float>::epsilon()) ? 0 : 1 - min / max;
+    if (max == this->x)
+      hsv.x = (int)(60.0f * (this->y - this->z) / dist) % 360;
+    else if (max == this->y)
+      hsv.x = 120.0f + (60.0f * (this->z - this->x) / dist);
+    else if (max == this->z)
+      hsv.x = 240.0f + (60.0f * (this->x - this->y) / dist);
+
+    if (hsv.x < 0)
+      hsv.x += 360.0f;
+
+    return hsv;
+  }
+
+/*****************************************************************************/
+  /**
+   * ostream operator for vectors, defined in StarStream.h
+   */
+  template <size_t N, typename T>
+  std::ostream&
+  operator << (std::ostream& os, const Vec<N, T>& v);
+
+/*****************************************************************************/
+#ifndef STARMATH_NO_EXTERN_TEMPLATES
+  //Instantiated once in the StarMath library, see StarMath.cpp
+  //Members are defined inline: GCC doesn't inline extern template members otherwise
+  extern template class Vec<2, float>;
+  extern template class Vec<2, double>;
+  extern template class Vec<2, int>;
+  extern template class Vec<3, float>;
+  extern template class Vec<3, double>;
+  extern template class Vec<3, int>;
+  extern template class Vec<4, float>;
+  extern template class Vec<4, double>;
+  extern template class Vec<4, int>;
+#endif
+}
+
+#endif
@@ -0,0 +1,232 @@
+#include <StarMath/StarKernels.h>
+
+#include "StarKernelsImpl.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(STARMATH_KERNELS_X86) && defined(_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+namespace Star
+{
+  namespace Kernels
+  {
+    namespace
+    {
+      /*****************************************************************************/
+      bool
+      cpuSupports(Isa isa)
+      {
+#ifdef STARMATH_KERNELS_X86
+#ifdef _MSC_VER
+        int regs[4];
+        __cpuid(regs, 0);
+        if(regs[0] < 7)
+          return isa == ISA_GENERIC;
+        __cpuid(regs, 1);
+        const bool fma = (regs[2] & (1 << 12)) != 0;
+        const bool osxsave = (regs[2] & (1 << 27)) != 0;
+        if(!osxsave)
+          return isa == ISA_GENERIC;
+        //YMM state, then opmask and ZMM state saved by the OS
+        const unsigned long long xcr0 = _xgetbv(0);
+        const bool ymm = (xcr0 & 0x6) == 0x6;
+        const bool zmm = (xcr0 & 0xe6) == 0xe6;
+        __cpuidex(regs, 7, 0);
+        const bool avx2 = (regs[1] & (1 << 5)) != 0;
+        const bool avx512 = (regs[1] & (1 << 16)) && (regs[1] & (1 << 17)) &&
+                            (regs[1] & (1 << 30)) && (regs[1] & (1u << 31));
+        switch(isa) {
+        case ISA_GENERIC: return true;
+        case ISA_AVX2: return ymm && avx2 && fma;
+        case ISA_AVX512: return zmm && avx512 && fma;
+        default: return false;
+        }
+#else
+        __builtin_cpu_init();
+        switch(isa) {
+        case ISA_GENERIC: return true;
+        case ISA_AVX2:
+          return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+        case ISA_AVX512:
+          return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512vl") &&
+                 __builtin_cpu_supports("avx512dq") && __builtin_cpu_supports("avx512bw") &&
+                 __builtin_cpu_supports("fma");
+        default: return false;
+        }
+#endif
+#else
+        return isa == ISA_GENERIC;
+#endif
+      }
+
+      /*****************************************************************************/
+      const KernelTable&
+      getTable(Isa isa)
+      {
+        switch(isa) {
+#ifdef STARMATH_KERNELS_X86
+        case ISA_AVX2: return avx2::getTable();
+        case ISA_AVX512: return avx512::getTable();
+#endif
+        default: return generic::getTable();
+        }
+      }
+
+      /*****************************************************************************/
+      /**
+       * Best supported instruction set, lowered by STARMATH_ISA if set.
+       */
+      Isa
+      detectIsa()
+      {
+        Isa best = ISA_GENERIC;
+        for(int isa = ISA_GENERIC; isa < NUM_ISAS; isa++)
+          if(cpuSupports(Isa(isa)))
+            best = Isa(isa);
+
+        const char* env = std::getenv("STARMATH_ISA");
+        if(env) {
+          for(int isa = ISA_GENERIC; isa < best; isa++)
+            if(std::strcmp(env, getIsaName(Isa(isa))) == 0)
+              best = Isa(isa);
+          if(std::strcmp(env, "sse2") == 0)
+            best = ISA_GENERIC;
+        }
+        return best;
+      }
+
+      struct Dispatch
+      {
+        Dispatch() : isa(detectIsa()), table(&getTable(isa)) {}
+
+        std::atomic<Isa> isa;
+        std::atomic<const KernelTable*> table;
+      };
+
+      /*****************************************************************************/
+      Dispatch&
+      getDispatch()
+      {
+        static Dispatch dispatch;
+        return dispatch;
+      }
+
+      /*****************************************************************************/
+      inline const KernelTable&
+      getTable()
+      {
+        return *getDispatch().table.load(std::memory_order_relaxed);
+      }
+    }
+
+    /*****************************************************************************/
+    Isa
+    getIsa()
+    {
+      return getDispatch().isa.load(std::memory_order_relaxed);
+    }
+
+    /*****************************************************************************/
+    bool
+    isSupported(Isa isa)
+    {
+      return isa >= ISA_GENERIC && isa < NUM_ISAS && cpuSupports(isa);
+    }
+
+    /*****************************************************************************/
+    bool
+    setIsa(Isa isa)
+    {
+      if(!isSupported(isa))
+        return false;
+      Dispatch& dispatch = getDispatch();
+      dispatch.table.store(&getTable(isa), std::memory_order_relaxed);
+      dispatch.isa.store(isa, std::memory_order_relaxed);
+      return true;
+    }
+
+    /*****************************************************************************/
+    const char*
+    getIsaName(Isa isa)
+    {
+      static const char* const names[NUM_ISAS] = {"generic", "avx2", "avx512"};
+      return isa >= ISA_GENERIC && isa < NUM_ISAS ? names[isa] : "unknown";
+    }
+
+    /*****************************************************************************/
+    void
+    quaternionRotate(QuaternionSoA<const float> q, Vec3SoA<const float> in,
+                     Vec3SoA<float> out, size_t n)
+    {
+      const float* const qs[4] = {q.x, q.y, q.z, q.w};
+      const float* const ins[3] = {in.x, in.y, in.z};
+      float* const outs[3] = {out.x, out.y, out.z};
+      getTable().quaternionRotate(qs, ins, outs, n);
+    }
+
+    /*****************************************************************************/
+    void
+    quaternionNlerp(QuaternionSoA<const float> a, QuaternionSoA<const float> b,
+                    const float* t, QuaternionSoA<float> out, size_t n)
+    {
+      const float* const as[4] = {a.x, a.y, a.z, a.w};
+      const float* const bs[4] = {b.x, b.y, b.z, b.w};
+      float* const outs[4] = {out.x, out.y, out.z, out.w};
+      getTable().quaternionNlerp(as, bs, t, outs, n);
+    }
+
+    /*****************************************************************************/
+    void
+    quaternionToRotationMatrix(QuaternionSoA<const float> q, Vec3SoA<const float> t,
+                               float* out, size_t n)
+    {
+      const float* const qs[4] = {q.x, q.y, q.z, q.w};
+      const float* const ts[3] = {t.x, t.y, t.z};
+      getTable().quaternionToRotationMatrix(qs, ts, out, n);
+    }
+
+    /*****************************************************************************/
+    void
+    linearBlendSkin(const float* palette, size_t stride, BoneInfluenceSoA<float> influences,
+                    Vec3SoA<const float> positions, Vec3SoA<const float> normals,
+                    Vec3SoA<float> outPositions, Vec3SoA<float> outNormals, size_t n)
+    {
+      const float* const ps[3] = {positions.x, positions.y, positions.z};
+      const float* const ns[3] = {normals.x, normals.y, normals.z};
+      float* const ops[3] = {outPositions.x, outPositions.y, outPositions.z};
+      float* const ons[3] = {outNormals.x, outNormals.y, outNormals.z};
+      getTable().linearBlendSkin(palette, stride, influences.weights, influences.indices,
+                                 influences.numBones, ps, ns, ops, ons, n);
+    }
+
+    /*****************************************************************************/
+    void
+    dualQuaternionSkin(const DualQuaternion<float>* bones, BoneInfluenceSoA<float> influences,
+                       Vec3SoA<const float> positions, Vec3SoA<const float> normals,
+                       Vec3SoA<float> outPositions, Vec3SoA<float> outNormals, size_t n)
+    {
+      static_assert(sizeof(DualQuaternion<float>) == 8*sizeof(float),
+                    "DualQuaternion<float> must be 8 contiguous floats");
+      const float* const ps[3] = {positions.x, positions.y, positions.z};
+      const float* const ns[3] = {normals.x, normals.y, normals.z};
+      float* const ops[3] = {outPositions.x, outPositions.y, outPositions.z};
+      float* const ons[3] = {outNormals.x, outNormals.y, outNormals.z};
+      getTable().dualQuaternionSkin(&bones[0].real.x, influences.weights, influences.indices,
+                                    influences.numBones, ps, ns, ops, ons, n);
+    }
+
+    /*****************************************************************************/
+    void
+    matrixInverse(const Matrix<float>* in, Matrix<float>* out, float* determinants, bool* singular, size_t n)
+    {
+      //Matrix<float> is 16 contiguous floats
+      getTable().matrixInverse(reinterpret_cast<const float*>(in), reinterpret_cast<float*>(out),
+                               determinants, singular, n);
+    }
+  }
+}
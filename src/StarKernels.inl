@@ -0,0 +1,516 @@
+//Kernel bodies, compiled once per instruction set: the including file
+//defines STAR_KERNEL_NS and its compiler flags select the width of
+//simd::floatv. The kernels process floatv::SIZE elements at a time, the
+//last partial block with masked loads and stores.
+
+#include "StarKernelsImpl.h"
+
+#include <StarMath/StarSimd.h>
+
+#include <cfloat>
+
+#ifndef STAR_KERNEL_NS
+#error "STAR_KERNEL_NS must name the instruction set namespace"
+#endif
+
+namespace Star
+{
+  namespace Kernels
+  {
+    namespace STAR_KERNEL_NS
+    {
+      namespace
+      {
+        typedef simd::floatv floatv;
+        typedef simd::floatm floatm;
+
+        /*****************************************************************************/
+        /**
+         * A block of floatv::SIZE elements.
+         */
+        struct FullBlock
+        {
+          STAR_SIMD_INLINE size_t getSize() const { return floatv::SIZE; }
+          STAR_SIMD_INLINE floatv load(const float* p) const { return floatv::loadu(p); }
+          STAR_SIMD_INLINE void store(float* p, const floatv& v) const { v.storeu(p); }
+
+          STAR_SIMD_INLINE floatv gather(const float* base, const unsigned int* indices,
+                                         unsigned int stride) const
+          {
+            return floatv::gather(base, indices, stride);
+          }
+        };
+
+        /*****************************************************************************/
+        /**
+         * The last block, only its first elements are read and written.
+         */
+        struct PartialBlock
+        {
+          explicit PartialBlock(size_t size) : m_mask(floatm::firstN(size)), m_size(size) {}
+
+          STAR_SIMD_INLINE size_t getSize() const { return m_size; }
+          STAR_SIMD_INLINE floatv load(const float* p) const { return floatv::load(p, m_mask); }
+          STAR_SIMD_INLINE void store(float* p, const floatv& v) const { v.store(p, m_mask); }
+
+          STAR_SIMD_INLINE floatv gather(const float* base, const unsigned int* indices,
+                                         unsigned int stride) const
+          {
+            return floatv::gather(base, indices, stride, m_mask);
+          }
+
+          floatm m_mask;
+          size_t m_size;
+        };
+
+        /*****************************************************************************/
+        /**
+         * Call kernel(block, i) on each block of the n elements, split
+         * across threads above parallelThreshold elements.
+         */
+        template<typename Kernel>
+        inline void
+        forEachBlock(const Kernel& kernel, size_t n, size_t parallelThreshold)
+        {
+          const long width = long(floatv::SIZE);
+          const long numFull = long(n/floatv::SIZE*floatv::SIZE);
+#pragma omp parallel for schedule(static) if(n > parallelThreshold)
+          for(long i = 0; i < numFull; i += width)
+            kernel(FullBlock(), size_t(i));
+          if(size_t(numFull) < n)
+            kernel(PartialBlock(n-size_t(numFull)), size_t(numFull));
+        }
+
+        /*****************************************************************************/
+        struct QuaternionRotate
+        {
+          const float* q[4];
+          const float* in[3];
+          float* out[3];
+
+          template<typename Block>
+          STAR_SIMD_INLINE void operator () (const Block& block, size_t i) const
+          {
+            floatv qx = block.load(q[0]+i), qy = block.load(q[1]+i);
+            floatv qz = block.load(q[2]+i), qw = block.load(q[3]+i);
+            floatv vx = block.load(in[0]+i), vy = block.load(in[1]+i), vz = block.load(in[2]+i);
+            floatv tx = floatv(2.f)*(qy*vz-qz*vy);
+            floatv ty = floatv(2.f)*(qz*vx-qx*vz);
+            floatv tz = floatv(2.f)*(qx*vy-qy*vx);
+            block.store(out[0]+i, vx+qw*tx+(qy*tz-qz*ty));
+            block.store(out[1]+i, vy+qw*ty+(qz*tx-qx*tz));
+            block.store(out[2]+i, vz+qw*tz+(qx*ty-qy*tx));
+          }
+        };
+
+        /*****************************************************************************/
+        void
+        quaternionRotate(const float* const q[4], const float* const in[3], float* const out[3], size_t n)
+        {
+          const QuaternionRotate kernel = { { q[0], q[1], q[2], q[3] }, { in[0], in[1], in[2] },
+                                            { out[0], out[1], out[2] } };
+          forEachBlock(kernel, n, 65536);
+        }
+
+        /*****************************************************************************/
+        struct QuaternionNlerp
+        {
+          const float* a[4];
+          const float* b[4];
+          const float* t;
+          float* out[4];
+
+          template<typename Block>
+          STAR_SIMD_INLINE void operator () (const Block& block, size_t i) const
+          {
+            floatv ax = block.load(a[0]+i), ay = block.load(a[1]+i);
+            floatv az = block.load(a[2]+i), aw = block.load(a[3]+i);
+            floatv bx = block.load(b[0]+i), by = block.load(b[1]+i);
+            floatv bz = block.load(b[2]+i), bw = block.load(b[3]+i);
+            floatv ti = block.load(t+i);
+            floatv d = ax*bx+ay*by+az*bz+aw*bw;
+            floatv wa = floatv(1.f)-ti;
+            floatv wb = simd::select(d < floatv::zero(), -ti, ti);
+            floatv x = wa*ax+wb*bx;
+            floatv y = wa*ay+wb*by;
+            floatv z = wa*az+wb*bz;
+            floatv w = wa*aw+wb*bw;
+            floatv invLen = floatv(1.f)/simd::sqrt(x*x+y*y+z*z+w*w);
+            block.store(out[0]+i, x*invLen);
+            block.store(out[1]+i, y*invLen);
+            block.store(out[2]+i, z*invLen);
+            block.store(out[3]+i, w*invLen);
+          }
+        };
+
+        /*****************************************************************************/
+        void
+        quaternionNlerp(const float* const a[4], const float* const b[4], const float* t,
+                        float* const out[4], size_t n)
+        {
+          const QuaternionNlerp kernel = { { a[0], a[1], a[2], a[3] }, { b[0], b[1], b[2], b[3] }, t,
+                                           { out[0], out[1], out[2], out[3] } };
+          forEachBlock(kernel, n, 65536);
+        }
+
+        /*****************************************************************************/
+        struct QuaternionToRotationMatrix
+        {
+          const float* q[4];
+          const float* t[3];
+          float* out;
+
+          template<typename Block>
+          STAR_SIMD_INLINE void operator () (const Block& block, size_t i) const
+          {
+            floatv x = block.load(q[0]+i), y = block.load(q[1]+i);
+            floatv z = block.load(q[2]+i), w = block.load(q[3]+i);
+            floatv x2 = x*x, y2 = y*y, z2 = z*z;
+            floatv xy = x*y, xz = x*z, yz = y*z;
+            floatv wx = w*x, wy = w*y, wz = w*z;
+            const floatv one(1.f), two(2.f);
+
+            //Computed as structure of arrays, written as arrays of 3x4
+            float rows[12][floatv::SIZE];
+            (one-two*(y2+z2)).storeu(rows[0]);
+            (two*(xy-wz)).storeu(rows[1]);
+            (two*(xz+wy)).storeu(rows[2]);
+            (two*(xy+wz)).storeu(rows[4]);
+            (one-two*(x2+z2)).storeu(rows[5]);
+            (two*(yz-wx)).storeu(rows[6]);
+            (two*(xz-wy)).storeu(rows[8]);
+            (two*(yz+wx)).storeu(rows[9]);
+            (one-two*(x2+y2)).storeu(rows[10]);
+            (t[0] ? block.load(t[0]+i) : floatv::zero()).storeu(rows[3]);
+            (t[0] ? block.load(t[1]+i) : floatv::zero()).storeu(rows[7]);
+            (t[0] ? block.load(t[2]+i) : floatv::zero()).storeu(rows[11]);
+
+            float* m = out+12*i;
+            for(size_t j = 0; j < block.getSize(); j++, m += 12)
+              for(size_t k = 0; k < 12; k++)
+                m[k] = rows[k][j];
+          }
+        };
+
+        /*****************************************************************************/
+        void
+        quaternionToRotationMatrix(const float* const q[4], const float* const t[3], float* out, size_t n)
+        {
+          const QuaternionToRotationMatrix kernel = { { q[0], q[1], q[2], q[3] }, { t[0], t[1], t[2] }, out };
+          forEachBlock(kernel, n, 65536);
+        }
+
+        /*****************************************************************************/
+        /**
+         * Skins floatv::SIZE vertices at a time, gathering each coefficient
+         * of their bones.
+         */
+        struct LinearBlendSkin
+        {
+          const float* palette;
+          unsigned int stride;
+          const float* weights[4];
+          const unsigned int* indices[4];
+          unsigned int numBones;
+          const float* positions[3];
+          const float* normals[3];
+          float* outPositions[3];
+          float* outNormals[3];
+
+          template<typename Block>
+          STAR_SIMD_INLINE void operator () (const Block& block, size_t i) const
+          {
+            floatv m[12];
+            floatv w = block.load(weights[0]+i);
+            for(unsigned int k = 0; k < 12; k++)
+              m[k] = w*block.gather(palette+k, indices[0]+i, stride);
+            for(unsigned int b = 1; b < numBones; b++) {
+              w = block.load(weights[b]+i);
+              for(unsigned int k = 0; k < 12; k++)
+                m[k] += w*block.gather(palette+k, indices[b]+i, stride);
+            }
+
+            floatv px = block.load(positions[0]+i), py = block.load(positions[1]+i);
+            floatv pz = block.load(positions[2]+i);
+            block.store(outPositions[0]+i, m[0]*px+m[1]*py+m[2]*pz+m[3]);
+            block.store(outPositions[1]+i, m[4]*px+m[5]*py+m[6]*pz+m[7]);
+            block.store(outPositions[2]+i, m[8]*px+m[9]*py+m[10]*pz+m[11]);
+
+            if(normals[0]) {
+              floatv nx = block.load(normals[0]+i), ny = block.load(normals[1]+i);
+              floatv nz = block.load(normals[2]+i);
+              floatv rx = m[0]*nx+m[1]*ny+m[2]*nz;
+              floatv ry = m[4]*nx+m[5]*ny+m[6]*nz;
+              floatv rz = m[8]*nx+m[9]*ny+m[10]*nz;
+              floatv invLen = floatv(1.f)/simd::sqrt(rx*rx+ry*ry+rz*rz);
+              block.store(outNormals[0]+i, rx*invLen);
+              block.store(outNormals[1]+i, ry*invLen);
+              block.store(outNormals[2]+i, rz*invLen);
+            }
+          }
+        };
+
+        /*****************************************************************************/
+        void
+        linearBlendSkin(const float* palette, size_t stride, const float* const weights[4],
+                        const unsigned int* const indices[4], unsigned int numBones,
+                        const float* const positions[3], const float* const normals[3],
+                        float* const outPositions[3], float* const outNormals[3], size_t n)
+        {
+          const LinearBlendSkin kernel = {
+            palette, (unsigned int)stride,
+            { weights[0], weights[1], weights[2], weights[3] },
+            { indices[0], indices[1], indices[2], indices[3] },
+            numBones,
+            { positions[0], positions[1], positions[2] },
+            { normals[0], normals[1], normals[2] },
+            { outPositions[0], outPositions[1], outPositions[2] },
+            { outNormals[0], outNormals[1], outNormals[2] }
+          };
+          forEachBlock(kernel, n, 16384);
+        }
+
+        /*****************************************************************************/
+        /**
+         * Skins floatv::SIZE vertices at a time, gathering each coefficient
+         * of their bone dual quaternions, real x, y, z, w then dual x, y, z,
+         * w.
+         */
+        struct DualQuaternionSkin
+        {
+          const float* bones;
+          const float* weights[4];
+          const unsigned int* indices[4];
+          unsigned int numBones;
+          const float* positions[3];
+          const float* normals[3];
+          float* outPositions[3];
+          float* outNormals[3];
+
+          template<typename Block>
+          STAR_SIMD_INLINE void operator () (const Block& block, size_t i) const
+          {
+            floatv first[8], dq[8];
+            floatv w = block.load(weights[0]+i);
+            for(unsigned int k = 0; k < 8; k++) {
+              first[k] = block.gather(bones+k, indices[0]+i, 8);
+              dq[k] = w*first[k];
+            }
+            for(unsigned int b = 1; b < numBones; b++) {
+              floatv bone[8];
+              for(unsigned int k = 0; k < 8; k++)
+                bone[k] = block.gather(bones+k, indices[b]+i, 8);
+              floatv d = bone[0]*first[0]+bone[1]*first[1]+bone[2]*first[2]+bone[3]*first[3];
+              w = block.load(weights[b]+i);
+              w = simd::select(d < floatv::zero(), -w, w);
+              for(unsigned int k = 0; k < 8; k++)
+                dq[k] += w*bone[k];
+            }
+
+            floatv invLen = floatv(1.f)/simd::sqrt(dq[0]*dq[0]+dq[1]*dq[1]+dq[2]*dq[2]+dq[3]*dq[3]);
+            floatv rx = dq[0]*invLen, ry = dq[1]*invLen, rz = dq[2]*invLen, rw = dq[3]*invLen;
+            floatv dx = dq[4]*invLen, dy = dq[5]*invLen, dz = dq[6]*invLen, dw = dq[7]*invLen;
+            const floatv two(2.f);
+            floatv tx = two*(dx*rw-rx*dw+ry*dz-rz*dy);
+            floatv ty = two*(dy*rw-ry*dw+rz*dx-rx*dz);
+            floatv tz = two*(dz*rw-rz*dw+rx*dy-ry*dx);
+
+            floatv px = block.load(positions[0]+i), py = block.load(positions[1]+i);
+            floatv pz = block.load(positions[2]+i);
+            floatv cx = two*(ry*pz-rz*py), cy = two*(rz*px-rx*pz), cz = two*(rx*py-ry*px);
+            block.store(outPositions[0]+i, px+rw*cx+(ry*cz-rz*cy)+tx);
+            block.store(outPositions[1]+i, py+rw*cy+(rz*cx-rx*cz)+ty);
+            block.store(outPositions[2]+i, pz+rw*cz+(rx*cy-ry*cx)+tz);
+
+            if(normals[0]) {
+              floatv nx = block.load(normals[0]+i), ny = block.load(normals[1]+i);
+              floatv nz = block.load(normals[2]+i);
+              cx = two*(ry*nz-rz*ny);
+              cy = two*(rz*nx-rx*nz);
+              cz = two*(rx*ny-ry*nx);
+              block.store(outNormals[0]+i, nx+rw*cx+(ry*cz-rz*cy));
+              block.store(outNormals[1]+i, ny+rw*cy+(rz*cx-rx*cz));
+              block.store(outNormals[2]+i, nz+rw*cz+(rx*cy-ry*cx));
+            }
+          }
+        };
+
+        /*****************************************************************************/
+        void
+        dualQuaternionSkin(const float* bones, const float* const weights[4],
+                           const unsigned int* const indices[4], unsigned int numBones,
+                           const float* const positions[3], const float* const normals[3],
+                           float* const outPositions[3], float* const outNormals[3], size_t n)
+        {
+          const DualQuaternionSkin kernel = {
+            bones,
+            { weights[0], weights[1], weights[2], weights[3] },
+            { indices[0], indices[1], indices[2], indices[3] },
+            numBones,
+            { positions[0], positions[1], positions[2] },
+            { normals[0], normals[1], normals[2] },
+            { outPositions[0], outPositions[1], outPositions[2] },
+            { outNormals[0], outNormals[1], outNormals[2] }
+          };
+          forEachBlock(kernel, n, 16384);
+        }
+
+        /*****************************************************************************/
+        /**
+         * Transpose count 4x4 matrices into structure of arrays: rows[k][j]
+         * receives value k of matrix j, zero past count. Groups of 4
+         * matrices are transposed in registers, 4x4 blocks at a time.
+         */
+        STAR_SIMD_INLINE void
+        loadMatrices(const float* m, size_t count, float rows[16][floatv::SIZE])
+        {
+          typedef simd::pack<float, 4> float4v;
+          size_t j = 0;
+          for(; j+4 <= count; j += 4, m += 64)
+            for(size_t k = 0; k < 16; k += 4) {
+              float4v a = float4v::loadu(m+k), b = float4v::loadu(m+16+k);
+              float4v c = float4v::loadu(m+32+k), d = float4v::loadu(m+48+k);
+              simd::transpose4(a, b, c, d);
+              a.storeu(rows[k]+j);
+              b.storeu(rows[k+1]+j);
+              c.storeu(rows[k+2]+j);
+              d.storeu(rows[k+3]+j);
+            }
+          for(; j < count; j++, m += 16)
+            for(size_t k = 0; k < 16; k++)
+              rows[k][j] = m[k];
+          for(; j < floatv::SIZE; j++)
+            for(size_t k = 0; k < 16; k++)
+              rows[k][j] = 0.f;
+        }
+
+        /*****************************************************************************/
+        /**
+         * The reverse of loadMatrices, write the first count matrices.
+         */
+        STAR_SIMD_INLINE void
+        storeMatrices(const float rows[16][floatv::SIZE], size_t count, float* m)
+        {
+          typedef simd::pack<float, 4> float4v;
+          size_t j = 0;
+          for(; j+4 <= count; j += 4, m += 64)
+            for(size_t k = 0; k < 16; k += 4) {
+              float4v a = float4v::loadu(rows[k]+j), b = float4v::loadu(rows[k+1]+j);
+              float4v c = float4v::loadu(rows[k+2]+j), d = float4v::loadu(rows[k+3]+j);
+              simd::transpose4(a, b, c, d);
+              a.storeu(m+k);
+              b.storeu(m+16+k);
+              c.storeu(m+32+k);
+              d.storeu(m+48+k);
+            }
+          for(; j < count; j++, m += 16)
+            for(size_t k = 0; k < 16; k++)
+              m[k] = rows[k][j];
+        }
+
+        /*****************************************************************************/
+        /**
+         * Inverts floatv::SIZE matrices at a time, transposed to structure
+         * of arrays through the stack.
+         */
+        struct MatrixInverse
+        {
+          const float* in;
+          float* out;
+          float* determinants;
+          bool* singular;
+
+          template<typename Block>
+          STAR_SIMD_INLINE void operator () (const Block& block, size_t i) const
+          {
+            //The unused lanes of a partial block are zero, so singular
+            float rows[16][floatv::SIZE];
+            loadMatrices(in+16*i, block.getSize(), rows);
+            floatv a[16];
+            for(size_t k = 0; k < 16; k++)
+              a[k] = floatv::loadu(rows[k]);
+
+            //Same computation as Star::matrixAdjugate
+            floatv s0 = a[0]*a[5]-a[4]*a[1];
+            floatv s1 = a[0]*a[6]-a[4]*a[2];
+            floatv s2 = a[0]*a[7]-a[4]*a[3];
+            floatv s3 = a[1]*a[6]-a[5]*a[2];
+            floatv s4 = a[1]*a[7]-a[5]*a[3];
+            floatv s5 = a[2]*a[7]-a[6]*a[3];
+            floatv c5 = a[10]*a[15]-a[14]*a[11];
+            floatv c4 = a[9]*a[15]-a[13]*a[11];
+            floatv c3 = a[9]*a[14]-a[13]*a[10];
+            floatv c2 = a[8]*a[15]-a[12]*a[11];
+            floatv c1 = a[8]*a[14]-a[12]*a[10];
+            floatv c0 = a[8]*a[13]-a[12]*a[9];
+            floatv det = s0*c5-s1*c4+s2*c3+s3*c2-s4*c1+s5*c0;
+
+            //Same tests as Star::matrixInverse: the determinant, NaN compares
+            //false, then the coefficients, x*0 is NaN if x isn't finite.
+            //FLT_MIN and FLT_MAX rather than numeric_limits: at -O0 its
+            //functions are weak symbols compiled with this file's flags
+            floatv absDet = simd::abs(det);
+            floatm invertible = (absDet >= floatv(FLT_MIN)) & (floatv(FLT_MAX) >= absDet);
+            floatv invDet = simd::select(invertible, floatv(1.f)/det, floatv::zero());
+            floatv inv[16];
+            inv[0] = (a[5]*c5-a[6]*c4+a[7]*c3)*invDet;
+            inv[1] = (a[2]*c4-a[1]*c5-a[3]*c3)*invDet;
+            inv[2] = (a[13]*s5-a[14]*s4+a[15]*s3)*invDet;
+            inv[3] = (a[10]*s4-a[9]*s5-a[11]*s3)*invDet;
+            inv[4] = (a[6]*c2-a[4]*c5-a[7]*c1)*invDet;
+            inv[5] = (a[0]*c5-a[2]*c2+a[3]*c1)*invDet;
+            inv[6] = (a[14]*s2-a[12]*s5-a[15]*s1)*invDet;
+            inv[7] = (a[8]*s5-a[10]*s2+a[11]*s1)*invDet;
+            inv[8] = (a[4]*c4-a[5]*c2+a[7]*c0)*invDet;
+            inv[9] = (a[1]*c2-a[0]*c4-a[3]*c0)*invDet;
+            inv[10] = (a[12]*s4-a[13]*s2+a[15]*s0)*invDet;
+            inv[11] = (a[9]*s2-a[8]*s4-a[11]*s0)*invDet;
+            inv[12] = (a[5]*c1-a[4]*c3-a[6]*c0)*invDet;
+            inv[13] = (a[0]*c3-a[1]*c1+a[2]*c0)*invDet;
+            inv[14] = (a[13]*s1-a[12]*s3-a[14]*s0)*invDet;
+            inv[15] = (a[8]*s3-a[9]*s1+a[10]*s0)*invDet;
+            const floatv zero = floatv::zero();
+            floatv z[8];
+            for(size_t k = 0; k < 8; k++)
+              z[k] = inv[k]*zero+inv[k+8]*zero;
+            invertible = invertible & (((z[0]+z[4])+(z[2]+z[6]))+((z[1]+z[5])+(z[3]+z[7])) == zero);
+            for(size_t k = 0; k < 16; k++)
+              simd::select(invertible, inv[k], zero).storeu(rows[k]);
+
+            storeMatrices(rows, block.getSize(), out+16*i);
+            if(determinants)
+              block.store(determinants+i, det);
+            if(singular) {
+              const unsigned int bits = invertible.getBits();
+              for(size_t j = 0; j < block.getSize(); j++)
+                singular[i+j] = ((bits >> j) & 1) == 0;
+            }
+          }
+        };
+
+        /*****************************************************************************/
+        void
+        matrixInverse(const float* in, float* out, float* determinants, bool* singular, size_t n)
+        {
+          const MatrixInverse kernel = { in, out, determinants, singular };
+          forEachBlock(kernel, n, 16384);
+        }
+      }
+
+      /*****************************************************************************/
+      const KernelTable&
+      getTable()
+      {
+        static const KernelTable table = {
+          quaternionRotate,
+          quaternionNlerp,
+          quaternionToRotationMatrix,
+          linearBlendSkin,
+          dualQuaternionSkin,
+          matrixInverse
+        };
+        return table;
+      }
+    }
+  }
+}
@@ -0,0 +1,3 @@
+//Compiled with the AVX2 and FMA flags, see CMakeLists.txt
+#define STAR_KERNEL_NS avx2
+#include "StarKernels.inl"
@@ -0,0 +1,3 @@
+//Compiled with the AVX-512 flags, see CMakeLists.txt
+#define STAR_KERNEL_NS avx512
+#include "StarKernels.inl"
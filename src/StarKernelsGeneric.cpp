@@ -0,0 +1,3 @@
+//Compiled with the baseline flags of the build
+#define STAR_KERNEL_NS generic
+#include "StarKernels.inl"
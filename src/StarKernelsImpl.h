@@ -0,0 +1,44 @@
+#ifndef STAR_KERNELS_IMPL_H
+#define STAR_KERNELS_IMPL_H
+
+#include <cstddef>
+
+namespace Star
+{
+  namespace Kernels
+  {
+    /**
+     * Kernels of one instruction set. The files compiled with wider
+     * instruction sets only include StarSimd.h, which puts its code in a
+     * namespace per instruction set: an inline function of the other
+     * headers compiled there could be the copy the linker keeps for the
+     * whole program.
+     */
+    struct KernelTable
+    {
+      void (*quaternionRotate)(const float* const q[4], const float* const in[3],
+                               float* const out[3], size_t n);
+      void (*quaternionNlerp)(const float* const a[4], const float* const b[4], const float* t,
+                              float* const out[4], size_t n);
+      void (*quaternionToRotationMatrix)(const float* const q[4], const float* const t[3],
+                                         float* out, size_t n);
+      void (*linearBlendSkin)(const float* palette, size_t stride, const float* const weights[4],
+                              const unsigned int* const indices[4], unsigned int numBones,
+                              const float* const positions[3], const float* const normals[3],
+                              float* const outPositions[3], float* const outNormals[3], size_t n);
+      void (*dualQuaternionSkin)(const float* bones, const float* const weights[4],
+                                 const unsigned int* const indices[4], unsigned int numBones,
+                                 const float* const positions[3], const float* const normals[3],
+                                 float* const outPositions[3], float* const outNormals[3], size_t n);
+      void (*matrixInverse)(const float* in, float* out, float* determinants, bool* singular, size_t n);
+    };
+
+    namespace generic { const KernelTable& getTable(); }
+#ifdef STARMATH_KERNELS_X86
+    namespace avx2 { const KernelTable& getTable(); }
+    namespace avx512 { const KernelTable& getTable(); }
+#endif
+  }
+}
+
+#endif
@@ -1 +1,68 @@
 #include <StarMath.h>
+#include <StarMath/StarStream.h>
+
+//The headers declare these instantiations extern, so the code using the
+//common typedefs doesn't compile them again
+
+namespace Star
+{
+  template class Vec<2, float>;
+  template class Vec<2, double>;
+  template class Vec<2, int>;
+
+  template class Vec<3, float>;
+  template class Vec<3, double>;
+  template class Vec<3, int>;
+
+  template class Vec<4, float>;
+  template class Vec<4, double>;
+  template class Vec<4, int>;
+
+  template class Mat<4, 4, float>;
+  template class Mat<4, 4, double>;
+  template class Mat<4, 4, int>;
+
+  template class Mat<2, 2, float>;
+  template class Mat<2, 2, double>;
+  template class Mat<2, 2, int>;
+
+  template Mat<2, 2, float> Mat<2, 2, float>::inverse<PRECISION_STRICT>(float&) const;
+  template Mat<2, 2, double> Mat<2, 2, double>::inverse<PRECISION_STRICT>(double&) const;
+  template Mat<4, 4, float> Mat<4, 4, float>::inverse<PRECISION_STRICT>(float&) const;
+  template Mat<4, 4, double> Mat<4, 4, double>::inverse<PRECISION_STRICT>(double&) const;
+
+  template class Quaternion<float>;
+  template class Quaternion<double>;
+
+  template class Plane<float>;
+  template class Plane<double>;
+  template class Plane<int>;
+
+  template class Box<float>;
+  template class Box<double>;
+  template class Box<int>;
+
+  template std::ostream& operator << (std::ostream&, const Vec2<float>&);
+  template std::ostream& operator << (std::ostream&, const Vec2<double>&);
+  template std::ostream& operator << (std::ostream&, const Vec2<int>&);
+  template std::ostream& operator << (std::ostream&, const Vec3<float>&);
+  template std::ostream& operator << (std::ostream&, const Vec3<double>&);
+  template std::ostream& operator << (std::ostream&, const Vec3<int>&);
+  template std::ostream& operator << (std::ostream&, const Vec4<float>&);
+  template std::ostream& operator << (std::ostream&, const Vec4<double>&);
+  template std::ostream& operator << (std::ostream&, const Vec4<int>&);
+  template std::ostream& operator << (std::ostream&, const Matrix<float>&);
+  template std::ostream& operator << (std::ostream&, const Matrix<double>&);
+  template std::ostream& operator << (std::ostream&, const Matrix<int>&);
+  template std::ostream& operator << (std::ostream&, const Matrix2<float>&);
+  template std::ostream& operator << (std::ostream&, const Matrix2<double>&);
+  template std::ostream& operator << (std::ostream&, const Matrix2<int>&);
+  template std::ostream& operator << (std::ostream&, const Quaternion<float>&);
+  template std::ostream& operator << (std::ostream&, const Quaternion<double>&);
+  template std::ostream& operator << (std::ostream&, const DualQuaternion<float>&);
+  template std::ostream& operator << (std::ostream&, const DualQuaternion<double>&);
+}
+
+template std::ostream& operator << (std::ostream&, const Star::Box<float>&);
+template std::ostream& operator << (std::ostream&, const Star::Box<double>&);
+template std::ostream& operator << (std::ostream&, const Star::Box<int>&);
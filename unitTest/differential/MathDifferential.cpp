@@ -0,0 +1,863 @@
+#include <StarMath.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <vector>
+
+/**
+ * Differential test of the batch kernels against the scalar templates.
+ *
+ * Each case runs a batch kernel and the scalar code it replaces on the
+ * same float inputs, random ones followed by adversarial ones (identical,
+ * opposite and nearly identical quaternions, half turns, huge and tiny
+ * vectors, angles on series boundaries...). Both are compared to the
+ * scalar template instantiated with long double, or an exact formula when
+ * the scalar code approximates. Errors are in float ULPs of the largest
+ * of |reference| and a per-case magnitude, so components that should be 0
+ * are judged at the scale of their vector.
+ *
+ * The Kernels cases run once per supported instruction set, selected with
+ * Kernels::setIsa. When STARMATH_ISA is set, the instruction set picked on
+ * the first call must honor it.
+ *
+ * The case fails when the batch kernel exceeds its ULP budget. The times
+ * are in nanoseconds per element, run with --no-timing to skip them.
+ */
+
+namespace
+{
+  typedef long double ld;
+
+  const size_t NUM_RANDOM = 1 << 15;
+  const size_t NUM_REPS = 5;
+
+  float
+  randf()
+  {
+    return std::rand()/float(RAND_MAX)*2-1;
+  }
+
+  Star::quaternionf
+  randomQuaternion()
+  {
+    Star::quaternionf q;
+    do {
+      q = Star::quaternionf(randf(), randf(), randf(), randf());
+    } while(q.length() < 0.1f);
+    q.normalize();
+    return q;
+  }
+
+  Star::Quaternion<ld>
+  toLd(const Star::quaternionf& q)
+  {
+    return Star::Quaternion<ld>(q.x, q.y, q.z, q.w);
+  }
+
+  /*****************************************************************************/
+  /**
+   * Error of value in ULPs of float at the magnitude of ref, at least
+   * scale.
+   */
+  double
+  ulpError(float value, ld ref, ld scale)
+  {
+    float mag = float(std::max(std::fabs(ref), scale));
+    float ulp = std::nextafter(mag, std::numeric_limits<float>::infinity())-mag;
+    if(!std::isfinite(value))
+      return std::numeric_limits<double>::infinity();
+    return double(std::fabs(ld(value)-ref)/ulp);
+  }
+
+  /*****************************************************************************/
+  struct Stats
+  {
+    Stats() : maxUlp(0), sumUlp(0), count(0) {}
+
+    void add(double ulp)
+    {
+      maxUlp = std::max(maxUlp, ulp);
+      sumUlp += ulp;
+      count++;
+    }
+
+    double mean() const { return count ? sumUlp/count : 0; }
+
+    double maxUlp;
+    double sumUlp;
+    size_t count;
+  };
+
+  /*****************************************************************************/
+  struct Report
+  {
+    Report() : scalarSeconds(0), batchSeconds(0), numElements(0) {}
+
+    //Error of each value of an output tuple, scale is the tuple magnitude
+    void add(const float* scalar, const float* batch, const ld* ref, size_t n, ld scale)
+    {
+      for(size_t k = 0; k < n; k++) {
+        scalarVsRef.add(ulpError(scalar[k], ref[k], scale));
+        batchVsRef.add(ulpError(batch[k], ref[k], scale));
+        batchVsScalar.add(ulpError(batch[k], scalar[k], scale));
+      }
+    }
+
+    Stats scalarVsRef, batchVsRef, batchVsScalar;
+    double scalarSeconds, batchSeconds;
+    //Elements processed by one timed run, the times are reported per element
+    size_t numElements;
+  };
+
+  bool g_timing = true;
+
+  /**
+   * Best time of a few runs, a single untimed run with --no-timing.
+   */
+  template<typename F>
+  double
+  timeBest(F f)
+  {
+    if(!g_timing) {
+      f();
+      return 0;
+    }
+    double best = std::numeric_limits<double>::max();
+    for(size_t r = 0; r < NUM_REPS; r++) {
+      std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+      f();
+      std::chrono::duration<double> elapsed = std::chrono::steady_clock::now()-start;
+      best = std::min(best, elapsed.count());
+    }
+    return best;
+  }
+
+  /*****************************************************************************/
+  /**
+   * Quaternions in SoA, also kept as AoS.
+   */
+  struct QuatArrays
+  {
+    void push(const Star::quaternionf& q)
+    {
+      aos.push_back(q);
+      c[0].push_back(q.x);
+      c[1].push_back(q.y);
+      c[2].push_back(q.z);
+      c[3].push_back(q.w);
+    }
+    void resize(size_t n)
+    {
+      aos.resize(n);
+      for(size_t k = 0; k < 4; k++)
+        c[k].resize(n);
+    }
+    Star::QuaternionSoA<const float> in() const { return Star::QuaternionSoA<const float>(&c[0][0], &c[1][0], &c[2][0], &c[3][0]); }
+    Star::QuaternionSoA<float> out() { return Star::QuaternionSoA<float>(&c[0][0], &c[1][0], &c[2][0], &c[3][0]); }
+    void get(size_t i, float* v) const { for(size_t k = 0; k < 4; k++) v[k] = c[k][i]; }
+
+    std::vector<Star::quaternionf> aos;
+    std::vector<float> c[4];
+  };
+
+  struct Vec3Arrays
+  {
+    void push(const Star::float3& v)
+    {
+      aos.push_back(v);
+      for(size_t k = 0; k < 3; k++)
+        c[k].push_back(v[k]);
+    }
+    void resize(size_t n)
+    {
+      aos.resize(n);
+      for(size_t k = 0; k < 3; k++)
+        c[k].resize(n);
+    }
+    Star::Vec3SoA<const float> in() const { return Star::Vec3SoA<const float>(&c[0][0], &c[1][0], &c[2][0]); }
+    Star::Vec3SoA<float> out() { return Star::Vec3SoA<float>(&c[0][0], &c[1][0], &c[2][0]); }
+    void get(size_t i, float* v) const { for(size_t k = 0; k < 3; k++) v[k] = c[k][i]; }
+
+    std::vector<Star::float3> aos;
+    std::vector<float> c[3];
+  };
+
+  /*****************************************************************************/
+  /**
+   * The batch functions under test: the header templates, or the same
+   * functions of Star::Kernels, run with the instruction set selected by
+   * Kernels::setIsa.
+   */
+  struct TemplateBatch
+  {
+    static void rotate(Star::QuaternionSoA<const float> q, Star::Vec3SoA<const float> v,
+                       Star::Vec3SoA<float> out, size_t n)
+    {
+      Star::quaternionRotate(q, v, out, n);
+    }
+    static void nlerp(Star::QuaternionSoA<const float> a, Star::QuaternionSoA<const float> b,
+                      const float* t, Star::QuaternionSoA<float> out, size_t n)
+    {
+      Star::quaternionNlerp(a, b, t, out, n);
+    }
+    static void toRotationMatrix(Star::QuaternionSoA<const float> q, float* out, size_t n)
+    {
+      Star::quaternionToRotationMatrix(q, Star::Vec3SoA<const float>(), out, n);
+    }
+    static void linearBlendSkin(const Star::float4x4* palette, Star::BoneInfluenceSoA<float> influences,
+                                Star::Vec3SoA<const float> positions, Star::Vec3SoA<float> out, size_t n)
+    {
+      Star::linearBlendSkin(palette, influences, positions, Star::Vec3SoA<const float>(),
+                            out, Star::Vec3SoA<float>(), n);
+    }
+    static void matrixInverse(const Star::float4x4* in, Star::float4x4* out, size_t n)
+    {
+      Star::matrixInverse(in, out, (float*)0, (bool*)0, n);
+    }
+  };
+
+  struct KernelBatch
+  {
+    static void rotate(Star::QuaternionSoA<const float> q, Star::Vec3SoA<const float> v,
+                       Star::Vec3SoA<float> out, size_t n)
+    {
+      Star::Kernels::quaternionRotate(q, v, out, n);
+    }
+    static void nlerp(Star::QuaternionSoA<const float> a, Star::QuaternionSoA<const float> b,
+                      const float* t, Star::QuaternionSoA<float> out, size_t n)
+    {
+      Star::Kernels::quaternionNlerp(a, b, t, out, n);
+    }
+    static void toRotationMatrix(Star::QuaternionSoA<const float> q, float* out, size_t n)
+    {
+      Star::Kernels::quaternionToRotationMatrix(q, Star::Vec3SoA<const float>(), out, n);
+    }
+    static void linearBlendSkin(const Star::float4x4* palette, Star::BoneInfluenceSoA<float> influences,
+                                Star::Vec3SoA<const float> positions, Star::Vec3SoA<float> out, size_t n)
+    {
+      Star::Kernels::linearBlendSkin(palette[0].constPtr(), 16, influences, positions,
+                                     Star::Vec3SoA<const float>(), out, Star::Vec3SoA<float>(), n);
+    }
+    static void matrixInverse(const Star::float4x4* in, Star::float4x4* out, size_t n)
+    {
+      Star::Kernels::matrixInverse(in, out, 0, 0, n);
+    }
+  };
+
+  /*****************************************************************************/
+  /**
+   * Random unit quaternions, then identity, half turns, a dominant
+   * component and nearly axis aligned ones.
+   */
+  void
+  makeQuaternions(QuatArrays& q)
+  {
+    for(size_t i = 0; i < NUM_RANDOM; i++)
+      q.push(randomQuaternion());
+
+    q.push(Star::quaternionf(0, 0, 0, 1));
+    q.push(Star::quaternionf(0, 0, 0, -1));
+    for(size_t k = 0; k < 4; k++)
+      for(float eps = 1e-1f; eps > 1e-8f; eps *= 0.1f) {
+        float c[4] = { eps, -eps, eps*0.5f, eps*0.25f };
+        c[k] = 1;
+        Star::quaternionf r(c[0], c[1], c[2], c[3]);
+        r.normalize();
+        q.push(r);
+      }
+    //Half turns have w = 0, the matrix trace is -1
+    q.push(Star::quaternionf(1, 0, 0, 0));
+    q.push(Star::quaternionf(0, 0.6f, 0.8f, 0));
+    q.push(Star::quaternionf(0.70710678f, 0.70710678f, 0, 1e-7f));
+  }
+
+  /*****************************************************************************/
+  /**
+   * Exact slerp, the angle from atan2 to stay accurate for close inputs.
+   */
+  Star::Quaternion<ld>
+  slerpReference(const Star::Quaternion<ld>& a, Star::Quaternion<ld> b, ld t)
+  {
+    if(a.dot(b) < 0)
+      b = -b;
+    ld theta = 2*std::atan2((a-b).length(), (a+b).length());
+    if(theta == 0)
+      return a;
+    ld s = std::sin(theta);
+    return a*(std::sin((1-t)*theta)/s)+b*(std::sin(t*theta)/s);
+  }
+
+  /*****************************************************************************/
+  void
+  caseSlerp(Report& report)
+  {
+    QuatArrays a, b;
+    std::vector<float> t;
+    makeQuaternions(a);
+    for(size_t i = 0; i < a.aos.size(); i++) {
+      b.push(randomQuaternion());
+      t.push_back(std::abs(randf()));
+    }
+    //Identical, opposite, nearly identical and threshold crossing pairs
+    const float offsets[] = { 0, 1e-7f, 1e-5f, 1e-3f, 0.0316f, 0.0317f, 0.1f };
+    for(size_t k = 0; k < sizeof(offsets)/sizeof(offsets[0]); k++)
+      for(int sign = -1; sign <= 1; sign += 2) {
+        Star::quaternionf qa = randomQuaternion();
+        Star::quaternionf qb = Star::quaternionf(Star::float3(0.3f, -0.5f, 0.8f), offsets[k])*qa*float(sign);
+        a.push(qa);
+        b.push(qb);
+        t.push_back(k%2 ? 0.5f : 0.25f);
+      }
+    a.push(randomQuaternion()); b.push(randomQuaternion()); t.push_back(0);
+    a.push(randomQuaternion()); b.push(randomQuaternion()); t.push_back(1);
+
+    const size_t n = a.aos.size();
+    QuatArrays out;
+    out.resize(n);
+    std::vector<Star::quaternionf> scalar(n);
+    report.numElements = n;
+    report.batchSeconds = timeBest([&]() { Star::quaternionSlerp(a.in(), b.in(), &t[0], out.out(), n); });
+    report.scalarSeconds = timeBest([&]() {
+        for(size_t i = 0; i < n; i++)
+          scalar[i] = Star::quaternionf::slerp(a.aos[i], b.aos[i], t[i]);
+      });
+    Star::quaternionSlerp(a.in(), b.in(), &t[0], out.out(), n);
+
+    for(size_t i = 0; i < n; i++) {
+      Star::Quaternion<ld> r = slerpReference(toLd(a.aos[i]), toLd(b.aos[i]), t[i]);
+      ld ref[4] = { r.x, r.y, r.z, r.w };
+      float batch[4];
+      out.get(i, batch);
+      report.add(&scalar[i].x, batch, ref, 4, 1);
+    }
+  }
+
+  /*****************************************************************************/
+  template<typename Batch>
+  void
+  caseNlerp(Report& report)
+  {
+    QuatArrays a, b;
+    std::vector<float> t;
+    makeQuaternions(a);
+    for(size_t i = 0; i < a.aos.size(); i++) {
+      b.push(randomQuaternion());
+      t.push_back(std::abs(randf()));
+    }
+    //Identical, opposite and nearly opposite pairs, both ends
+    Star::quaternionf q = randomQuaternion();
+    a.push(q); b.push(q); t.push_back(0.5f);
+    a.push(q); b.push(-q); t.push_back(0.5f);
+    a.push(q); b.push(-(Star::quaternionf(Star::float3(0, 0, 1), 1e-3f)*q)); t.push_back(0.5f);
+    a.push(randomQuaternion()); b.push(randomQuaternion()); t.push_back(0);
+    a.push(randomQuaternion()); b.push(randomQuaternion()); t.push_back(1);
+
+    const size_t n = a.aos.size();
+    QuatArrays out;
+    out.resize(n);
+    std::vector<Star::quaternionf> scalar(n);
+    report.numElements = n;
+    report.batchSeconds = timeBest([&]() { Batch::nlerp(a.in(), b.in(), &t[0], out.out(), n); });
+    report.scalarSeconds = timeBest([&]() {
+        for(size_t i = 0; i < n; i++)
+          scalar[i] = Star::quaternionf::nlerp(a.aos[i], b.aos[i], t[i]);
+      });
+    Batch::nlerp(a.in(), b.in(), &t[0], out.out(), n);
+
+    for(size_t i = 0; i < n; i++) {
+      Star::Quaternion<ld> r = Star::Quaternion<ld>::nlerp(toLd(a.aos[i]), toLd(b.aos[i]), t[i]);
+      ld ref[4] = { r.x, r.y, r.z, r.w };
+      float batch[4];
+      out.get(i, batch);
+      report.add(&scalar[i].x, batch, ref, 4, 1);
+    }
+  }
+
+  /*****************************************************************************/
+  /**
+   * Random vectors, then huge, tiny and null ones.
+   */
+  void
+  makeVectors(Vec3Arrays& v, size_t n)
+  {
+    for(size_t i = 0; i < n; i++) {
+      float scale = std::pow(10.f, float(std::rand()%9)-4);
+      v.push(Star::float3(randf(), randf(), randf())*scale);
+    }
+    v.aos[n-1] = Star::float3(0, 0, 0);
+    v.c[0][n-1] = v.c[1][n-1] = v.c[2][n-1] = 0;
+    v.aos[n-2] = Star::float3(1e30f, -1e30f, 1e30f);
+    v.c[0][n-2] = v.c[2][n-2] = 1e30f;
+    v.c[1][n-2] = -1e30f;
+    v.aos[n-3] = Star::float3(1e-30f, 1e-30f, -1e-30f);
+    v.c[0][n-3] = v.c[1][n-3] = 1e-30f;
+    v.c[2][n-3] = -1e-30f;
+  }
+
+  template<typename Batch>
+  void
+  caseRotate(Report& report)
+  {
+    QuatArrays q;
+    makeQuaternions(q);
+    const size_t n = q.aos.size();
+    Vec3Arrays v, out;
+    makeVectors(v, n);
+    out.resize(n);
+    std::vector<Star::float3> scalar(n);
+
+    report.numElements = n;
+    report.batchSeconds = timeBest([&]() { Batch::rotate(q.in(), v.in(), out.out(), n); });
+    report.scalarSeconds = timeBest([&]() {
+        for(size_t i = 0; i < n; i++)
+          scalar[i] = q.aos[i].rotate(v.aos[i]);
+      });
+    Batch::rotate(q.in(), v.in(), out.out(), n);
+
+    for(size_t i = 0; i < n; i++) {
+      Star::Vec3<ld> vi(v.aos[i].x, v.aos[i].y, v.aos[i].z);
+      Star::Vec3<ld> r = toLd(q.aos[i]).rotate(vi);
+      ld ref[3] = { r.x, r.y, r.z };
+      float batch[3];
+      out.get(i, batch);
+      report.add(&scalar[i].x, batch, ref, 3, vi.length());
+    }
+  }
+
+  /*****************************************************************************/
+  void
+  caseRotateOne(Report& report)
+  {
+    const Star::quaternionf q = randomQuaternion();
+    Vec3Arrays v, out;
+    makeVectors(v, NUM_RANDOM);
+    const size_t n = v.aos.size();
+    out.resize(n);
+    std::vector<Star::float3> scalar(n);
+
+    report.numElements = n;
+    report.batchSeconds = timeBest([&]() { Star::quaternionRotate(q, v.in(), out.out(), n); });
+    report.scalarSeconds = timeBest([&]() {
+        for(size_t i = 0; i < n; i++)
+          scalar[i] = q.rotate(v.aos[i]);
+      });
+    Star::quaternionRotate(q, v.in(), out.out(), n);
+
+    for(size_t i = 0; i < n; i++) {
+      Star::Vec3<ld> vi(v.aos[i].x, v.aos[i].y, v.aos[i].z);
+      Star::Vec3<ld> r = toLd(q).rotate(vi);
+      ld ref[3] = { r.x, r.y, r.z };
+      float batch[3];
+      out.get(i, batch);
+      report.add(&scalar[i].x, batch, ref, 3, vi.length());
+    }
+  }
+
+  /*****************************************************************************/
+  template<typename Batch>
+  void
+  caseToRotationMatrix(Report& report)
+  {
+    QuatArrays q;
+    makeQuaternions(q);
+    const size_t n = q.aos.size();
+    std::vector<float> out(n*12);
+    std::vector<Star::float4x4> scalar(n);
+
+    report.numElements = n;
+    report.batchSeconds = timeBest([&]() { Batch::toRotationMatrix(q.in(), &out[0], n); });
+    report.scalarSeconds = timeBest([&]() {
+        for(size_t i = 0; i < n; i++)
+          q.aos[i].toRotationMatrix(scalar[i]);
+      });
+    Batch::toRotationMatrix(q.in(), &out[0], n);
+
+    for(size_t i = 0; i < n; i++) {
+      Star::Matrix<ld> r;
+      toLd(q.aos[i]).toRotationMatrix(r);
+      report.add(scalar[i].constPtr(), &out[i*12], r.constPtr(), 12, 1);
+    }
+  }
+
+  /*****************************************************************************/
+  void
+  caseFromRotationMatrix(Report& report)
+  {
+    QuatArrays q;
+    makeQuaternions(q);
+    const size_t n = q.aos.size();
+    std::vector<Star::float4x4> matrices(n);
+    for(size_t i = 0; i < n; i++)
+      q.aos[i].toRotationMatrix(matrices[i]);
+    QuatArrays out;
+    out.resize(n);
+    std::vector<Star::quaternionf> scalar(n);
+
+    const float* in = matrices[0].constPtr();
+    report.numElements = n;
+    report.batchSeconds = timeBest([&]() { Star::quaternionFromRotationMatrix(in, out.out(), n, 16); });
+    report.scalarSeconds = timeBest([&]() {
+        for(size_t i = 0; i < n; i++)
+          scalar[i].fromRotationMatrix(matrices[i]);
+      });
+    Star::quaternionFromRotationMatrix(in, out.out(), n, 16);
+
+    for(size_t i = 0; i < n; i++) {
+      Star::Matrix<ld> m;
+      for(size_t k = 0; k < 16; k++)
+        m.ptr()[k] = matrices[i].constPtr()[k];
+      Star::Quaternion<ld> r;
+      r.fromRotationMatrix(m);
+      //Both signs are the same rotation, compare in the reference hemisphere
+      float batch[4];
+      out.get(i, batch);
+      float sb = r.x*batch[0]+r.y*batch[1]+r.z*batch[2]+r.w*batch[3] < 0 ? -1.f : 1.f;
+      float ss = r.dot(toLd(scalar[i])) < 0 ? -1.f : 1.f;
+      for(size_t k = 0; k < 4; k++)
+        batch[k] *= sb;
+      Star::quaternionf s = scalar[i]*ss;
+      ld ref[4] = { r.x, r.y, r.z, r.w };
+      report.add(&s.x, batch, ref, 4, 1);
+    }
+  }
+
+  /*****************************************************************************/
+  void
+  caseIntegrate(Report& report)
+  {
+    QuatArrays q;
+    makeQuaternions(q);
+    const size_t n = q.aos.size();
+    Vec3Arrays omega;
+    const float dt = 1/60.f;
+    for(size_t i = 0; i < n; i++) {
+      //Mostly slow bodies, every 8th one past the series range
+      float speed = i%8 ? std::abs(randf())*30 : 40+std::abs(randf())*1000;
+      Star::float3 axis(randf(), randf(), randf()+1);
+      axis.normalize();
+      omega.push(axis*speed);
+    }
+    //Half angle exactly on the series limit and around it
+    const float limit = 2*Star::quaternionf::expSeriesLimit()/dt;
+    const float speeds[] = { 0, 1e-30f, 1e-10f, limit, std::nextafter(limit, 0.f), std::nextafter(limit, 1e9f) };
+    for(size_t k = 0; k < sizeof(speeds)/sizeof(speeds[0]); k++) {
+      omega.aos[k] = Star::float3(0, 0, speeds[k]);
+      omega.c[0][k] = omega.c[1][k] = 0;
+      omega.c[2][k] = speeds[k];
+    }
+
+    QuatArrays out;
+    out.resize(n);
+    std::vector<Star::quaternionf> scalar(n);
+    report.numElements = n;
+    report.batchSeconds = timeBest([&]() { Star::quaternionIntegrate(q.in(), omega.in(), dt, out.out(), n); });
+    report.scalarSeconds = timeBest([&]() {
+        for(size_t i = 0; i < n; i++)
+          scalar[i] = Star::quaternionf::integrate(q.aos[i], omega.aos[i], dt);
+      });
+    Star::quaternionIntegrate(q.in(), omega.in(), dt, out.out(), n);
+
+    for(size_t i = 0; i < n; i++) {
+      //Exact exponential
+      Star::Vec3<ld> v = Star::Vec3<ld>(omega.aos[i].x, omega.aos[i].y, omega.aos[i].z)*(ld(dt)/2);
+      ld a = v.length();
+      ld s = a > 0 ? std::sin(a)/a : 1;
+      Star::Quaternion<ld> e(v.x*s, v.y*s, v.z*s, std::cos(a));
+      Star::Quaternion<ld> r = e*toLd(q.aos[i]);
+      r.normalize();
+      ld ref[4] = { r.x, r.y, r.z, r.w };
+      float batch[4];
+      out.get(i, batch);
+      report.add(&scalar[i].x, batch, ref, 4, 1);
+    }
+  }
+
+  /*****************************************************************************/
+  template<typename Batch>
+  void
+  caseLinearBlendSkin(Report& report)
+  {
+    const size_t numBones = 32;
+    std::vector<Star::float4x4> palette(numBones);
+    std::vector<Star::Matrix<ld> > paletteLd(numBones);
+    for(size_t b = 0; b < numBones; b++) {
+      randomQuaternion().toRotationMatrix(palette[b]);
+      palette[b](0, 3) = randf()*10;
+      palette[b](1, 3) = randf()*10;
+      palette[b](2, 3) = randf()*10;
+      for(size_t k = 0; k < 16; k++)
+        paletteLd[b].ptr()[k] = palette[b].constPtr()[k];
+    }
+
+    const size_t n = NUM_RANDOM;
+    Vec3Arrays pos, out;
+    makeVectors(pos, n);
+    out.resize(n);
+    std::vector<float> weights[3];
+    std::vector<unsigned int> indices[3];
+    for(size_t i = 0; i < n; i++) {
+      float w[3] = { std::abs(randf()), std::abs(randf()), std::abs(randf())+1e-3f };
+      //Single bone vertices and a vanishing weight
+      if(i%16 == 0)
+        w[0] = w[1] = 0;
+      if(i%16 == 1)
+        w[1] = 1e-7f;
+      float sum = w[0]+w[1]+w[2];
+      for(size_t b = 0; b < 3; b++) {
+        weights[b].push_back(w[b]/sum);
+        indices[b].push_back(std::rand()%numBones);
+      }
+    }
+    const float* w[3] = { &weights[0][0], &weights[1][0], &weights[2][0] };
+    const unsigned int* idx[3] = { &indices[0][0], &indices[1][0], &indices[2][0] };
+    Star::BoneInfluenceSoA<float> influences(w, idx, 3);
+
+    std::vector<Star::float3> scalar(n);
+    report.numElements = n;
+    report.batchSeconds = timeBest([&]() { Batch::linearBlendSkin(&palette[0], influences, pos.in(), out.out(), n); });
+    report.scalarSeconds = timeBest([&]() {
+        for(size_t i = 0; i < n; i++) {
+          Star::float3 res(0, 0, 0);
+          for(size_t b = 0; b < 3; b++)
+            res += (palette[indices[b][i]]*pos.aos[i])*weights[b][i];
+          scalar[i] = res;
+        }
+      });
+    Batch::linearBlendSkin(&palette[0], influences, pos.in(), out.out(), n);
+
+    for(size_t i = 0; i < n; i++) {
+      Star::Vec3<ld> p(pos.aos[i].x, pos.aos[i].y, pos.aos[i].z);
+      Star::Vec3<ld> r(0, 0, 0);
+      for(size_t b = 0; b < 3; b++)
+        r += (paletteLd[indices[b][i]]*p)*ld(weights[b][i]);
+      ld ref[3] = { r.x, r.y, r.z };
+      float batch[3];
+      out.get(i, batch);
+      //Blending cancels up to the magnitude of the transformed point
+      report.add(&scalar[i].x, batch, ref, 3, p.length()+10);
+    }
+  }
+
+  /*****************************************************************************/
+  template<typename Batch>
+  void
+  caseMatrixInverse(Report& report)
+  {
+    //Scaled rigid transforms, then random diagonally dominant matrices
+    const size_t n = NUM_RANDOM;
+    std::vector<Star::float4x4> m(n), out(n), scalar(n);
+    for(size_t i = 0; i < n; i++) {
+      if(i%2) {
+        randomQuaternion().toRotationMatrix(m[i]);
+        const float scale = std::exp2(randf()*4);
+        for(size_t j = 0; j < 3; j++) {
+          for(size_t k = 0; k < 3; k++)
+            m[i](j, k) *= scale;
+          m[i](j, 3) = randf()*100;
+        }
+      }
+      else {
+        for(size_t k = 0; k < 16; k++)
+          m[i].ptr()[k] = randf();
+        for(size_t k = 0; k < 4; k++)
+          m[i](k, k) += 4;
+      }
+    }
+
+    report.numElements = n;
+    report.batchSeconds = timeBest([&]() { Batch::matrixInverse(&m[0], &out[0], n); });
+    report.scalarSeconds = timeBest([&]() {
+        for(size_t i = 0; i < n; i++)
+          scalar[i] = m[i].inverse();
+      });
+    Batch::matrixInverse(&m[0], &out[0], n);
+
+    for(size_t i = 0; i < n; i++) {
+      Star::Matrix<ld> a;
+      for(size_t k = 0; k < 16; k++)
+        a.ptr()[k] = m[i].constPtr()[k];
+      const Star::Matrix<ld> r = a.inverse();
+      //Judged per row at the magnitude of |r| |a| |r|, how much a
+      //rounding of the inputs moves the inverse: the translations of the
+      //inverses are dot products which can cancel
+      Star::Matrix<ld> absA, absR;
+      for(size_t k = 0; k < 16; k++) {
+        absA.ptr()[k] = std::fabs(a.constPtr()[k]);
+        absR.ptr()[k] = std::fabs(r.constPtr()[k]);
+      }
+      const Star::Matrix<ld> bound = absR*absA*absR;
+      for(size_t j = 0; j < 4; j++) {
+        ld scale = 0;
+        for(size_t k = 0; k < 4; k++)
+          scale = std::max(scale, bound(j, k));
+        report.add(scalar[i].constPtr()+4*j, out[i].constPtr()+4*j, r.constPtr()+4*j, 4, scale);
+      }
+    }
+  }
+
+  /*****************************************************************************/
+  void
+  caseTransformHierarchy(Report& report)
+  {
+    //Chains 8 deep, so errors accumulate like in a skeleton
+    const size_t n = NUM_RANDOM;
+    Star::transformHierarchyf hierarchy;
+    Star::TransformHierarchy<ld> reference;
+    for(size_t i = 0; i < n; i++) {
+      unsigned int parent = i%8 ? (unsigned int)(i-1) : Star::transformHierarchyf::NONE;
+      Star::float3 t(randf(), randf(), randf());
+      Star::quaternionf r = randomQuaternion();
+      Star::float3 s(1+randf()*0.2f, 1+randf()*0.2f, 1+randf()*0.2f);
+      hierarchy.addNode(parent, t, r, s);
+      reference.addNode(parent == Star::transformHierarchyf::NONE ? Star::TransformHierarchy<ld>::NONE : parent,
+                        Star::Vec3<ld>(t.x, t.y, t.z), toLd(r), Star::Vec3<ld>(s.x, s.y, s.z));
+    }
+    reference.update();
+
+    std::vector<Star::float4x4> scalar(n);
+    report.numElements = n;
+    report.batchSeconds = timeBest([&]() {
+        for(size_t i = 0; i < n; i++)
+          hierarchy.setDirty((unsigned int)i);
+        hierarchy.update();
+      });
+    report.scalarSeconds = timeBest([&]() {
+        for(size_t i = 0; i < n; i++) {
+          Star::float4x4 t, r, s;
+          t.makeTranslation(hierarchy.getTranslation(i));
+          hierarchy.getRotation(i).toRotationMatrix(r);
+          s.makeScaling(hierarchy.getScale(i));
+          scalar[i] = t*r*s;
+          unsigned int parent = hierarchy.getParent(i);
+          if(parent != Star::transformHierarchyf::NONE)
+            scalar[i] = scalar[parent]*scalar[i];
+        }
+      });
+
+    for(size_t i = 0; i < n; i++) {
+      const Star::Matrix<ld>& r = reference.getWorld(i);
+      ld scale = 1;
+      for(size_t k = 0; k < 12; k++)
+        scale = std::max(scale, std::fabs(r.constPtr()[k]));
+      report.add(scalar[i].constPtr(), hierarchy.getWorld(i).constPtr(), r.constPtr(), 12, scale);
+    }
+  }
+
+  /*****************************************************************************/
+  struct Case
+  {
+    const char* name;
+    void (*run)(Report&);
+    //Maximum error of the batch kernel, in ULPs
+    double budget;
+    //Run once per instruction set supported by Kernels
+    bool perIsa;
+  };
+
+  //About twice the errors measured with SSE2 and AVX-512 builds. slerp
+  //uses nlerp below its threshold angle, which costs up to 26 ULPs.
+  const Case CASES[] = {
+    { "quaternionSlerp", caseSlerp, 48, false },
+    { "quaternionNlerp", caseNlerp<TemplateBatch>, 4, false },
+    { "quaternionRotate", caseRotate<TemplateBatch>, 8, false },
+    { "quaternionRotate one", caseRotateOne, 8, false },
+    { "quaternionToRotationMatrix", caseToRotationMatrix<TemplateBatch>, 4, false },
+    { "quaternionFromRotationMatrix", caseFromRotationMatrix, 4, false },
+    { "quaternionIntegrate", caseIntegrate, 16, false },
+    { "linearBlendSkin", caseLinearBlendSkin<TemplateBatch>, 8, false },
+    { "matrixInverse", caseMatrixInverse<TemplateBatch>, 12, false },
+    { "TransformHierarchy::update", caseTransformHierarchy, 16, false },
+    { "Kernels::quaternionNlerp", caseNlerp<KernelBatch>, 4, true },
+    { "Kernels::quaternionRotate", caseRotate<KernelBatch>, 8, true },
+    { "Kernels::quaternionToRotationMatrix", caseToRotationMatrix<KernelBatch>, 4, true },
+    { "Kernels::linearBlendSkin", caseLinearBlendSkin<KernelBatch>, 8, true },
+    { "Kernels::matrixInverse", caseMatrixInverse<KernelBatch>, 12, true }
+  };
+
+  /*****************************************************************************/
+  /**
+   * Check that the instruction set picked by Kernels on its first call
+   * honors STARMATH_ISA: the one named if supported and lower than the
+   * best, generic for sse2, the best otherwise.
+   */
+  bool
+  checkIsaOverride()
+  {
+    const Star::Kernels::Isa isa = Star::Kernels::getIsa();
+    const char* forced = std::getenv("STARMATH_ISA");
+    if(!forced)
+      return true;
+
+    int expected = Star::Kernels::ISA_GENERIC;
+    for(int i = 0; i < Star::Kernels::NUM_ISAS; i++)
+      if(Star::Kernels::isSupported(Star::Kernels::Isa(i)))
+        expected = i;
+    for(int i = 0; i < expected; i++)
+      if(!std::strcmp(forced, Star::Kernels::getIsaName(Star::Kernels::Isa(i))))
+        expected = i;
+    if(!std::strcmp(forced, "sse2"))
+      expected = Star::Kernels::ISA_GENERIC;
+
+    const bool ok = isa == expected;
+    std::printf("STARMATH_ISA=%s selected %s %s\n", forced, Star::Kernels::getIsaName(isa),
+                ok ? "ok" : "FAILED");
+    return ok;
+  }
+}
+
+/*****************************************************************************/
+int
+main(int argc, char** argv)
+{
+  const char* filter = 0;
+  for(int i = 1; i < argc; i++) {
+    if(!std::strcmp(argv[i], "--no-timing"))
+      g_timing = false;
+    else
+      filter = argv[i];
+  }
+
+  int numFailures = !checkIsaOverride();
+  const Star::Kernels::Isa initialIsa = Star::Kernels::getIsa();
+
+  std::printf("%-44s %21s %21s %12s %7s %10s %10s %8s\n", "kernel", "scalar ulp max/mean",
+              "batch ulp max/mean", "batch-scalar", "budget", "scalar ns", "batch ns", "speedup");
+  for(size_t c = 0; c < sizeof(CASES)/sizeof(CASES[0]); c++) {
+    const Case& test = CASES[c];
+    if(filter && !std::strstr(test.name, filter))
+      continue;
+
+    for(int isa = 0; isa < (test.perIsa ? int(Star::Kernels::NUM_ISAS) : 1); isa++) {
+      std::string name = test.name;
+      if(test.perIsa) {
+        if(!Star::Kernels::setIsa(Star::Kernels::Isa(isa)))
+          continue;
+        name += std::string(" ")+Star::Kernels::getIsaName(Star::Kernels::Isa(isa));
+      }
+
+      std::srand(1234);
+      Report report;
+      test.run(report);
+
+      const double n = double(std::max(report.numElements, size_t(1)));
+      const bool ok = report.batchVsRef.maxUlp <= test.budget;
+      std::printf("%-44s %10.2f/%-10.3f %10.2f/%-10.3f %12.2f %7.0f %10.2f %10.2f %7.2fx %s\n", name.c_str(),
+                  report.scalarVsRef.maxUlp, report.scalarVsRef.mean(),
+                  report.batchVsRef.maxUlp, report.batchVsRef.mean(),
+                  report.batchVsScalar.maxUlp, test.budget,
+                  report.scalarSeconds*1e9/n, report.batchSeconds*1e9/n,
+                  report.batchSeconds > 0 ? report.scalarSeconds/report.batchSeconds : 0.,
+                  ok ? "ok" : "FAILED");
+      numFailures += !ok;
+    }
+    Star::Kernels::setIsa(initialIsa);
+  }
+
+  return numFailures ? 1 : 0;
+}
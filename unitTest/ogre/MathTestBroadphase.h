@@ -0,0 +1,107 @@
+#include <cxxtest/TestSuite.h>
+
+#include <StarMath.h>
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <vector>
+
+#include "RandGen.h"
+
+class MathTestBroadphase : public CxxTest::TestSuite
+{
+public:
+  void testIntersects()
+  {
+    Star::boxf a(Star::float3(0, 0, 0), Star::float3(1, 1, 1));
+    TS_ASSERT(a.intersects(Star::boxf(Star::float3(0.5f, 0.5f, 0.5f), Star::float3(2, 2, 2))));
+    TS_ASSERT(!a.intersects(Star::boxf(Star::float3(1, 0, 0), Star::float3(2, 1, 1))));
+    TS_ASSERT(!a.intersects(Star::boxf(Star::float3(0, 0, 2), Star::float3(1, 1, 3))));
+    TS_ASSERT(Star::boxIntersects(a, Star::boxf(Star::float3(0.5f, 0.5f, 0.5f), Star::float3(2, 2, 2))));
+    TS_ASSERT(!Star::boxIntersects(a, Star::boxf(Star::float3(1, 0, 0), Star::float3(2, 1, 1))));
+    TS_ASSERT(!Star::boxIntersects(a, Star::boxf(Star::float3(0, 0, 2), Star::float3(1, 1, 3))));
+
+    //Integer coordinates, so that boxes often touch or share a face
+    FloatRandGen rand(4.f);
+    for(size_t i = 0; i < 10000; i++) {
+      Star::float3 p[4];
+      for(size_t k = 0; k < 4; k++)
+        p[k] = Star::float3(std::floor(rand()), std::floor(rand()), std::floor(rand()));
+      Star::boxf b(p[0], p[0]+p[1]);
+      Star::boxf c(p[2], p[2]+p[3]);
+      TS_ASSERT_EQUALS(Star::boxIntersects(b, c), b.intersects(c));
+      TS_ASSERT_EQUALS(Star::boxIntersects(c, b), b.intersects(c));
+    }
+  }
+
+  void testInfiniteBounds()
+  {
+    //A box reaching +inf along the sweep axis passes every min, even the
+    //padding after the last box
+    const float inf = std::numeric_limits<float>::infinity();
+    for(size_t numBoxes = 2; numBoxes <= 9; numBoxes++) {
+      std::vector<Star::boxf> boxes;
+      for(size_t i = 0; i < numBoxes; i++)
+        boxes.push_back(Star::boxf(Star::float3(i*10.f, 0, 0), Star::float3(i*10.f+5, 1, 1)));
+      boxes[0] = Star::boxf(Star::float3(0, 0, 0), Star::float3(inf, 1, 1));
+
+      Star::sweepAndPrunef sap;
+      std::vector<Star::sweepAndPrunef::Pair> pairs(numBoxes*numBoxes);
+      size_t numPairs = sap.update(&boxes[0], numBoxes, &pairs[0], pairs.size());
+      TS_ASSERT_EQUALS(sap.getAxis(), 0u);
+      TS_ASSERT_EQUALS(numPairs, numBoxes-1);
+      std::sort(pairs.begin(), pairs.begin()+numPairs);
+      for(size_t i = 0; i < numPairs; i++)
+        TS_ASSERT(pairs[i] == Star::sweepAndPrunef::Pair(0, (unsigned int)i+1));
+    }
+  }
+
+  void testSweepAndPrune()
+  {
+    using namespace std;
+    const size_t numBoxes = 2000;
+    vector<float> randValues;
+    generate_n(back_inserter(randValues), numBoxes*6, FloatRandGen(100.f));
+
+    vector<Star::float3> positions, velocities;
+    for(size_t i = 0; i < numBoxes; i++)
+    {
+      positions.push_back(Star::float3(&randValues[i*6]));
+      velocities.push_back(Star::float3(&randValues[i*6+3])*0.01f);
+    }
+
+    Star::sweepAndPrunef sap;
+    vector<Star::sweepAndPrunef::Pair> pairs(numBoxes*8);
+    vector<Star::boxf> boxes(numBoxes);
+    for(size_t step = 0; step < 5; step++)
+    {
+      for(size_t i = 0; i < numBoxes; i++)
+      {
+        positions[i] += velocities[i];
+        Star::float3 halfSize(0.5f+i%4, 1.f, 0.5f+i%3);
+        boxes[i] = Star::boxf(positions[i]-halfSize, positions[i]+halfSize);
+      }
+
+      size_t numPairs = sap.update(&boxes[0], numBoxes, &pairs[0], pairs.size());
+      TS_ASSERT_LESS_THAN_EQUALS(numPairs, pairs.size());
+      vector<Star::sweepAndPrunef::Pair> found(pairs.begin(), pairs.begin()+numPairs);
+      sort(found.begin(), found.end());
+
+      vector<Star::sweepAndPrunef::Pair> ref;
+      for(unsigned int i = 0; i < numBoxes; i++)
+      {
+        for(unsigned int j = i+1; j < numBoxes; j++)
+        {
+          if(boxes[i].intersects(boxes[j]))
+            ref.push_back(make_pair(i, j));
+        }
+      }
+      TS_ASSERT(found == ref);
+    }
+
+    //Overflow only reports the count
+    size_t numPairs = sap.update(&boxes[0], numBoxes, &pairs[0], 1);
+    TS_ASSERT_LESS_THAN(size_t(1), numPairs);
+  }
+};
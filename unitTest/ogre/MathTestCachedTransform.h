@@ -0,0 +1,76 @@
+#include <cxxtest/TestSuite.h>
+
+#include <StarMath.h>
+
+#include <limits>
+#include <algorithm>
+#include <vector>
+
+#include "RandGen.h"
+
+class MathTestCachedTransform : public CxxTest::TestSuite
+{
+public:
+  void setUp()
+  {
+    Star::quaterniond q(0.3, -0.2, 0.5, 0.8);
+    q.normalize();
+    Star::double4x4 r, s, t;
+    q.toRotationMatrix(r);
+    s.makeScaling(2, 0.5, 3);
+    t.makeTranslation(1, -2, 5);
+    m_matrix = t*r*s;
+  }
+
+  void testInverse()
+  {
+    Star::cachedTransformd transform(m_matrix);
+    TS_ASSERT(!transform.isCached());
+    TS_ASSERT(near(transform.getInverse(), m_matrix.inverse()));
+    TS_ASSERT(transform.isCached());
+    TS_ASSERT_DELTA(transform.getDeterminant(), m_matrix.determinant(), 1e-12);
+    TS_ASSERT_DELTA(transform.getDeterminant(), 3., 1e-12);
+
+    //Normal matrix maps normals of the transformed plane
+    Star::double3 a(1, 0, 0), b(0, 1, 0);
+    Star::double3 o = m_matrix*Star::double3(0, 0, 0);
+    Star::double3 n = transform.getNormalMatrix()*a.cross(b);
+    TS_ASSERT_DELTA(n.dot(m_matrix*a-o), 0, 1e-12);
+    TS_ASSERT_DELTA(n.dot(m_matrix*b-o), 0, 1e-12);
+    TS_ASSERT(transform.getNormalMatrix()*Star::double3(0, 0, 0) == Star::double3(0, 0, 0));
+
+    //Modification invalidates, copies keep the cache
+    Star::cachedTransformd copy(transform);
+    TS_ASSERT(copy.isCached());
+    transform.setMatrix(m_matrix*m_matrix);
+    TS_ASSERT(!transform.isCached());
+    TS_ASSERT_DELTA(transform.getDeterminant(), 9., 1e-12);
+    TS_ASSERT(near(copy.getInverse(), m_matrix.inverse()));
+    copy = Star::cachedTransformd();
+    TS_ASSERT_DELTA(copy.getDeterminant(), 1., 0.);
+  }
+
+  void testConcurrentReaders()
+  {
+    std::vector<Star::cachedTransformd> transforms(64, Star::cachedTransformd(m_matrix));
+    std::vector<double> determinants(64*64);
+#pragma omp parallel for schedule(dynamic, 1) num_threads(8)
+    for(long i = 0; i < long(determinants.size()); i++)
+      determinants[i] = transforms[i%64].getDeterminant();
+    for(size_t i = 0; i < determinants.size(); i++)
+      TS_ASSERT_DELTA(determinants[i], 3., 1e-12);
+    for(size_t i = 0; i < transforms.size(); i++)
+      TS_ASSERT(near(transforms[i].getInverse(), m_matrix.inverse()));
+  }
+
+private:
+  static bool near(const Star::double4x4& a, const Star::double4x4& b)
+  {
+    for(size_t k = 0; k < 16; k++)
+      if(std::abs(a.constPtr()[k]-b.constPtr()[k]) > 1e-12)
+        return false;
+    return true;
+  }
+
+  Star::double4x4 m_matrix;
+};
@@ -0,0 +1,88 @@
+#include <cxxtest/TestSuite.h>
+
+#include <StarMath.h>
+
+#include <limits>
+#include <algorithm>
+#include <vector>
+
+#include "RandGen.h"
+
+class MathTestClipper : public CxxTest::TestSuite
+{
+public:
+  void testPolygon()
+  {
+    //Unit square cut in half by x >= 0.5
+    Star::float3 square[4] = { Star::float3(0, 0, 0), Star::float3(1, 0, 0),
+                               Star::float3(1, 1, 0), Star::float3(0, 1, 0) };
+    Star::planef plane(Star::float3(1, 0, 0), Star::float3(0.5f, 0, 0));
+    Star::float3 out[5];
+    TS_ASSERT_EQUALS(Star::clipPolygon(square, 4, plane, out), size_t(4));
+    TS_ASSERT_DELTA(area(out, 4), 0.5f, 1e-6f);
+
+    Star::planef away(Star::float3(1, 0, 0), Star::float3(2, 0, 0));
+    TS_ASSERT_EQUALS(Star::clipPolygon(square, 4, away, out), size_t(0));
+  }
+
+  void testTriangles()
+  {
+    using namespace std;
+    const size_t numTriangles = 3000;
+    vector<float> randValues;
+    generate_n(back_inserter(randValues), numTriangles*9, FloatRandGen(10.f));
+    vector<Star::float3> triangles;
+    for(size_t i = 0; i < numTriangles*3; i++)
+      triangles.push_back(Star::float3(randValues[i*3], randValues[i*3+1], 0));
+
+    //Keep 2 <= x <= 8 and y >= 3
+    Star::planef planes[3] = { Star::planef(Star::float3(1, 0, 0), Star::float3(2, 0, 0)),
+                               Star::planef(Star::float3(-1, 0, 0), Star::float3(8, 0, 0)),
+                               Star::planef(Star::float3(0, 1, 0), Star::float3(0, 3, 0)) };
+
+    Star::triangleClipperf serial(planes, 3, numTriangles);
+    Star::triangleClipperf chunked(planes, 3, 64);
+    vector<Star::float3> out(serial.getMaxOutputTriangles(numTriangles)*3);
+    vector<Star::float3> outChunked(chunked.getMaxOutputTriangles(numTriangles)*3);
+
+    size_t numOut = serial.clip(&triangles[0], numTriangles, &out[0]);
+    size_t numOutChunked = chunked.clip(&triangles[0], numTriangles, &outChunked[0]);
+    TS_ASSERT_EQUALS(numOut, numOutChunked);
+    TS_ASSERT(std::equal(out.begin(), out.begin()+3*numOut, outChunked.begin()));
+
+    for(size_t i = 0; i < numOut*3; i++)
+    {
+      TS_ASSERT_LESS_THAN(1.9999f, out[i].x);
+      TS_ASSERT_LESS_THAN(out[i].x, 8.0001f);
+      TS_ASSERT_LESS_THAN(2.9999f, out[i].y);
+    }
+
+    //Clipped area matches each triangle clipped by hand
+    float clippedArea = 0;
+    for(size_t i = 0; i < numOut; i++)
+      clippedArea += area(&out[i*3], 3);
+    float refArea = 0;
+    for(size_t i = 0; i < numTriangles; i++)
+    {
+      Star::float3 poly[8], tmp[8];
+      std::copy(&triangles[i*3], &triangles[i*3]+3, poly);
+      size_t n = 3;
+      for(size_t p = 0; p < 3; p++)
+      {
+        n = Star::clipPolygon(poly, n, planes[p], tmp);
+        std::copy(tmp, tmp+n, poly);
+      }
+      refArea += area(poly, n);
+    }
+    TS_ASSERT_DELTA(clippedArea, refArea, refArea*1e-4f);
+  }
+
+private:
+  static float area(const Star::float3* poly, size_t n)
+  {
+    Star::float3 sum(0, 0, 0);
+    for(size_t i = 1; i+1 < n; i++)
+      sum += (poly[i]-poly[0]).cross(poly[i+1]-poly[0]);
+    return sum.length()*0.5f;
+  }
+};
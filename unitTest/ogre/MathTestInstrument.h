@@ -0,0 +1,81 @@
+#include <cxxtest/TestSuite.h>
+
+#include <StarMath.h>
+
+#include <vector>
+
+class MathTestInstrument : public CxxTest::TestSuite
+{
+public:
+  void setUp()
+  {
+    Star::Instrument::reset();
+    Star::Instrument::setTimersEnabled(false);
+  }
+
+  void testCounters()
+  {
+    using namespace Star::Instrument;
+    TS_ASSERT(isEnabled());
+
+    Star::float4x4 m;
+    m.makeScaling(2, 3, 4);
+    Star::quaternionf q(Star::float3(0, 0, 1), 0.5f);
+    Star::float3 v(1, 2, 3);
+    Star::float4 v4(1, 2, 3, 4);
+    Star::Vec2<float> v2(1, 2);
+
+    Counters before = snapshot();
+    Star::float4x4 p = m*m;
+    p *= m;
+    p = m.inverse();
+    for(size_t i = 0; i < 5; i++)
+      v = q.rotate(v);
+    v.normalize();
+    v4.normalize();
+    v2.normalize();
+    Counters diff = snapshot()-before;
+
+    TS_ASSERT_EQUALS(diff.calls[MATRIX_MULTIPLY], 2u);
+    TS_ASSERT_EQUALS(diff.calls[MATRIX_INVERSE], 1u);
+    TS_ASSERT_EQUALS(diff.calls[QUATERNION_ROTATE], 5u);
+    TS_ASSERT_EQUALS(diff.calls[VEC_NORMALIZE], 3u);
+    for(size_t op = 0; op < NUM_OPERATIONS; op++)
+      TS_ASSERT_EQUALS(diff.nanoseconds[op], 0u);
+    TS_ASSERT_EQUALS(std::string(getName(QUATERNION_ROTATE)), "Quaternion::rotate");
+
+    reset();
+    TS_ASSERT_EQUALS(snapshot().calls[MATRIX_MULTIPLY], 0u);
+  }
+
+  void testTimers()
+  {
+    using namespace Star::Instrument;
+    setTimersEnabled(true);
+    std::vector<Star::float4x4> m(1000);
+    for(size_t i = 0; i < m.size(); i++) {
+      m[i].makeScaling(2, 3, float(i+1));
+      m[i] = m[i].inverse();
+    }
+    setTimersEnabled(false);
+
+    Counters c = snapshot();
+    TS_ASSERT_EQUALS(c.calls[MATRIX_INVERSE], 1000u);
+    TS_ASSERT_LESS_THAN(0u, c.nanoseconds[MATRIX_INVERSE]);
+    TS_ASSERT_EQUALS(c.nanoseconds[MATRIX_MULTIPLY], 0u);
+  }
+
+  void testThreadLocal()
+  {
+    using namespace Star::Instrument;
+    uint64_t maxCalls = 0;
+#pragma omp parallel num_threads(4) reduction(max:maxCalls)
+    {
+      reset();
+      Star::float3 v(1, 2, 3);
+      v.normalize();
+      maxCalls = snapshot().calls[VEC_NORMALIZE];
+    }
+    TS_ASSERT_EQUALS(maxCalls, 1u);
+  }
+};
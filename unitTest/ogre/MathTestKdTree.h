@@ -0,0 +1,112 @@
+#include <cxxtest/TestSuite.h>
+
+#include <StarMath.h>
+
+#include <limits>
+#include <algorithm>
+#include <vector>
+
+#include "RandGen.h"
+
+class MathTestKdTree : public CxxTest::TestSuite
+{
+public:
+  void setUp()
+  {
+    using namespace std;
+    const size_t numPoints = 5000;
+    vector<float> randValues;
+    generate_n(back_inserter(randValues), numPoints*3, FloatRandGen(100.f));
+
+    m_points.clear();
+    for(size_t i = 0; i < numPoints; i++)
+      m_points.push_back(Star::float3(&randValues[i*3]));
+    m_tree.build(m_points);
+  }
+
+  void testEmpty()
+  {
+    Star::kdtreef tree;
+    float dist;
+    TS_ASSERT_EQUALS(tree.nearest(Star::float3(0, 0, 0), dist), Star::kdtreef::NOT_FOUND);
+    std::vector<unsigned int> res;
+    TS_ASSERT_EQUALS(tree.radiusSearch(Star::float3(0, 0, 0), 1.f, res), size_t(0));
+  }
+
+  void testKnn()
+  {
+    const size_t k = 8;
+    unsigned int indices[k];
+    float dists[k];
+    for(size_t q = 0; q < 50; q++)
+    {
+      Star::float3 query(q*2.f, 100.f-q*2.f, q*1.5f);
+      TS_ASSERT_EQUALS(m_tree.knn(query, k, indices, dists), k);
+
+      std::vector<float> ref = sortedDistances(query);
+      for(size_t i = 0; i < k; i++)
+      {
+        TS_ASSERT_EQUALS(dists[i], ref[i]);
+        Star::float3 d = m_points[indices[i]]-query;
+        TS_ASSERT_EQUALS(dists[i], d.dot(d));
+      }
+    }
+  }
+
+  void testRadius()
+  {
+    const float radius = 10.f;
+    for(size_t q = 0; q < 50; q++)
+    {
+      Star::float3 query(q*2.f, q*1.5f, 100.f-q*2.f);
+      std::vector<unsigned int> res;
+      m_tree.radiusSearch(query, radius, res);
+      std::sort(res.begin(), res.end());
+
+      std::vector<unsigned int> ref;
+      for(size_t i = 0; i < m_points.size(); i++)
+      {
+        Star::float3 d = m_points[i]-query;
+        if(d.dot(d) <= radius*radius)
+          ref.push_back(i);
+      }
+      TS_ASSERT(res == ref);
+    }
+  }
+
+  void testBatch()
+  {
+    const size_t k = 4;
+    const size_t numQueries = 200;
+    std::vector<unsigned int> indices(numQueries*k);
+    std::vector<float> dists(numQueries*k);
+    std::vector<size_t> counts(numQueries);
+    m_tree.knnBatch(&m_points[0], numQueries, k, &indices[0], &dists[0], &counts[0]);
+
+    for(size_t q = 0; q < numQueries; q++)
+    {
+      TS_ASSERT_EQUALS(counts[q], k);
+      TS_ASSERT_EQUALS(dists[q*k], 0.f);
+      unsigned int single[k];
+      float singleDists[k];
+      m_tree.knn(m_points[q], k, single, singleDists);
+      TS_ASSERT(std::equal(singleDists, singleDists+k, &dists[q*k]));
+    }
+  }
+
+private:
+  std::vector<float> sortedDistances(const Star::float3& query) const
+  {
+    std::vector<float> dists;
+    for(size_t i = 0; i < m_points.size(); i++)
+    {
+      Star::float3 d = m_points[i]-query;
+      dists.push_back(d.dot(d));
+    }
+    std::sort(dists.begin(), dists.end());
+    return dists;
+  }
+
+  std::vector<Star::float3> m_points;
+  Star::kdtreef m_tree;
+};
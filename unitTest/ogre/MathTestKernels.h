@@ -0,0 +1,319 @@
+#include <cxxtest/TestSuite.h>
+
+#include <StarMath.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "RandGen.h"
+
+class MathTestKernels : public CxxTest::TestSuite
+{
+public:
+  void setUp()
+  {
+    using namespace std;
+    m_isa = Star::Kernels::getIsa();
+
+    vector<float> randValues;
+    generate_n(back_inserter(randValues), NUM_VALUES*12, FloatRandGen(2.f));
+    for(size_t c = 0; c < 4; c++) {
+      m_a[c].resize(NUM_VALUES);
+      m_b[c].resize(NUM_VALUES);
+    }
+    for(size_t c = 0; c < 3; c++)
+      m_v[c].resize(NUM_VALUES);
+    m_t.resize(NUM_VALUES);
+
+    for(size_t i = 0; i < NUM_VALUES; i++) {
+      const float* r = &randValues[i*12];
+      Star::quaternionf a(r[0]-1, r[1]-1, r[2]-1, r[3]-1);
+      Star::quaternionf b(r[4]-1, r[5]-1, r[6]-1, r[7]-1);
+      a.normalize();
+      b.normalize();
+      const float* qa = &a.x;
+      const float* qb = &b.x;
+      for(size_t c = 0; c < 4; c++) {
+        m_a[c][i] = qa[c];
+        m_b[c][i] = qb[c];
+      }
+      for(size_t c = 0; c < 3; c++)
+        m_v[c][i] = (r[8+c]-1)*10;
+      m_t[i] = r[11]/2;
+    }
+  }
+
+  void tearDown()
+  {
+    Star::Kernels::setIsa(m_isa);
+  }
+
+  void testDispatch()
+  {
+    using namespace Star::Kernels;
+    TS_ASSERT(isSupported(ISA_GENERIC));
+    TS_ASSERT(isSupported(getIsa()));
+    TS_ASSERT(!isSupported(NUM_ISAS));
+    TS_ASSERT(!setIsa(NUM_ISAS));
+    TS_ASSERT_EQUALS(std::string(getIsaName(ISA_AVX2)), "avx2");
+
+    for(int isa = ISA_GENERIC; isa < NUM_ISAS; isa++) {
+      TS_ASSERT_EQUALS(setIsa(Isa(isa)), isSupported(Isa(isa)));
+      if(isSupported(Isa(isa)))
+        TS_ASSERT_EQUALS(getIsa(), Isa(isa));
+    }
+  }
+
+  void testQuaternionRotate()
+  {
+    std::vector<float> ref[3], out[3];
+    for(size_t c = 0; c < 3; c++) {
+      ref[c].resize(NUM_VALUES);
+      out[c].resize(NUM_VALUES);
+    }
+    Star::quaternionRotate(getA(), getV(), Star::Vec3SoA<float>(&ref[0][0], &ref[1][0], &ref[2][0]),
+                           NUM_VALUES);
+
+    for(int isa = 0; isa < Star::Kernels::NUM_ISAS; isa++) {
+      if(!Star::Kernels::setIsa(Star::Kernels::Isa(isa)))
+        continue;
+      Star::Kernels::quaternionRotate(getA(), getV(),
+                                      Star::Vec3SoA<float>(&out[0][0], &out[1][0], &out[2][0]),
+                                      NUM_VALUES);
+      for(size_t c = 0; c < 3; c++)
+        TS_ASSERT(near(out[c], ref[c], 1e-5f*10));
+    }
+  }
+
+  void testQuaternionNlerp()
+  {
+    std::vector<float> ref[4], out[4];
+    for(size_t c = 0; c < 4; c++) {
+      ref[c].resize(NUM_VALUES);
+      out[c].resize(NUM_VALUES);
+    }
+    Star::quaternionNlerp(getA(), getB(), &m_t[0],
+                          Star::QuaternionSoA<float>(&ref[0][0], &ref[1][0], &ref[2][0], &ref[3][0]),
+                          NUM_VALUES);
+
+    for(int isa = 0; isa < Star::Kernels::NUM_ISAS; isa++) {
+      if(!Star::Kernels::setIsa(Star::Kernels::Isa(isa)))
+        continue;
+      Star::Kernels::quaternionNlerp(getA(), getB(), &m_t[0],
+                                     Star::QuaternionSoA<float>(&out[0][0], &out[1][0], &out[2][0], &out[3][0]),
+                                     NUM_VALUES);
+      for(size_t c = 0; c < 4; c++)
+        TS_ASSERT(near(out[c], ref[c], 1e-5f));
+    }
+  }
+
+  void testQuaternionToRotationMatrix()
+  {
+    std::vector<float> ref(NUM_VALUES*12), out(NUM_VALUES*12);
+    for(size_t pass = 0; pass < 2; pass++) {
+      //Without then with translations
+      Star::Vec3SoA<const float> t = pass == 0 ? Star::Vec3SoA<const float>() : getV();
+      Star::quaternionToRotationMatrix(getA(), t, &ref[0], NUM_VALUES);
+
+      for(int isa = 0; isa < Star::Kernels::NUM_ISAS; isa++) {
+        if(!Star::Kernels::setIsa(Star::Kernels::Isa(isa)))
+          continue;
+        Star::Kernels::quaternionToRotationMatrix(getA(), t, &out[0], NUM_VALUES);
+        TS_ASSERT(near(out, ref, 1e-5f));
+      }
+    }
+  }
+
+  void testLinearBlendSkin()
+  {
+    const size_t numBones = 32;
+    std::vector<float> palette(numBones*12);
+    Star::quaternionToRotationMatrix(getA(), getV(), &palette[0], numBones);
+
+    std::vector<float> weights[2];
+    std::vector<unsigned int> indices[2];
+    for(size_t b = 0; b < 2; b++) {
+      weights[b].resize(NUM_VALUES);
+      indices[b].resize(NUM_VALUES);
+    }
+    for(size_t i = 0; i < NUM_VALUES; i++) {
+      indices[0][i] = (i*7)%numBones;
+      indices[1][i] = (i*11+3)%numBones;
+      weights[0][i] = m_t[i]*2;
+      weights[1][i] = 1-weights[0][i];
+    }
+    const float* w[2] = { &weights[0][0], &weights[1][0] };
+    const unsigned int* idx[2] = { &indices[0][0], &indices[1][0] };
+    Star::BoneInfluenceSoA<float> influences(w, idx, 2);
+    Star::Vec3SoA<const float> normals(&m_a[0][0], &m_a[1][0], &m_a[2][0]);
+
+    std::vector<float> refPos[3], refNrm[3], outPos[3], outNrm[3];
+    for(size_t c = 0; c < 3; c++) {
+      refPos[c].resize(NUM_VALUES);
+      refNrm[c].resize(NUM_VALUES);
+      outPos[c].resize(NUM_VALUES);
+      outNrm[c].resize(NUM_VALUES);
+    }
+    Star::linearBlendSkin(&palette[0], 12, influences, getV(), normals,
+                          Star::Vec3SoA<float>(&refPos[0][0], &refPos[1][0], &refPos[2][0]),
+                          Star::Vec3SoA<float>(&refNrm[0][0], &refNrm[1][0], &refNrm[2][0]),
+                          NUM_VALUES);
+
+    for(int isa = 0; isa < Star::Kernels::NUM_ISAS; isa++) {
+      if(!Star::Kernels::setIsa(Star::Kernels::Isa(isa)))
+        continue;
+      Star::Kernels::linearBlendSkin(&palette[0], 12, influences, getV(), normals,
+                                     Star::Vec3SoA<float>(&outPos[0][0], &outPos[1][0], &outPos[2][0]),
+                                     Star::Vec3SoA<float>(&outNrm[0][0], &outNrm[1][0], &outNrm[2][0]),
+                                     NUM_VALUES);
+      for(size_t c = 0; c < 3; c++) {
+        TS_ASSERT(near(outPos[c], refPos[c], 1e-5f*20));
+        TS_ASSERT(near(outNrm[c], refNrm[c], 1e-4f));
+      }
+    }
+  }
+
+  void testDualQuaternionSkin()
+  {
+    //Every other bone in the opposite hemisphere, the same transform
+    const size_t numBones = 32;
+    std::vector<Star::dualQuaternionf> bones(numBones);
+    for(size_t b = 0; b < numBones; b++) {
+      Star::quaternionf q(m_b[0][b], m_b[1][b], m_b[2][b], m_b[3][b]);
+      bones[b] = Star::dualQuaternionf(b%2 ? -q : q, Star::float3(m_v[0][b], m_v[1][b], m_v[2][b]));
+    }
+
+    std::vector<float> weights[3];
+    std::vector<unsigned int> indices[3];
+    for(size_t b = 0; b < 3; b++) {
+      weights[b].resize(NUM_VALUES);
+      indices[b].resize(NUM_VALUES);
+    }
+    for(size_t i = 0; i < NUM_VALUES; i++) {
+      indices[0][i] = (i*7)%numBones;
+      indices[1][i] = (i*11+3)%numBones;
+      indices[2][i] = (i*5+1)%numBones;
+      weights[0][i] = m_t[i]*2;
+      weights[1][i] = (1-weights[0][i])*0.75f;
+      weights[2][i] = 1-weights[0][i]-weights[1][i];
+    }
+    const float* w[3] = { &weights[0][0], &weights[1][0], &weights[2][0] };
+    const unsigned int* idx[3] = { &indices[0][0], &indices[1][0], &indices[2][0] };
+    Star::BoneInfluenceSoA<float> influences(w, idx, 3);
+    Star::Vec3SoA<const float> normals(&m_a[0][0], &m_a[1][0], &m_a[2][0]);
+
+    std::vector<float> refPos[3], refNrm[3], outPos[3], outNrm[3];
+    for(size_t c = 0; c < 3; c++) {
+      refPos[c].resize(NUM_VALUES);
+      refNrm[c].resize(NUM_VALUES);
+      outPos[c].resize(NUM_VALUES);
+      outNrm[c].resize(NUM_VALUES);
+    }
+    Star::dualQuaternionSkin(&bones[0], influences, getV(), normals,
+                             Star::Vec3SoA<float>(&refPos[0][0], &refPos[1][0], &refPos[2][0]),
+                             Star::Vec3SoA<float>(&refNrm[0][0], &refNrm[1][0], &refNrm[2][0]),
+                             NUM_VALUES);
+
+    for(int isa = 0; isa < Star::Kernels::NUM_ISAS; isa++) {
+      if(!Star::Kernels::setIsa(Star::Kernels::Isa(isa)))
+        continue;
+      Star::Kernels::dualQuaternionSkin(&bones[0], influences, getV(), normals,
+                                        Star::Vec3SoA<float>(&outPos[0][0], &outPos[1][0], &outPos[2][0]),
+                                        Star::Vec3SoA<float>(&outNrm[0][0], &outNrm[1][0], &outNrm[2][0]),
+                                        NUM_VALUES);
+      for(size_t c = 0; c < 3; c++) {
+        TS_ASSERT(near(outPos[c], refPos[c], 1e-5f*40));
+        TS_ASSERT(near(outNrm[c], refNrm[c], 1e-5f*4));
+      }
+    }
+  }
+
+  void testMatrixInverse()
+  {
+    //Well conditioned, except a few singular ones
+    FloatRandGen rand(2.f);
+    std::vector<Star::float4x4> m(NUM_VALUES);
+    for(size_t n = 0; n < NUM_VALUES; n++) {
+      for(size_t i = 0; i < 16; i++)
+        m[n].ptr()[i] = rand()-1;
+      for(size_t i = 0; i < 4; i++)
+        m[n](i, i) += 4;
+    }
+    for(size_t i = 0; i < 16; i++)
+      m[5].ptr()[i] = 0;
+    for(size_t i = 0; i < 4; i++)
+      m[NUM_VALUES-1](i, 2) = 0;
+    m[100](2, 0) = std::numeric_limits<float>::infinity();
+    //A normal determinant, 1e-9, but 1/1e-39 overflows
+    m[200].toIdentity();
+    m[200](0, 0) = 1e-39f;
+    m[200](1, 1) = 1e30f;
+
+    std::vector<Star::float4x4> ref(NUM_VALUES), out(NUM_VALUES);
+    std::vector<float> refDet(NUM_VALUES), det(NUM_VALUES);
+    bool refSingular[NUM_VALUES], singular[NUM_VALUES];
+    Star::matrixInverse(&m[0], &ref[0], &refDet[0], refSingular, NUM_VALUES);
+    TS_ASSERT(refSingular[5] && refSingular[100] && refSingular[200] && refSingular[NUM_VALUES-1]);
+    TS_ASSERT_EQUALS(std::count(refSingular, refSingular+NUM_VALUES, true), 4);
+    TS_ASSERT(near(ref[200], ref[5], 0.f));
+
+    for(int isa = 0; isa < Star::Kernels::NUM_ISAS; isa++) {
+      if(!Star::Kernels::setIsa(Star::Kernels::Isa(isa)))
+        continue;
+      Star::Kernels::matrixInverse(&m[0], &out[0], &det[0], singular, NUM_VALUES);
+      for(size_t n = 0; n < NUM_VALUES; n++) {
+        TS_ASSERT_EQUALS(singular[n], refSingular[n]);
+        if(!refSingular[n])
+          TS_ASSERT_DELTA(det[n], refDet[n], 1e-5f*std::abs(refDet[n]));
+        TS_ASSERT(near(out[n], ref[n], 1e-5f));
+      }
+
+      //In place, without the optional outputs
+      std::vector<Star::float4x4> inPlace = m;
+      Star::Kernels::matrixInverse(&inPlace[0], &inPlace[0], 0, 0, NUM_VALUES);
+      for(size_t n = 0; n < NUM_VALUES; n++)
+        TS_ASSERT(near(inPlace[n], ref[n], 1e-5f));
+    }
+  }
+
+private:
+  //Not a multiple of the vector width, so the kernels have a remainder
+  static const size_t NUM_VALUES = 1003;
+
+  static bool near(const std::vector<float>& a, const std::vector<float>& b, float tolerance)
+  {
+    for(size_t i = 0; i < a.size(); i++)
+      if(!(std::fabs(a[i]-b[i]) <= tolerance))
+        return false;
+    return true;
+  }
+
+  static bool near(const Star::float4x4& a, const Star::float4x4& b, float tolerance)
+  {
+    for(size_t i = 0; i < 16; i++)
+      if(!(std::fabs(a.constPtr()[i]-b.constPtr()[i]) <= tolerance))
+        return false;
+    return true;
+  }
+
+  Star::QuaternionSoA<const float> getA() const
+  {
+    return Star::QuaternionSoA<const float>(&m_a[0][0], &m_a[1][0], &m_a[2][0], &m_a[3][0]);
+  }
+
+  Star::QuaternionSoA<const float> getB() const
+  {
+    return Star::QuaternionSoA<const float>(&m_b[0][0], &m_b[1][0], &m_b[2][0], &m_b[3][0]);
+  }
+
+  Star::Vec3SoA<const float> getV() const
+  {
+    return Star::Vec3SoA<const float>(&m_v[0][0], &m_v[1][0], &m_v[2][0]);
+  }
+
+  Star::Kernels::Isa m_isa;
+  std::vector<float> m_a[4], m_b[4], m_v[3], m_t;
+};
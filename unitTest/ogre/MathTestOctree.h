@@ -0,0 +1,194 @@
+#include <cxxtest/TestSuite.h>
+
+#include <StarMath.h>
+
+#include <limits>
+#include <algorithm>
+#include <vector>
+
+#include "RandGen.h"
+
+class MathTestOctree : public CxxTest::TestSuite
+{
+public:
+  void setUp()
+  {
+    using namespace std;
+    const size_t numPoints = 20000;
+    vector<float> randValues;
+    generate_n(back_inserter(randValues), numPoints*3, FloatRandGen(100.f));
+
+    m_points.clear();
+    for(size_t i = 0; i < numPoints; i++)
+      m_points.push_back(Star::float3(&randValues[i*3]));
+  }
+
+  void testMorton()
+  {
+    uint32_t x, y, z;
+    uint64_t code = Star::mortonEncode3(0x1fffff, 5, 1234);
+    Star::mortonDecode3(code, x, y, z);
+    TS_ASSERT_EQUALS(x, 0x1fffffu);
+    TS_ASSERT_EQUALS(y, 5u);
+    TS_ASSERT_EQUALS(z, 1234u);
+    TS_ASSERT_EQUALS(Star::mortonEncode3(1, 1, 1), uint64_t(7));
+  }
+
+  void testBuildPoints()
+  {
+    Star::octreef tree(domain(), 8, 8);
+    tree.build(&m_points[0], m_points.size());
+    TS_ASSERT_EQUALS(tree.getNumItems(), m_points.size());
+    checkQueries(tree);
+
+    //Every point ends in the leaf of its cell
+    unsigned int numLeafItems = 0;
+    for(size_t i = 0; i < tree.getNumNodes(); i++)
+    {
+      const Star::octreef::Node& node = tree.getNode(i);
+      if(node.firstChild)
+        continue;
+      TS_ASSERT_EQUALS(tree.findNode(node.key), i);
+      numLeafItems += node.numItems;
+    }
+    TS_ASSERT_EQUALS(numLeafItems, m_points.size());
+  }
+
+  void testFlatDomain()
+  {
+    //Points on the z = 50 plane, the domain has no depth
+    std::vector<Star::float3> points(m_points);
+    for(size_t i = 0; i < points.size(); i++)
+      points[i].z = 50;
+    Star::octreef tree(Star::boxf(Star::float3(0, 0, 50), Star::float3(100, 100, 50)), 8, 8);
+    TS_ASSERT_EQUALS(tree.getDomain().getSize(), Star::float3(100, 100, 100));
+    tree.build(&points[0], points.size());
+    TS_ASSERT_EQUALS(tree.getNumItems(), points.size());
+
+    std::vector<unsigned int> items, ref;
+    Star::boxf query(Star::float3(10, 20, 40), Star::float3(40, 35, 60));
+    tree.queryBox(query, items);
+    std::sort(items.begin(), items.end());
+    for(size_t i = 0; i < points.size(); i++)
+      if(overlaps(Star::boxf(points[i], points[i]), query))
+        ref.push_back(i);
+    TS_ASSERT(!ref.empty());
+    TS_ASSERT(items == ref);
+
+    //A single point
+    Star::octreef point(Star::boxf(Star::float3(1, 2, 3), Star::float3(1, 2, 3)));
+    TS_ASSERT_EQUALS(point.getDomain().getSize(), Star::float3(1, 1, 1));
+    TS_ASSERT_EQUALS(point.insert(Star::float3(1, 2, 3)), 0u);
+    point.queryBox(Star::boxf(Star::float3(0, 0, 0), Star::float3(5, 5, 5)), items);
+    TS_ASSERT_EQUALS(items.size(), 1u);
+  }
+
+  void testInsertRemove()
+  {
+    Star::octreef tree(domain(), 8, 8);
+    for(size_t i = 0; i < m_points.size(); i++)
+      TS_ASSERT_EQUALS(tree.insert(m_points[i]), i);
+    checkQueries(tree);
+
+    for(size_t i = 0; i < m_points.size(); i += 2)
+      TS_ASSERT(tree.remove(i));
+    TS_ASSERT(!tree.remove(0));
+    TS_ASSERT_EQUALS(tree.getNumItems(), m_points.size()/2);
+
+    std::vector<unsigned int> items;
+    tree.queryBox(domain(), items);
+    TS_ASSERT_EQUALS(items.size(), m_points.size()/2);
+    for(size_t i = 0; i < items.size(); i++)
+      TS_ASSERT(items[i] % 2 == 1);
+
+    for(size_t i = 1; i < m_points.size(); i += 2)
+      TS_ASSERT(tree.remove(i));
+    TS_ASSERT_EQUALS(tree.getNumItems(), size_t(0));
+    TS_ASSERT_EQUALS(tree.getNode(0).firstChild, 0u);
+  }
+
+  void testBoxes()
+  {
+    std::vector<Star::boxf> boxes;
+    for(size_t i = 0; i < m_points.size(); i++)
+    {
+      Star::float3 size(i%7*0.5f, i%5*0.5f, i%3*0.5f);
+      boxes.push_back(Star::boxf(m_points[i]-size, m_points[i]+size));
+    }
+
+    Star::octreef tree(domain(), 4, 10);
+    tree.build(&boxes[0], boxes.size());
+
+    Star::boxf query(Star::float3(20, 30, 40), Star::float3(35, 50, 45));
+    std::vector<unsigned int> items;
+    tree.queryBox(query, items);
+    std::sort(items.begin(), items.end());
+
+    std::vector<unsigned int> ref;
+    for(size_t i = 0; i < boxes.size(); i++)
+    {
+      if(overlaps(boxes[i], query))
+        ref.push_back(i);
+    }
+    TS_ASSERT(items == ref);
+  }
+
+private:
+  static Star::boxf domain()
+  {
+    return Star::boxf(Star::float3(0, 0, 0), Star::float3(100, 100, 100));
+  }
+
+  static bool overlaps(const Star::boxf& a, const Star::boxf& b)
+  {
+    for(size_t i = 0; i < 3; i++)
+    {
+      if(a.getMin()[i] > b.getMax()[i] || a.getMax()[i] < b.getMin()[i])
+        return false;
+    }
+    return true;
+  }
+
+  void checkQueries(const Star::octreef& tree)
+  {
+    std::vector<unsigned int> items;
+    std::vector<unsigned int> ref;
+
+    Star::boxf query(Star::float3(10, 20, 30), Star::float3(40, 35, 60));
+    tree.queryBox(query, items);
+    std::sort(items.begin(), items.end());
+    for(size_t i = 0; i < m_points.size(); i++)
+    {
+      if(overlaps(Star::boxf(m_points[i], m_points[i]), query))
+        ref.push_back(i);
+    }
+    TS_ASSERT(items == ref);
+
+    Star::float3 center(50, 40, 30);
+    tree.querySphere(center, 15.f, items);
+    std::sort(items.begin(), items.end());
+    ref.clear();
+    for(size_t i = 0; i < m_points.size(); i++)
+    {
+      Star::float3 d = m_points[i]-center;
+      if(d.dot(d) <= 15.f*15.f)
+        ref.push_back(i);
+    }
+    TS_ASSERT(items == ref);
+
+    //Slab 20 <= x <= 60
+    Star::planef planes[2] = { Star::planef(Star::float3(1, 0, 0), Star::float3(20, 0, 0)),
+                               Star::planef(Star::float3(-1, 0, 0), Star::float3(60, 0, 0)) };
+    tree.queryFrustum(planes, 2, items);
+    std::sort(items.begin(), items.end());
+    ref.clear();
+    for(size_t i = 0; i < m_points.size(); i++)
+    {
+      if(m_points[i].x >= 20 && m_points[i].x <= 60)
+        ref.push_back(i);
+    }
+    TS_ASSERT(items == ref);
+  }
+
+  std::vector<Star::float3> m_points;
+};
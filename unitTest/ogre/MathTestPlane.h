@@ -31,6 +31,67 @@ public:
     }
   }
 
+  void testDistance()
+  {
+    Star::planef plane(Star::float3(0, 0, 1), Star::float3(5, 5, 2));
+    TS_ASSERT_DELTA(plane.distance(Star::float3(1, 2, 5)), 3.f, std::numeric_limits<float>::epsilon());
+    TS_ASSERT_DELTA(plane.distance(Star::float3(1, 2, -1)), -3.f, std::numeric_limits<float>::epsilon());
+    TS_ASSERT(plane.project(Star::float3(1, 2, 5)) == Star::float3(1, 2, 2));
+    TS_ASSERT_EQUALS(plane.classify(Star::float3(1, 2, 5), 0.1f), Star::planef::FRONT);
+    TS_ASSERT_EQUALS(plane.classify(Star::float3(1, 2, 1), 0.1f), Star::planef::BACK);
+    TS_ASSERT_EQUALS(plane.classify(Star::float3(1, 2, 2.05f), 0.1f), Star::planef::ON);
+  }
+
+  void testBatch()
+  {
+    using namespace std;
+    const size_t numPoints = 1000;
+    vector<float> x, y, z;
+    generate_n(back_inserter(x), numPoints, FloatRandGen(10.f));
+    generate_n(back_inserter(y), numPoints, FloatRandGen(10.f));
+    generate_n(back_inserter(z), numPoints, FloatRandGen(10.f));
+    vector<Star::float3> points;
+    for(size_t i = 0; i < numPoints; i++)
+      points.push_back(Star::float3(x[i], y[i], z[i]));
+    Star::Vec3SoA<const float> soa(&x[0], &y[0], &z[0]);
+
+    Star::float3 normal(1, 2, 3);
+    normal.normalize();
+    Star::planef planes[3] = { Star::planef(normal, Star::float3(5, 5, 5)),
+                               Star::planef(Star::float3(1, 0, 0), Star::float3(3, 0, 0)),
+                               Star::planef(Star::float3(0, -1, 0), Star::float3(0, 6, 0)) };
+    const float eps = 0.5f;
+
+    vector<float> dists(numPoints), soaDists(numPoints);
+    vector<unsigned char> sides(numPoints), soaSides(numPoints);
+    Star::planeDistances(planes[0], &points[0], numPoints, &dists[0]);
+    Star::planeDistances(planes[0], soa, numPoints, &soaDists[0]);
+    Star::planeClassify(planes[0], &points[0], numPoints, eps, &sides[0]);
+    Star::planeClassify(planes[0], soa, numPoints, eps, &soaSides[0]);
+
+    vector<float> px(numPoints), py(numPoints), pz(numPoints);
+    Star::planeProject(planes[0], soa, numPoints, Star::Vec3SoA<float>(&px[0], &py[0], &pz[0]));
+
+    vector<uint32_t> backMasks(numPoints), frontMasks(numPoints);
+    Star::planesClassify(planes, 3, soa, numPoints, eps, &backMasks[0], &frontMasks[0]);
+
+    for(size_t i = 0; i < numPoints; i++)
+    {
+      TS_ASSERT_DELTA(dists[i], planes[0].distance(points[i]), 1e-5f);
+      TS_ASSERT_EQUALS(dists[i], soaDists[i]);
+      TS_ASSERT_EQUALS(sides[i], planes[0].classify(points[i], eps));
+      TS_ASSERT_EQUALS(soaSides[i], sides[i]);
+      TS_ASSERT_DELTA(planes[0].distance(Star::float3(px[i], py[i], pz[i])), 0.f, 1e-5f);
+
+      for(size_t p = 0; p < 3; p++)
+      {
+        Star::planef::Side side = planes[p].classify(points[i], eps);
+        TS_ASSERT_EQUALS((backMasks[i] >> p) & 1, uint32_t(side == Star::planef::BACK));
+        TS_ASSERT_EQUALS((frontMasks[i] >> p) & 1, uint32_t(side == Star::planef::FRONT));
+      }
+    }
+  }
+
 
 private:
   /*****************************************************************************/
@@ -0,0 +1,145 @@
+#include <cxxtest/TestSuite.h>
+
+#include <StarMath.h>
+#include <StarMath/StarStream.h>
+
+#include <cfloat>
+
+#include "RandGen.h"
+
+class MathTestPrecision : public CxxTest::TestSuite
+{
+public:
+  void setUp()
+  {
+    FloatRandGen rand(2.f);
+    for(size_t i = 0; i < 16; i++) {
+      m_a.ptr()[i] = rand()-1;
+      m_b.ptr()[i] = rand()-1;
+    }
+    //Well conditioned, so float and double inverses stay close
+    for(size_t i = 0; i < 4; i++)
+      m_a(i, i) += 4;
+    m_u = Star::float3(rand()-1, rand()-1, rand()-1);
+    m_v = Star::float3(rand()-1, rand()-1, rand()-1);
+    m_q = Star::quaternionf(rand()-1, rand()-1, rand()-1, rand()-1);
+    m_r = Star::quaternionf(rand()-1, rand()-1, rand()-1, rand()-1);
+  }
+
+  void testStrict()
+  {
+    //Same bits as the plain expressions, unless the compiler evaluates
+    //them with more precision (x87)
+    if(FLT_EVAL_METHOD != 0)
+      return;
+
+    const Star::float3& u = m_u;
+    const Star::float3& v = m_v;
+    TS_ASSERT_EQUALS(u.dot<Star::PRECISION_STRICT>(v), u.x*v.x+u.y*v.y+u.z*v.z);
+    const Star::float3 c = u.cross<Star::PRECISION_STRICT>(v);
+    TS_ASSERT_EQUALS(c.x, u.y*v.z-u.z*v.y);
+    TS_ASSERT_EQUALS(c.y, u.z*v.x-u.x*v.z);
+    TS_ASSERT_EQUALS(c.z, u.x*v.y-u.y*v.x);
+
+    const Star::quaternionf& q = m_q;
+    const Star::quaternionf& r = m_r;
+    const Star::quaternionf qr = q.operator *<Star::PRECISION_STRICT>(r);
+    TS_ASSERT_EQUALS(qr.x, q.w*r.x + q.x*r.w + q.y*r.z - q.z*r.y);
+    TS_ASSERT_EQUALS(qr.w, q.w*r.w - q.x*r.x - q.y*r.y - q.z*r.z);
+
+    const Star::float4x4& a = m_a;
+    const Star::float4x4& b = m_b;
+    const Star::float4x4 ab = a.operator *<Star::PRECISION_STRICT>(b);
+    for(size_t j = 0; j < 4; j++)
+      for(size_t k = 0; k < 4; k++)
+        TS_ASSERT_EQUALS(ab(j, k), a(j, 0)*b(0, k)+a(j, 1)*b(1, k)+a(j, 2)*b(2, k)+a(j, 3)*b(3, k));
+
+    const float minor = a(1, 1)*(a(2, 2)*a(3, 3)-a(2, 3)*a(3, 2))-
+                        a(1, 2)*(a(2, 1)*a(3, 3)-a(3, 1)*a(2, 3))+
+                        a(1, 3)*(a(2, 1)*a(3, 2)-a(3, 1)*a(2, 2));
+    TS_ASSERT_EQUALS((a.minor4<Star::PRECISION_STRICT>(1, 2, 3, 1, 2, 3)), minor);
+  }
+
+  void testFma()
+  {
+    const Star::float3& u = m_u;
+    const Star::float3& v = m_v;
+    const float dot = u.dot<Star::PRECISION_FMA>(v);
+#ifdef STAR_HAS_FMA
+    TS_ASSERT_EQUALS(dot, std::fma(u.z, v.z, std::fma(u.y, v.y, u.x*v.x)));
+#else
+    TS_ASSERT_EQUALS(dot, u.dot<Star::PRECISION_STRICT>(v));
+#endif
+
+    //Within a few ulps of the double results
+    checkPolicy<Star::PRECISION_FMA>(1e-5);
+  }
+
+  void testFast()
+  {
+    for(float x = 0.01f; x < 1000; x *= 1.7f) {
+      TS_ASSERT_DELTA(Star::reciprocal<Star::PRECISION_FAST>(x), 1/x, 1e-6/x);
+      TS_ASSERT_DELTA(Star::reciprocalSqrt<Star::PRECISION_FAST>(x), 1/std::sqrt(x), 1e-6/std::sqrt(x));
+    }
+    //Exact for double
+    TS_ASSERT_EQUALS(Star::reciprocal<Star::PRECISION_FAST>(3.), 1/3.);
+
+    Star::float3 n = m_u;
+    const float len = n.normalize<Star::PRECISION_FAST>();
+    TS_ASSERT_DELTA(len, m_u.length(), 1e-5);
+    TS_ASSERT_DELTA(n.length(), 1, 1e-5);
+
+    Star::quaternionf q = m_q;
+    q.normalize<Star::PRECISION_FAST>();
+    TS_ASSERT_DELTA(q.length(), 1, 1e-5);
+
+    checkPolicy<Star::PRECISION_FAST>(1e-4);
+  }
+
+  void testDefault()
+  {
+    //The operators and members without a policy use STARMATH_PRECISION
+    TS_ASSERT_EQUALS(m_u.dot(m_v), m_u.dot<STARMATH_PRECISION>(m_v));
+    TS_ASSERT_EQUALS(m_a*m_b, m_a.operator *<STARMATH_PRECISION>(m_b));
+    TS_ASSERT_EQUALS(m_a.inverse(), m_a.inverse<STARMATH_PRECISION>());
+  }
+
+private:
+  /**
+   * Check the policy P against the same computations in double.
+   */
+  template <Star::Precision P>
+  void checkPolicy(double delta)
+  {
+    Star::double4x4 a, b;
+    for(size_t i = 0; i < 16; i++) {
+      a.ptr()[i] = m_a.constPtr()[i];
+      b.ptr()[i] = m_b.constPtr()[i];
+    }
+
+    const Star::float4x4 ab = m_a.operator *<P>(m_b);
+    const Star::double4x4 dab = a*b;
+    float det;
+    const Star::float4x4 inv = m_a.inverse<P>(det);
+    double ddet;
+    const Star::double4x4 dinv = a.inverse(ddet);
+    TS_ASSERT_DELTA(det, ddet, delta*std::abs(ddet));
+    for(size_t i = 0; i < 16; i++) {
+      TS_ASSERT_DELTA(ab.constPtr()[i], dab.constPtr()[i], delta);
+      TS_ASSERT_DELTA(inv.constPtr()[i], dinv.constPtr()[i], delta*std::abs(dinv.constPtr()[i])+delta);
+    }
+
+    const Star::float3 c = m_u.cross<P>(m_v);
+    const Star::double3 dc = Star::double3(m_u).cross(Star::double3(m_v));
+    const Star::float3 rotated = m_q.rotate<P>(m_u);
+    const Star::double3 drotated = Star::quaterniond(m_q.x, m_q.y, m_q.z, m_q.w).rotate(Star::double3(m_u));
+    for(size_t i = 0; i < 3; i++) {
+      TS_ASSERT_DELTA(c[i], dc[i], delta);
+      TS_ASSERT_DELTA(rotated[i], drotated[i], delta);
+    }
+  }
+
+  Star::float4x4 m_a, m_b;
+  Star::float3 m_u, m_v;
+  Star::quaternionf m_q, m_r;
+};
@@ -0,0 +1,367 @@
+#include <cxxtest/TestSuite.h>
+
+#include <StarMath.h>
+
+#include <limits>
+#include <algorithm>
+#include <vector>
+
+#include "RandGen.h"
+
+class MathTestQuaternionBatch : public CxxTest::TestSuite
+{
+public:
+  void setUp()
+  {
+    using namespace std;
+    vector<float> randValues;
+    generate_n(back_inserter(randValues), NUM_QUAT*9, FloatRandGen(2.f));
+
+    m_a.clear();
+    m_b.clear();
+    m_t.clear();
+    for(size_t i = 0; i < NUM_QUAT; i++)
+    {
+      Star::quaternionf a(randValues[i*9]-1, randValues[i*9+1]-1, randValues[i*9+2]-1, randValues[i*9+3]-1);
+      Star::quaternionf b(randValues[i*9+4]-1, randValues[i*9+5]-1, randValues[i*9+6]-1, randValues[i*9+7]-1);
+      a.normalize();
+      b.normalize();
+      m_a.push_back(a);
+      m_b.push_back(b);
+      m_t.push_back(randValues[i*9+8]/2);
+    }
+    //Nearly identical and opposite quaternions
+    m_b[0] = m_a[0];
+    m_b[1] = -m_a[1];
+    m_b[2] = Star::quaternionf(m_a[2].x+1e-4f, m_a[2].y, m_a[2].z, m_a[2].w);
+    m_b[2].normalize();
+  }
+
+  void testSlerp()
+  {
+    Star::quaternionf a(Star::float3(0, 0, 1), 0.f);
+    Star::quaternionf b(Star::float3(0, 0, 1), 1.f);
+    TS_ASSERT(Star::quaternionf::slerp(a, b, 0.25f) == Star::quaternionf(Star::float3(0, 0, 1), 0.25f));
+    TS_ASSERT(Star::quaternionf::slerp(a, -b, 0.25f) == Star::quaternionf(Star::float3(0, 0, 1), 0.25f));
+    TS_ASSERT(Star::quaternionf::slerp(a, b, 0.f) == a);
+    TS_ASSERT(Star::quaternionf::slerp(a, b, 1.f) == b);
+
+    for(size_t i = 0; i < NUM_QUAT; i++)
+    {
+      Star::quaternionf ref = Star::quaternionf::slerp(m_a[i], m_b[i], m_t[i]);
+      TS_ASSERT_DELTA(ref.length(), 1.f, 1e-5f);
+      TS_ASSERT_LESS_THAN(angle(ref, Star::quaternionf::slerpFast(m_a[i], m_b[i], m_t[i])), 1e-3f);
+      TS_ASSERT_LESS_THAN(angle(ref, Star::quaternionf::nlerp(m_a[i], m_b[i], m_t[i])), 0.2f);
+    }
+  }
+
+  void testSlerpBatch()
+  {
+    std::vector<float> a[4], b[4], out[4];
+    toSoA(m_a, a);
+    toSoA(m_b, b);
+    for(size_t c = 0; c < 4; c++)
+      out[c].resize(NUM_QUAT);
+    Star::QuaternionSoA<const float> sa(&a[0][0], &a[1][0], &a[2][0], &a[3][0]);
+    Star::QuaternionSoA<const float> sb(&b[0][0], &b[1][0], &b[2][0], &b[3][0]);
+    Star::QuaternionSoA<float> so(&out[0][0], &out[1][0], &out[2][0], &out[3][0]);
+    std::vector<Star::quaternionf> aos(NUM_QUAT);
+
+    Star::quaternionSlerp(sa, sb, &m_t[0], so, NUM_QUAT);
+    Star::quaternionSlerp(&m_a[0], &m_b[0], &m_t[0], &aos[0], NUM_QUAT);
+    for(size_t i = 0; i < NUM_QUAT; i++)
+    {
+      Star::quaternionf ref = Star::quaternionf::slerp(m_a[i], m_b[i], m_t[i]);
+      TS_ASSERT_LESS_THAN(angle(ref, at(out, i)), 1e-5f);
+      TS_ASSERT(aos[i] == ref);
+    }
+
+    Star::quaternionSlerpFast(sa, sb, &m_t[0], so, NUM_QUAT);
+    Star::quaternionSlerpFast(&m_a[0], &m_b[0], &m_t[0], &aos[0], NUM_QUAT);
+    for(size_t i = 0; i < NUM_QUAT; i++)
+    {
+      Star::quaternionf ref = Star::quaternionf::slerpFast(m_a[i], m_b[i], m_t[i]);
+      TS_ASSERT_LESS_THAN(angle(ref, at(out, i)), 1e-5f);
+      TS_ASSERT(aos[i] == ref);
+    }
+
+    Star::quaternionNlerp(sa, sb, &m_t[0], so, NUM_QUAT);
+    Star::quaternionNlerp(&m_a[0], &m_b[0], &m_t[0], &aos[0], NUM_QUAT);
+    for(size_t i = 0; i < NUM_QUAT; i++)
+    {
+      Star::quaternionf ref = Star::quaternionf::nlerp(m_a[i], m_b[i], m_t[i]);
+      TS_ASSERT_LESS_THAN(angle(ref, at(out, i)), 1e-5f);
+      TS_ASSERT(aos[i] == ref);
+    }
+  }
+
+  void testRotate()
+  {
+    std::vector<Star::float3> v(NUM_QUAT);
+    for(size_t i = 0; i < NUM_QUAT; i++)
+      v[i] = Star::float3(m_b[i].x, m_b[i].y, m_b[i].z)*10.f;
+
+    //Reference is q*v*q^-1
+    std::vector<Star::float3> ref(NUM_QUAT), ref0(NUM_QUAT);
+    for(size_t i = 0; i < NUM_QUAT; i++) {
+      Star::quaternionf p(v[i].x, v[i].y, v[i].z, 0);
+      p = m_a[i]*p*m_a[i].conjugate();
+      ref[i] = Star::float3(p.x, p.y, p.z);
+      p = Star::quaternionf(v[i].x, v[i].y, v[i].z, 0);
+      p = m_a[0]*p*m_a[0].conjugate();
+      ref0[i] = Star::float3(p.x, p.y, p.z);
+      TS_ASSERT_DELTA((m_a[i].rotate(v[i])-ref[i]).length(), 0.f, 1e-5f);
+    }
+
+    std::vector<Star::float3> aos(NUM_QUAT);
+    Star::quaternionRotate(&m_a[0], &v[0], &aos[0], NUM_QUAT);
+    for(size_t i = 0; i < NUM_QUAT; i++)
+      TS_ASSERT_DELTA((aos[i]-ref[i]).length(), 0.f, 1e-5f);
+    Star::quaternionRotate(m_a[0], &v[0], &aos[0], NUM_QUAT);
+    for(size_t i = 0; i < NUM_QUAT; i++)
+      TS_ASSERT_DELTA((aos[i]-ref0[i]).length(), 0.f, 1e-5f);
+
+    std::vector<float> q[4], in[3], out[3];
+    toSoA(m_a, q);
+    for(size_t c = 0; c < 3; c++) {
+      in[c].resize(NUM_QUAT);
+      out[c].resize(NUM_QUAT);
+      for(size_t i = 0; i < NUM_QUAT; i++)
+        in[c][i] = v[i][c];
+    }
+    Star::QuaternionSoA<const float> sq(&q[0][0], &q[1][0], &q[2][0], &q[3][0]);
+    Star::Vec3SoA<const float> sin(&in[0][0], &in[1][0], &in[2][0]);
+    Star::Vec3SoA<float> sout(&out[0][0], &out[1][0], &out[2][0]);
+    Star::quaternionRotate(sq, sin, sout, NUM_QUAT);
+    for(size_t i = 0; i < NUM_QUAT; i++)
+      TS_ASSERT_DELTA((Star::float3(out[0][i], out[1][i], out[2][i])-ref[i]).length(), 0.f, 1e-5f);
+    Star::quaternionRotate(m_a[0], sin, sout, NUM_QUAT);
+    for(size_t i = 0; i < NUM_QUAT; i++)
+      TS_ASSERT_DELTA((Star::float3(out[0][i], out[1][i], out[2][i])-ref0[i]).length(), 0.f, 1e-5f);
+  }
+
+  void testRotationMatrix()
+  {
+    //Half turns exercise every branch of fromRotationMatrix
+    std::vector<Star::quaternionf> q(m_a);
+    q[3] = Star::quaternionf(1, 0, 0, 0);
+    q[4] = Star::quaternionf(0, 1, 0, 0);
+    q[5] = Star::quaternionf(0, 0, 1, 0);
+    q[6] = Star::quaternionf(0.6f, 0, 0.8f, 0);
+
+    std::vector<Star::float4x4> mat(NUM_QUAT);
+    std::vector<Star::float3> t(NUM_QUAT);
+    for(size_t i = 0; i < NUM_QUAT; i++) {
+      q[i].toRotationMatrix(mat[i]);
+      t[i] = Star::float3(m_b[i].x, m_b[i].y, m_b[i].z);
+      Star::quaternionf r;
+      r.fromRotationMatrix(mat[i]);
+      TS_ASSERT_LESS_THAN(angle(r, q[i]), 1e-3f);
+      TS_ASSERT_DELTA(r.length(), 1.f, 1e-5f);
+    }
+
+    std::vector<float> affine(NUM_QUAT*12), affineSoA(NUM_QUAT*12);
+    Star::quaternionToRotationMatrix(&q[0], &t[0], &affine[0], NUM_QUAT);
+    std::vector<float> sq[4];
+    toSoA(q, sq);
+    Star::quaternionToRotationMatrix(Star::QuaternionSoA<const float>(&sq[0][0], &sq[1][0], &sq[2][0], &sq[3][0]),
+                                     Star::Vec3SoA<const float>(), &affineSoA[0], NUM_QUAT);
+    for(size_t i = 0; i < NUM_QUAT; i++) {
+      for(size_t r = 0; r < 3; r++) {
+        for(size_t c = 0; c < 3; c++) {
+          TS_ASSERT_DELTA(affine[i*12+r*4+c], mat[i](r, c), 1e-6f);
+          TS_ASSERT_DELTA(affineSoA[i*12+r*4+c], mat[i](r, c), 1e-6f);
+        }
+        TS_ASSERT_EQUALS(affine[i*12+r*4+3], t[i][r]);
+        TS_ASSERT_EQUALS(affineSoA[i*12+r*4+3], 0.f);
+      }
+    }
+
+    std::vector<Star::quaternionf> res(NUM_QUAT);
+    std::vector<float> out[4];
+    for(size_t c = 0; c < 4; c++)
+      out[c].resize(NUM_QUAT);
+    Star::quaternionFromRotationMatrix(&affine[0], &res[0], NUM_QUAT);
+    Star::quaternionFromRotationMatrix(mat[0].ptr(), Star::QuaternionSoA<float>(&out[0][0], &out[1][0], &out[2][0], &out[3][0]),
+                                       NUM_QUAT, 16);
+    for(size_t i = 0; i < NUM_QUAT; i++) {
+      Star::quaternionf ref;
+      ref.fromRotationMatrix(mat[i]);
+      TS_ASSERT_LESS_THAN(angle(res[i], ref), 1e-3f);
+      TS_ASSERT(at(out, i) == ref);
+    }
+  }
+
+  void testRotationMatrixDouble()
+  {
+    Star::quaterniond q(0.1, -0.7, 0.3, 0.2);
+    q.normalize();
+    Star::double4x4 m;
+    q.toRotationMatrix(m);
+    Star::double4x4 identity = m*m.transpose();
+    for(size_t r = 0; r < 4; r++)
+      for(size_t c = 0; c < 4; c++)
+        TS_ASSERT_DELTA(identity(r, c), r == c ? 1. : 0., 1e-14);
+
+    Star::quaterniond r;
+    r.fromRotationMatrix(m);
+    TS_ASSERT_DELTA(std::abs(r.dot(q)), 1., 1e-14);
+  }
+
+  void testCodec()
+  {
+    //Ties between the largest components are the hard cases
+    std::vector<Star::quaternionf> q(m_a);
+    q[0] = Star::quaternionf(0.5f, 0.5f, -0.5f, 0.5f);
+    q[1] = Star::quaternionf(0, 0, 0, 1);
+    q[2] = Star::quaternionf(0, -1, 0, 0);
+    for(size_t i = 3; i < NUM_QUAT; i += 4) {
+      q[i].y = -q[i].x;
+      q[i].normalize();
+    }
+
+    checkCodec<Star::QuaternionCodec32>(q, 0.0068f);
+    checkCodec<Star::QuaternionCodec48>(q, 2e-4f);
+    checkCodec<Star::QuaternionCodec64>(q, 7.5e-6f);
+    TS_ASSERT_EQUALS(sizeof(Star::QuaternionCodec48::Packed), size_t(6));
+  }
+
+  void testExpLog()
+  {
+    Star::float3 axis(1, 2, -3);
+    axis.normalize();
+    for(float angle = 0; angle < 6; angle += 0.05f) {
+      Star::quaternionf q = Star::quaternionf::exp(axis*(angle/2));
+      TS_ASSERT_LESS_THAN(angle > 0 ? this->angle(q, Star::quaternionf(axis, angle)) : 0.f, 1e-5f);
+      TS_ASSERT_LESS_THAN(this->angle(Star::quaternionf::exp(q.log()), q), 1e-5f);
+      TS_ASSERT_LESS_THAN(this->angle(q.pow(0.5f)*q.pow(0.5f), q), 1e-5f);
+    }
+
+    //Tiny angles stay accurate and null ones are valid
+    Star::quaterniond tiny = Star::quaterniond::exp(Star::double3(1e-9, 0, 0));
+    TS_ASSERT_EQUALS(tiny.x, 1e-9);
+    TS_ASSERT_EQUALS(tiny.w, 1.);
+    TS_ASSERT_DELTA(tiny.log().x, 1e-9, 1e-24);
+    Star::quaterniond identity = Star::quaterniond::exp(Star::double3(0, 0, 0));
+    TS_ASSERT_EQUALS(identity.w, 1.);
+    TS_ASSERT(identity.log().isNull());
+    TS_ASSERT(identity.pow(0.3).log().isNull());
+
+    //Series and sin/cos agree at the switch
+    double limit = Star::quaterniond::expSeriesLimit();
+    double sinc, cosine;
+    Star::quaterniond::expSeries(limit*limit, sinc, cosine);
+    TS_ASSERT_DELTA(sinc, std::sin(limit)/limit, 1e-15);
+    TS_ASSERT_DELTA(cosine, std::cos(limit), 1e-15);
+  }
+
+  void testIntegrate()
+  {
+    //Constant angular velocity over many steps
+    Star::quaterniond q(Star::double3(0, 1, 0), 0.3);
+    Star::double3 omega(0.5, -2, 1);
+    Star::quaterniond res = q;
+    for(size_t i = 0; i < 100; i++)
+      res = Star::quaterniond::integrate(res, omega, 0.01);
+    Star::quaterniond ref = Star::quaterniond::exp(omega*0.5)*q;
+    TS_ASSERT_DELTA(std::abs(res.dot(ref)), 1., 1e-12);
+
+    std::vector<Star::float3> omegas(NUM_QUAT);
+    for(size_t i = 0; i < NUM_QUAT; i++) {
+      //Some bodies spin fast enough to leave the series range
+      float scale = i%10 == 0 ? 100.f : 5.f;
+      omegas[i] = Star::float3(m_b[i].x, m_b[i].y, m_b[i].z)*scale;
+    }
+    const float dt = 1.f/60;
+
+    std::vector<Star::quaternionf> aos(NUM_QUAT);
+    Star::quaternionIntegrate(&m_a[0], &omegas[0], dt, &aos[0], NUM_QUAT);
+
+    std::vector<float> q4[4], w3[3];
+    toSoA(m_a, q4);
+    for(size_t c = 0; c < 3; c++) {
+      w3[c].resize(NUM_QUAT);
+      for(size_t i = 0; i < NUM_QUAT; i++)
+        w3[c][i] = omegas[i][c];
+    }
+    //In place
+    Star::QuaternionSoA<float> sq(&q4[0][0], &q4[1][0], &q4[2][0], &q4[3][0]);
+    Star::quaternionIntegrate(Star::QuaternionSoA<const float>(sq), Star::Vec3SoA<const float>(&w3[0][0], &w3[1][0], &w3[2][0]),
+                              dt, sq, NUM_QUAT);
+
+    for(size_t i = 0; i < NUM_QUAT; i++) {
+      Star::quaternionf ref = Star::quaternionf::integrate(m_a[i], omegas[i], dt);
+      TS_ASSERT(aos[i] == ref);
+      TS_ASSERT_LESS_THAN(angle(at(q4, i), ref), 1e-5f);
+      TS_ASSERT_DELTA(at(q4, i).length(), 1.f, 1e-6f);
+    }
+  }
+
+private:
+  template<typename Codec>
+  void checkCodec(const std::vector<Star::quaternionf>& q, float maxError)
+  {
+    std::vector<typename Codec::Packed> packed(NUM_QUAT);
+    std::vector<Star::quaternionf> decoded(NUM_QUAT);
+    Star::quaternionEncode<Codec>(&q[0], &packed[0], NUM_QUAT);
+    Star::quaternionDecode<Codec>(&packed[0], &decoded[0], NUM_QUAT);
+
+    std::vector<float> soa[4], out[4];
+    toSoA(q, soa);
+    toSoA(q, out);
+    std::vector<typename Codec::Packed> packedSoA(NUM_QUAT);
+    Star::quaternionEncode<Codec>(Star::QuaternionSoA<const float>(&soa[0][0], &soa[1][0], &soa[2][0], &soa[3][0]),
+                                  &packedSoA[0], NUM_QUAT);
+    Star::quaternionDecode<Codec>(&packed[0], Star::QuaternionSoA<float>(&out[0][0], &out[1][0], &out[2][0], &out[3][0]),
+                                  NUM_QUAT);
+
+    for(size_t i = 0; i < NUM_QUAT; i++) {
+      TS_ASSERT_LESS_THAN_EQUALS(angle(q[i], decoded[i]), maxError);
+      TS_ASSERT_DELTA(decoded[i].length(), 1.f, 1e-6f);
+      TS_ASSERT_EQUALS(Codec::unpack(packed[i]), Codec::unpack(Star::quaternionEncode<Codec>(q[i])));
+      TS_ASSERT_EQUALS(Codec::unpack(packed[i]), Codec::unpack(packedSoA[i]));
+      TS_ASSERT_EQUALS(Codec::unpack(packed[i]), Codec::unpack(Star::quaternionEncode<Codec>(decoded[i])));
+
+      Star::quaternionf single;
+      Star::quaternionDecode<Codec>(packed[i], single);
+      TS_ASSERT_EQUALS(single.x, decoded[i].x);
+      TS_ASSERT_EQUALS(single.w, decoded[i].w);
+      TS_ASSERT_EQUALS(at(out, i).y, decoded[i].y);
+      TS_ASSERT_EQUALS(at(out, i).z, decoded[i].z);
+    }
+  }
+
+  static const size_t NUM_QUAT = 1000;
+
+  /**
+   * Angle of the rotation between two unit quaternions
+   */
+  static float angle(const Star::quaternionf& a, const Star::quaternionf& b)
+  {
+    //Chord length form, acos of the dot product is too imprecise near 1
+    double sign = a.dot(b) < 0 ? -1 : 1;
+    double d2 = 0;
+    for(size_t c = 0; c < 4; c++)
+      d2 += (a[c]-sign*b[c])*(a[c]-sign*b[c]);
+    return float(4*std::asin(std::min(std::sqrt(d2)/2, 1.)));
+  }
+
+  static void toSoA(const std::vector<Star::quaternionf>& q, std::vector<float>* soa)
+  {
+    for(size_t c = 0; c < 4; c++)
+    {
+      soa[c].resize(q.size());
+      for(size_t i = 0; i < q.size(); i++)
+        soa[c][i] = q[i][c];
+    }
+  }
+
+  static Star::quaternionf at(const std::vector<float>* soa, size_t i)
+  {
+    return Star::quaternionf(soa[0][i], soa[1][i], soa[2][i], soa[3][i]);
+  }
+
+  std::vector<Star::quaternionf> m_a;
+  std::vector<Star::quaternionf> m_b;
+  std::vector<float> m_t;
+};
@@ -0,0 +1,206 @@
+#include <cxxtest/TestSuite.h>
+
+#include <StarMath/StarSimd.h>
+#include <StarMath/StarKernels.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "RandGen.h"
+
+/**
+ * Also built with the AVX2 and AVX-512 flags of the kernel sources, see
+ * CMakeLists.txt, so the 8 and 16 lane packs run with their native
+ * backends. Those builds skip their tests on CPUs without the
+ * instructions.
+ */
+class MathTestSimd : public CxxTest::TestSuite
+{
+public:
+  void testFloat4()
+  {
+    if(isCompiledIsaSupported())
+      checkPack<float, 4>();
+  }
+
+  void testNative()
+  {
+    if(isCompiledIsaSupported())
+      checkPack<float, Star::simd::FLOAT_WIDTH>();
+  }
+
+  void testWide()
+  {
+    if(isCompiledIsaSupported()) {
+      checkPack<float, 8>();
+      checkPack<float, 16>();
+    }
+  }
+
+  void testScalar()
+  {
+    if(isCompiledIsaSupported()) {
+      checkPack<float, 3>();
+      checkPack<double, 5>();
+    }
+  }
+
+  void testTranspose4()
+  {
+    if(isCompiledIsaSupported()) {
+      checkTranspose4<float>();
+      checkTranspose4<double>();
+    }
+  }
+
+private:
+  static bool isCompiledIsaSupported()
+  {
+#if defined(STAR_SIMD_AVX512)
+    return Star::Kernels::isSupported(Star::Kernels::ISA_AVX512);
+#elif defined(STAR_SIMD_AVX2)
+    return Star::Kernels::isSupported(Star::Kernels::ISA_AVX2);
+#else
+    return true;
+#endif
+  }
+
+  //Equal values, both NaNs, and the same sign for zeros
+  template<typename T>
+  static bool isSame(T a, T b)
+  {
+    if(std::isnan(a) || std::isnan(b))
+      return std::isnan(a) && std::isnan(b);
+    return a == b && std::signbit(a) == std::signbit(b);
+  }
+
+  template<typename T>
+  void checkTranspose4()
+  {
+    typedef Star::simd::pack<T, 4> Pack;
+    T m[4][4];
+    for(size_t i = 0; i < 16; i++)
+      m[i/4][i%4] = T(i);
+    Pack a = Pack::loadu(m[0]), b = Pack::loadu(m[1]);
+    Pack c = Pack::loadu(m[2]), d = Pack::loadu(m[3]);
+    Star::simd::transpose4(a, b, c, d);
+    const Pack* rows[4] = { &a, &b, &c, &d };
+    for(size_t j = 0; j < 4; j++)
+      for(size_t i = 0; i < 4; i++)
+        TS_ASSERT_EQUALS((*rows[j])[i], m[i][j]);
+  }
+
+  //Compares every operation of pack<T, N> with the same scalar code
+  template<typename T, size_t N>
+  void checkPack()
+  {
+    typedef Star::simd::pack<T, N> Pack;
+    typedef Star::simd::mask<T, N> Mask;
+    TS_ASSERT_EQUALS(Pack::SIZE, N);
+
+    FloatRandGen rand(2.f);
+    T a[N], b[N], c[N], r[N];
+    unsigned int indices[N];
+    std::vector<T> table(N*3*5);
+    for(size_t i = 0; i < N; i++) {
+      a[i] = T(rand())-1;
+      b[i] = T(rand())-1;
+      c[i] = T(rand())-1;
+      indices[i] = (unsigned int)((i*7+3)%(N*3));
+    }
+    b[0] = a[0];
+    for(size_t i = 0; i < table.size(); i++)
+      table[i] = T(i);
+
+    const Pack pa = Pack::loadu(a), pb = Pack::loadu(b), pc = Pack::loadu(c);
+    for(size_t i = 0; i < N; i++) {
+      TS_ASSERT_EQUALS(pa[i], a[i]);
+      TS_ASSERT_EQUALS(Pack(T(2))[i], T(2));
+      TS_ASSERT_EQUALS(Pack::zero()[i], T(0));
+      TS_ASSERT_DELTA((pa+pb)[i], a[i]+b[i], 1e-6);
+      TS_ASSERT_DELTA((pa-pb)[i], a[i]-b[i], 1e-6);
+      TS_ASSERT_DELTA((pa*pb)[i], a[i]*b[i], 1e-6);
+      TS_ASSERT_DELTA((pa/pc)[i], a[i]/c[i], 1e-5*std::fabs(a[i]/c[i]));
+      TS_ASSERT_EQUALS((-pa)[i], -a[i]);
+      TS_ASSERT_DELTA(Star::simd::fma(pa, pb, pc)[i], a[i]*b[i]+c[i], 1e-6);
+      TS_ASSERT_EQUALS(Star::simd::min(pa, pb)[i], std::min(a[i], b[i]));
+      TS_ASSERT_EQUALS(Star::simd::max(pa, pb)[i], std::max(a[i], b[i]));
+      TS_ASSERT_EQUALS(Star::simd::abs(pa)[i], std::fabs(a[i]));
+      TS_ASSERT_DELTA(Star::simd::sqrt(Star::simd::abs(pa))[i], std::sqrt(std::fabs(a[i])), 1e-6);
+      const T d = std::fabs(a[i])+T(0.5);
+      TS_ASSERT_DELTA(Star::simd::rcp(Star::simd::abs(pa)+Pack(T(0.5)))[i], 1/d, 1e-6/d);
+      TS_ASSERT_DELTA(Star::simd::rsqrt(Star::simd::abs(pa)+Pack(T(0.5)))[i], 1/std::sqrt(d), 1e-6/std::sqrt(d));
+      TS_ASSERT_EQUALS((pa < pb)[i], a[i] < b[i]);
+      TS_ASSERT_EQUALS((pa <= pb)[i], a[i] <= b[i]);
+      TS_ASSERT_EQUALS((pa > pb)[i], a[i] > b[i]);
+      TS_ASSERT_EQUALS((pa >= pb)[i], a[i] >= b[i]);
+      TS_ASSERT_EQUALS((pa == pb)[i], a[i] == b[i]);
+      TS_ASSERT_EQUALS((pa != pb)[i], a[i] != b[i]);
+      TS_ASSERT_EQUALS(Star::simd::select(pa < pb, pa, pc)[i], a[i] < b[i] ? a[i] : c[i]);
+      TS_ASSERT_EQUALS(Pack::gather(&table[0], indices, 5)[i], table[indices[i]*5]);
+    }
+
+    //NaNs and signed zeros, the second operand unless the comparison
+    //holds as with the x86 instructions
+    const T nan = std::numeric_limits<T>::quiet_NaN();
+    const T special[4][2] = { { nan, T(1) }, { T(1), nan }, { T(0), -T(0) }, { -T(0), T(0) } };
+    T x[N], y[N];
+    for(size_t i = 0; i < N; i++) {
+      x[i] = special[i%4][0];
+      y[i] = special[i%4][1];
+    }
+    const Pack pmin = Star::simd::min(Pack::loadu(x), Pack::loadu(y));
+    const Pack pmax = Star::simd::max(Pack::loadu(x), Pack::loadu(y));
+    for(size_t i = 0; i < N; i++) {
+      TS_ASSERT(isSame(pmin[i], x[i] < y[i] ? x[i] : y[i]));
+      TS_ASSERT(isSame(pmax[i], y[i] < x[i] ? x[i] : y[i]));
+    }
+
+    //Masks
+    const unsigned int all = (1u << N)-1;
+    const Mask lt = pa < pb;
+    const Mask gt = pa > pb;
+    TS_ASSERT_EQUALS(Mask::fromBits(0x5 & all).getBits(), 0x5 & all);
+    TS_ASSERT_EQUALS(Mask::firstN(0).getBits(), 0u);
+    TS_ASSERT_EQUALS(Mask::firstN(N-1).getBits(), all >> 1);
+    TS_ASSERT_EQUALS(Mask::firstN(N+5).getBits(), all);
+    TS_ASSERT_EQUALS((lt | gt).getBits(), (pa != pb).getBits());
+    TS_ASSERT_EQUALS((lt & gt).getBits(), 0u);
+    TS_ASSERT_EQUALS((lt ^ Mask::fromBits(all)).getBits(), (~lt).getBits());
+    TS_ASSERT_EQUALS((~lt).getBits(), (pa >= pb).getBits());
+
+    //Masked loads, stores and gathers don't touch the other lanes
+    const Mask first = Mask::firstN(N-1);
+    for(size_t i = 0; i < N; i++)
+      r[i] = T(-7);
+    pa.store(r, first);
+    Pack loaded = Pack::load(a, first);
+    Pack gathered = Pack::gather(&table[0], indices, 5, first);
+    for(size_t i = 0; i < N; i++) {
+      TS_ASSERT_EQUALS(r[i], i < N-1 ? a[i] : T(-7));
+      TS_ASSERT_EQUALS(loaded[i], i < N-1 ? a[i] : T(0));
+      TS_ASSERT_EQUALS(gathered[i], i < N-1 ? table[indices[i]*5] : T(0));
+    }
+
+    //Reductions
+    T sum = 0, lo = a[0], hi = a[0];
+    for(size_t i = 0; i < N; i++) {
+      sum += a[i];
+      lo = std::min(lo, a[i]);
+      hi = std::max(hi, a[i]);
+    }
+    TS_ASSERT_DELTA(Star::simd::reduceAdd(pa), sum, 1e-5);
+    TS_ASSERT_EQUALS(Star::simd::reduceMin(pa), lo);
+    TS_ASSERT_EQUALS(Star::simd::reduceMax(pa), hi);
+
+    //Shuffles within groups of 4
+    if(N%4 == 0) {
+      Pack s = Star::simd::shuffle<3, 0, 2, 2>(pa);
+      const size_t idx[4] = { 3, 0, 2, 2 };
+      for(size_t i = 0; i < N; i++)
+        TS_ASSERT_EQUALS(s[i], a[i/4*4+idx[i%4]]);
+    }
+  }
+};
@@ -0,0 +1,217 @@
+#include <cxxtest/TestSuite.h>
+
+#include <StarMath.h>
+
+#include <limits>
+#include <algorithm>
+#include <vector>
+
+#include "RandGen.h"
+
+class MathTestSkinning : public CxxTest::TestSuite
+{
+public:
+  void setUp()
+  {
+    using namespace std;
+    vector<float> randValues;
+    generate_n(back_inserter(randValues), NUM_BONES*7, FloatRandGen(2.f));
+
+    m_bones.clear();
+    m_matrices.clear();
+    for(size_t i = 0; i < NUM_BONES; i++) {
+      const float* r = &randValues[i*7];
+      Star::quaternionf q(r[0]-1, r[1]-1, r[2]-1, r[3]-1);
+      q.normalize();
+      Star::float3 t(r[4]*5, r[5]*5, r[6]*5);
+      m_bones.push_back(Star::dualQuaternionf(q, t));
+
+      Star::float4x4 m;
+      q.toRotationMatrix(m);
+      m(0, 3) = t.x;
+      m(1, 3) = t.y;
+      m(2, 3) = t.z;
+      m_matrices.push_back(m);
+    }
+  }
+
+  void testDualQuaternion()
+  {
+    Star::float3 p(1, -2, 3);
+    for(size_t i = 0; i < NUM_BONES; i++) {
+      const Star::dualQuaternionf& dq = m_bones[i];
+      TS_ASSERT(near(dq.transformPoint(p), m_matrices[i]*p));
+
+      Star::dualQuaternionf fromMatrix;
+      fromMatrix.fromRigidMatrix(m_matrices[i]);
+      TS_ASSERT(near(fromMatrix.transformPoint(p), m_matrices[i]*p));
+
+      Star::float4x4 m;
+      dq.toRigidMatrix(m);
+      TS_ASSERT(near(m*p, m_matrices[i]*p));
+
+      //Composition matches the matrix product
+      const size_t j = (i+1)%NUM_BONES;
+      Star::dualQuaternionf composed = dq*m_bones[j];
+      TS_ASSERT(near(composed.transformPoint(p), m_matrices[i]*(m_matrices[j]*p)));
+      TS_ASSERT(near(dq.conjugate().transformPoint(dq.transformPoint(p)), p));
+
+      Star::dualQuaternionf scaled = dq*3.f;
+      TS_ASSERT_DELTA(scaled.normalize(), 3.f, 1e-5f);
+      TS_ASSERT(near(scaled.transformPoint(p), dq.transformPoint(p)));
+    }
+
+    Star::dualQuaternionf identity;
+    identity.toIdentity();
+    TS_ASSERT(identity.transformPoint(p) == p);
+  }
+
+  void testDualQuaternionSkin()
+  {
+    using namespace std;
+    const size_t numVertices = 5000;
+    vector<float> randValues;
+    generate_n(back_inserter(randValues), numVertices*7, FloatRandGen(1.f));
+
+    vector<float> pos[3], nrm[3], outPos[3], outNrm[3], weights[4];
+    vector<unsigned int> indices[4];
+    for(size_t c = 0; c < 3; c++) {
+      pos[c].resize(numVertices);
+      nrm[c].resize(numVertices);
+      outPos[c].resize(numVertices);
+      outNrm[c].resize(numVertices);
+    }
+    for(size_t b = 0; b < 4; b++) {
+      weights[b].resize(numVertices);
+      indices[b].resize(numVertices);
+    }
+    for(size_t i = 0; i < numVertices; i++) {
+      const float* r = &randValues[i*7];
+      for(size_t c = 0; c < 3; c++) {
+        pos[c][i] = r[c]*10;
+        nrm[c][i] = r[3+c];
+      }
+      float sum = 0;
+      for(size_t b = 0; b < 4; b++) {
+        indices[b][i] = (i*7+b*13)%NUM_BONES;
+        weights[b][i] = b == 3 ? 0 : r[6]+b;
+        sum += weights[b][i];
+      }
+      for(size_t b = 0; b < 4; b++)
+        weights[b][i] /= sum;
+    }
+
+    const float* w[4] = { &weights[0][0], &weights[1][0], &weights[2][0], &weights[3][0] };
+    const unsigned int* idx[4] = { &indices[0][0], &indices[1][0], &indices[2][0], &indices[3][0] };
+    Star::dualQuaternionSkin(&m_bones[0], Star::BoneInfluenceSoA<float>(w, idx, 4),
+                             Star::Vec3SoA<const float>(&pos[0][0], &pos[1][0], &pos[2][0]),
+                             Star::Vec3SoA<const float>(&nrm[0][0], &nrm[1][0], &nrm[2][0]),
+                             Star::Vec3SoA<float>(&outPos[0][0], &outPos[1][0], &outPos[2][0]),
+                             Star::Vec3SoA<float>(&outNrm[0][0], &outNrm[1][0], &outNrm[2][0]),
+                             numVertices);
+
+    for(size_t i = 0; i < numVertices; i++) {
+      //Reference blend with the same hemisphere rule
+      const Star::dualQuaternionf& first = m_bones[indices[0][i]];
+      Star::dualQuaternionf blend = first*weights[0][i];
+      for(size_t b = 1; b < 4; b++) {
+        const Star::dualQuaternionf& dq = m_bones[indices[b][i]];
+        float sign = first.real.dot(dq.real) < 0 ? -1.f : 1.f;
+        blend += dq*(sign*weights[b][i]);
+      }
+      blend.normalize();
+
+      Star::float3 p(pos[0][i], pos[1][i], pos[2][i]);
+      Star::float3 n(nrm[0][i], nrm[1][i], nrm[2][i]);
+      TS_ASSERT(near(Star::float3(outPos[0][i], outPos[1][i], outPos[2][i]), blend.transformPoint(p)));
+      TS_ASSERT(near(Star::float3(outNrm[0][i], outNrm[1][i], outNrm[2][i]), blend.transformVector(n)));
+    }
+
+    //One bone per vertex is a plain rigid transform, normals are optional
+    vector<float> ones(numVertices, 1.f);
+    const float* one = &ones[0];
+    Star::dualQuaternionSkin(&m_bones[0], Star::BoneInfluenceSoA<float>(&one, idx, 1),
+                             Star::Vec3SoA<const float>(&pos[0][0], &pos[1][0], &pos[2][0]),
+                             Star::Vec3SoA<const float>(), Star::Vec3SoA<float>(&outPos[0][0], &outPos[1][0], &outPos[2][0]),
+                             Star::Vec3SoA<float>(), numVertices);
+    for(size_t i = 0; i < numVertices; i++) {
+      Star::float3 p(pos[0][i], pos[1][i], pos[2][i]);
+      TS_ASSERT(near(Star::float3(outPos[0][i], outPos[1][i], outPos[2][i]), m_matrices[indices[0][i]]*p));
+    }
+  }
+
+  void testLinearBlendSkin()
+  {
+    using namespace std;
+    const size_t numVertices = 5000;
+    vector<float> randValues;
+    generate_n(back_inserter(randValues), numVertices*7, FloatRandGen(1.f));
+
+    vector<float> pos[3], nrm[3], outPos[3], outNrm[3], weights[3];
+    vector<unsigned int> indices[3];
+    for(size_t c = 0; c < 3; c++) {
+      pos[c].resize(numVertices);
+      nrm[c].resize(numVertices);
+      outPos[c].resize(numVertices);
+      outNrm[c].resize(numVertices);
+      weights[c].resize(numVertices);
+      indices[c].resize(numVertices);
+    }
+    for(size_t i = 0; i < numVertices; i++) {
+      const float* r = &randValues[i*7];
+      for(size_t c = 0; c < 3; c++) {
+        pos[c][i] = r[c]*10;
+        nrm[c][i] = r[3+c]+0.1f;
+        indices[c][i] = (i*5+c*17)%NUM_BONES;
+        weights[c][i] = (r[6]+c)/(3*r[6]+3);
+      }
+    }
+
+    //3x4 palette
+    vector<float> palette(NUM_BONES*12);
+    for(size_t b = 0; b < NUM_BONES; b++)
+      copy(m_matrices[b].constPtr(), m_matrices[b].constPtr()+12, &palette[b*12]);
+
+    const float* w[3] = { &weights[0][0], &weights[1][0], &weights[2][0] };
+    const unsigned int* idx[3] = { &indices[0][0], &indices[1][0], &indices[2][0] };
+    Star::BoneInfluenceSoA<float> influences(w, idx, 3);
+    Star::Vec3SoA<const float> sPos(&pos[0][0], &pos[1][0], &pos[2][0]);
+    Star::Vec3SoA<const float> sNrm(&nrm[0][0], &nrm[1][0], &nrm[2][0]);
+    Star::Vec3SoA<float> sOutPos(&outPos[0][0], &outPos[1][0], &outPos[2][0]);
+    Star::Vec3SoA<float> sOutNrm(&outNrm[0][0], &outNrm[1][0], &outNrm[2][0]);
+
+    for(size_t pass = 0; pass < 2; pass++) {
+      if(pass == 0)
+        Star::linearBlendSkin(&palette[0], 12, influences, sPos, sNrm, sOutPos, sOutNrm, numVertices);
+      else
+        Star::linearBlendSkin(&m_matrices[0], influences, sPos, sNrm, sOutPos, sOutNrm, numVertices);
+
+      for(size_t i = 0; i < numVertices; i++) {
+        //Reference transforms the vertex by each bone and blends the results
+        Star::float3 p(pos[0][i], pos[1][i], pos[2][i]);
+        Star::float3 n(nrm[0][i], nrm[1][i], nrm[2][i]);
+        Star::float3 refPos(0, 0, 0);
+        Star::float3 refNrm(0, 0, 0);
+        for(size_t b = 0; b < 3; b++) {
+          const Star::float4x4& m = m_matrices[indices[b][i]];
+          refPos += (m*p)*weights[b][i];
+          refNrm += (m*n-m*Star::float3(0, 0, 0))*weights[b][i];
+        }
+        refNrm.normalize();
+        TS_ASSERT(near(Star::float3(outPos[0][i], outPos[1][i], outPos[2][i]), refPos));
+        TS_ASSERT(near(Star::float3(outNrm[0][i], outNrm[1][i], outNrm[2][i]), refNrm));
+      }
+    }
+  }
+
+private:
+  static const size_t NUM_BONES = 50;
+
+  static bool near(const Star::float3& a, const Star::float3& b)
+  {
+    return (a-b).length() < 1e-4f*std::max(1.f, b.length());
+  }
+
+  std::vector<Star::dualQuaternionf> m_bones;
+  std::vector<Star::float4x4> m_matrices;
+};
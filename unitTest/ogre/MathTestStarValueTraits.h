@@ -3,6 +3,7 @@
 #include <sstream>
 
 #include <StarMath.h>
+#include <StarMath/StarStream.h>
 
 namespace CxxTest
 {
@@ -0,0 +1,173 @@
+#include <cxxtest/TestSuite.h>
+
+#include <StarMath.h>
+
+#include <limits>
+#include <algorithm>
+#include <vector>
+
+#include "RandGen.h"
+
+class MathTestTransformHierarchy : public CxxTest::TestSuite
+{
+public:
+  void setUp()
+  {
+    using namespace std;
+    vector<float> randValues;
+    generate_n(back_inserter(randValues), NUM_NODES*11, FloatRandGen(2.f));
+
+    m_hierarchy.clear();
+    for(size_t i = 0; i < NUM_NODES; i++) {
+      const float* r = &randValues[i*11];
+      //A few roots, then random parents among the previous nodes
+      unsigned int parent = i < 3 ? Star::transformHierarchyf::NONE : (unsigned int)(r[10]*0.5f*i);
+      m_hierarchy.addNode(parent, translation(r), rotation(r+3), scale(r+7));
+    }
+  }
+
+  void testUpdate()
+  {
+    TS_ASSERT(m_hierarchy.isDirty(NUM_NODES-1));
+    TS_ASSERT_EQUALS(m_hierarchy.update(), NUM_NODES);
+    TS_ASSERT(!m_hierarchy.isDirty(NUM_NODES-1));
+    TS_ASSERT_EQUALS(m_hierarchy.update(), 0u);
+    checkWorlds();
+
+    Star::float4x4 identity;
+    identity.toIdentity();
+    Star::transformHierarchyf single;
+    single.addNode(Star::transformHierarchyf::NONE, Star::float3(0, 0, 0),
+                   Star::quaternionf(0, 0, 0, 1), Star::float3(1, 1, 1));
+    single.update();
+    TS_ASSERT(single.getWorld(0) == identity);
+    TS_ASSERT_EQUALS(single.getWorldMatrices(), &single.getWorld(0));
+  }
+
+  void testIncrementalUpdate()
+  {
+    m_hierarchy.update();
+
+    //Move a node and count its subtree
+    const unsigned int moved = NUM_NODES/10;
+    std::vector<unsigned char> inSubtree(NUM_NODES, 0);
+    inSubtree[moved] = 1;
+    size_t subtreeSize = 0;
+    for(size_t i = moved; i < NUM_NODES; i++) {
+      unsigned int parent = m_hierarchy.getParent(i);
+      if(parent != Star::transformHierarchyf::NONE && inSubtree[parent])
+        inSubtree[i] = 1;
+      subtreeSize += inSubtree[i];
+    }
+    TS_ASSERT_LESS_THAN(subtreeSize, size_t(NUM_NODES));
+
+    m_hierarchy.setTranslation(moved, Star::float3(1, 2, 3));
+    for(size_t i = 0; i < NUM_NODES; i++)
+      TS_ASSERT_EQUALS(m_hierarchy.isDirty(i), inSubtree[i] != 0);
+    TS_ASSERT_EQUALS(m_hierarchy.update(), subtreeSize);
+    checkWorlds();
+
+    //Several changes, a leaf only updates itself
+    m_hierarchy.setRotation(NUM_NODES-1, Star::quaternionf(Star::float3(0, 1, 0), 0.5f));
+    TS_ASSERT_EQUALS(m_hierarchy.update(), 1u);
+    m_hierarchy.setScale(0, Star::float3(2, 2, 2));
+    m_hierarchy.setLocal(5, Star::float3(0, 0, 1), Star::quaternionf(0, 0, 0, 1), Star::float3(1, 3, 1));
+    m_hierarchy.setDirty(NUM_NODES/2);
+    m_hierarchy.update();
+    checkWorlds();
+
+    //Nodes added after an update are computed by the next one
+    m_hierarchy.addNode(moved, Star::float3(1, 1, 1), Star::quaternionf(0, 0, 0, 1), Star::float3(1, 1, 1));
+    TS_ASSERT_EQUALS(m_hierarchy.update(), 1u);
+    checkWorlds();
+  }
+
+  void testParallelUpdate()
+  {
+    Star::transformHierarchyf serial(m_hierarchy);
+    TS_ASSERT_EQUALS(m_hierarchy.updateParallel(), NUM_NODES);
+    TS_ASSERT_EQUALS(serial.update(), NUM_NODES);
+    checkWorlds();
+    for(size_t i = 0; i < NUM_NODES; i++) {
+      unsigned int parent = m_hierarchy.getParent(i);
+      TS_ASSERT_EQUALS(m_hierarchy.getDepth(i), parent == Star::transformHierarchyf::NONE ? 0 : m_hierarchy.getDepth(parent)+1);
+      TS_ASSERT(m_hierarchy.getWorld(i) == serial.getWorld(i));
+    }
+
+    //Incremental, with nodes added since the depths were sorted
+    m_hierarchy.setTranslation(NUM_NODES/10, Star::float3(1, 2, 3));
+    m_hierarchy.addNode(NUM_NODES/10, Star::float3(1, 1, 1), Star::quaternionf(0, 0, 0, 1), Star::float3(1, 1, 1));
+    serial.setTranslation(NUM_NODES/10, Star::float3(1, 2, 3));
+    serial.addNode(NUM_NODES/10, Star::float3(1, 1, 1), Star::quaternionf(0, 0, 0, 1), Star::float3(1, 1, 1));
+    TS_ASSERT_EQUALS(m_hierarchy.updateParallel(), serial.update());
+    TS_ASSERT_EQUALS(m_hierarchy.updateParallel(), 0u);
+    checkWorlds();
+
+#ifdef _OPENMP
+    const int numThreads = omp_get_max_threads();
+    omp_set_num_threads(4);
+#endif
+    //Large enough to use threads: one root, then 4096 chains. The root
+    //depth is processed by a single thread
+    Star::transformHierarchyf wide;
+    for(size_t i = 0; i < 102401; i++)
+      wide.addNode(i == 0 ? Star::transformHierarchyf::NONE : (unsigned int)(i <= 4096 ? 0 : i-4096),
+                   Star::float3(0.001f, 0, 0), Star::quaternionf(0, 0, 0, 1), Star::float3(1, 1, 1));
+    TS_ASSERT_EQUALS(wide.updateParallel(), 102401u);
+    TS_ASSERT_EQUALS(wide.getDepth(102400), 25u);
+    TS_ASSERT_DELTA(wide.getWorld(102400)(0, 3), 0.026f, 1e-5f);
+    wide.setTranslation(0, Star::float3(1, 0, 0));
+    TS_ASSERT_EQUALS(wide.updateParallel(), 102401u);
+    TS_ASSERT_DELTA(wide.getWorld(102400)(0, 3), 1.025f, 1e-5f);
+
+    //Depths of 1000 nodes are too thin, update() runs instead
+    Star::transformHierarchyf thin;
+    for(size_t i = 0; i < 100000; i++)
+      thin.addNode(i < 1000 ? Star::transformHierarchyf::NONE : (unsigned int)(i-1000),
+                   Star::float3(0.001f, 0, 0), Star::quaternionf(0, 0, 0, 1), Star::float3(1, 1, 1));
+    TS_ASSERT_EQUALS(thin.updateParallel(), 100000u);
+    TS_ASSERT_EQUALS(thin.getDepth(99999), 99u);
+    TS_ASSERT_DELTA(thin.getWorld(99999)(0, 3), 0.1f, 1e-5f);
+#ifdef _OPENMP
+    omp_set_num_threads(numThreads);
+#endif
+  }
+
+private:
+  static const size_t NUM_NODES = 2000;
+
+  static Star::float3 translation(const float* r) { return Star::float3(r[0]-1, r[1]-1, r[2]-1); }
+  static Star::float3 scale(const float* r) { return Star::float3(r[0]*0.25f+0.75f, r[1]*0.25f+0.75f, r[2]*0.25f+0.75f); }
+  static Star::quaternionf rotation(const float* r)
+  {
+    Star::quaternionf q(r[0]-1, r[1]-1, r[2]-1, r[3]-1);
+    q.normalize();
+    return q;
+  }
+
+  /**
+   * Compare the world matrices with products of Matrix<float>.
+   */
+  void checkWorlds()
+  {
+    std::vector<Star::float4x4> ref(m_hierarchy.getNumNodes());
+    for(size_t i = 0; i < m_hierarchy.getNumNodes(); i++) {
+      Star::float4x4 t, r, s;
+      t.makeTranslation(m_hierarchy.getTranslation(i));
+      m_hierarchy.getRotation(i).toRotationMatrix(r);
+      s.makeScaling(m_hierarchy.getScale(i));
+      ref[i] = t*r*s;
+      unsigned int parent = m_hierarchy.getParent(i);
+      if(parent != Star::transformHierarchyf::NONE)
+        ref[i] = ref[parent]*ref[i];
+
+      const Star::float4x4& world = m_hierarchy.getWorldMatrices()[i];
+      for(size_t k = 0; k < 16; k++) {
+        float scale = std::max(1.f, std::abs(ref[i].constPtr()[k]));
+        TS_ASSERT_DELTA(world.constPtr()[k], ref[i].constPtr()[k], 1e-4f*scale);
+      }
+    }
+  }
+
+  Star::transformHierarchyf m_hierarchy;
+};
@@ -0,0 +1,214 @@
+#include <cxxtest/TestSuite.h>
+
+#include <StarMath.h>
+#include <StarMath/StarStream.h>
+
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+#include "RandGen.h"
+
+class MathTestVecMat : public CxxTest::TestSuite
+{
+public:
+  void testAliases()
+  {
+    TS_ASSERT((std::is_same<Star::float2, Star::Vec<2, float> >::value));
+    TS_ASSERT((std::is_same<Star::float3, Star::Vec<3, float> >::value));
+    TS_ASSERT((std::is_same<Star::float4, Star::Vec<4, float> >::value));
+    TS_ASSERT((std::is_same<Star::float2x2, Star::Mat<2, 2, float> >::value));
+    TS_ASSERT((std::is_same<Star::float4x4, Star::Mat<4, 4, float> >::value));
+    TS_ASSERT_EQUALS(sizeof(Star::float3), 3*sizeof(float));
+    TS_ASSERT_EQUALS(sizeof(Star::float4x4), 16*sizeof(float));
+
+    //Matrix2 kept its identity default constructor
+    TS_ASSERT_EQUALS(Star::float2x2(), Star::float2x2(1, 0, 0, 1));
+    TS_ASSERT_EQUALS(Star::int2x2(), Star::int2x2(1, 0, 0, 1));
+  }
+
+  void testVec()
+  {
+    FloatRandGen rand(2.f);
+    double a[5], b[5];
+    for(size_t i = 0; i < 5; i++) {
+      a[i] = rand()-1;
+      b[i] = rand()+1;
+    }
+
+    typedef Star::Vec<5, double> double5;
+    const double5 va(a), vb(b);
+    const double k = 3;
+    double dot = 0;
+    for(size_t i = 0; i < 5; i++) {
+      TS_ASSERT_DELTA((va+vb)[i], a[i]+b[i], 1e-12);
+      TS_ASSERT_DELTA((va-vb)[i], a[i]-b[i], 1e-12);
+      TS_ASSERT_DELTA((va*vb)[i], a[i]*b[i], 1e-12);
+      TS_ASSERT_DELTA((va/vb)[i], a[i]/b[i], 1e-12);
+      TS_ASSERT_DELTA((va*k)[i], a[i]*k, 1e-12);
+      TS_ASSERT_DELTA((k*va)[i], a[i]*k, 1e-12);
+      TS_ASSERT_DELTA((va/k)[i], a[i]/k, 1e-12);
+      TS_ASSERT_DELTA((-va)[i], -a[i], 1e-12);
+      dot += a[i]*b[i];
+    }
+    TS_ASSERT_DELTA(va.dot(vb), dot, 1e-12);
+    double5 n = va;
+    TS_ASSERT_DELTA(n.normalize(), std::sqrt(va.dot(va)), 1e-12);
+    TS_ASSERT_DELTA(n.length(), 1, 1e-12);
+
+    //Named components and the per size members
+    Star::float4 v4(Star::float3(1, 2, 3), 4);
+    TS_ASSERT_EQUALS(v4.x, 1);
+    TS_ASSERT_EQUALS(v4.w, 4);
+    TS_ASSERT_EQUALS(Star::float3(1, 2, 3).getSize(), 6);
+    TS_ASSERT_EQUALS(Star::float3(1, 0, 0).cross(Star::float3(0, 1, 0)), Star::float3(0, 0, 1));
+    TS_ASSERT_EQUALS(Star::int2(Star::float2(1.5f, -2.5f)), Star::int2(1, -2));
+    TS_ASSERT(Star::float4(0, 0, 0, 0).isNull());
+    TS_ASSERT_EQUALS(v4.clamp(Star::float4(2, 0, 0, 0), Star::float4(3, 3, 3, 3)), Star::float4(2, 2, 3, 3));
+  }
+
+  void testEquality()
+  {
+    //Same semantics for every size: epsilon for floats, exact for integers
+    const float e = std::numeric_limits<float>::epsilon()/2;
+    TS_ASSERT_EQUALS(Star::float2(1, 2), Star::float2(1+e, 2));
+    TS_ASSERT_EQUALS(Star::float3(1, 2, 3), Star::float3(1+e, 2, 3));
+    TS_ASSERT_DIFFERS(Star::float2(1, 2), Star::float2(1.001f, 2));
+    TS_ASSERT_DIFFERS(Star::int2(1, 2), Star::int2(1, 3));
+    TS_ASSERT_EQUALS(Star::uint4(1, 2, 3, 4), Star::uint4(1, 2, 3, 4));
+    TS_ASSERT_DIFFERS(Star::uint4(1, 2, 3, 4), Star::uint4(1, 2, 3, 5));
+
+    //Exact for matrices
+    Star::float2x2 m(1, 2, 3, 4);
+    TS_ASSERT_EQUALS(m, Star::float2x2(1, 2, 3, 4));
+    TS_ASSERT_DIFFERS(m, Star::float2x2(1+2*e, 2, 3, 4));
+  }
+
+  void testMatProduct()
+  {
+    FloatRandGen rand(2.f);
+    for(size_t n = 0; n < 100; n++) {
+      Star::float4x4 a, b;
+      Star::double4x4 da, db;
+      for(size_t i = 0; i < 16; i++) {
+        a.ptr()[i] = rand()-1;
+        b.ptr()[i] = rand()-1;
+        da.ptr()[i] = a.ptr()[i];
+        db.ptr()[i] = b.ptr()[i];
+      }
+
+      //The simd::pack specialization against the generic double product
+      const Star::float4x4 ab = a*b;
+      const Star::double4x4 dab = da*db;
+      Star::float4x4 c = a;
+      c *= b;
+      for(size_t j = 0; j < 4; j++)
+        for(size_t k = 0; k < 4; k++) {
+          TS_ASSERT_DELTA(ab(j, k), dab(j, k), 1e-5);
+          TS_ASSERT_EQUALS(c(j, k), ab(j, k));
+        }
+    }
+
+    //Non square
+    const Star::Mat<2, 3, int> a(1, 2, 3,
+                                 4, 5, 6);
+    const Star::Mat<3, 2, int> at = a.transpose();
+    TS_ASSERT_EQUALS(at, (Star::Mat<3, 2, int>(1, 4,
+                                               2, 5,
+                                               3, 6)));
+    TS_ASSERT_EQUALS(a*at, Star::int2x2(14, 32,
+                                        32, 77));
+    TS_ASSERT_EQUALS(a*Star::int3(1, 0, -1), Star::int2(-2, -2));
+  }
+
+  void testTransform()
+  {
+    Star::float4x4 m;
+    m.makeRotationAxis(Star::float3(1, 2, 3)/Star::float3(1, 2, 3).length(), 0.3f);
+    m(0, 3) = 4;
+    m(1, 3) = 5;
+    m(2, 3) = 6;
+    const Star::float3 p(-1, 2, 0.5f);
+    const Star::float4 q = m*Star::float4(p, 1);
+    TS_ASSERT_EQUALS(m*p, Star::float3(q.x, q.y, q.z));
+  }
+
+  void testInverse()
+  {
+    Star::double2x2 m2(2, 1,
+                       7, 4);
+    Star::double3x3 m3(2, 1, 0,
+                       1, 3, 1,
+                       0, 1, 4);
+    Star::double4x4 m4;
+    m4.makeRotationAxis(Star::double3(0, 0, 1), 0.5);
+    m4(0, 3) = 3;
+    m4(1, 1) *= 2;
+
+    double det;
+    TS_ASSERT(isIdentity(m2*m2.inverse(det)));
+    TS_ASSERT_DELTA(det, 1, 1e-12);
+    TS_ASSERT(isIdentity(m3*m3.inverse(det)));
+    TS_ASSERT_DELTA(det, 18, 1e-12);
+    TS_ASSERT(isIdentity(m4*m4.inverse()));
+    TS_ASSERT_DELTA(m2.trace(), 6, 1e-12);
+    TS_ASSERT_DELTA(m3.trace(), 9, 1e-12);
+  }
+
+  void testInverseBatch()
+  {
+    FloatRandGen rand(2.f);
+    std::vector<Star::double4x4> m(20);
+    for(size_t n = 0; n < m.size(); n++)
+      for(size_t i = 0; i < 16; i++)
+        m[n].ptr()[i] = rand()-1;
+    //Zero, zero column, NaN, normal determinant but overflowing inverse
+    for(size_t i = 0; i < 16; i++)
+      m[3].ptr()[i] = 0;
+    for(size_t i = 0; i < 4; i++)
+      m[7](i, 1) = 0;
+    m[11](1, 2) = std::numeric_limits<double>::quiet_NaN();
+    m[15].toIdentity();
+    m[15](0, 0) = 1e-310;
+    m[15](1, 1) = 1e300;
+
+    std::vector<Star::double4x4> inv(m.size());
+    std::vector<double> det(m.size());
+    bool singular[20];
+    Star::matrixInverse(&m[0], &inv[0], &det[0], singular, m.size());
+    for(size_t n = 0; n < m.size(); n++) {
+      if(n == 3 || n == 7 || n == 11 || n == 15) {
+        TS_ASSERT(singular[n]);
+        TS_ASSERT_EQUALS(inv[n], m[3]);
+        continue;
+      }
+      double ref;
+      const Star::double4x4 refInv = m[n].inverse(ref);
+      TS_ASSERT(!singular[n]);
+      TS_ASSERT_DELTA(det[n], ref, 1e-12);
+      TS_ASSERT(isIdentity(m[n]*inv[n]));
+      for(size_t i = 0; i < 16; i++)
+        TS_ASSERT_DELTA(inv[n].constPtr()[i], refInv.constPtr()[i], 1e-9*std::abs(refInv.constPtr()[i])+1e-12);
+    }
+    TS_ASSERT_EQUALS(det[3], 0);
+    TS_ASSERT_EQUALS(det[7], 0);
+    TS_ASSERT_DELTA(det[15], 1e-10, 1e-22);
+
+    //In place, without the optional outputs
+    std::vector<Star::double4x4> inPlace = m;
+    Star::matrixInverse<double>(&inPlace[0], &inPlace[0], 0, 0, m.size());
+    for(size_t n = 0; n < m.size(); n++)
+      TS_ASSERT_EQUALS(inPlace[n], inv[n]);
+  }
+
+private:
+  template <size_t N>
+  static bool isIdentity(const Star::Mat<N, N, double>& m)
+  {
+    for(size_t j = 0; j < N; j++)
+      for(size_t i = 0; i < N; i++)
+        if(std::abs(m(j, i)-(i == j ? 1 : 0)) > 1e-12)
+          return false;
+    return true;
+  }
+};